@@ -1,9 +1,53 @@
 {
+  "variables": {
+    "with_zstd%": 0,
+    "core_sources": [
+      "src/system_monitor.cc",
+      "src/sample_ring.cc",
+      "src/quantile_sketch.cc",
+      "src/rolling_window.cc",
+      "src/perf_counters.cc",
+      "src/io_rates.cc",
+      "src/gpu_monitor.cc",
+      "src/disk_health.cc",
+      "src/session_log.cc",
+      "src/history_store.cc",
+      "src/shm_snapshot.cc",
+      "src/metrics_server.cc",
+      "src/delta_frame.cc",
+      "src/sensor_scheduler.cc",
+      "src/process_table.cc"
+    ]
+  },
+  "target_defaults": {
+    "conditions": [
+      ["OS=='linux'", {
+        "defines": ["LINUX"],
+        "libraries": ["-ldl", "-lrt"]
+      }],
+      ["with_zstd==1", {
+        "defines": ["HAVE_ZSTD"],
+        "libraries": ["-lzstd"]
+      }]
+    ],
+    "cflags!": ["-fno-exceptions"],
+    "cflags_cc!": ["-fno-exceptions"],
+    "xcode_settings": {
+      "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+      "CLANG_CXX_LIBRARY": "libc++",
+      "MACOSX_DEPLOYMENT_TARGET": "10.7"
+    },
+    "msvs_settings": {
+      "VCCLCompilerTool": {
+        "ExceptionHandling": 1
+      }
+    }
+  },
   "targets": [
     {
       "target_name": "system_monitor",
       "sources": [
-        "src/system_monitor.cc",
+        "<@(core_sources)",
         "src/bindings.cc"
       ],
       "include_dirs": [
@@ -12,24 +56,52 @@
       "defines": [
         "NAPI_DISABLE_CPP_EXCEPTIONS",
         "NAPI_VERSION=10"
+      ]
+    },
+    {
+      # Headless collector (see src/daemon.cc); no Node or Electron at runtime
+      "target_name": "system_monitor_daemon",
+      "product_name": "system-monitor-daemon",
+      "type": "executable",
+      "sources": [
+        "<@(core_sources)",
+        "src/daemon.cc"
       ],
       "conditions": [
         ["OS=='linux'", {
-          "defines": ["LINUX"]
+          "ldflags": ["-pthread"]
         }]
+      ]
+    },
+    {
+      # Per-call cost of the sensor paths against generated sysfs trees; not shipped
+      "target_name": "system_monitor_bench",
+      "product_name": "system-monitor-bench",
+      "type": "executable",
+      "sources": [
+        "<@(core_sources)",
+        "src/bench.cc"
       ],
-      "cflags!": ["-fno-exceptions"],
-      "cflags_cc!": ["-fno-exceptions"],
-      "xcode_settings": {
-        "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
-        "CLANG_CXX_LIBRARY": "libc++",
-        "MACOSX_DEPLOYMENT_TARGET": "10.7"
-      },
-      "msvs_settings": {
-        "VCCLCompilerTool": {
-          "ExceptionHandling": 1
-        }
-      }
+      "conditions": [
+        ["OS=='linux'", {
+          "ldflags": ["-pthread"]
+        }]
+      ]
+    },
+    {
+      # Decoder checks against fake NVML and recorded pages; not shipped
+      "target_name": "system_monitor_tests",
+      "product_name": "system-monitor-tests",
+      "type": "executable",
+      "sources": [
+        "<@(core_sources)",
+        "src/decoder_tests.cc"
+      ],
+      "conditions": [
+        ["OS=='linux'", {
+          "ldflags": ["-pthread"]
+        }]
+      ]
     }
   ]
 }
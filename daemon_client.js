@@ -0,0 +1,114 @@
+const net = require('net');
+const path = require('path');
+
+// Client for system-monitor-daemon (src/daemon.cc). Requests are single
+// lines and every reply is one JSON line, answered in order, so pending
+// requests are matched to replies with a simple FIFO.
+class DaemonClient {
+    constructor() {
+        this.socket = null;
+        this.buffer = '';
+        this.pending = [];
+        this.schema = null;
+    }
+
+    static defaultSocketPath() {
+        return path.join(process.env.XDG_RUNTIME_DIR || '/tmp', 'system-monitor.sock');
+    }
+
+    connect(socketPath = DaemonClient.defaultSocketPath()) {
+        return new Promise((resolve, reject) => {
+            const socket = net.createConnection(socketPath);
+            socket.setEncoding('utf8');
+            socket.once('connect', () => {
+                this.socket = socket;
+                resolve(this);
+            });
+            socket.once('error', (error) => {
+                if (this.socket !== socket) {
+                    reject(error);
+                }
+            });
+            socket.on('data', (chunk) => this.onData(chunk));
+            socket.on('close', () => this.onClose());
+        });
+    }
+
+    isConnected() {
+        return this.socket !== null;
+    }
+
+    close() {
+        if (this.socket) {
+            this.socket.end();
+        }
+    }
+
+    onData(chunk) {
+        this.buffer += chunk;
+        let newline;
+        while ((newline = this.buffer.indexOf('\n')) !== -1) {
+            const line = this.buffer.slice(0, newline);
+            this.buffer = this.buffer.slice(newline + 1);
+            const request = this.pending.shift();
+            if (!request) {
+                continue;
+            }
+            try {
+                const reply = JSON.parse(line);
+                if (reply.error) {
+                    request.reject(new Error(reply.error));
+                } else {
+                    request.resolve(reply);
+                }
+            } catch (error) {
+                request.reject(error);
+            }
+        }
+    }
+
+    onClose() {
+        this.socket = null;
+        this.buffer = '';
+        const pending = this.pending;
+        this.pending = [];
+        for (const request of pending) {
+            request.reject(new Error('System monitor daemon disconnected'));
+        }
+    }
+
+    request(command) {
+        if (!this.socket) {
+            return Promise.reject(new Error('Not connected to system monitor daemon'));
+        }
+        return new Promise((resolve, reject) => {
+            this.pending.push({ resolve, reject });
+            this.socket.write(command + '\n');
+        });
+    }
+
+    getInfo() {
+        return this.request('info');
+    }
+
+    getSchema() {
+        return this.request('schema');
+    }
+
+    // Same shape as HybridSystemMonitor.getSnapshot(): values[0] is the schema
+    // version and values[i + 1] is described by schema.fields[i]
+    async getSnapshot() {
+        const reply = await this.request('snapshot');
+        if (!this.schema || this.schema.version !== reply.version) {
+            this.schema = await this.getSchema();
+        }
+        const values = new Float64Array(reply.values.length + 1);
+        values[0] = reply.version;
+        for (let i = 0; i < reply.values.length; i++) {
+            values[i + 1] = reply.values[i] === null ? NaN : reply.values[i];
+        }
+        return { schema: this.schema, values, timestamp: reply.timestamp };
+    }
+}
+
+module.exports = DaemonClient;
@@ -9,10 +9,20 @@ class HybridSystemMonitor {
             rapl: false,
             battery: false,
             cpuFreq: true,
+            cpuLoad: true,
+            io: true,
+            gpu: true,
+            diskHealth: true,
             cpuTemp: true,
             ddr5: true
         };
         this.simpleStats = {};
+        // Native stats updates are interned to metric ids and flushed in batches
+        this.metricIds = new Map();
+        this.pendingStatIds = new Int32Array(256);
+        this.pendingStatValues = new Float64Array(256);
+        this.pendingStatCount = 0;
+        this.historyOpen = false;
         this.init();
     }
 
@@ -57,7 +67,7 @@ class HybridSystemMonitor {
     async getCPUFrequencies() {
         if (this.useNative) {
             try {
-                const cores = this.nativeMonitor.getCPUCores();
+                const cores = await this.nativeMonitor.getCPUCoresAsync();
                 return cores.map(core => core.frequency);
             } catch (error) {
                 console.warn('Native CPU frequency failed, falling back to JavaScript:', error.message);
@@ -74,16 +84,99 @@ class HybridSystemMonitor {
         return cores;
     }
 
+    // CPU load (aggregate + per core) - native /proc/stat deltas if available,
+    // same shape as si.currentLoad()
+    async getCPULoad() {
+        if (this.useNative && this.nativeFeatures.cpuLoad) {
+            try {
+                return await this.nativeMonitor.getCPULoadAsync();
+            } catch (error) {
+                console.warn('Native CPU load failed, falling back to JavaScript:', error.message);
+                this.nativeFeatures.cpuLoad = false;
+            }
+        }
+        
+        // JavaScript fallback
+        return si.currentLoad();
+    }
+
+    // GPUs via NVML / amdgpu sysfs - null when native has nothing, so the
+    // caller can fall back to nvidia-smi or its own sysfs parsing
+    async getGPUData() {
+        if (!this.useNative || !this.nativeFeatures.gpu) {
+            return null;
+        }
+        try {
+            const gpus = await this.nativeMonitor.getGPUDataAsync();
+            if (gpus.length === 0) {
+                // No NVML and no amdgpu card; don't ask again
+                this.nativeFeatures.gpu = false;
+                return null;
+            }
+            return gpus;
+        } catch (error) {
+            console.warn('Native GPU read failed, falling back to JavaScript:', error.message);
+            this.nativeFeatures.gpu = false;
+            return null;
+        }
+    }
+
+    // SMART / NVMe health via native ioctls - null when no disk could be read
+    // (typically missing CAP_SYS_ADMIN / CAP_SYS_RAWIO), so the caller can
+    // fall back to smartctl
+    async getDiskHealth(maxAgeMs) {
+        if (!this.useNative || !this.nativeFeatures.diskHealth) {
+            return null;
+        }
+        try {
+            const disks = await this.nativeMonitor.getDiskHealthAsync(maxAgeMs);
+            const health = {};
+            for (const [device, disk] of Object.entries(disks)) {
+                if (!disk.error) {
+                    health[device] = disk;
+                }
+            }
+            return Object.keys(health).length > 0 ? health : null;
+        } catch (error) {
+            console.warn('Native disk health failed, falling back to smartctl:', error.message);
+            this.nativeFeatures.diskHealth = false;
+            return null;
+        }
+    }
+
+    // Top-N processes by 'cpu', 'rss' or 'io'; native only, null without it
+    async getTopProcesses(sortKey = 'cpu', count = 10) {
+        if (!this.useNative || typeof this.nativeMonitor.getTopProcessesAsync !== 'function') {
+            return null;
+        }
+        try {
+            return await this.nativeMonitor.getTopProcessesAsync(sortKey, count);
+        } catch (error) {
+            console.warn('Native process table failed:', error.message);
+            return null;
+        }
+    }
+
+    // RAPL joules charged by CPU time; byCgroup aggregates per cgroup instead of per process
+    async getEnergyByProcess(topN = 10, byCgroup = false) {
+        const method = byCgroup ? 'getEnergyByCgroupAsync' : 'getEnergyByProcessAsync';
+        if (!this.useNative || typeof this.nativeMonitor[method] !== 'function') {
+            return null;
+        }
+        try {
+            return await this.nativeMonitor[method](topN);
+        } catch (error) {
+            console.warn('Native energy attribution failed:', error.message);
+            return null;
+        }
+    }
+
     // CPU Temperature Sensors - use native if available
     async getCPUTemperatures() {
         if (this.useNative) {
             try {
-                const sensors = this.nativeMonitor.getTemperatureSensors();
-                return sensors.map(sensor => ({
-                    type: sensor.label,
-                    temp: sensor.value,
-                    isCPU: true
-                }));
+                const sensors = await this.nativeMonitor.getTemperatureSensorsAsync();
+                return this.mapCPUTemperatures(sensors);
             } catch (error) {
                 console.warn('Native temperature sensors failed, falling back to JavaScript:', error.message);
                 this.useNative = false;
@@ -98,11 +191,8 @@ class HybridSystemMonitor {
     async getDDR5MemoryTemps() {
         if (this.useNative) {
             try {
-                const sensors = this.nativeMonitor.getDDR5Temperatures();
-                return sensors.map(sensor => ({
-                    label: sensor.label,
-                    temp: sensor.value
-                }));
+                const sensors = await this.nativeMonitor.getDDR5TemperaturesAsync();
+                return this.mapDDR5Temperatures(sensors);
             } catch (error) {
                 console.warn('Native DDR5 temperatures failed, falling back to JavaScript:', error.message);
                 this.useNative = false;
@@ -118,30 +208,8 @@ class HybridSystemMonitor {
         if (this.nativeFeatures.rapl) {
             try {
                 // Use the new native C implementation with power calculations
-                const powerData = this.nativeMonitor.getRAPLPowerCalculated();
-                const raplPower = {};
-                powerData.forEach(power => {
-                    raplPower[power.name] = {
-                        power: power.power,
-                        energy: power.energy, // joules
-                        totalWh: power.totalWh,
-                        totalKWh: power.totalKWh,
-                        stats: {
-                            current: power.power,
-                            min: power.min_power,
-                            max: power.max_power,
-                            avg: power.avg_power
-                        }
-                    };
-                });
-                
-                // Store last valid values for persistence
-                if (Object.keys(raplPower).length > 0) {
-                    this.lastValidRAPLData = raplPower;
-                }
-                
-                // Return current data if available, otherwise return last valid data
-                return Object.keys(raplPower).length > 0 ? raplPower : (this.lastValidRAPLData || {});
+                const powerData = await this.nativeMonitor.getRAPLPowerCalculatedAsync();
+                return this.mapRAPLPower(powerData);
             } catch (error) {
                 console.warn('Native RAPL power calculated failed, falling back to JavaScript:', error.message);
                 this.nativeFeatures.rapl = false;
@@ -165,7 +233,7 @@ class HybridSystemMonitor {
     async getBatterySensors() {
         if (this.nativeFeatures.battery) {
             try {
-                const bat = this.nativeMonitor.getBatteryCalculated();
+                const bat = await this.nativeMonitor.getBatteryCalculatedAsync();
                 if (bat) return bat;
             } catch (error) {
                 console.warn('Native battery sensors failed, falling back to JavaScript:', error.message);
@@ -222,11 +290,277 @@ class HybridSystemMonitor {
         return { status, acConnected, voltage, current, powerWatts, estimatedHours, state, energyNowWh, energyFullWh };
     }
 
+    // Sample every native sensor group with a single awaited call per tick.
+    // Returns null when the native path is unavailable so callers can fall back
+    // to the individual getters.
+    async sampleAll() {
+        if (!this.useNative || typeof this.nativeMonitor.sampleAllAsync !== 'function') {
+            return null;
+        }
+        try {
+            const sample = await this.nativeMonitor.sampleAllAsync();
+            return {
+                cpuFrequencies: sample.cores.map(core => core.frequency),
+                cpuTemps: this.mapCPUTemperatures(sample.temperatures),
+                ddr5Temps: this.mapDDR5Temperatures(sample.ddr5),
+                raplPower: this.mapRAPLPower(sample.rapl),
+                battery: sample.battery
+            };
+        } catch (error) {
+            console.warn('Native sampleAll failed, falling back to individual getters:', error.message);
+            return null;
+        }
+    }
+
+    // Flat snapshot of every native sensor: values[i + 1] is described by
+    // schema.fields[i]. The schema is only re-fetched when its version changes
+    // and the Float64Array is refilled in place between ticks. groups limits
+    // which sensor groups are read; the others are NaN.
+    getSnapshot(groups) {
+        if (!this.useNative || typeof this.nativeMonitor.snapshot !== 'function') {
+            return null;
+        }
+        try {
+            this.snapshotValues = this.nativeMonitor.snapshot(this.snapshotValues, groups);
+            const version = this.snapshotValues[0];
+            if (!this.snapshotSchema || this.snapshotSchema.version !== version) {
+                this.snapshotSchema = this.nativeMonitor.getSchema();
+            }
+            return { schema: this.snapshotSchema, values: this.snapshotValues };
+        } catch (error) {
+            console.warn('Native snapshot failed:', error.message);
+            return null;
+        }
+    }
+
+    // Push streaming: each subscriber gets its own delta encoder. Returns null
+    // without the native layer, so callers keep polling getSystemData instead.
+    openSnapshotStream() {
+        if (!this.useNative || typeof this.nativeMonitor.openSnapshotStream !== 'function') {
+            return null;
+        }
+        try {
+            return this.nativeMonitor.openSnapshotStream();
+        } catch (error) {
+            console.warn('Snapshot stream unavailable:', error.message);
+            return null;
+        }
+    }
+
+    // Full frames carry the schema, so a subscriber never has to ask for it
+    nextSnapshotFrame(streamId, reset = false) {
+        try {
+            const frame = this.nativeMonitor.nextSnapshotFrame(streamId, reset);
+            if (frame.full) {
+                if (!this.snapshotSchema || this.snapshotSchema.version !== frame.version) {
+                    this.snapshotSchema = this.nativeMonitor.getSchema();
+                }
+                frame.schema = this.snapshotSchema;
+            }
+            return frame;
+        } catch (error) {
+            console.warn('Snapshot frame failed:', error.message);
+            return null;
+        }
+    }
+
+    // One snapshot per tick, shared by every open stream; resolves
+    // { [streamId]: frame } or null. Only the given groups are read.
+    async nextSnapshotFrames(groups) {
+        try {
+            const frames = await this.nativeMonitor.nextSnapshotFramesAsync(groups);
+            for (const streamId of Object.keys(frames)) {
+                if (frames[streamId].full) {
+                    if (!this.snapshotSchema || this.snapshotSchema.version !== frames[streamId].version) {
+                        this.snapshotSchema = this.nativeMonitor.getSchema();
+                    }
+                    frames[streamId].schema = this.snapshotSchema;
+                }
+            }
+            return frames;
+        } catch (error) {
+            console.warn('Snapshot frames failed:', error.message);
+            return null;
+        }
+    }
+
+    closeSnapshotStream(streamId) {
+        try {
+            this.nativeMonitor.closeSnapshotStream(streamId);
+        } catch (error) {
+            // Best-effort on unsubscribe
+        }
+    }
+
+    // Read snapshots from a running system-monitor-daemon instead of sampling
+    // in-process; getSnapshotAsync() falls back to getSnapshot() if it goes away
+    async attachDaemon(socketPath) {
+        const DaemonClient = require('./daemon_client');
+        const client = new DaemonClient();
+        await client.connect(socketPath);
+        this.daemonClient = client;
+        return client;
+    }
+
+    async getSnapshotAsync() {
+        if (this.daemonClient && this.daemonClient.isConnected()) {
+            try {
+                return await this.daemonClient.getSnapshot();
+            } catch (error) {
+                console.warn('Daemon snapshot failed, sampling in-process:', error.message);
+            }
+        }
+        return this.getSnapshot();
+    }
+
+    // Native disk/network rates as { layout, values, ms }, read at most once per
+    // tick and shared by getDisksIO(), getPerDiskIORates() and getNetworkStats()
+    readNativeIO() {
+        if (!this.useNative || !this.nativeFeatures.io) {
+            return null;
+        }
+        const now = Date.now();
+        if (this.ioSample && now - this.ioSample.time < 50) {
+            return this.ioSample;
+        }
+        try {
+            this.ioValues = this.nativeMonitor.readIORates(this.ioValues);
+            if (!this.ioLayout || this.ioLayout.version !== this.ioValues[0]) {
+                this.ioLayout = this.nativeMonitor.getIODevices();
+            }
+            const ms = this.ioSample ? now - this.ioSample.time : null;
+            this.ioSample = { layout: this.ioLayout, values: this.ioValues, time: now, ms };
+            return this.ioSample;
+        } catch (error) {
+            console.warn('Native I/O rates failed, falling back to JavaScript:', error.message);
+            this.nativeFeatures.io = false;
+            return null;
+        }
+    }
+
+    // The row starting at `offset` of a readIORates() array as { fieldName: value }
+    ioRow(sample, offset, fields) {
+        const row = {};
+        fields.forEach((field, i) => {
+            row[field] = sample.values[1 + offset + i];
+        });
+        return row;
+    }
+
+    // Aggregate disk I/O in si.disksIO() shape. dm/md devices are left out: the
+    // disks under them already count the same requests
+    async getDisksIO() {
+        const sample = this.readNativeIO();
+        if (!sample) {
+            return si.disksIO();
+        }
+        const { disks, diskFields, diskStacked } = sample.layout;
+        const result = { rIO: 0, wIO: 0, tIO: 0, rIO_sec: 0, wIO_sec: 0, tIO_sec: 0, ms: sample.ms };
+        disks.forEach((name, d) => {
+            if (diskStacked && diskStacked[d]) return;
+            const row = this.ioRow(sample, d * diskFields.length, diskFields);
+            if (Number.isNaN(row.readsTotal)) return;
+            result.rIO += row.readsTotal;
+            result.wIO += row.writesTotal;
+            result.rIO_sec += row.readIOPS || 0;
+            result.wIO_sec += row.writeIOPS || 0;
+        });
+        result.tIO = result.rIO + result.wIO;
+        result.tIO_sec = result.rIO_sec + result.wIO_sec;
+        if (sample.ms === null) {
+            result.rIO_sec = result.wIO_sec = result.tIO_sec = null;
+        }
+        return result;
+    }
+
+    // Per-disk rates keyed by device name, or null when native I/O is unavailable
+    getPerDiskIORates() {
+        const sample = this.readNativeIO();
+        if (!sample) {
+            return null;
+        }
+        const { disks, diskFields } = sample.layout;
+        const rates = {};
+        disks.forEach((name, d) => {
+            const row = this.ioRow(sample, d * diskFields.length, diskFields);
+            if (!Number.isNaN(row.readBytesPerSec)) {
+                rates[name] = { device: name, ...row };
+            }
+        });
+        return rates;
+    }
+
+    // Per-interface network stats in si.networkStats() shape
+    async getNetworkStats() {
+        const sample = this.readNativeIO();
+        if (!sample) {
+            return si.networkStats();
+        }
+        const { disks, diskFields, interfaces, netFields } = sample.layout;
+        const base = disks.length * diskFields.length;
+        return interfaces.map((iface, n) => {
+            const row = this.ioRow(sample, base + n * netFields.length, netFields);
+            return {
+                iface,
+                operstate: row.operUp === 1 ? 'up' : (row.operUp === 0 ? 'down' : 'unknown'),
+                rx_bytes: row.rxBytes,
+                tx_bytes: row.txBytes,
+                rx_sec: Number.isNaN(row.rxBytesPerSec) ? null : row.rxBytesPerSec,
+                tx_sec: Number.isNaN(row.txBytesPerSec) ? null : row.txBytesPerSec,
+                ms: sample.ms
+            };
+        });
+    }
+
+    mapCPUTemperatures(sensors) {
+        return sensors.map(sensor => ({
+            type: sensor.label,
+            temp: sensor.value,
+            isCPU: true
+        }));
+    }
+
+    mapDDR5Temperatures(sensors) {
+        return sensors.map(sensor => ({
+            label: sensor.label,
+            temp: sensor.value
+        }));
+    }
+
+    mapRAPLPower(powerData) {
+        const raplPower = {};
+        powerData.forEach(power => {
+            raplPower[power.name] = {
+                power: power.power,
+                energy: power.energy, // joules
+                parent: power.parent, // '' for top-level domains, e.g. 'package-0' for 'package-0/core'
+                totalWh: power.totalWh,
+                totalKWh: power.totalKWh,
+                ewma: power.ewma,     // per window, see nativeMonitor.getPowerWindows()
+                boxcar: power.boxcar,
+                stats: {
+                    current: power.stats.current,
+                    min: power.stats.min,
+                    max: power.stats.max,
+                    avg: power.stats.avg
+                }
+            };
+        });
+        
+        // Store last valid values for persistence
+        if (Object.keys(raplPower).length > 0) {
+            this.lastValidRAPLData = raplPower;
+        }
+        
+        // Return current data if available, otherwise return last valid data
+        return Object.keys(raplPower).length > 0 ? raplPower : (this.lastValidRAPLData || {});
+    }
+
     // Statistics - use native if available
     updateStats(key, value) {
         if (this.useNative) {
             try {
-                this.nativeMonitor.updateStats(key, value);
+                this.queueNativeStat(key, value);
                 return;
             } catch (error) {
                 console.warn('Native stats update failed, falling back to JavaScript:', error.message);
@@ -238,10 +572,38 @@ class HybridSystemMonitor {
         this.updateStatsJS(key, value);
     }
 
+    queueNativeStat(key, value) {
+        let id = this.metricIds.get(key);
+        if (id === undefined) {
+            id = this.nativeMonitor.registerMetric(key);
+            this.metricIds.set(key, id);
+        }
+        if (this.pendingStatCount === this.pendingStatIds.length) {
+            this.flushNativeStats();
+        }
+        this.pendingStatIds[this.pendingStatCount] = id;
+        this.pendingStatValues[this.pendingStatCount] = value; // null/undefined become NaN and are skipped natively
+        this.pendingStatCount++;
+    }
+
+    flushNativeStats() {
+        if (this.pendingStatCount > 0) {
+            this.nativeMonitor.updateStatsBatch(this.pendingStatIds, this.pendingStatValues, this.pendingStatCount);
+            this.pendingStatCount = 0;
+            if (this.historyOpen) {
+                const refused = this.nativeMonitor.takeHistoryRefused();
+                if (refused.length > 0) {
+                    console.warn(`History file full; not recording ${refused.join(', ')}`);
+                }
+            }
+        }
+    }
+
     // Check if last valid value exists
     hasLastValidValue(key) {
         if (this.useNative) {
             try {
+                this.flushNativeStats();
                 return this.nativeMonitor.hasLastValidValue(key);
             } catch (error) {
                 console.warn('Native hasLastValidValue failed, falling back to JavaScript:', error.message);
@@ -257,6 +619,7 @@ class HybridSystemMonitor {
     getLastValidValue(key) {
         if (this.useNative) {
             try {
+                this.flushNativeStats();
                 return this.nativeMonitor.getLastValidValue(key);
             } catch (error) {
                 console.warn('Native getLastValidValue failed, falling back to JavaScript:', error.message);
@@ -271,6 +634,7 @@ class HybridSystemMonitor {
     getStats() {
         if (this.useNative) {
             try {
+                this.flushNativeStats();
                 return this.nativeMonitor.getStats();
             } catch (error) {
                 console.warn('Native stats get failed, falling back to JavaScript:', error.message);
@@ -282,6 +646,181 @@ class HybridSystemMonitor {
         return this.getStatsJS();
     }
 
+    // Streaming p50/p95/p99/p99.9 (or the requested quantiles); native only
+    getQuantiles(key, quantiles) {
+        if (!this.useNative) {
+            return null;
+        }
+        try {
+            this.flushNativeStats();
+            return this.nativeMonitor.getQuantiles(key, quantiles);
+        } catch (error) {
+            console.warn('Native getQuantiles failed:', error.message);
+            return null;
+        }
+    }
+
+    // Publish the native sampler through shared memory so other local viewers
+    // read this process's samples instead of sweeping sysfs themselves.
+    // Subscribes the published groups for as long as the segment is open;
+    // snapshots follow sensorHz.
+    publishSharedSnapshot(name, sensorHz = 10) {
+        if (!this.useNative || typeof this.nativeMonitor.openSharedSnapshot !== 'function') {
+            return false;
+        }
+        try {
+            this.nativeMonitor.openSharedSnapshot(name);
+            this.sharedSubscriptions = [
+                this.nativeMonitor.subscribe(['rapl'], Math.max(sensorHz, 10)),
+                this.nativeMonitor.subscribe(['cpu', 'ddr5', 'cpufreq', 'battery'], sensorHz)
+            ];
+            return true;
+        } catch (error) {
+            console.warn('Shared snapshot unavailable:', error.message);
+            return false;
+        }
+    }
+
+    closeSharedSnapshot() {
+        if (!this.useNative || typeof this.nativeMonitor.closeSharedSnapshot !== 'function') {
+            return;
+        }
+        try {
+            for (const id of this.sharedSubscriptions || []) {
+                this.nativeMonitor.unsubscribe(id);
+            }
+            this.sharedSubscriptions = null;
+            this.nativeMonitor.closeSharedSnapshot();
+        } catch (error) {
+            // Best-effort on shutdown
+        }
+    }
+
+    // Demand-driven native sampling: the sampler reads a group only while
+    // some subscription covers it. Returns the id, or null without the native layer
+    subscribe(groups, rateHz) {
+        if (!this.useNative || typeof this.nativeMonitor.subscribe !== 'function') {
+            return null;
+        }
+        try {
+            return this.nativeMonitor.subscribe(groups, rateHz);
+        } catch (error) {
+            console.warn('Native subscribe failed:', error.message);
+            return null;
+        }
+    }
+
+    unsubscribe(id) {
+        if (!this.useNative || typeof this.nativeMonitor.unsubscribe !== 'function' || id === null) {
+            return;
+        }
+        try {
+            this.nativeMonitor.unsubscribe(id);
+        } catch (error) {
+            // Unknown ids are harmless
+        }
+    }
+
+    // Prometheus-compatible scrape target; returns the port, or null without the native layer
+    startMetricsServer(port, address = '127.0.0.1') {
+        if (!this.useNative || typeof this.nativeMonitor.startMetricsServer !== 'function') {
+            return null;
+        }
+        try {
+            return this.nativeMonitor.startMetricsServer(port, address);
+        } catch (error) {
+            console.warn('Metrics server unavailable:', error.message);
+            return null;
+        }
+    }
+
+    stopMetricsServer() {
+        if (!this.useNative || typeof this.nativeMonitor.stopMetricsServer !== 'function') {
+            return;
+        }
+        try {
+            this.nativeMonitor.stopMetricsServer();
+        } catch (error) {
+            // Best-effort on shutdown
+        }
+    }
+
+    // Same shape as getSnapshot(), read from a segment another process
+    // publishes; null when it doesn't exist or has no snapshot yet
+    readSharedSnapshot(name) {
+        try {
+            const NativeSystemMonitor = require('./native_monitor');
+            const values = NativeSystemMonitor.readSharedSnapshot(name, this.sharedValues);
+            if (!values) {
+                return null;
+            }
+            this.sharedValues = values;
+            if (!this.sharedSchema || this.sharedSchema.version !== values[0]) {
+                this.sharedSchema = NativeSystemMonitor.getSharedSnapshotSchema(name);
+            }
+            return { schema: this.sharedSchema, values };
+        } catch (error) {
+            return null;
+        }
+    }
+
+    // Persist the listed stats keys to an mmap'd history file for long-range
+    // charts; each key reserves about 1 MiB of disk
+    openHistory(historyPath, metrics) {
+        if (!this.useNative) {
+            return false;
+        }
+        try {
+            this.historyOpen = this.nativeMonitor.openHistory(historyPath, 0, metrics);
+            return this.historyOpen;
+        } catch (error) {
+            console.warn('Native history unavailable:', error.message);
+            return false;
+        }
+    }
+
+    closeHistory() {
+        if (!this.useNative) {
+            return;
+        }
+        try {
+            this.flushNativeStats();
+            this.historyOpen = false;
+            this.nativeMonitor.closeHistory();
+        } catch (error) {
+            // Best-effort on shutdown
+        }
+    }
+
+    // { key: { bucketMs, timestamps, min, max, avg } } for stats keys over [t0, t1] (ms since the epoch);
+    // null when history is unavailable
+    queryHistory(keys, t0, t1, maxPoints) {
+        if (!this.useNative) {
+            return null;
+        }
+        try {
+            this.flushNativeStats();
+            const ids = keys.map(key => {
+                let id = this.metricIds.get(key);
+                if (id === undefined) {
+                    id = this.nativeMonitor.registerMetric(key);
+                    this.metricIds.set(key, id);
+                }
+                return id;
+            });
+            const ranges = this.nativeMonitor.queryRange(ids, t0, t1, maxPoints);
+            const result = {};
+            keys.forEach((key, i) => {
+                const { id, ...range } = ranges[i];
+                result[key] = range;
+            });
+            return result;
+        } catch (error) {
+            console.warn('Native history query failed:', error.message);
+            return null;
+        }
+    }
+
     // Helper function to read sensor files
     readSensorFile(path) {
         try {
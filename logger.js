@@ -18,6 +18,11 @@ class SystemLogger {
     this.detailedStream = null;
     this.csvHeader = null;
     
+    // Native columnar log (.smlog) when the addon is available; CSV otherwise
+    this.nativeMonitor = null;
+    this.sessionLogOpen = false;
+    this.rowBuffer = null;
+    
     this.initialize();
   }
   
@@ -27,9 +32,23 @@ class SystemLogger {
       fs.mkdirSync(this.logDir, { recursive: true });
     }
     
-    // Setup detailed log file
-    this.detailedLogPath = path.join(this.logDir, `system-monitor-${this.sessionId}.csv`);
-    this.detailedStream = fs.createWriteStream(this.detailedLogPath, { flags: 'a' });
+    try {
+      const NativeSystemMonitor = require('./native_monitor');
+      const nativeMonitor = new NativeSystemMonitor();
+      if (nativeMonitor.isInitialized()) {
+        this.nativeMonitor = nativeMonitor;
+      }
+    } catch (e) {
+      // Fall back to CSV
+    }
+    
+    // Setup detailed log file; the native log is opened once the first sample defines the columns
+    if (this.nativeMonitor) {
+      this.detailedLogPath = path.join(this.logDir, `system-monitor-${this.sessionId}.smlog`);
+    } else {
+      this.detailedLogPath = path.join(this.logDir, `system-monitor-${this.sessionId}.csv`);
+      this.detailedStream = fs.createWriteStream(this.detailedLogPath, { flags: 'a' });
+    }
     this.summaryTxtPath = path.join(this.logDir, `system-monitor-${this.sessionId}.txt`);
     
     console.log(`Logging to: ${this.detailedLogPath}`);
@@ -38,6 +57,8 @@ class SystemLogger {
   logData(data) {
     if (!this.isLogging || !data) return;
     
+    if (this.nativeMonitor && this.logNative(data)) return;
+    
     const timestamp = new Date().toISOString();
     
     // Write header if first time (need data to build proper header)
@@ -60,6 +81,52 @@ class SystemLogger {
     this.writeRollingSummaryTxt();
   }
   
+  // Append to the native session log. Summaries are rewritten only when a
+  // chunk reaches disk, not on every sample. Returns false if the native log
+  // failed and logging should continue as CSV.
+  logNative(data) {
+    try {
+      if (!this.sessionLogOpen) {
+        this.lastData = data;
+        this.csvHeader = this.buildCSVHeader(data);
+        const columns = this.csvHeader.split(',').slice(1); // Timestamps are stored natively
+        this.nativeMonitor.openSessionLog(this.detailedLogPath, columns);
+        this.sessionLogOpen = true;
+        this.rowBuffer = new Float64Array(columns.length);
+      }
+      
+      this.lastData = data;
+      const values = this.buildRowValues(data);
+      this.rowBuffer.fill(NaN);
+      this.rowBuffer.set(values.length > this.rowBuffer.length ? values.slice(0, this.rowBuffer.length) : values);
+      const chunkWritten = this.nativeMonitor.appendSessionLog(Date.now(), this.rowBuffer);
+      
+      this.updateStats(data);
+      if (chunkWritten) {
+        this.writeRollingSummaryTxt();
+      }
+      return true;
+    } catch (e) {
+      console.warn('Native session log failed, falling back to CSV:', e.message);
+      this.closeNativeLog();
+      this.nativeMonitor = null;
+      this.csvHeader = null;
+      this.detailedLogPath = path.join(this.logDir, `system-monitor-${this.sessionId}.csv`);
+      this.detailedStream = fs.createWriteStream(this.detailedLogPath, { flags: 'a' });
+      return false;
+    }
+  }
+  
+  closeNativeLog() {
+    if (!this.sessionLogOpen) return;
+    this.sessionLogOpen = false;
+    try {
+      this.nativeMonitor.closeSessionLog();
+    } catch (e) {
+      // Best-effort on shutdown
+    }
+  }
+  
   buildCSVHeader(data) {
     const headers = ['timestamp', 'runtime_ms'];
     
@@ -163,47 +230,48 @@ class SystemLogger {
     return headers.join(',');
   }
   
-  buildCSVRow(data, timestamp) {
-    const values = [timestamp];
+  // Numeric row matching buildCSVHeader() minus the timestamp column; NaN marks a missing value
+  buildRowValues(data) {
+    const values = [];
     const runtime = Date.now() - this.startTime;
     values.push(runtime);
     
     // CPU data (only dynamic values)
     if (data && data.cpu) {
-      values.push(this.formatNumber(data.cpu.currentLoad)); // Overall CPU usage
+      values.push(this.toValue(data.cpu.currentLoad)); // Overall CPU usage
       
       // CPU package frequency (average of all cores)
       const avgFreq = data.cpu.frequencies && data.cpu.frequencies.length > 0 
         ? data.cpu.frequencies.reduce((a, b) => a + b, 0) / data.cpu.frequencies.length
         : data.cpu.speed || 0;
-      values.push(this.formatNumber(avgFreq));
+      values.push(this.toValue(avgFreq));
       
       // CPU package temperature (main temperature)
       if (data.cpu.temperature && data.cpu.temperature.main) {
-        values.push(this.formatNumber(data.cpu.temperature.main));
+        values.push(this.toValue(data.cpu.temperature.main));
       } else if (data.cpu.temperature && data.cpu.temperature.sensors && data.cpu.temperature.sensors.length > 0) {
         // Use first sensor as package temp if no main temp
-        values.push(this.formatNumber(data.cpu.temperature.sensors[0].temp));
+        values.push(this.toValue(data.cpu.temperature.sensors[0].temp));
       }
       
       // Per-core CPU usage
       if (data.cpu.coreLoads) {
         for (let i = 0; i < data.cpu.coreLoads.length; i++) {
-          values.push(this.formatNumber(data.cpu.coreLoads[i].load));
+          values.push(this.toValue(data.cpu.coreLoads[i].load));
         }
       }
       
       // Per-core CPU frequencies
       if (data.cpu.frequencies) {
         for (let i = 0; i < data.cpu.frequencies.length; i++) {
-          values.push(this.formatNumber(data.cpu.frequencies[i]));
+          values.push(this.toValue(data.cpu.frequencies[i]));
         }
       }
       
       // CPU temperature sensors (all sensors - package, cores, CCDs)
       if (data.cpu.temperature && data.cpu.temperature.sensors) {
         data.cpu.temperature.sensors.forEach(sensor => {
-          values.push(this.formatNumber(sensor.temp));
+          values.push(this.toValue(sensor.temp));
         });
       }
     }
@@ -211,7 +279,7 @@ class SystemLogger {
     // Memory data (only dynamic values)
     if (data && data.memory) {
       values.push(data.memory.used || 0);
-      values.push(this.formatNumber(data.memory.usedPercent));
+      values.push(this.toValue(data.memory.usedPercent));
       if (data.memory.swap && data.memory.swap.used !== undefined) {
         values.push(data.memory.swap.used || 0);
       }
@@ -219,7 +287,7 @@ class SystemLogger {
       // DDR5 memory temperatures
       if (data.memory.ddr5Temps && data.memory.ddr5Temps.length > 0) {
         data.memory.ddr5Temps.forEach(memTemp => {
-          values.push(this.formatNumber(memTemp.temp));
+          values.push(this.toValue(memTemp.temp));
         });
       }
     }
@@ -233,15 +301,15 @@ class SystemLogger {
       if (data.disk.perDiskIO) {
         Object.keys(data.disk.perDiskIO).forEach(device => {
           const diskIO = data.disk.perDiskIO[device];
-          values.push(this.formatNumber(diskIO.readBytesPerSec));
-          values.push(this.formatNumber(diskIO.writeBytesPerSec));
+          values.push(this.toValue(diskIO.readBytesPerSec));
+          values.push(this.toValue(diskIO.writeBytesPerSec));
         });
       }
       
       // Per-disk temperatures
       if (data.disk.temperatures) {
         Object.keys(data.disk.temperatures).forEach(device => {
-          values.push(this.formatNumber(data.disk.temperatures[device]));
+          values.push(this.toValue(data.disk.temperatures[device]));
         });
       }
     }
@@ -249,9 +317,9 @@ class SystemLogger {
     // GPU data
     if (data && data.gpu && data.gpu.length > 0) {
       const gpu = data.gpu[0];
-      if (gpu.utilizationGpu !== undefined) values.push(this.formatNumber(gpu.utilizationGpu));
-      if (gpu.temperatureGpu !== undefined) values.push(this.formatNumber(gpu.temperatureGpu));
-      if (gpu.powerDraw !== undefined) values.push(this.formatNumber(gpu.powerDraw));
+      if (gpu.utilizationGpu !== undefined) values.push(this.toValue(gpu.utilizationGpu));
+      if (gpu.temperatureGpu !== undefined) values.push(this.toValue(gpu.temperatureGpu));
+      if (gpu.powerDraw !== undefined) values.push(this.toValue(gpu.powerDraw));
       if (gpu.memoryUsed !== undefined) values.push(gpu.memoryUsed || 0);
       if (gpu.memoryTotal !== undefined) values.push(gpu.memoryTotal || 0);
     }
@@ -260,7 +328,7 @@ class SystemLogger {
     if (data && data.raplPower) {
       Object.keys(data.raplPower).forEach(name => {
         const raplData = data.raplPower[name];
-        values.push(this.formatNumber(raplData.power));
+        values.push(this.toValue(raplData.power));
       });
     }
     
@@ -275,7 +343,12 @@ class SystemLogger {
       values.push(txTotal);
     }
     
-    return values.join(',');
+    return values;
+  }
+  
+  buildCSVRow(data, timestamp) {
+    const values = this.buildRowValues(data).map(value => this.formatCSVValue(value));
+    return [timestamp, ...values].join(',');
   }
   
   updateStats(data) {
@@ -456,10 +529,24 @@ class SystemLogger {
     return Number(num).toFixed(2);
   }
   
+  // Whole numbers (byte counts, runtime) print bare, like the native CSV exporter
+  formatCSVValue(value) {
+    return Number.isInteger(value) ? String(value) : this.formatNumber(value);
+  }
+  
+  toValue(num) {
+    if (num === null || num === undefined || isNaN(num)) return NaN;
+    return Number(num);
+  }
+  
   close() {
     if (this.detailedStream) {
       this.detailedStream.end();
     }
+    if (this.nativeMonitor) {
+      this.closeNativeLog();
+      this.writeRollingSummaryTxt();
+    }
     this.writeSummary();
   }
 }
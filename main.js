@@ -39,13 +39,14 @@ if (process.platform === 'linux' && process.getuid && process.getuid() === 0) {
   }
 }
 
-const { BrowserWindow, ipcMain } = require('electron');
+const { BrowserWindow, ipcMain, MessageChannelMain } = require('electron');
 const path = require('path');
 const si = require('systeminformation');
 const fs = require('fs');
 const { execSync } = require('child_process');
 const SystemLogger = require('./logger');
 const HybridSystemMonitor = require('./hybrid_monitor');
+const { patchSnapshotValues } = require('./snapshot_patch');
 
 let mainWindow;
 let gpuType = null; // 'nvidia', 'amd', or null
@@ -113,7 +114,12 @@ function getSimpleStats() {
   return result;
 }
 
-// Caching for expensive/static data with tiered update rates
+// Caching for expensive/static data with tiered update rates. The native
+// sensor groups (RAPL, CPU and DDR5 temperatures, CPU frequencies, battery
+// sensors) are not tiered: they are read on every call, and while the native
+// sampler streams them its adaptive per-sensor schedule sets their cadence
+// (see readUnlessStreamed). The tiers below cover only what that scheduler
+// does not read: hardware inventory and the systeminformation/sysfs reads.
 let smartDataCache = null;
 let smartDataCacheTime = 0;
 const SMART_CACHE_DURATION = 60000; // 60 seconds
@@ -126,14 +132,12 @@ let staticDataCache = {
 };
 const STATIC_CACHE_DURATION = 30000; // 30 seconds
 
-// Medium-speed data cache (battery, fans, power, some temps)
+// Medium-speed data cache (battery status, fans, power supplies, disk and system temps)
 let mediumDataCache = {
   battery: null,
   fans: null,
   power: null,
-  raplPower: null,
   diskTemps: null,
-  cpuTemps: null,
   systemTemps: null,
   lastUpdate: 0
 };
@@ -144,6 +148,13 @@ let gpuDataCacheTime = 0;
 const GPU_CACHE_DURATION = 5000; // 5 seconds - GPU data changes less frequently
 const MEDIUM_CACHE_DURATION = 1000; // 1 second
 
+// Stats keys kept in the persistent history when SYSTEM_MONITOR_HISTORY=1
+const HISTORY_METRICS = [
+  'cpu_usage', 'mem_percent', 'cpu_avg_freq',
+  'gpu_usage', 'gpu_temp', 'gpu_power',
+  'battery_power', 'battery_current', 'battery_voltage'
+];
+
 
 function createWindow() {
   mainWindow = new BrowserWindow({
@@ -222,6 +233,21 @@ app.whenReady().then(() => {
   
   // Initialize hybrid monitor
   hybridMonitor = new HybridSystemMonitor();
+  // Opt-in: SYSTEM_MONITOR_HISTORY=1 keeps a persistent history of HISTORY_METRICS
+  // (about 1 MiB of disk each); a comma-separated list of stats keys picks others
+  if (process.env.SYSTEM_MONITOR_HISTORY) {
+    const metrics = process.env.SYSTEM_MONITOR_HISTORY === '1' ? HISTORY_METRICS :
+      process.env.SYSTEM_MONITOR_HISTORY.split(',').map(key => key.trim()).filter(key => key.length > 0);
+    hybridMonitor.openHistory(path.join(app.getPath('userData'), 'history.smhist'), metrics);
+  }
+  // Opt-in: SYSTEM_MONITOR_SHM=/name lets other local viewers map our samples
+  if (process.env.SYSTEM_MONITOR_SHM) {
+    hybridMonitor.publishSharedSnapshot(process.env.SYSTEM_MONITOR_SHM);
+  }
+  // Opt-in: SYSTEM_MONITOR_METRICS_PORT=9184 serves /metrics on loopback
+  if (process.env.SYSTEM_MONITOR_METRICS_PORT) {
+    hybridMonitor.startMetricsServer(parseInt(process.env.SYSTEM_MONITOR_METRICS_PORT, 10));
+  }
   
   createWindow();
   
@@ -238,11 +264,16 @@ app.on('window-all-closed', () => {
     logger.close();
     logger = null;
   }
+  if (hybridMonitor) {
+    hybridMonitor.closeHistory();
+    hybridMonitor.closeSharedSnapshot();
+    hybridMonitor.stopMetricsServer();
+  }
   
   // Clear all caches on shutdown
   smartDataCache = null;
   staticDataCache = { cpu: null, osInfo: null, diskLayout: null, lastUpdate: 0 };
-  mediumDataCache = { battery: null, fans: null, power: null, raplPower: null, diskTemps: null, cpuTemps: null, systemTemps: null, lastUpdate: 0 };
+  mediumDataCache = { battery: null, fans: null, power: null, diskTemps: null, systemTemps: null, lastUpdate: 0 };
   
   if (process.platform !== 'darwin') {
     app.quit();
@@ -568,10 +599,13 @@ async function getGPUData() {
     return gpuDataCache;
   }
   
-  const type = detectGPUType();
-  let gpuData = [];
+  // Native NVML / amdgpu readings first: no nvidia-smi process per refresh
+  let gpuData = hybridMonitor ? await hybridMonitor.getGPUData() : null;
+  const type = gpuData ? 'native' : detectGPUType();
   
-  if (type === 'nvidia') {
+  if (type === 'native') {
+    // Already filled
+  } else if (type === 'nvidia') {
     gpuData = await getNvidiaGPUData();
   } else if (type === 'amd') {
     gpuData = await getAMDGPUData();
@@ -618,6 +652,66 @@ async function getGPUData() {
   return gpuData;
 }
 
+// Whole disks from /sys/block, without partitions or virtual devices
+const VIRTUAL_BLOCK_DEVICE = /^(loop|ram|zram|dm-|md|sr|fd|nbd)/;
+
+function listWholeDisks() {
+  try {
+    return fs.readdirSync('/sys/block').filter(name => !VIRTUAL_BLOCK_DEVICE.test(name));
+  } catch (e) {
+    return [];
+  }
+}
+
+// One disk's attributes from `smartctl -A`; null when smartctl can't read it
+function readSmartctl(device) {
+  const devPath = `/dev/${device}`;
+  let output = execCommand(`sudo smartctl -A ${devPath} 2>/dev/null`);
+  if (!output) output = execCommand(`smartctl -A ${devPath} 2>/dev/null`);
+  if (!output) return null;
+  
+  const data = {
+    device: device,
+    healthy: true,
+    temperature: null,
+    powerOnHours: null,
+    powerCycles: null,
+    wearLevel: null,
+    reallocatedSectors: null,
+    pendingSectors: null
+  };
+  
+  // Parse SMART attributes
+  const lines = output.split('\n');
+  for (const line of lines) {
+    const parts = line.trim().split(/\s+/);
+    if (parts.length >= 10) {
+      const id = parts[0];
+      const value = parts[9];
+      
+      // Temperature (194)
+      if (id === '194') data.temperature = parseInt(value);
+      // Power On Hours (9)
+      if (id === '9') data.powerOnHours = parseInt(value);
+      // Power Cycle Count (12)
+      if (id === '12') data.powerCycles = parseInt(value);
+      // Wear Leveling / SSD Life (231 or 233)
+      if (id === '231' || id === '233') data.wearLevel = parseInt(parts[3]);
+      // Reallocated Sectors (5)
+      if (id === '5') {
+        data.reallocatedSectors = parseInt(value);
+        if (parseInt(value) > 0) data.healthy = false;
+      }
+      // Current Pending Sectors (197)
+      if (id === '197') {
+        data.pendingSectors = parseInt(value);
+        if (parseInt(value) > 0) data.healthy = false;
+      }
+    }
+  }
+  return data;
+}
+
 // Get SMART data for disks (cached)
 async function getDiskSMARTData() {
   const now = Date.now();
@@ -627,81 +721,22 @@ async function getDiskSMARTData() {
     return smartDataCache;
   }
   
-  const smartData = {};
-  
-  // Check if smartctl is available
-  const hasSmartctl = execCommand('which smartctl');
-  if (!hasSmartctl) {
-    smartDataCache = smartData;
-    smartDataCacheTime = now;
-    return smartData;
-  }
+  // Native ioctls first: no smartctl processes and no sudo prompt. Disks
+  // they can't read (USB bridges without SAT, virtio, eMMC, or no
+  // CAP_SYS_RAWIO for SATA while NVMe works) fall back to smartctl one by one
+  const nativeHealth = hybridMonitor ? await hybridMonitor.getDiskHealth(SMART_CACHE_DURATION) : null;
+  const smartData = Object.assign({}, nativeHealth);
+  const remaining = listWholeDisks().filter(device => !smartData[device]);
   
-  try {
-    // Get list of block devices
-    const devices = execCommand('lsblk -d -o NAME,TYPE -n | grep disk | awk \'{print $1}\'');
-    if (!devices) return smartData;
-    
-    const deviceList = devices.split('\n');
-    
-    for (const device of deviceList) {
-      const devPath = `/dev/${device}`;
-      
+  if (remaining.length > 0 && execCommand('which smartctl')) {
+    for (const device of remaining) {
       try {
-        // Get SMART data in JSON format (requires smartmontools 7.0+)
-        // Fall back to text parsing if JSON not available
-        let output = execCommand(`sudo smartctl -A ${devPath} 2>/dev/null`);
-        if (!output) output = execCommand(`smartctl -A ${devPath} 2>/dev/null`);
-        
-        if (output) {
-          const data = {
-            device: device,
-            healthy: true,
-            temperature: null,
-            powerOnHours: null,
-            powerCycles: null,
-            wearLevel: null,
-            reallocatedSectors: null,
-            pendingSectors: null
-          };
-          
-          // Parse SMART attributes
-          const lines = output.split('\n');
-          for (const line of lines) {
-            const parts = line.trim().split(/\s+/);
-            if (parts.length >= 10) {
-              const id = parts[0];
-              const value = parts[9];
-              
-              // Temperature (194)
-              if (id === '194') data.temperature = parseInt(value);
-              // Power On Hours (9)
-              if (id === '9') data.powerOnHours = parseInt(value);
-              // Power Cycle Count (12)
-              if (id === '12') data.powerCycles = parseInt(value);
-              // Wear Leveling / SSD Life (231 or 233)
-              if (id === '231' || id === '233') data.wearLevel = parseInt(parts[3]);
-              // Reallocated Sectors (5)
-              if (id === '5') {
-                data.reallocatedSectors = parseInt(value);
-                if (parseInt(value) > 0) data.healthy = false;
-              }
-              // Current Pending Sectors (197)
-              if (id === '197') {
-                data.pendingSectors = parseInt(value);
-                if (parseInt(value) > 0) data.healthy = false;
-              }
-            }
-          }
-          
-          smartData[device] = data;
-        }
+        const data = readSmartctl(device);
+        if (data) smartData[device] = data;
       } catch (e) {
         // Skip this device
       }
     }
-  } catch (error) {
-    console.error('Error reading SMART data:', error);
   }
   
   // Cache the result
@@ -1262,6 +1297,152 @@ async function getDiskTemperatures() {
   return diskTemps;
 }
 
+// Decimated history for the charts: typed arrays from the mmap'd store, never the whole series
+ipcMain.handle('query-history', async (event, keys, t0, t1, maxPoints) => {
+  return hybridMonitor ? hybridMonitor.queryHistory(keys, t0, t1, maxPoints) : null;
+});
+
+// Heaviest processes for the "what is drawing power" view; the native table
+// spreads its /proc sweep across calls, so polling this is cheap
+ipcMain.handle('get-top-processes', async (event, sortKey, count) => {
+  return hybridMonitor ? hybridMonitor.getTopProcesses(sortKey, count) : null;
+});
+
+ipcMain.handle('get-energy-by-process', async (event, topN, byCgroup) => {
+  return hybridMonitor ? hybridMonitor.getEnergyByProcess(topN, byCgroup) : null;
+});
+
+// Push stream of native snapshot frames: the renderer subscribes once and gets
+// a MessagePort, then only changed values arrive, plus the schema whenever the
+// sensor layout changes. Replaces the 10 Hz get-system-data round trips for
+// the fast sensors; the nested object is still polled for everything else.
+// Every subscriber shares one timer and one snapshot per tick, taken on the
+// threadpool from the native sampler, which follows the streamed groups while
+// anyone is watching. Only the groups some subscriber asked for are read.
+const SNAPSHOT_STREAM_INTERVAL_MS = 100;
+const SNAPSHOT_STREAM_GROUPS = ['rapl', 'cpu', 'ddr5', 'cpufreq', 'battery'];
+const snapshotStreams = new Map(); // streamId -> { port, sender, groups }
+let snapshotStreamTimer = null;
+let snapshotSampling = null; // { id, groups } while the native sampler follows the stream
+let snapshotStreamBusy = false;
+
+function snapshotStreamGroups() {
+  return SNAPSHOT_STREAM_GROUPS.filter(group =>
+    [...snapshotStreams.values()].some(stream => stream.groups.includes(group)));
+}
+
+function snapshotStreamVisible() {
+  for (const { sender } of snapshotStreams.values()) {
+    const win = BrowserWindow.fromWebContents(sender);
+    if (win && !win.isMinimized() && win.isVisible()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// groups: what the sampler should follow, or [] to release it
+function setSnapshotSampling(groups) {
+  if (snapshotSampling && snapshotSampling.groups.join() === groups.join()) {
+    return;
+  }
+  if (snapshotSampling) {
+    hybridMonitor.unsubscribe(snapshotSampling.id);
+    snapshotSampling = null;
+  }
+  if (groups.length > 0) {
+    const id = hybridMonitor.subscribe(groups, 1000 / SNAPSHOT_STREAM_INTERVAL_MS);
+    if (id !== null) {
+      snapshotSampling = { id, groups };
+    }
+  }
+}
+
+async function tickSnapshotStreams() {
+  // Nobody is looking at a minimized or hidden window; stop sampling for it
+  const visible = snapshotStreamVisible();
+  const groups = snapshotStreamGroups();
+  setSnapshotSampling(visible ? groups : []);
+  // A slow tick is skipped rather than queued behind
+  if (!visible || snapshotStreamBusy || groups.length === 0) {
+    return;
+  }
+  snapshotStreamBusy = true;
+  try {
+    const frames = await hybridMonitor.nextSnapshotFrames(groups);
+    const timestamp = Date.now();
+    for (const [streamId, stream] of snapshotStreams) {
+      const frame = frames ? frames[streamId] : null;
+      // Unchanged ticks are not posted at all
+      if (frame && (frame.full || frame.values.length > 0)) {
+        frame.timestamp = timestamp;
+        stream.port.postMessage(frame);
+      }
+    }
+  } finally {
+    snapshotStreamBusy = false;
+  }
+}
+
+ipcMain.on('subscribe-snapshots', (event, groups) => {
+  const streamId = hybridMonitor ? hybridMonitor.openSnapshotStream() : null;
+  if (streamId === null) {
+    return;
+  }
+  const { port1, port2 } = new MessageChannelMain();
+  snapshotStreams.set(streamId, {
+    port: port1,
+    sender: event.sender,
+    groups: Array.isArray(groups) ? SNAPSHOT_STREAM_GROUPS.filter(group => groups.includes(group)) : SNAPSHOT_STREAM_GROUPS
+  });
+  if (snapshotStreamTimer === null) {
+    snapshotStreamTimer = setInterval(tickSnapshotStreams, SNAPSHOT_STREAM_INTERVAL_MS);
+  }
+  const close = () => {
+    if (!snapshotStreams.delete(streamId)) {
+      return;
+    }
+    hybridMonitor.closeSnapshotStream(streamId);
+    port1.close();
+    if (snapshotStreams.size === 0) {
+      clearInterval(snapshotStreamTimer);
+      snapshotStreamTimer = null;
+      setSnapshotSampling([]);
+    }
+  };
+  port1.on('close', close);
+  event.sender.once('destroyed', close);
+  event.sender.once('did-start-navigation', close);
+  port1.start();
+  event.sender.postMessage('snapshot-port', null, [port2]);
+});
+
+// While the native sampler follows a streamed group, get-system-data does not
+// sweep that group's sensors again: it keeps the last sensor list, refreshed
+// every STREAMED_LAYOUT_REFRESH_MS, and fills in values from one snapshot of
+// the sampler's latest readings
+const STREAMED_LAYOUT_REFRESH_MS = 10000;
+const streamedLayouts = {}; // group -> { value, time }
+
+async function readUnlessStreamed(group, read) {
+  const now = Date.now();
+  const cached = streamedLayouts[group];
+  if (snapshotSampling && snapshotSampling.groups.includes(group) && cached &&
+      now - cached.time < STREAMED_LAYOUT_REFRESH_MS) {
+    return cached.value;
+  }
+  const value = await read();
+  streamedLayouts[group] = { value, time: now };
+  return value;
+}
+
+function applyStreamedValues(target) {
+  const snapshot = snapshotSampling ? hybridMonitor.getSnapshot(snapshotSampling.groups) : null;
+  if (snapshot) {
+    patchSnapshotValues(target, snapshot.schema.fields, snapshot.values, 1);
+  }
+}
+
 // IPC Handler for system data with tiered caching
 ipcMain.handle('get-system-data', async () => {
   // Add initialization delay for first few calls to allow GPU detection to stabilize
@@ -1298,25 +1479,18 @@ ipcMain.handle('get-system-data', async () => {
     // Update medium-speed data cache if needed (every 1s)
     if (needsMediumUpdate) {
       try {
-        const [battery, fans, power, diskTemps, cpuTemps, systemTemps, ddr5Temps, nativeBat] = await Promise.all([
+        const [battery, fans, power, diskTemps, systemTemps] = await Promise.all([
           si.battery(),
           getFanSpeeds(),
           getPowerConsumption(),
           getDiskTemperatures(),
-          hybridMonitor.getCPUTemperatures(),
-          getSystemTemperatures(),
-          hybridMonitor.getDDR5MemoryTemps(),
-          hybridMonitor.getBatterySensors()
+          getSystemTemperatures()
         ]);
         mediumDataCache.battery = battery;
-        mediumDataCache.nativeBat = nativeBat;
         mediumDataCache.fans = fans;
         mediumDataCache.power = power;
-        // RAPL power now handled in fast cache (10Hz)
         mediumDataCache.diskTemps = diskTemps;
-        mediumDataCache.cpuTemps = cpuTemps;
         mediumDataCache.systemTemps = systemTemps;
-        mediumDataCache.ddr5Temps = ddr5Temps;
         mediumDataCache.lastUpdate = now;
       } catch (error) {
         console.error('Error updating medium data cache:', error);
@@ -1324,8 +1498,10 @@ ipcMain.handle('get-system-data', async () => {
       }
     }
     
-    // Fetch fast-updating data (every 100ms) - only the essentials
+    // Fetch fast-updating data (every 100ms) - only the essentials, plus the
+    // native sensor groups, whose cadence the native scheduler sets
     let cpuLoad, cpuTemp, cpuFreqs, mem, diskIO, perDiskIO, gpuData, networkStats, diskSmart, raplPower;
+    let cpuTemps, ddr5Temps, nativeBat;
     
     try {
       [
@@ -1337,17 +1513,23 @@ ipcMain.handle('get-system-data', async () => {
         perDiskIO,
         gpuData,
         networkStats,
-        raplPower
+        raplPower,
+        cpuTemps,
+        ddr5Temps,
+        nativeBat
       ] = await Promise.all([
-        si.currentLoad(),
+        hybridMonitor.getCPULoad(),
         si.cpuTemperature(),
-        getCPUFrequencies(),
+        readUnlessStreamed('cpufreq', getCPUFrequencies),
         si.mem(),
-        si.disksIO(),
-        getPerDiskIORates(),
+        hybridMonitor.getDisksIO(),
+        hybridMonitor.getPerDiskIORates() || getPerDiskIORates(),
         getGPUData(),
-        si.networkStats(),
-        hybridMonitor.getIntelRAPLPower() // Move RAPL to 10Hz fast updates
+        hybridMonitor.getNetworkStats(),
+        readUnlessStreamed('rapl', () => hybridMonitor.getIntelRAPLPower()),
+        readUnlessStreamed('cpu', () => hybridMonitor.getCPUTemperatures()),
+        readUnlessStreamed('ddr5', () => hybridMonitor.getDDR5MemoryTemps()),
+        readUnlessStreamed('battery', () => hybridMonitor.getBatterySensors())
       ]);
     
       // Get SMART data (cached for 60s)
@@ -1362,14 +1544,11 @@ ipcMain.handle('get-system-data', async () => {
     const osInfo = staticDataCache.osInfo || await si.osInfo();
     const diskLayout = staticDataCache.diskLayout || await si.diskLayout();
     const battery = mediumDataCache.battery || await si.battery();
-    const nativeBat = mediumDataCache.nativeBat || await hybridMonitor.getBatterySensors();
     const fans = mediumDataCache.fans || [];
     const power = mediumDataCache.power || [];
-    // RAPL power now comes from fast cache (10Hz updates)
     const diskTemps = mediumDataCache.diskTemps || [];
-    const cpuTemps = mediumDataCache.cpuTemps || [];
     const systemTemps = mediumDataCache.systemTemps || [];
-    const ddr5Temps = mediumDataCache.ddr5Temps || [];
+    applyStreamedValues({ cpuTemps, ddr5Temps, cpuFreqs, raplPower, battery: nativeBat });
 
     // Calculate per-core usage
     const coreLoads = cpuLoad.cpus || [];
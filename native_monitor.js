@@ -79,6 +79,13 @@ class NativeSystemMonitor {
         return this.initialized;
     }
 
+    rescan() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.rescan();
+    }
+
     getCPUCores() {
         if (!this.initialized) {
             throw new Error('Native system monitor not initialized');
@@ -100,6 +107,14 @@ class NativeSystemMonitor {
         return systemMonitor.getDDR5Temperatures();
     }
 
+    // { currentLoad, currentLoadUser, ..., cpus: [{ cpu, load, loadUser, ... }] }, like si.currentLoad()
+    getCPULoad() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getCPULoad();
+    }
+
     getRAPLPower() {
         if (!this.initialized) {
             throw new Error('Native system monitor not initialized');
@@ -121,6 +136,213 @@ class NativeSystemMonitor {
         return systemMonitor.getBatteryCalculated();
     }
 
+    // Per-CPU perf counters (ipc, cacheMissRate, branchMissRate, effectiveFrequency in getCPUCores());
+    // needs CAP_PERFMON or perf_event_paranoid <= 0, returns the number of CPUs covered
+    enableHardwareCounters(enable = true) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.enableHardwareCounters(enable);
+    }
+
+    // Same domains as getRAPLPowerCalculated(), with subzones nested under `children`
+    getRAPLPowerTree() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getRAPLPowerTree();
+    }
+
+    // Smoothing horizons (seconds) for the per-domain ewma/boxcar RAPL power
+    setPowerWindows(seconds) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.setPowerWindows(seconds);
+    }
+
+    getPowerWindows() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getPowerWindows();
+    }
+
+    getCPUCoresAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getCPUCoresAsync();
+    }
+
+    getCPULoadAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getCPULoadAsync();
+    }
+
+    getGPUData() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getGPUData();
+    }
+
+    getGPUDataAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getGPUDataAsync();
+    }
+
+    getGPUBackend() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getGPUBackend();
+    }
+
+    // { device: health } from NVMe / ATA SMART ioctls; maxAgeMs defaults to 60 s
+    getDiskHealth(maxAgeMs) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getDiskHealth(maxAgeMs);
+    }
+
+    getDiskHealthAsync(maxAgeMs) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getDiskHealthAsync(maxAgeMs);
+    }
+
+    // sortKey: 'cpu', 'rss' or 'io'; each call advances the incremental /proc sweep
+    getTopProcesses(sortKey, count) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getTopProcesses(sortKey, count);
+    }
+
+    getTopProcessesAsync(sortKey, count) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getTopProcessesAsync(sortKey, count);
+    }
+
+    getEnergyByProcess(topN) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getEnergyByProcess(topN);
+    }
+
+    getEnergyByProcessAsync(topN) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getEnergyByProcessAsync(topN);
+    }
+
+    getEnergyByCgroup(topN) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getEnergyByCgroup(topN);
+    }
+
+    getEnergyByCgroupAsync(topN) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getEnergyByCgroupAsync(topN);
+    }
+
+    getTemperatureSensorsAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getTemperatureSensorsAsync();
+    }
+
+    getDDR5TemperaturesAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getDDR5TemperaturesAsync();
+    }
+
+    getRAPLPowerAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getRAPLPowerAsync();
+    }
+
+    getRAPLPowerCalculatedAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getRAPLPowerCalculatedAsync();
+    }
+
+    getBatteryCalculatedAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getBatteryCalculatedAsync();
+    }
+
+    // Samples cores, temperatures, DDR5, RAPL and battery in one native call
+    sampleAllAsync() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.sampleAllAsync();
+    }
+
+    getSchema() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getSchema();
+    }
+
+    // Returns Float64Array [schemaVersion, ...values]; pass the previous array to reuse it.
+    // groups limits the read to those sensor groups; the rest are NaN
+    snapshot(target, groups) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.snapshot(target, groups);
+    }
+
+    // Disk/network rate layout: { version, diskFields, netFields, disks, diskStacked, interfaces }
+    getIODevices() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getIODevices();
+    }
+
+    // Float64Array [version, disk rows..., interface rows...]; pass the last one back to reuse it
+    readIORates(target) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.readIORates(target);
+    }
+
+    registerMetric(key) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.registerMetric(key);
+    }
+
     updateStats(key, value) {
         if (!this.initialized) {
             throw new Error('Native system monitor not initialized');
@@ -128,6 +350,14 @@ class NativeSystemMonitor {
         return systemMonitor.updateStats(key, value);
     }
 
+    // ids: Int32Array of registerMetric() ids, values: Float64Array, count: entries to apply
+    updateStatsBatch(ids, values, count) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.updateStatsBatch(ids, values, count);
+    }
+
     getStats() {
         if (!this.initialized) {
             throw new Error('Native system monitor not initialized');
@@ -135,6 +365,74 @@ class NativeSystemMonitor {
         return systemMonitor.getStats();
     }
 
+    // mmap'd history of the stats keys in metrics (every key when omitted);
+    // maxMetrics defaults to 512, and 0 sizes the file to the list
+    openHistory(historyPath, maxMetrics, metrics) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.openHistory(historyPath, maxMetrics, metrics);
+    }
+
+    // Keys refused a history slot because the file was full, each returned once
+    takeHistoryRefused() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.takeHistoryRefused();
+    }
+
+    closeHistory() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.closeHistory();
+    }
+
+    // [{ id, bucketMs, timestamps, min, max, avg }] with at most maxPoints points per metric
+    queryRange(metricIds, t0, t1, maxPoints) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.queryRange(metricIds, t0, t1, maxPoints);
+    }
+
+    // Float64Array of [min, max, avg, current, count] columns, each getMetricNames().length long
+    getStatsColumns(target) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getStatsColumns(target);
+    }
+
+    getMetricNames() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getMetricNames();
+    }
+
+    getQuantiles(key, quantiles) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getQuantiles(key, quantiles);
+    }
+
+    getQuantileSketch(key) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getQuantileSketch(key);
+    }
+
+    mergeQuantileSketch(key, sketch) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.mergeQuantileSketch(key, sketch);
+    }
+
     resetStats() {
         if (!this.initialized) {
             throw new Error('Native system monitor not initialized');
@@ -155,6 +453,190 @@ class NativeSystemMonitor {
         }
         return systemMonitor.getLastValidValue(key);
     }
+
+    startSampler(raplHz, sensorHz) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.startSampler(raplHz, sensorHz);
+    }
+
+    stopSampler() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.stopSampler();
+    }
+
+    // groups: any of 'rapl', 'cpu', 'ddr5', 'cpufreq', 'battery'; returns an id for unsubscribe()
+    subscribe(groups, rateHz) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.subscribe(groups, rateHz);
+    }
+
+    unsubscribe(id) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.unsubscribe(id);
+    }
+
+    getSamplingRates() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getSamplingRates();
+    }
+
+    getSamplerStatus() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getSamplerStatus();
+    }
+
+    getSamplerChannels() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getSamplerChannels();
+    }
+
+    // { generation, rates }: each channel's current adaptive read rate in Hz
+    getSamplerCadence() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.getSamplerCadence();
+    }
+
+    readSamples(sinceSeq, maxRecords) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.readSamples(sinceSeq, maxRecords);
+    }
+
+    // Mirror the sampler into POSIX shared memory ("/name") for other processes
+    openSharedSnapshot(name) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.openSharedSnapshot(name);
+    }
+
+    closeSharedSnapshot() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.closeSharedSnapshot();
+    }
+
+    // OpenMetrics exporter on http://address:port/metrics; returns the bound port
+    startMetricsServer(port, address) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.startMetricsServer(port, address);
+    }
+
+    stopMetricsServer() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.stopMetricsServer();
+    }
+
+    // Delta-encoded snapshot frames, one stream per subscriber (see src/delta_frame.h)
+    openSnapshotStream() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.openSnapshotStream();
+    }
+
+    // { version, full, count, bitmap, values }: values holds the fields whose bitmap bit is set
+    nextSnapshotFrame(streamId, reset) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.nextSnapshotFrame(streamId, !!reset);
+    }
+
+    // Promise of { [streamId]: frame } for every open stream, from one snapshot taken off the JS thread
+    nextSnapshotFramesAsync(groups) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.nextSnapshotFramesAsync(groups);
+    }
+
+    closeSnapshotStream(streamId) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.closeSnapshotStream(streamId);
+    }
+
+    // Columnar session log writer; options: { chunkRows, compress }
+    openSessionLog(logPath, columns, options) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.openSessionLog(logPath, columns, options || {});
+    }
+
+    // Returns true when the row completed a chunk and it was written out
+    appendSessionLog(timestampMs, values) {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.appendSessionLog(timestampMs, values);
+    }
+
+    closeSessionLog() {
+        if (!this.initialized) {
+            throw new Error('Native system monitor not initialized');
+        }
+        return systemMonitor.closeSessionLog();
+    }
+
+    // Session log readers only touch the file and need no initialized monitor
+    static getSessionLogInfo(logPath) {
+        return systemMonitor.getSessionLogInfo(logPath);
+    }
+
+    static readSessionLog(logPath, t0, t1) {
+        return systemMonitor.readSessionLog(logPath, t0, t1);
+    }
+
+    static exportSessionLogCSV(logPath, csvPath) {
+        return systemMonitor.exportSessionLogCSV(logPath, csvPath);
+    }
+
+    // Shared snapshot readers map another process's segment read-only and
+    // need no initialized monitor; they return null until it has data
+    static readSharedSnapshot(name, target) {
+        return systemMonitor.readSharedSnapshot(name, target);
+    }
+
+    static getSharedSnapshotSchema(name) {
+        return systemMonitor.getSharedSnapshotSchema(name);
+    }
+
+    static getSharedSamplerChannels(name) {
+        return systemMonitor.getSharedSamplerChannels(name);
+    }
+
+    static readSharedSamples(name, sinceSeq, maxRecords) {
+        return systemMonitor.readSharedSamples(name, sinceSeq, maxRecords);
+    }
+
+    static getSharedSnapshotInfo(name) {
+        return systemMonitor.getSharedSnapshotInfo(name);
+    }
 }
 
 module.exports = NativeSystemMonitor;
@@ -3,6 +3,17 @@ const { contextBridge, ipcRenderer } = require('electron');
 // Expose protected methods that allow the renderer process to use
 // the ipcRenderer without exposing the entire object
 contextBridge.exposeInMainWorld('electron', {
-  getSystemData: () => ipcRenderer.invoke('get-system-data')
+  getSystemData: () => ipcRenderer.invoke('get-system-data'),
+  queryHistory: (keys, t0, t1, maxPoints) => ipcRenderer.invoke('query-history', keys, t0, t1, maxPoints),
+  getTopProcesses: (sortKey, count) => ipcRenderer.invoke('get-top-processes', sortKey, count),
+  getEnergyByProcess: (topN, byCgroup) => ipcRenderer.invoke('get-energy-by-process', topN, byCgroup),
+  // The port arrives as a window 'message' event with data 'snapshot-port'
+  // groups: the sensor groups to stream ('rapl', 'cpu', 'ddr5', 'cpufreq', 'battery')
+  subscribeSnapshots: (groups) => ipcRenderer.send('subscribe-snapshots', groups)
+});
+
+// MessagePorts can't cross the context bridge, so hand them to the page with postMessage
+ipcRenderer.on('snapshot-port', (event) => {
+  window.postMessage('snapshot-port', '*', event.ports);
 });
 
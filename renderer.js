@@ -718,6 +718,72 @@ function updateSystemInfo(data) {
 let isUpdating = false;
 let firstUpdateComplete = false;
 
+// Push stream of native sensor values ('subscribe-snapshots' in main.js).
+// Frames patch the last full system data in place, so the fast sensors still
+// refresh at 10 Hz while getSystemData() drops to once a second.
+const FULL_UPDATE_INTERVAL_MS = 1000;
+const SNAPSHOT_GROUPS = ['rapl', 'cpu', 'ddr5', 'cpufreq', 'battery']; // Everything patchSystemData() reads
+let snapshotStreamActive = false;
+let snapshotSchema = null;
+let snapshotValues = null; // Mirror of the native snapshot, indexed like snapshotSchema.fields
+let lastSystemData = null;
+let lastFullUpdate = 0;
+let snapshotRenderPending = false;
+
+// Bit i of the bitmap marks field i as changed; values holds the changed fields in order
+function applySnapshotFrame(frame) {
+  if (frame.full) {
+    snapshotSchema = frame.schema;
+    snapshotValues = new Float64Array(frame.count);
+  }
+  if (!snapshotValues || snapshotValues.length !== frame.count) {
+    return false; // Joined mid-stream; wait for the next full frame
+  }
+  let next = 0;
+  for (let byte = 0; byte < frame.bitmap.length; byte++) {
+    let bits = frame.bitmap[byte];
+    while (bits) {
+      const bit = 31 - Math.clz32(bits & -bits);
+      snapshotValues[byte * 8 + bit] = frame.values[next++];
+      bits &= bits - 1;
+    }
+  }
+  return true;
+}
+
+// Writes the streamed values over the matching entries of the nested object
+// (patchSnapshotValues() comes from snapshot_patch.js, loaded before this file)
+function patchSystemData(data) {
+  patchSnapshotValues({
+    cpuTemps: data.cpu.temperature && data.cpu.temperature.sensors,
+    ddr5Temps: data.memory.ddr5Temps,
+    cpuFreqs: data.cpu.frequencies,
+    raplPower: data.raplPower,
+    battery: data.battery.hasBattery ? data.battery : null
+  }, snapshotSchema.fields, snapshotValues);
+}
+
+function onSnapshotFrame(frame) {
+  if (!applySnapshotFrame(frame) || !lastSystemData) {
+    return;
+  }
+  patchSystemData(lastSystemData);
+  // Frames can outpace the display; render at most once per animation frame
+  if (!snapshotRenderPending) {
+    snapshotRenderPending = true;
+    requestAnimationFrame(() => {
+      snapshotRenderPending = false;
+      try {
+        updateCPU(lastSystemData);
+        updateMemory(lastSystemData);
+        updateBattery(lastSystemData);
+      } catch (updateError) {
+        console.error('❌ Error applying snapshot frame:', updateError);
+      }
+    });
+  }
+}
+
 // Update all system data
 async function updateSystemData() {
   if (isUpdating) {
@@ -727,6 +793,8 @@ async function updateSystemData() {
   isUpdating = true;
   try {
     const data = await window.electron.getSystemData();
+    lastSystemData = data;
+    lastFullUpdate = Date.now();
     
     // Hide loading overlay after first successful update
     if (!firstUpdateComplete) {
@@ -806,6 +874,17 @@ document.addEventListener('DOMContentLoaded', () => {
     loadingStatus.textContent = 'Loading system data...';
   }
   
+  // Subscribe once; the port arrives through preload.js as a window message
+  window.addEventListener('message', (event) => {
+    if (event.source === window && event.data === 'snapshot-port' && event.ports.length > 0) {
+      event.ports[0].onmessage = (message) => onSnapshotFrame(message.data);
+      snapshotStreamActive = true;
+    }
+  });
+  if (window.electron.subscribeSnapshots) {
+    window.electron.subscribeSnapshots(SNAPSHOT_GROUPS);
+  }
+  
   // Initial update
   updateSystemData().catch(err => {
     console.error('Error on initial data load:', err);
@@ -816,6 +895,14 @@ document.addEventListener('DOMContentLoaded', () => {
   
   // Update every 100ms for 10 Hz refresh rate (high-performance monitoring)
   setInterval(() => {
+    // Nothing is drawn while the page is hidden, so don't make main collect
+    if (document.hidden) {
+      return;
+    }
+    // With the stream attached the nested object is only needed once a second
+    if (snapshotStreamActive && Date.now() - lastFullUpdate < FULL_UPDATE_INTERVAL_MS) {
+      return;
+    }
     updateSystemData();
     updateCount++;
     
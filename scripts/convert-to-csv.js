@@ -0,0 +1,21 @@
+#!/usr/bin/env node
+// Convert a binary session log (.smlog) written by logger.js to CSV.
+// Usage: node scripts/convert-to-csv.js <session.smlog> [output.csv]
+const path = require('path');
+const NativeSystemMonitor = require('../native_monitor');
+
+const input = process.argv[2];
+if (!input) {
+  console.error('Usage: node scripts/convert-to-csv.js <session.smlog> [output.csv]');
+  process.exit(1);
+}
+const output = process.argv[3] || path.join(path.dirname(input), path.basename(input, '.smlog') + '.csv');
+
+try {
+  const info = NativeSystemMonitor.getSessionLogInfo(input);
+  NativeSystemMonitor.exportSessionLogCSV(input, output);
+  console.log(`Wrote ${info.rows} rows x ${info.columns.length} columns (${info.chunks.length} chunks) to ${output}`);
+} catch (e) {
+  console.error(`Failed to convert ${input}: ${e.message}`);
+  process.exit(1);
+}
@@ -0,0 +1,48 @@
+// Writes native snapshot values over the sensor lists getSystemData() builds.
+// Shared by main.js (require) and renderer.js (a plain <script> ahead of it),
+// so both sides match fields to sensors the same way.
+//
+// target: { cpuTemps, ddr5Temps, cpuFreqs, raplPower, battery }, any of which
+// may be missing. values[offset + i] is the value of fields[i]. Sensors are
+// matched by label, so a layout built by the JS fallback is left alone.
+function patchSnapshotValues(target, fields, values, offset = 0) {
+  const cpuTemps = target.cpuTemps || [];
+  const ddr5Temps = target.ddr5Temps || [];
+  const cpuFreqs = target.cpuFreqs || [];
+  let cpuIndex = 0;
+  let ddr5Index = 0;
+  for (let i = 0; i < fields.length; i++) {
+    const field = fields[i];
+    const value = values[offset + i];
+    if (field.group === 'cpu') {
+      const sensor = cpuTemps[cpuIndex++];
+      if (sensor && sensor.type === field.label && !Number.isNaN(value)) sensor.temp = value;
+    } else if (field.group === 'ddr5') {
+      const sensor = ddr5Temps[ddr5Index++];
+      if (sensor && sensor.label === field.label && !Number.isNaN(value)) sensor.temp = value;
+    } else if (Number.isNaN(value)) {
+      continue;
+    } else if (field.group === 'cpufreq') {
+      const cpu = parseInt(field.name.slice(3), 10);
+      if (cpu < cpuFreqs.length) cpuFreqs[cpu] = value;
+    } else if (field.group === 'rapl') {
+      const domain = target.raplPower && target.raplPower[field.name];
+      if (!domain) continue;
+      if (field.label === 'power') domain.power = value;
+      if (field.label === 'totalWh') {
+        domain.totalWh = value;
+        domain.totalKWh = value / 1000;
+      }
+    } else if (field.group === 'battery' && target.battery) {
+      if (field.label === 'acConnected') target.battery.acConnected = value === 1;
+      if (field.label === 'voltage' || field.label === 'current' || field.label === 'powerWatts' ||
+          field.label === 'estimatedHours') {
+        target.battery[field.label] = value;
+      }
+    }
+  }
+}
+
+if (typeof module !== 'undefined' && module.exports) {
+  module.exports = { patchSnapshotValues };
+}
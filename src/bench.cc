@@ -0,0 +1,487 @@
+// system-monitor-bench: per-call cost of the SystemMonitor read paths.
+//
+// For each topology (CPUs x hwmon chips x RAPL packages) this writes a
+// synthetic /sys and /proc under a temporary directory, points a
+// SystemMonitor at it through its root argument and times every public read
+// path. Reported per call:
+//
+//   ns        wall time, averaged over a batch that ran for at least --min-time
+//   syscalls  from the raw_syscalls:sys_enter tracepoint when perf allows it,
+//             otherwise read+write syscalls from /proc/self/io (marked "rw")
+//   bytes     requested from operator new (malloc calls made by libc itself,
+//             e.g. inside opendir(), are not seen)
+//   allocs    operator new calls
+//
+// The fake files are regular files, so absolute ns are lower than on real
+// sysfs (no driver callbacks), but syscall and allocation counts carry over.
+#include "system_monitor.h"
+#include <fcntl.h>
+#include <ftw.h>
+#include <linux/perf_event.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <sstream>
+
+// Counting replacements for the global allocator; the benchmarks run on one thread
+static uint64_t g_alloc_count = 0;
+static uint64_t g_alloc_bytes = 0;
+
+void* operator new(size_t size) {
+    g_alloc_count++;
+    g_alloc_bytes += size;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// Out of line, or GCC pairs the inlined free() with the builtin operator new and warns
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+struct BenchOptions {
+    std::vector<int> cpus;
+    std::vector<int> hwmon;
+    std::vector<int> rapl;
+    int temps_per_chip;
+    double min_time;
+    std::string filter;
+    std::string root;   // Existing tree; skips generation
+    bool keep;
+};
+
+struct Topology {
+    int cpus;
+    int hwmon;
+    int rapl;
+    int temps_per_chip;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --cpus LIST         CPU counts to generate (default 1,64,512)\n"
+            "  --hwmon LIST        hwmon chip counts (default 1,64)\n"
+            "  --rapl LIST         RAPL packages, each with core and dram subzones (default 1,16)\n"
+            "  --temps N           Temperature inputs per chip (default 8)\n"
+            "  --min-time SEC      Minimum measured time per benchmark (default 0.1)\n"
+            "  --filter TEXT       Only run benchmarks whose name contains TEXT\n"
+            "  --root DIR          Benchmark an existing tree instead (\"\" or / for this machine)\n"
+            "  --keep              Leave the generated trees in place\n",
+            argv0);
+}
+
+static bool parseList(const char* text, std::vector<int>& out) {
+    out.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int value = std::atoi(item.c_str());
+        if (value <= 0) {
+            return false;
+        }
+        out.push_back(value);
+    }
+    return !out.empty();
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    options.cpus = { 1, 64, 512 };
+    options.hwmon = { 1, 64 };
+    options.rapl = { 1, 16 };
+    options.temps_per_chip = 8;
+    options.min_time = 0.1;
+    options.keep = false;
+    
+    bool hasRoot = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--cpus" && hasValue) {
+            if (!parseList(argv[++i], options.cpus)) return false;
+        } else if (arg == "--hwmon" && hasValue) {
+            if (!parseList(argv[++i], options.hwmon)) return false;
+        } else if (arg == "--rapl" && hasValue) {
+            if (!parseList(argv[++i], options.rapl)) return false;
+        } else if (arg == "--temps" && hasValue) {
+            options.temps_per_chip = std::atoi(argv[++i]);
+        } else if (arg == "--min-time" && hasValue) {
+            options.min_time = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--root" && hasValue) {
+            options.root = argv[++i];
+            if (options.root == "/") {
+                options.root.clear();
+            }
+            hasRoot = true;
+        } else if (arg == "--keep") {
+            options.keep = true;
+        } else {
+            return false;
+        }
+    }
+    if (hasRoot) {
+        // One run against the given tree; the lists only describe generated ones
+        options.cpus = { 0 };
+        options.hwmon = { 0 };
+        options.rapl = { 0 };
+    }
+    return options.min_time > 0.0 && options.temps_per_chip > 0;
+}
+
+// --- Synthetic tree -------------------------------------------------------
+
+static bool makeDirs(const std::string& path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+static bool writeFile(const std::string& path, const std::string& content) {
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && !makeDirs(path.substr(0, slash))) {
+        return false;
+    }
+    FILE* f = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+    return fclose(f) == 0 && ok;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+static bool buildTree(const std::string& root, const Topology& topo) {
+    bool ok = true;
+    
+    // cpufreq, topology and /proc/stat, one package per 64 CPUs
+    std::string procStat = "cpu  1000 20 300 40000 50 0 6 0 0 0\n";
+    for (int cpu = 0; cpu < topo.cpus; cpu++) {
+        std::string dir = root + "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        ok = ok && writeFile(dir + "/cpufreq/scaling_cur_freq", std::to_string(2400000 + cpu) + "\n");
+        ok = ok && writeFile(dir + "/cpufreq/base_frequency", "2400000\n");
+        ok = ok && writeFile(dir + "/topology/physical_package_id", std::to_string(cpu / 64) + "\n");
+        procStat += "cpu" + std::to_string(cpu) + " 100 2 30 4000 5 0 1 0 0 0\n";
+    }
+    procStat += "intr 0\nctxt 0\nbtime 0\nprocesses 1\nprocs_running 1\nprocs_blocked 0\n";
+    ok = ok && writeFile(root + "/proc/stat", procStat);
+    
+    // Every fourth chip is a DDR5 SPD hub, the rest CPU sensors
+    for (int chip = 0; chip < topo.hwmon; chip++) {
+        std::string dir = root + "/sys/class/hwmon/hwmon" + std::to_string(chip);
+        bool ddr5 = chip % 4 == 3;
+        ok = ok && writeFile(dir + "/name", ddr5 ? "spd5118\n" : "coretemp\n");
+        for (int t = 1; t <= topo.temps_per_chip; t++) {
+            std::string prefix = dir + "/temp" + std::to_string(t);
+            ok = ok && writeFile(prefix + "_input", std::to_string(40000 + t * 500) + "\n");
+            if (!ddr5) {
+                ok = ok && writeFile(prefix + "_label", t == 1 ? "Package id " + std::to_string(chip) + "\n"
+                                                             : "Core " + std::to_string(t - 2) + "\n");
+            }
+            ok = ok && writeFile(prefix + "_max", "100000\n");
+        }
+    }
+    
+    for (int pkg = 0; pkg < topo.rapl; pkg++) {
+        std::string zone = root + "/sys/class/powercap/intel-rapl:" + std::to_string(pkg);
+        const char* subzones[] = { nullptr, "core", "dram" };
+        for (int sub = 0; sub < 3; sub++) {
+            std::string dir = sub == 0 ? zone : zone + ":" + std::to_string(sub - 1);
+            ok = ok && writeFile(dir + "/name", sub == 0 ? "package-" + std::to_string(pkg) + "\n"
+                                                         : std::string(subzones[sub]) + "\n");
+            ok = ok && writeFile(dir + "/energy_uj", std::to_string(123456789 + pkg) + "\n");
+            ok = ok && writeFile(dir + "/max_energy_range_uj", "262143328850\n");
+        }
+    }
+    ok = ok && makeDirs(root + "/sys/class/powercap/intel-rapl");
+    
+    std::string bat = root + "/sys/class/power_supply/BAT0";
+    ok = ok && writeFile(bat + "/status", "Discharging\n");
+    ok = ok && writeFile(bat + "/voltage_now", "12100000\n");
+    ok = ok && writeFile(bat + "/current_now", "1200000\n");
+    ok = ok && writeFile(bat + "/power_now", "14520000\n");
+    ok = ok && writeFile(bat + "/energy_now", "41000000\n");
+    ok = ok && writeFile(bat + "/energy_full", "57000000\n");
+    ok = ok && writeFile(root + "/sys/class/power_supply/AC/online", "0\n");
+    
+    // Two disks and two interfaces for the I/O rate parser
+    ok = ok && writeFile(root + "/proc/diskstats",
+                         "   8       0 sda 1000 0 8000 100 2000 0 16000 200 0 300 300 0 0 0 0 0 0\n"
+                         " 259       0 nvme0n1 5000 0 40000 500 6000 0 48000 600 0 900 900 0 0 0 0 0 0\n");
+    ok = ok && makeDirs(root + "/sys/block/sda") && makeDirs(root + "/sys/block/nvme0n1");
+    ok = ok && writeFile(root + "/proc/net/dev",
+                         "Inter-|   Receive                                                |  Transmit\n"
+                         " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+                         "    lo: 1000 10 0 0 0 0 0 0 1000 10 0 0 0 0 0 0\n"
+                         "  eth0: 900000 700 0 0 0 0 0 0 80000 600 0 0 0 0 0 0\n");
+    ok = ok && writeFile(root + "/sys/class/net/eth0/operstate", "up\n");
+    return ok;
+}
+
+// --- Counters -------------------------------------------------------------
+
+class SyscallCounter {
+public:
+    SyscallCounter() : fd_(-1), io_fd_(-1) {
+        const char* idPaths[] = {
+            "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+            "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+        };
+        for (const char* path : idPaths) {
+            FILE* f = fopen(path, "r");
+            unsigned long long id = 0;
+            if (f == nullptr) {
+                continue;
+            }
+            bool parsed = fscanf(f, "%llu", &id) == 1;
+            fclose(f);
+            if (!parsed) {
+                continue;
+            }
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_TRACEPOINT;
+            attr.size = sizeof(attr);
+            attr.config = id;
+            fd_ = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            if (fd_ >= 0) {
+                return;
+            }
+        }
+        io_fd_ = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+    }
+    
+    ~SyscallCounter() {
+        if (fd_ >= 0) close(fd_);
+        if (io_fd_ >= 0) close(io_fd_);
+    }
+    
+    bool available() const { return fd_ >= 0 || io_fd_ >= 0; }
+    bool exact() const { return fd_ >= 0; }
+    
+    uint64_t read() const {
+        if (fd_ >= 0) {
+            uint64_t count = 0;
+            return ::read(fd_, &count, sizeof(count)) == (ssize_t)sizeof(count) ? count : 0;
+        }
+        char buf[512];
+        ssize_t n = io_fd_ >= 0 ? pread(io_fd_, buf, sizeof(buf) - 1, 0) : -1;
+        if (n <= 0) {
+            return 0;
+        }
+        buf[n] = '\0';
+        uint64_t total = 0;
+        const char* keys[] = { "syscr: ", "syscw: " };
+        for (const char* key : keys) {
+            const char* at = std::strstr(buf, key);
+            if (at != nullptr) {
+                total += std::strtoull(at + std::strlen(key), nullptr, 10);
+            }
+        }
+        return total;
+    }
+
+private:
+    int fd_;
+    int io_fd_;
+};
+
+struct Measurement {
+    uint64_t iterations;
+    double ns;
+    double syscalls;
+    double bytes;
+    double allocs;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Doubles the batch until one runs for min_time, then reports that batch;
+// the cost of reading the counters themselves is measured once and subtracted
+static Measurement measure(const std::function<void()>& fn, double minTime, const SyscallCounter& syscalls) {
+    fn(); // First call discovers sensors and opens handles
+    
+    uint64_t before = syscalls.read();
+    uint64_t overhead = syscalls.read() - before;
+    
+    Measurement m;
+    for (uint64_t n = 1; ; n *= 2) {
+        uint64_t allocs = g_alloc_count;
+        uint64_t bytes = g_alloc_bytes;
+        uint64_t sys = syscalls.read();
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; i++) {
+            fn();
+        }
+        double elapsed = secondsSince(start);
+        uint64_t sysDelta = syscalls.read() - sys;
+        if (elapsed >= minTime || n >= (1ULL << 40)) {
+            m.iterations = n;
+            m.ns = elapsed * 1e9 / (double)n;
+            m.syscalls = (double)(sysDelta > overhead ? sysDelta - overhead : 0) / (double)n;
+            m.bytes = (double)(g_alloc_bytes - bytes) / (double)n;
+            m.allocs = (double)(g_alloc_count - allocs) / (double)n;
+            return m;
+        }
+    }
+}
+
+// --- Benchmarks -----------------------------------------------------------
+
+struct Benchmark {
+    const char* name;
+    std::function<void(SystemMonitor&)> run;
+};
+
+// Outputs live outside the lambdas so the steady-state reuse is what's measured;
+// the ids are registered per monitor in runTopology()
+static std::vector<double> g_values;
+static std::vector<PowerData> g_power;
+static int g_stat_id = -1;
+static std::vector<int32_t> g_batch_ids;
+static std::vector<double> g_batch_values;
+
+static std::vector<Benchmark> benchmarks() {
+    return {
+        { "getCPUCores", [](SystemMonitor& m) { m.getCPUCores(); } },
+        { "getCPULoad", [](SystemMonitor& m) {
+            m.expireRateCaches();
+            m.getCPULoad();
+        } },
+        { "getTemperatureSensors", [](SystemMonitor& m) { m.getTemperatureSensors(); } },
+        { "getDDR5Temperatures", [](SystemMonitor& m) { m.getDDR5Temperatures(); } },
+        { "getRAPLPower", [](SystemMonitor& m) { m.getRAPLPower(); } },
+        { "getRAPLPowerCalculated", [](SystemMonitor& m) { m.getRAPLPowerCalculated(g_power); } },
+        { "getBatteryCalculated", [](SystemMonitor& m) {
+            std::string status, state;
+            bool ac = false;
+            double v, a, w, now, full, hours;
+            m.getBatteryCalculated(status, ac, v, a, w, now, full, hours, state);
+        } },
+        { "readIORates", [](SystemMonitor& m) {
+            m.expireRateCaches();
+            m.readIORates(g_values);
+        } },
+        { "snapshot", [](SystemMonitor& m) { m.snapshot(g_values); } },
+        { "updateStats(key)", [](SystemMonitor& m) { m.updateStats("cpu_temp", 42.5); } },
+        { "updateStats(id)", [](SystemMonitor& m) { m.updateStats(g_stat_id, 42.5); } },
+        { "updateStatsBatch(64)", [](SystemMonitor& m) {
+            m.updateStatsBatch(g_batch_ids.data(), g_batch_values.data(), g_batch_ids.size());
+        } },
+        { "rescan", [](SystemMonitor& m) { m.rescan(); } },
+    };
+}
+
+static void runTopology(const BenchOptions& options, const std::string& root, const std::string& title,
+                        const SyscallCounter& syscalls) {
+    SystemMonitor monitor(root);
+    monitor.initialize();
+    g_stat_id = monitor.registerMetric("cpu_temp");
+    g_batch_ids.clear();
+    g_batch_values.clear();
+    for (int i = 0; i < 64; i++) {
+        g_batch_ids.push_back(monitor.registerMetric("metric_" + std::to_string(i)));
+        g_batch_values.push_back(i * 0.5);
+    }
+    
+    uint64_t version = 0;
+    std::vector<SnapshotField> fields = monitor.getSnapshotSchema(version);
+    size_t temps = 0, rapl = 0;
+    for (const auto& field : fields) {
+        temps += field.group == "cpu" || field.group == "ddr5";
+        rapl += field.group == "rapl" && field.label == "power";
+    }
+    printf("\n%s: %zu temperature inputs, %zu RAPL domains, %zu snapshot fields\n",
+           title.c_str(), temps, rapl, fields.size());
+    printf("  %-24s %12s %12s %12s %10s\n", "benchmark", "ns/call",
+           syscalls.exact() ? "syscalls" : "rw syscalls", "bytes", "allocs");
+    
+    for (const Benchmark& bench : benchmarks()) {
+        if (!options.filter.empty() && std::strstr(bench.name, options.filter.c_str()) == nullptr) {
+            continue;
+        }
+        Measurement m = measure([&]() { bench.run(monitor); }, options.min_time, syscalls);
+        printf("  %-24s %12.0f %12.1f %12.0f %10.1f\n", bench.name, m.ns, m.syscalls, m.bytes, m.allocs);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    
+    SyscallCounter syscalls;
+    if (!syscalls.available()) {
+        fprintf(stderr, "system-monitor-bench: syscall counts unavailable\n");
+    } else if (!syscalls.exact()) {
+        fprintf(stderr, "system-monitor-bench: raw_syscalls tracepoint not permitted; "
+                        "counting read/write syscalls from /proc/self/io\n");
+    }
+    
+    if (options.cpus[0] == 0) {
+        runTopology(options, options.root, options.root.empty() ? std::string("this machine") : options.root,
+                    syscalls);
+        return 0;
+    }
+    
+    char pattern[] = "/tmp/system-monitor-bench-XXXXXX";
+    const char* base = mkdtemp(pattern);
+    if (base == nullptr) {
+        fprintf(stderr, "system-monitor-bench: mkdtemp: %s\n", std::strerror(errno));
+        return 1;
+    }
+    
+    int status = 0;
+    for (int cpus : options.cpus) {
+        for (int hwmon : options.hwmon) {
+            for (int rapl : options.rapl) {
+                Topology topo{ cpus, hwmon, rapl, options.temps_per_chip };
+                char title[96];
+                snprintf(title, sizeof(title), "%d CPUs, %d hwmon chips, %d RAPL packages", cpus, hwmon, rapl);
+                std::string root = std::string(base) + "/" + std::to_string(cpus) + "-" +
+                                   std::to_string(hwmon) + "-" + std::to_string(rapl);
+                if (!buildTree(root, topo)) {
+                    fprintf(stderr, "system-monitor-bench: cannot build %s: %s\n", root.c_str(), std::strerror(errno));
+                    status = 1;
+                    break;
+                }
+                runTopology(options, root, title, syscalls);
+            }
+        }
+    }
+    
+    if (options.keep) {
+        printf("\nTrees kept in %s\n", base);
+    } else {
+        nftw(base, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    return status;
+}
@@ -1,7 +1,15 @@
 #include <napi.h>
 #include "system_monitor.h"
+#include "metrics_server.h"
+#include "delta_frame.h"
+#include <algorithm>
 #include <limits>
+#include <map>
 #include <cmath>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
 
 using namespace Napi;
 
@@ -13,19 +21,63 @@ Value Initialize(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         g_monitor = new SystemMonitor();
+        g_monitor->initialize();
     }
     return Boolean::New(env, true);
 }
 
-// Get CPU cores data
-Value GetCPUCores(const CallbackInfo& info) {
+// Re-run sensor discovery (hwmon chips, RAPL domains, cpufreq policies)
+Value Rescan(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::vector<CoreData> cores = g_monitor->getCPUCores();
+    g_monitor->rescan();
+    return Boolean::New(env, true);
+}
+
+// Battery readings gathered off the JS thread for getBatteryCalculated(Async)
+struct BatteryReading {
+    bool ok;
+    std::string status;
+    bool ac_connected;
+    double voltage_v;
+    double current_a;
+    double power_w;
+    double energy_now_wh;
+    double energy_full_wh;
+    double estimated_hours;
+    std::string derived_state;
+};
+
+// Everything sampleAllAsync() collects in one threadpool hop
+struct SampleAllReading {
+    std::vector<CoreData> cores;
+    std::vector<SensorData> temperatures;
+    std::vector<SensorData> ddr5;
+    std::vector<PowerData> rapl;
+    BatteryReading battery;
+};
+
+static BatteryReading ReadBattery(SystemMonitor* monitor) {
+    BatteryReading reading;
+    reading.ac_connected = false;
+    reading.voltage_v = std::numeric_limits<double>::quiet_NaN();
+    reading.current_a = std::numeric_limits<double>::quiet_NaN();
+    reading.power_w = std::numeric_limits<double>::quiet_NaN();
+    reading.energy_now_wh = std::numeric_limits<double>::quiet_NaN();
+    reading.energy_full_wh = std::numeric_limits<double>::quiet_NaN();
+    reading.estimated_hours = std::numeric_limits<double>::quiet_NaN();
+    reading.ok = monitor->getBatteryCalculated(reading.status, reading.ac_connected, reading.voltage_v,
+                                               reading.current_a, reading.power_w, reading.energy_now_wh,
+                                               reading.energy_full_wh, reading.estimated_hours,
+                                               reading.derived_state);
+    return reading;
+}
+
+static Value CoresToArray(Env env, const std::vector<CoreData>& cores) {
     Array result = Array::New(env, cores.size());
     
     for (size_t i = 0; i < cores.size(); i++) {
@@ -33,67 +85,112 @@ Value GetCPUCores(const CallbackInfo& info) {
         core.Set("load", Number::New(env, cores[i].load));
         core.Set("frequency", Number::New(env, cores[i].frequency));
         core.Set("temperature", Number::New(env, cores[i].temperature));
+        core.Set("cpu", Number::New(env, cores[i].cpu));
+        core.Set("ipc", Number::New(env, cores[i].ipc));
+        core.Set("cacheMissRate", Number::New(env, cores[i].cache_miss_rate));
+        core.Set("branchMissRate", Number::New(env, cores[i].branch_miss_rate));
+        core.Set("effectiveFrequency", Number::New(env, cores[i].effective_frequency));
         result[i] = core;
     }
     
     return result;
 }
 
-// Get temperature sensors
-Value GetTemperatureSensors(const CallbackInfo& info) {
-    Env env = info.Env();
-    if (g_monitor == nullptr) {
-        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-    
-    std::vector<SensorData> sensors = g_monitor->getTemperatureSensors();
-    Array result = Array::New(env, sensors.size());
-    
-    for (size_t i = 0; i < sensors.size(); i++) {
-        Object sensor = Object::New(env);
-        sensor.Set("name", String::New(env, sensors[i].name));
-        sensor.Set("label", String::New(env, sensors[i].label));
-        sensor.Set("value", Number::New(env, sensors[i].value));
-        sensor.Set("type", String::New(env, sensors[i].type));
-        result[i] = sensor;
+// Same shape as systeminformation's currentLoad() so callers can switch over directly
+static Value CPULoadToObject(Env env, const std::vector<CPULoad>& loads) {
+    Object result = Object::New(env);
+    Array cpus = Array::New(env);
+    for (const auto& load : loads) {
+        Object entry = Object::New(env);
+        entry.Set("load", Number::New(env, load.load));
+        entry.Set("loadUser", Number::New(env, load.user));
+        entry.Set("loadSystem", Number::New(env, load.system));
+        entry.Set("loadIdle", Number::New(env, load.idle));
+        entry.Set("loadIowait", Number::New(env, load.iowait));
+        entry.Set("loadIrq", Number::New(env, load.irq));
+        entry.Set("loadSteal", Number::New(env, load.steal));
+        if (load.cpu < 0) {
+            result.Set("currentLoad", Number::New(env, load.load));
+            result.Set("currentLoadUser", Number::New(env, load.user));
+            result.Set("currentLoadSystem", Number::New(env, load.system));
+            result.Set("currentLoadIdle", Number::New(env, load.idle));
+            result.Set("currentLoadIowait", Number::New(env, load.iowait));
+            result.Set("currentLoadIrq", Number::New(env, load.irq));
+            result.Set("currentLoadSteal", Number::New(env, load.steal));
+        } else {
+            entry.Set("cpu", Number::New(env, load.cpu));
+            cpus[cpus.Length()] = entry;
+        }
     }
-    
+    result.Set("cpus", cpus);
     return result;
 }
 
-// Get DDR5 temperatures
-Value GetDDR5Temperatures(const CallbackInfo& info) {
-    Env env = info.Env();
-    if (g_monitor == nullptr) {
-        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+// NaN (not reported by the driver) becomes null, matching the nvidia-smi parser in main.js
+static Value NumberOrNull(Env env, double value) {
+    if (std::isnan(value)) {
         return env.Null();
     }
+    return Number::New(env, value);
+}
+
+static Value GPUsToArray(Env env, const std::vector<GPUData>& gpus) {
+    Array result = Array::New(env, gpus.size());
     
-    std::vector<SensorData> sensors = g_monitor->getDDR5Temperatures();
-    Array result = Array::New(env, sensors.size());
-    
-    for (size_t i = 0; i < sensors.size(); i++) {
-        Object sensor = Object::New(env);
-        sensor.Set("name", String::New(env, sensors[i].name));
-        sensor.Set("label", String::New(env, sensors[i].label));
-        sensor.Set("value", Number::New(env, sensors[i].value));
-        sensor.Set("type", String::New(env, sensors[i].type));
-        result[i] = sensor;
+    for (size_t i = 0; i < gpus.size(); i++) {
+        Object gpu = Object::New(env);
+        gpu.Set("index", Number::New(env, gpus[i].index));
+        gpu.Set("vendor", String::New(env, gpus[i].vendor));
+        gpu.Set("model", String::New(env, gpus[i].model));
+        gpu.Set("temperatureGpu", NumberOrNull(env, gpus[i].temperature));
+        gpu.Set("utilizationGpu", NumberOrNull(env, gpus[i].utilization_gpu));
+        gpu.Set("utilizationMemory", NumberOrNull(env, gpus[i].utilization_memory));
+        gpu.Set("vram", NumberOrNull(env, gpus[i].memory_total_mb));
+        gpu.Set("vramUsed", NumberOrNull(env, gpus[i].memory_used_mb));
+        gpu.Set("vramFree", NumberOrNull(env, gpus[i].memory_free_mb));
+        gpu.Set("powerDraw", NumberOrNull(env, gpus[i].power_draw_w));
+        gpu.Set("powerLimit", NumberOrNull(env, gpus[i].power_limit_w));
+        gpu.Set("clockCore", NumberOrNull(env, gpus[i].clock_core_mhz));
+        gpu.Set("clockMemory", NumberOrNull(env, gpus[i].clock_memory_mhz));
+        gpu.Set("fanSpeed", NumberOrNull(env, gpus[i].fan_speed));
+        result[i] = gpu;
     }
     
     return result;
 }
 
-// Get RAPL power data
-Value GetRAPLPower(const CallbackInfo& info) {
-    Env env = info.Env();
-    if (g_monitor == nullptr) {
-        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
-        return env.Null();
+// Keyed by device, same shape main.js built from smartctl output
+static Value DiskHealthToObject(Env env, const std::vector<DiskHealthData>& disks) {
+    Object result = Object::New(env);
+    
+    for (const auto& disk : disks) {
+        Object entry = Object::New(env);
+        entry.Set("device", String::New(env, disk.device));
+        entry.Set("transport", String::New(env, disk.transport));
+        entry.Set("ageMs", Number::New(env, disk.age_ms));
+        if (disk.error != 0) {
+            entry.Set("error", String::New(env, std::strerror(disk.error)));
+            result.Set(disk.device, entry);
+            continue;
+        }
+        entry.Set("healthy", Boolean::New(env, disk.healthy));
+        entry.Set("temperature", NumberOrNull(env, disk.temperature));
+        entry.Set("powerOnHours", NumberOrNull(env, disk.power_on_hours));
+        entry.Set("powerCycles", NumberOrNull(env, disk.power_cycles));
+        entry.Set("wearLevel", NumberOrNull(env, disk.wear_level));
+        entry.Set("reallocatedSectors", NumberOrNull(env, disk.reallocated_sectors));
+        entry.Set("pendingSectors", NumberOrNull(env, disk.pending_sectors));
+        entry.Set("mediaErrors", NumberOrNull(env, disk.media_errors));
+        entry.Set("unsafeShutdowns", NumberOrNull(env, disk.unsafe_shutdowns));
+        entry.Set("availableSpare", NumberOrNull(env, disk.available_spare));
+        entry.Set("criticalWarning", NumberOrNull(env, disk.critical_warning));
+        result.Set(disk.device, entry);
     }
     
-    std::vector<SensorData> sensors = g_monitor->getRAPLPower();
+    return result;
+}
+
+static Value SensorsToArray(Env env, const std::vector<SensorData>& sensors) {
     Array result = Array::New(env, sensors.size());
     
     for (size_t i = 0; i < sensors.size(); i++) {
@@ -108,20 +205,14 @@ Value GetRAPLPower(const CallbackInfo& info) {
     return result;
 }
 
-// Get RAPL power with calculations
-Value GetRAPLPowerCalculated(const CallbackInfo& info) {
-    Env env = info.Env();
-    if (g_monitor == nullptr) {
-        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-    
-    std::vector<PowerData> powerData = g_monitor->getRAPLPowerCalculated();
+static Value PowerDataToArray(Env env, const std::vector<PowerData>& powerData) {
     Array result = Array::New(env, powerData.size());
     
     for (size_t i = 0; i < powerData.size(); i++) {
         Object power = Object::New(env);
         power.Set("name", String::New(env, powerData[i].name));
+        power.Set("zone", String::New(env, powerData[i].zone));
+        power.Set("parent", String::New(env, powerData[i].parent));
         power.Set("power", Number::New(env, powerData[i].power));
         power.Set("energy", Number::New(env, powerData[i].energy));
         power.Set("totalWh", Number::New(env, powerData[i].total_wh));
@@ -135,183 +226,1895 @@ Value GetRAPLPowerCalculated(const CallbackInfo& info) {
         stats.Set("avg", Number::New(env, powerData[i].avg_power));
         
         power.Set("stats", stats);
+        
+        // Smoothed power, one entry per configured window (see getPowerWindows)
+        Array ewma = Array::New(env, powerData[i].ewma_power.size());
+        for (size_t w = 0; w < powerData[i].ewma_power.size(); w++) {
+            ewma[w] = Number::New(env, powerData[i].ewma_power[w]);
+        }
+        power.Set("ewma", ewma);
+        Array boxcar = Array::New(env, powerData[i].boxcar_power.size());
+        for (size_t w = 0; w < powerData[i].boxcar_power.size(); w++) {
+            boxcar[w] = Number::New(env, powerData[i].boxcar_power[w]);
+        }
+        power.Set("boxcar", boxcar);
         result[i] = power;
     }
     
     return result;
 }
 
-// Get Battery calculated sensors
-Value GetBatteryCalculated(const CallbackInfo& info) {
+// Nest subzones under their parent domain: [{ name: 'package-0', ..., children: [...] }]
+static Value PowerDataToTree(Env env, const std::vector<PowerData>& powerData) {
+    Array flat = PowerDataToArray(env, powerData).As<Array>();
+    std::map<std::string, Array> children;
+    Array roots = Array::New(env);
+    for (size_t i = 0; i < powerData.size(); i++) {
+        Object node = flat.Get(i).As<Object>();
+        Array nodeChildren = Array::New(env);
+        node.Set("children", nodeChildren);
+        children[powerData[i].name] = nodeChildren;
+        
+        // Parents are listed before their subzones; orphans are promoted to roots
+        auto parent = children.find(powerData[i].parent);
+        Array& siblings = (powerData[i].parent.empty() || parent == children.end()) ? roots : parent->second;
+        siblings[siblings.Length()] = node;
+    }
+    return roots;
+}
+
+static Value BatteryToObject(Env env, const BatteryReading& bat) {
+    if (!bat.ok) {
+        return env.Null();
+    }
+
+    Object obj = Object::New(env);
+    obj.Set("status", String::New(env, bat.status));
+    obj.Set("acConnected", Boolean::New(env, bat.ac_connected));
+    
+    // Check for NaN using comparison (NaN != NaN is always true)
+    if (bat.voltage_v == bat.voltage_v) obj.Set("voltage", Number::New(env, bat.voltage_v));
+    if (bat.current_a == bat.current_a) obj.Set("current", Number::New(env, bat.current_a));
+    if (bat.power_w == bat.power_w) obj.Set("powerWatts", Number::New(env, bat.power_w));
+    if (bat.energy_now_wh == bat.energy_now_wh) obj.Set("energyNowWh", Number::New(env, bat.energy_now_wh));
+    if (bat.energy_full_wh == bat.energy_full_wh) obj.Set("energyFullWh", Number::New(env, bat.energy_full_wh));
+    if (bat.estimated_hours == bat.estimated_hours) obj.Set("estimatedHours", Number::New(env, bat.estimated_hours));
+    
+    obj.Set("state", String::New(env, bat.derived_state));
+    return obj;
+}
+
+static Value SampleAllToObject(Env env, const SampleAllReading& sample) {
+    Object result = Object::New(env);
+    result.Set("cores", CoresToArray(env, sample.cores));
+    result.Set("temperatures", SensorsToArray(env, sample.temperatures));
+    result.Set("ddr5", SensorsToArray(env, sample.ddr5));
+    result.Set("rapl", PowerDataToArray(env, sample.rapl));
+    result.Set("battery", BatteryToObject(env, sample.battery));
+    return result;
+}
+
+// Runs a SystemMonitor read on the libuv threadpool and settles a promise
+// with the converted result back on the JS thread
+template <typename Result>
+class MonitorPromiseWorker : public AsyncWorker {
+public:
+    typedef std::function<Result(SystemMonitor*)> ReadFn;
+    typedef Value (*ConvertFn)(Napi::Env, const Result&);
+    
+    MonitorPromiseWorker(Napi::Env env, ReadFn read, ConvertFn convert)
+        : AsyncWorker(env), deferred_(Promise::Deferred::New(env)), read_(read), convert_(convert) {}
+    
+    Promise GetPromise() { return deferred_.Promise(); }
+    
+protected:
+    void Execute() override {
+        try {
+            result_ = read_(g_monitor);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+    
+    void OnOK() override {
+        deferred_.Resolve(convert_(Env(), result_));
+    }
+    
+    void OnError(const Error& error) override {
+        deferred_.Reject(error.Value());
+    }
+    
+private:
+    Promise::Deferred deferred_;
+    ReadFn read_;
+    ConvertFn convert_;
+    Result result_;
+};
+
+template <typename Result>
+static Value QueuePromiseWorker(const CallbackInfo& info,
+                                typename MonitorPromiseWorker<Result>::ReadFn read,
+                                typename MonitorPromiseWorker<Result>::ConvertFn convert) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Promise::Deferred deferred = Promise::Deferred::New(env);
+        deferred.Reject(Error::New(env, "SystemMonitor not initialized").Value());
+        return deferred.Promise();
+    }
+    
+    MonitorPromiseWorker<Result>* worker = new MonitorPromiseWorker<Result>(env, read, convert);
+    Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+static std::vector<CoreData> ReadCPUCores(SystemMonitor* monitor) { return monitor->getCPUCores(); }
+static std::vector<CPULoad> ReadCPULoad(SystemMonitor* monitor) { return monitor->getCPULoad(); }
+static std::vector<SensorData> ReadTemperatureSensors(SystemMonitor* monitor) { return monitor->getTemperatureSensors(); }
+static std::vector<SensorData> ReadDDR5Temperatures(SystemMonitor* monitor) { return monitor->getDDR5Temperatures(); }
+static std::vector<SensorData> ReadRAPLPower(SystemMonitor* monitor) { return monitor->getRAPLPower(); }
+static std::vector<PowerData> ReadRAPLPowerCalculated(SystemMonitor* monitor) { return monitor->getRAPLPowerCalculated(); }
+static std::vector<GPUData> ReadGPUs(SystemMonitor* monitor) { return monitor->getGPUs(); }
+
+static SampleAllReading ReadSampleAll(SystemMonitor* monitor) {
+    SampleAllReading sample;
+    sample.cores = monitor->getCPUCores();
+    sample.temperatures = monitor->getTemperatureSensors();
+    sample.ddr5 = monitor->getDDR5Temperatures();
+    sample.rapl = monitor->getRAPLPowerCalculated();
+    sample.battery = ReadBattery(monitor);
+    return sample;
+}
+
+// Get CPU cores data
+Value GetCPUCores(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string status;
-    bool ac_connected = false;
-    double voltage_v = std::numeric_limits<double>::quiet_NaN();
-    double current_a = std::numeric_limits<double>::quiet_NaN();
-    double power_w = std::numeric_limits<double>::quiet_NaN();
-    double energy_now_wh = std::numeric_limits<double>::quiet_NaN();
-    double energy_full_wh = std::numeric_limits<double>::quiet_NaN();
-    double estimated_hours = std::numeric_limits<double>::quiet_NaN();
-    std::string derived_state;
+    return CoresToArray(env, g_monitor->getCPUCores());
+}
 
-    bool ok = g_monitor->getBatteryCalculated(status, ac_connected, voltage_v, current_a, power_w,
-                                              energy_now_wh, energy_full_wh, estimated_hours, derived_state);
-    if (!ok) {
+// Get NVIDIA (NVML) and AMD (amdgpu sysfs) GPU telemetry
+Value GetGPUData(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
+    
+    return GPUsToArray(env, g_monitor->getGPUs());
+}
 
-    Object obj = Object::New(env);
-    obj.Set("status", String::New(env, status));
-    obj.Set("acConnected", Boolean::New(env, ac_connected));
+// Which GPU backend loaded: "nvml" or "none" (AMD cards are read either way)
+Value GetGPUBackend(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
     
-    // Check for NaN using comparison (NaN != NaN is always true)
-    if (voltage_v == voltage_v) obj.Set("voltage", Number::New(env, voltage_v));
-    if (current_a == current_a) obj.Set("current", Number::New(env, current_a));
-    if (power_w == power_w) obj.Set("powerWatts", Number::New(env, power_w));
-    if (energy_now_wh == energy_now_wh) obj.Set("energyNowWh", Number::New(env, energy_now_wh));
-    if (energy_full_wh == energy_full_wh) obj.Set("energyFullWh", Number::New(env, energy_full_wh));
-    if (estimated_hours == estimated_hours) obj.Set("estimatedHours", Number::New(env, estimated_hours));
-    
-    obj.Set("state", String::New(env, derived_state));
-    return obj;
+    return String::New(env, g_monitor->getGPUBackend());
 }
 
-// Update statistics
-Value UpdateStats(const CallbackInfo& info) {
+// Get per-CPU and aggregate load from /proc/stat deltas
+Value GetCPULoad(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    if (info.Length() < 2) {
-        Error::New(env, "Expected 2 arguments: key and value").ThrowAsJavaScriptException();
+    return CPULoadToObject(env, g_monitor->getCPULoad());
+}
+
+// Get temperature sensors
+Value GetTemperatureSensors(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    if (!info[0].IsString() || !info[1].IsNumber()) {
-        Error::New(env, "Expected string key and number value").ThrowAsJavaScriptException();
+    return SensorsToArray(env, g_monitor->getTemperatureSensors());
+}
+
+// Get DDR5 temperatures
+Value GetDDR5Temperatures(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string key = info[0].As<String>().Utf8Value();
-    double value = info[1].As<Number>().DoubleValue();
+    return SensorsToArray(env, g_monitor->getDDR5Temperatures());
+}
+
+// Get RAPL power data
+Value GetRAPLPower(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
     
-    g_monitor->updateStats(key, value);
-    return Boolean::New(env, true);
+    return SensorsToArray(env, g_monitor->getRAPLPower());
 }
 
-// Get statistics
-Value GetStats(const CallbackInfo& info) {
+// Get RAPL power with calculations
+Value GetRAPLPowerCalculated(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    SystemStats stats = g_monitor->getStats();
-    Object result = Object::New(env);
+    return PowerDataToArray(env, g_monitor->getRAPLPowerCalculated());
+}
+
+// Open (or with false, close) per-CPU hardware counter groups; returns the number of CPUs covered
+Value EnableHardwareCounters(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
     
-    // Convert stats to JavaScript object in the same format as the JavaScript version
-    // Each key should have { current, min, max, avg }
-    for (const auto& pair : stats.min_values) {
-        const std::string& key = pair.first;
-        Object statObj = Object::New(env);
-        
-        // Set min value
-        statObj.Set("min", Number::New(env, pair.second));
-        
-        // Set max value if it exists
-        if (stats.max_values.find(key) != stats.max_values.end()) {
-            statObj.Set("max", Number::New(env, stats.max_values[key]));
-        }
-        
-        // Set avg value if it exists - use valid_count for accurate average
-        if (stats.sum_values.find(key) != stats.sum_values.end() && 
-            stats.valid_count_values.find(key) != stats.valid_count_values.end() &&
-            stats.valid_count_values[key] > 0) {
-            double avg = stats.sum_values[key] / stats.valid_count_values[key];
-            statObj.Set("avg", Number::New(env, avg));
-        }
-        
-        // Set current value
-        if (stats.current_values.find(key) != stats.current_values.end()) {
-            statObj.Set("current", Number::New(env, stats.current_values[key]));
-        }
-        
-        result.Set(key, statObj);
+    bool enable = info.Length() < 1 || !info[0].IsBoolean() || info[0].As<Boolean>().Value();
+    return Number::New(env, g_monitor->enableHardwareCounters(enable));
+}
+
+// Get RAPL power as a tree of domains and their subzones
+Value GetRAPLPowerTree(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
     }
     
-    return result;
+    return PowerDataToTree(env, g_monitor->getRAPLPowerCalculated());
 }
 
-// Reset statistics
-Value ResetStats(const CallbackInfo& info) {
+// Set the RAPL smoothing horizons in seconds, e.g. setPowerWindows([1, 10, 60])
+Value SetPowerWindows(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    g_monitor->resetStats();
-    return Boolean::New(env, true);
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Error::New(env, "Expected array of window lengths in seconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<double> seconds;
+    Array list = info[0].As<Array>();
+    for (uint32_t i = 0; i < list.Length(); i++) {
+        Value s = list.Get(i);
+        if (s.IsNumber()) {
+            seconds.push_back(s.As<Number>().DoubleValue());
+        }
+    }
+    g_monitor->setPowerWindows(seconds);
+    return env.Undefined();
 }
 
-// Check if last valid value exists
-Value HasLastValidValue(const CallbackInfo& info) {
+// Get the RAPL smoothing horizons in seconds
+Value GetPowerWindows(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+    std::vector<double> seconds = g_monitor->getPowerWindows();
+    Array result = Array::New(env, seconds.size());
+    for (size_t i = 0; i < seconds.size(); i++) {
+        result[i] = Number::New(env, seconds[i]);
+    }
+    return result;
+}
+
+// Get Battery calculated sensors
+Value GetBatteryCalculated(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string key = info[0].As<String>().Utf8Value();
-    bool hasValue = g_monitor->hasLastValidValue(key);
-    return Boolean::New(env, hasValue);
+    return BatteryToObject(env, ReadBattery(g_monitor));
 }
 
-// Get last valid value
-Value GetLastValidValue(const CallbackInfo& info) {
+// Promise-returning variants: sysfs I/O runs on the libuv threadpool
+Value GetCPUCoresAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<CoreData>>(info, ReadCPUCores, CoresToArray);
+}
+
+Value GetCPULoadAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<CPULoad>>(info, ReadCPULoad, CPULoadToObject);
+}
+
+Value GetGPUDataAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<GPUData>>(info, ReadGPUs, GPUsToArray);
+}
+
+// Matches main.js's SMART_CACHE_DURATION
+static const uint64_t DISK_HEALTH_DEFAULT_MAX_AGE_MS = 60000;
+
+// Optional maxAgeMs: younger cached results are returned without touching the drives
+static uint64_t DiskHealthMaxAge(const CallbackInfo& info) {
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        double maxAge = info[0].As<Number>().DoubleValue();
+        return maxAge > 0 ? (uint64_t)maxAge : 0;
+    }
+    return DISK_HEALTH_DEFAULT_MAX_AGE_MS;
+}
+
+Value GetDiskHealth(const CallbackInfo& info) {
     Env env = info.Env();
     if (g_monitor == nullptr) {
         Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+    return DiskHealthToObject(env, g_monitor->getDiskHealth(DiskHealthMaxAge(info)));
+}
+
+Value GetDiskHealthAsync(const CallbackInfo& info) {
+    uint64_t maxAge = DiskHealthMaxAge(info);
+    return QueuePromiseWorker<std::vector<DiskHealthData>>(info,
+        [maxAge](SystemMonitor* monitor) { return monitor->getDiskHealth(maxAge); },
+        DiskHealthToObject);
+}
+
+static Value ProcessesToArray(Env env, const std::vector<ProcessInfo>& processes) {
+    Array result = Array::New(env, processes.size());
+    for (size_t i = 0; i < processes.size(); i++) {
+        const ProcessInfo& process = processes[i];
+        Object entry = Object::New(env);
+        entry.Set("pid", Number::New(env, process.pid));
+        entry.Set("name", String::New(env, process.name));
+        entry.Set("state", String::New(env, std::string(1, process.state)));
+        entry.Set("threads", Number::New(env, process.threads));
+        entry.Set("cpu", Number::New(env, process.cpu_percent));
+        entry.Set("rssBytes", Number::New(env, (double)process.rss_bytes));
+        // null rather than NaN when /proc/<pid>/io is off limits
+        if (std::isnan(process.read_bytes_per_sec)) {
+            entry.Set("readBytesPerSec", env.Null());
+            entry.Set("writeBytesPerSec", env.Null());
+        } else {
+            entry.Set("readBytesPerSec", Number::New(env, process.read_bytes_per_sec));
+            entry.Set("writeBytesPerSec", Number::New(env, process.write_bytes_per_sec));
+        }
+        result[i] = entry;
+    }
+    return result;
+}
+
+static const size_t TOP_PROCESSES_DEFAULT_COUNT = 10;
+
+// Optional (sortKey = 'cpu' | 'rss' | 'io', count = 10); false after throwing on a bad key
+static bool TopProcessesArgs(const CallbackInfo& info, ProcessSortKey& key, size_t& count) {
+    key = PROCESS_SORT_CPU;
+    count = TOP_PROCESSES_DEFAULT_COUNT;
+    if (info.Length() > 0 && info[0].IsString() &&
+        !ProcessTable::parseSortKey(info[0].As<String>().Utf8Value(), key)) {
+        Error::New(info.Env(), "Expected sort key 'cpu', 'rss' or 'io'").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        double requested = info[1].As<Number>().DoubleValue();
+        count = requested > 0 ? (size_t)requested : 0;
+    }
+    return true;
+}
+
+Value GetTopProcesses(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string key = info[0].As<String>().Utf8Value();
-    double value = g_monitor->getLastValidValue(key);
-    return Number::New(env, value);
+    ProcessSortKey key;
+    size_t count;
+    if (!TopProcessesArgs(info, key, count)) {
+        return env.Null();
+    }
+    return ProcessesToArray(env, g_monitor->getTopProcesses(key, count));
+}
+
+Value GetTopProcessesAsync(const CallbackInfo& info) {
+    ProcessSortKey key;
+    size_t count;
+    if (!TopProcessesArgs(info, key, count)) {
+        return info.Env().Null();
+    }
+    return QueuePromiseWorker<std::vector<ProcessInfo>>(info,
+        [key, count](SystemMonitor* monitor) { return monitor->getTopProcesses(key, count); },
+        ProcessesToArray);
+}
+
+// Energy attribution with the domain names its per-domain joules line up with
+struct EnergyReading {
+    std::vector<ProcessEnergy> entries;
+    std::vector<std::string> domains;
+};
+
+static Value EnergyToArray(Env env, const EnergyReading& reading) {
+    Array result = Array::New(env, reading.entries.size());
+    for (size_t i = 0; i < reading.entries.size(); i++) {
+        const ProcessEnergy& energy = reading.entries[i];
+        Object entry = Object::New(env);
+        if (energy.pid != 0) {
+            entry.Set("pid", Number::New(env, energy.pid));
+            entry.Set("name", String::New(env, energy.name));
+            entry.Set("exited", Boolean::New(env, energy.exited));
+        }
+        entry.Set("cgroup", String::New(env, energy.cgroup));
+        entry.Set("joules", Number::New(env, energy.joules));
+        Object domains = Object::New(env);
+        for (size_t d = 0; d < reading.domains.size() && d < energy.domain_joules.size(); d++) {
+            domains.Set(reading.domains[d], Number::New(env, energy.domain_joules[d]));
+        }
+        entry.Set("domains", domains);
+        result[i] = entry;
+    }
+    return result;
+}
+
+// Optional (topN = 10)
+static size_t EnergyCountArg(const CallbackInfo& info) {
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        double requested = info[0].As<Number>().DoubleValue();
+        return requested > 0 ? (size_t)requested : 0;
+    }
+    return TOP_PROCESSES_DEFAULT_COUNT;
+}
+
+static EnergyReading ReadEnergyByProcess(SystemMonitor* monitor, size_t count) {
+    EnergyReading reading;
+    reading.entries = monitor->getEnergyByProcess(count, reading.domains);
+    return reading;
+}
+
+static EnergyReading ReadEnergyByCgroup(SystemMonitor* monitor, size_t count) {
+    EnergyReading reading;
+    reading.entries = monitor->getEnergyByCgroup(count, reading.domains);
+    return reading;
+}
+
+Value GetEnergyByProcess(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return EnergyToArray(env, ReadEnergyByProcess(g_monitor, EnergyCountArg(info)));
+}
+
+Value GetEnergyByProcessAsync(const CallbackInfo& info) {
+    size_t count = EnergyCountArg(info);
+    return QueuePromiseWorker<EnergyReading>(info,
+        [count](SystemMonitor* monitor) { return ReadEnergyByProcess(monitor, count); },
+        EnergyToArray);
+}
+
+Value GetEnergyByCgroup(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return EnergyToArray(env, ReadEnergyByCgroup(g_monitor, EnergyCountArg(info)));
+}
+
+Value GetEnergyByCgroupAsync(const CallbackInfo& info) {
+    size_t count = EnergyCountArg(info);
+    return QueuePromiseWorker<EnergyReading>(info,
+        [count](SystemMonitor* monitor) { return ReadEnergyByCgroup(monitor, count); },
+        EnergyToArray);
+}
+
+Value GetTemperatureSensorsAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<SensorData>>(info, ReadTemperatureSensors, SensorsToArray);
+}
+
+Value GetDDR5TemperaturesAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<SensorData>>(info, ReadDDR5Temperatures, SensorsToArray);
+}
+
+Value GetRAPLPowerAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<SensorData>>(info, ReadRAPLPower, SensorsToArray);
+}
+
+Value GetRAPLPowerCalculatedAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<std::vector<PowerData>>(info, ReadRAPLPowerCalculated, PowerDataToArray);
+}
+
+Value GetBatteryCalculatedAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<BatteryReading>(info, ReadBattery, BatteryToObject);
+}
+
+// Sample every sensor group in one threadpool hop
+Value SampleAllAsync(const CallbackInfo& info) {
+    return QueuePromiseWorker<SampleAllReading>(info, ReadSampleAll, SampleAllToObject);
+}
+
+// Describe the snapshot() layout; element i of the schema is values[i + 1]
+Value GetSchema(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint64_t version = 0;
+    std::vector<SnapshotField> fields = g_monitor->getSnapshotSchema(version);
+    Array list = Array::New(env, fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+        Object field = Object::New(env);
+        field.Set("group", String::New(env, fields[i].group));
+        field.Set("name", String::New(env, fields[i].name));
+        field.Set("label", String::New(env, fields[i].label));
+        field.Set("unit", String::New(env, fields[i].unit));
+        list[i] = field;
+    }
+    
+    Object result = Object::New(env);
+    result.Set("version", Number::New(env, (double)version));
+    result.Set("fields", list);
+    return result;
+}
+
+// Optional array of sensor group names at info[index]; absent means every group.
+// Throws and returns false on a bad list.
+static bool SensorGroupsArg(const CallbackInfo& info, size_t index, uint32_t& mask) {
+    Env env = info.Env();
+    mask = SENSOR_GROUPS_ALL;
+    if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull()) {
+        return true;
+    }
+    if (!info[index].IsArray()) {
+        Error::New(env, "Expected array of sensor groups").ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Array names = info[index].As<Array>();
+    std::vector<std::string> groups;
+    for (uint32_t i = 0; i < names.Length(); i++) {
+        Value name = names[i];
+        if (!name.IsString()) {
+            Error::New(env, "Sensor groups must be strings").ThrowAsJavaScriptException();
+            return false;
+        }
+        groups.push_back(name.As<String>().Utf8Value());
+    }
+    std::string error;
+    if (!SystemMonitor::parseSensorGroups(groups, mask, error)) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Sample everything into a Float64Array: [schemaVersion, field0, field1, ...].
+// Pass the previous array back in to have it refilled without allocating, and
+// optionally a list of sensor groups to read (the rest come back NaN).
+Value Snapshot(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t groups = SENSOR_GROUPS_ALL;
+    if (!SensorGroupsArg(info, 1, groups)) {
+        return env.Null();
+    }
+    
+    std::vector<double> values;
+    uint64_t version = g_monitor->snapshot(values, POWER_CONSUMER_UI, groups);
+    
+    Float64Array target;
+    if (info.Length() > 0 && info[0].IsTypedArray() &&
+        info[0].As<TypedArray>().TypedArrayType() == napi_float64_array) {
+        target = info[0].As<Float64Array>();
+    }
+    if (target.IsEmpty() || target.ElementLength() != values.size() + 1) {
+        target = Float64Array::New(env, values.size() + 1);
+    }
+    
+    double* out = target.Data();
+    out[0] = (double)version;
+    std::copy(values.begin(), values.end(), out + 1);
+    return target;
+}
+
+// Open a columnar session log: (path, columnNames, { chunkRows, compress })
+Value OpenSessionLog(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsArray()) {
+        Error::New(env, "Expected path and array of column names").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<std::string> columns;
+    Array list = info[1].As<Array>();
+    for (uint32_t i = 0; i < list.Length(); i++) {
+        columns.push_back(list.Get(i).ToString().Utf8Value());
+    }
+    uint32_t chunkRows = SessionLogWriter::DEFAULT_CHUNK_ROWS;
+    bool compress = true;
+    if (info.Length() > 2 && info[2].IsObject()) {
+        Object options = info[2].As<Object>();
+        if (options.Get("chunkRows").IsNumber()) {
+            chunkRows = options.Get("chunkRows").As<Number>().Uint32Value();
+        }
+        if (options.Get("compress").IsBoolean()) {
+            compress = options.Get("compress").As<Boolean>().Value();
+        }
+    }
+    
+    std::string error;
+    if (!g_monitor->openSessionLog(info[0].As<String>().Utf8Value(), columns, chunkRows, compress, error)) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Boolean::New(env, true);
+}
+
+// Append one row: (timestampMs, values as Float64Array or Array); true when a chunk was written
+Value AppendSessionLog(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsNumber()) {
+        Error::New(env, "Expected timestamp and values").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    int64_t timestamp = info[0].As<Number>().Int64Value();
+    std::vector<double> row;
+    const double* values = nullptr;
+    size_t count = 0;
+    if (info[1].IsTypedArray() && info[1].As<TypedArray>().TypedArrayType() == napi_float64_array) {
+        Float64Array array = info[1].As<Float64Array>();
+        values = array.Data();
+        count = array.ElementLength();
+    } else if (info[1].IsArray()) {
+        Array array = info[1].As<Array>();
+        row.resize(array.Length());
+        for (uint32_t i = 0; i < array.Length(); i++) {
+            Value v = array.Get(i);
+            row[i] = v.IsNumber() ? v.As<Number>().DoubleValue() : std::numeric_limits<double>::quiet_NaN();
+        }
+        values = row.data();
+        count = row.size();
+    } else {
+        Error::New(env, "Expected values as Float64Array or Array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string error;
+    int result = g_monitor->appendSessionLog(timestamp, values, count, error);
+    if (result < 0) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Boolean::New(env, result == 1);
+}
+
+// Flush the partial chunk and write the index
+Value CloseSessionLog(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    g_monitor->closeSessionLog();
+    return env.Undefined();
+}
+
+// Reader bindings only touch the file, so they work before initialize()
+// (e.g. from scripts/convert-to-csv.js)
+Value GetSessionLogInfo(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected session log path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    SessionLogReader reader;
+    if (!reader.open(info[0].As<String>().Utf8Value())) {
+        Error::New(env, reader.error()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Array columns = Array::New(env, reader.columns().size());
+    for (size_t i = 0; i < reader.columns().size(); i++) {
+        columns[i] = String::New(env, reader.columns()[i]);
+    }
+    Array chunks = Array::New(env, reader.chunks().size());
+    double rows = 0;
+    for (size_t i = 0; i < reader.chunks().size(); i++) {
+        const SessionLogChunk& chunk = reader.chunks()[i];
+        Object entry = Object::New(env);
+        entry.Set("firstMs", Number::New(env, (double)chunk.first_ms));
+        entry.Set("lastMs", Number::New(env, (double)chunk.last_ms));
+        entry.Set("rows", Number::New(env, chunk.rows));
+        chunks[i] = entry;
+        rows += chunk.rows;
+    }
+    
+    Object result = Object::New(env);
+    result.Set("columns", columns);
+    result.Set("chunks", chunks);
+    result.Set("rows", Number::New(env, rows));
+    return result;
+}
+
+// Decode rows in [t0, t1] (default: all): { timestamps, columns: { name: Float64Array } }
+Value ReadSessionLog(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected session log path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    int64_t t0 = std::numeric_limits<int64_t>::min();
+    int64_t t1 = std::numeric_limits<int64_t>::max();
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        t0 = info[1].As<Number>().Int64Value();
+    }
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        t1 = info[2].As<Number>().Int64Value();
+    }
+    
+    SessionLogReader reader;
+    std::vector<int64_t> timestamps;
+    std::vector<std::vector<double>> values;
+    if (!reader.open(info[0].As<String>().Utf8Value()) || !reader.readRange(t0, t1, timestamps, values)) {
+        Error::New(env, reader.error()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Float64Array times = Float64Array::New(env, timestamps.size());
+    std::copy(timestamps.begin(), timestamps.end(), times.Data());
+    Object columns = Object::New(env);
+    for (size_t c = 0; c < reader.columns().size(); c++) {
+        Float64Array column = Float64Array::New(env, values[c].size());
+        std::copy(values[c].begin(), values[c].end(), column.Data());
+        columns.Set(reader.columns()[c], column);
+    }
+    
+    Object result = Object::New(env);
+    result.Set("timestamps", times);
+    result.Set("columns", columns);
+    return result;
+}
+
+Value ExportSessionLogCSV(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Error::New(env, "Expected session log path and CSV path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string error;
+    if (!SessionLogReader::exportCSV(info[0].As<String>().Utf8Value(), info[1].As<String>().Utf8Value(), error)) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Boolean::New(env, true);
+}
+
+// Describe the readIORates() layout: disk rows then interface rows, in stable index order
+Value GetIODevices(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<std::string> disks, interfaces;
+    std::vector<bool> stacked;
+    uint64_t version = g_monitor->getIODevices(disks, stacked, interfaces);
+    
+    Array diskFields = Array::New(env, DISK_FIELD_COUNT);
+    for (size_t i = 0; i < DISK_FIELD_COUNT; i++) {
+        diskFields[i] = String::New(env, IORates::diskFieldName(i));
+    }
+    Array netFields = Array::New(env, NET_FIELD_COUNT);
+    for (size_t i = 0; i < NET_FIELD_COUNT; i++) {
+        netFields[i] = String::New(env, IORates::netFieldName(i));
+    }
+    Array diskNames = Array::New(env, disks.size());
+    Array diskStacked = Array::New(env, disks.size());
+    for (size_t i = 0; i < disks.size(); i++) {
+        diskNames[i] = String::New(env, disks[i]);
+        diskStacked[i] = Boolean::New(env, stacked[i]);
+    }
+    Array interfaceNames = Array::New(env, interfaces.size());
+    for (size_t i = 0; i < interfaces.size(); i++) {
+        interfaceNames[i] = String::New(env, interfaces[i]);
+    }
+    
+    Object result = Object::New(env);
+    result.Set("version", Number::New(env, (double)version));
+    result.Set("diskFields", diskFields);
+    result.Set("netFields", netFields);
+    result.Set("disks", diskNames);
+    result.Set("diskStacked", diskStacked);
+    result.Set("interfaces", interfaceNames);
+    return result;
+}
+
+// Disk/network rates into a Float64Array: [layoutVersion, disk rows..., interface rows...].
+// Pass the previous array back in to have it refilled without allocating.
+Value ReadIORates(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<double> values;
+    uint64_t version = g_monitor->readIORates(values);
+    
+    Float64Array target;
+    if (info.Length() > 0 && info[0].IsTypedArray() &&
+        info[0].As<TypedArray>().TypedArrayType() == napi_float64_array) {
+        target = info[0].As<Float64Array>();
+    }
+    if (target.IsEmpty() || target.ElementLength() != values.size() + 1) {
+        target = Float64Array::New(env, values.size() + 1);
+    }
+    
+    double* out = target.Data();
+    out[0] = (double)version;
+    std::copy(values.begin(), values.end(), out + 1);
+    return target;
+}
+
+// Intern a metric key to a dense id for updateStatsBatch()
+Value RegisterMetric(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string key = info[0].As<String>().Utf8Value();
+    return Number::New(env, g_monitor->registerMetric(key));
+}
+
+// Update statistics (key may be a string or a registered metric id)
+Value UpdateStats(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2) {
+        Error::New(env, "Expected 2 arguments: key and value").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (!(info[0].IsString() || info[0].IsNumber()) || !info[1].IsNumber()) {
+        Error::New(env, "Expected string key or metric id and number value").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    double value = info[1].As<Number>().DoubleValue();
+    if (info[0].IsNumber()) {
+        g_monitor->updateStats(info[0].As<Number>().Int32Value(), value);
+    } else {
+        g_monitor->updateStats(info[0].As<String>().Utf8Value(), value);
+    }
+    return Boolean::New(env, true);
+}
+
+// Apply many updates in one call: ids[i] receives values[i]
+Value UpdateStatsBatch(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsTypedArray() || !info[1].IsTypedArray() ||
+        info[0].As<TypedArray>().TypedArrayType() != napi_int32_array ||
+        info[1].As<TypedArray>().TypedArrayType() != napi_float64_array) {
+        Error::New(env, "Expected Int32Array ids and Float64Array values").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Int32Array ids = info[0].As<Int32Array>();
+    Float64Array values = info[1].As<Float64Array>();
+    size_t count = std::min(ids.ElementLength(), values.ElementLength());
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        count = std::min(count, (size_t)std::max<int64_t>(0, info[2].As<Number>().Int64Value()));
+    }
+    
+    g_monitor->updateStatsBatch(ids.Data(), values.Data(), count);
+    return Boolean::New(env, true);
+}
+
+// Open (or reopen) the mmap'd history file fed by updateStats: (path, maxMetrics?, metrics?).
+// metrics is the list of stats keys to record; maxMetrics 0 sizes the file to it.
+Value OpenHistory(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected history file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint32_t maxMetrics = HistoryStore::DEFAULT_MAX_METRICS;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        maxMetrics = info[1].As<Number>().Uint32Value();
+    }
+    std::vector<std::string> metrics;
+    if (info.Length() > 2 && info[2].IsArray()) {
+        Array keys = info[2].As<Array>();
+        for (uint32_t i = 0; i < keys.Length(); i++) {
+            Value key = keys[i];
+            if (!key.IsString()) {
+                Error::New(env, "History metrics must be strings").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            metrics.push_back(key.As<String>().Utf8Value());
+        }
+    }
+    
+    std::string error;
+    if (!g_monitor->openHistory(info[0].As<String>().Utf8Value(), maxMetrics, metrics, error)) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Boolean::New(env, true);
+}
+
+// Names refused a history slot because the file was full, each reported once
+Value TakeHistoryRefused(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<std::string> refused = g_monitor->takeHistoryRefused();
+    Array names = Array::New(env, refused.size());
+    for (size_t i = 0; i < refused.size(); i++) {
+        names[i] = String::New(env, refused[i]);
+    }
+    return names;
+}
+
+Value CloseHistory(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    g_monitor->closeHistory();
+    return env.Undefined();
+}
+
+// queryRange(metricIds, t0, t1, maxPoints): per id { id, bucketMs, timestamps, min, max, avg },
+// at most maxPoints points each, decimated from the finest pyramid level that covers [t0, t1]
+Value QueryRange(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 4 || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
+        Error::New(env, "Expected metric ids, t0, t1 and maxPoints").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<int> ids;
+    if (info[0].IsTypedArray() && info[0].As<TypedArray>().TypedArrayType() == napi_int32_array) {
+        Int32Array list = info[0].As<Int32Array>();
+        ids.assign(list.Data(), list.Data() + list.ElementLength());
+    } else if (info[0].IsArray()) {
+        Array list = info[0].As<Array>();
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Value id = list.Get(i);
+            ids.push_back(id.IsNumber() ? id.As<Number>().Int32Value() : -1);
+        }
+    } else {
+        Error::New(env, "Expected metric ids as Int32Array or Array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<HistoryRange> ranges;
+    if (!g_monitor->queryHistory(ids, info[1].As<Number>().Int64Value(), info[2].As<Number>().Int64Value(),
+                                 (size_t)std::max<int64_t>(1, info[3].As<Number>().Int64Value()), ranges)) {
+        Error::New(env, "History not open").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    auto toArray = [&env](const std::vector<double>& values) {
+        Float64Array array = Float64Array::New(env, values.size());
+        std::copy(values.begin(), values.end(), array.Data());
+        return array;
+    };
+    Array result = Array::New(env, ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        Object range = Object::New(env);
+        range.Set("id", Number::New(env, ids[i]));
+        range.Set("bucketMs", Number::New(env, (double)ranges[i].bucket_ms));
+        range.Set("timestamps", toArray(ranges[i].timestamps));
+        range.Set("min", toArray(ranges[i].min));
+        range.Set("max", toArray(ranges[i].max));
+        range.Set("avg", toArray(ranges[i].avg));
+        result[i] = range;
+    }
+    return result;
+}
+
+// Get statistics
+Value GetStats(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Object result = Object::New(env);
+    
+    // Convert stats to JavaScript object in the same format as the JavaScript version
+    // Each key should have { current, min, max, avg }
+    g_monitor->visitStats([&](const SystemStats& stats) {
+        for (size_t id = 0; id < stats.names.size(); id++) {
+            if (!stats.has_value[id]) {
+                continue;
+            }
+            
+            Object statObj = Object::New(env);
+            statObj.Set("min", Number::New(env, stats.min_values[id]));
+            statObj.Set("max", Number::New(env, stats.max_values[id]));
+            statObj.Set("avg", Number::New(env, stats.sum_values[id] / stats.count_values[id]));
+            statObj.Set("current", Number::New(env, stats.current_values[id]));
+            result.Set(stats.names[id], statObj);
+        }
+    });
+    
+    return result;
+}
+
+// Column layout of getStatsColumns(): column c of metric id i is at [c * count + i]
+static const size_t STATS_COLUMN_COUNT = 5; // min, max, avg, current, count
+
+// Copy the stats columns into a Float64Array, refilling `target` in place when it fits
+Value GetStatsColumns(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Float64Array target;
+    if (info.Length() > 0 && info[0].IsTypedArray() &&
+        info[0].As<TypedArray>().TypedArrayType() == napi_float64_array) {
+        target = info[0].As<Float64Array>();
+    }
+    
+    g_monitor->visitStats([&](const SystemStats& stats) {
+        size_t count = stats.names.size();
+        if (target.IsEmpty() || target.ElementLength() != count * STATS_COLUMN_COUNT) {
+            target = Float64Array::New(env, count * STATS_COLUMN_COUNT);
+        }
+        
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        double* out = target.Data();
+        for (size_t id = 0; id < count; id++) {
+            bool has = stats.has_value[id] != 0;
+            out[id] = has ? stats.min_values[id] : nan;
+            out[count + id] = has ? stats.max_values[id] : nan;
+            out[2 * count + id] = has ? stats.sum_values[id] / stats.count_values[id] : nan;
+            out[3 * count + id] = has ? stats.current_values[id] : nan;
+            out[4 * count + id] = stats.count_values[id];
+        }
+    });
+    
+    return target;
+}
+
+// Names of all registered metrics, indexed by metric id
+Value GetMetricNames(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Array result = Array::New(env);
+    g_monitor->visitStats([&](const SystemStats& stats) {
+        for (size_t id = 0; id < stats.names.size(); id++) {
+            result[(uint32_t)id] = String::New(env, stats.names[id]);
+        }
+    });
+    return result;
+}
+
+// Estimate quantiles of a metric, e.g. getQuantiles('cpu_package_power', [0.5, 0.99])
+Value GetQuantiles(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<double> quantiles;
+    if (info.Length() > 1 && info[1].IsArray()) {
+        Array list = info[1].As<Array>();
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Value q = list.Get(i);
+            quantiles.push_back(q.IsNumber() ? q.As<Number>().DoubleValue() : std::numeric_limits<double>::quiet_NaN());
+        }
+    } else {
+        quantiles = { 0.5, 0.95, 0.99, 0.999 };
+    }
+    
+    std::string key = info[0].As<String>().Utf8Value();
+    std::vector<double> values = g_monitor->getQuantiles(key, quantiles);
+    Array result = Array::New(env, values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        result[i] = Number::New(env, values[i]);
+    }
+    return result;
+}
+
+// Export a metric's sketch as a Float64Array so it can be persisted and merged later
+Value GetQuantileSketch(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<double> data;
+    if (!g_monitor->exportQuantileSketch(info[0].As<String>().Utf8Value(), data)) {
+        return env.Null();
+    }
+    
+    Float64Array result = Float64Array::New(env, data.size());
+    std::copy(data.begin(), data.end(), result.Data());
+    return result;
+}
+
+// Merge a previously exported sketch (e.g. from an earlier session) into a metric
+Value MergeQuantileSketch(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsTypedArray() ||
+        info[1].As<TypedArray>().TypedArrayType() != napi_float64_array) {
+        Error::New(env, "Expected string key and Float64Array sketch").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Float64Array data = info[1].As<Float64Array>();
+    bool merged = g_monitor->mergeQuantileSketch(info[0].As<String>().Utf8Value(), data.Data(), data.ElementLength());
+    return Boolean::New(env, merged);
+}
+
+// Reset statistics
+Value ResetStats(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    g_monitor->resetStats();
+    return Boolean::New(env, true);
+}
+
+// Check if last valid value exists
+Value HasLastValidValue(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string key = info[0].As<String>().Utf8Value();
+    bool hasValue = g_monitor->hasLastValidValue(key);
+    return Boolean::New(env, hasValue);
+}
+
+// Get last valid value
+Value GetLastValidValue(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected string key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string key = info[0].As<String>().Utf8Value();
+    double value = g_monitor->getLastValidValue(key);
+    return Number::New(env, value);
+}
+
+// Start the native background sampler
+Value StartSampler(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Error::New(env, "Expected number rate in Hz").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    double raplHz = info[0].As<Number>().DoubleValue();
+    double sensorHz = 10.0;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        sensorHz = info[1].As<Number>().DoubleValue();
+    }
+    
+    bool started = g_monitor->startSampler(raplHz, sensorHz);
+    return Boolean::New(env, started);
+}
+
+// Stop the native background sampler
+Value StopSampler(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    g_monitor->stopSampler();
+    return Boolean::New(env, true);
+}
+
+// Subscribe to sensor groups at a rate; the sampler only reads subscribed groups
+Value Subscribe(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsNumber()) {
+        Error::New(env, "Expected array of sensor groups and number rate in Hz").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Array names = info[0].As<Array>();
+    std::vector<std::string> groups;
+    for (uint32_t i = 0; i < names.Length(); i++) {
+        Value name = names[i];
+        if (!name.IsString()) {
+            Error::New(env, "Sensor groups must be strings").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        groups.push_back(name.As<String>().Utf8Value());
+    }
+    
+    std::string error;
+    int id = g_monitor->subscribe(groups, info[1].As<Number>().DoubleValue(), error);
+    if (id < 0) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Number::New(env, id);
+}
+
+Value Unsubscribe(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Error::New(env, "Expected number subscription id").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    return Boolean::New(env, g_monitor->unsubscribe(info[0].As<Number>().Int32Value()));
+}
+
+// { running, error }: error is why the thread last failed to start or stopped, or null
+Value GetSamplerStatus(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Object result = Object::New(env);
+    result.Set("running", Boolean::New(env, g_monitor->isSamplerRunning()));
+    std::string error = g_monitor->getSamplerError();
+    result.Set("error", error.empty() ? env.Null() : String::New(env, error));
+    return result;
+}
+
+// Effective per-group rates in Hz; 0 means the group is not being read
+Value GetSamplingRates(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Object result = Object::New(env);
+    for (const auto& entry : g_monitor->getSamplingRates()) {
+        result.Set(entry.first, Number::New(env, entry.second));
+    }
+    return result;
+}
+
+// Get the channel names that sample records index into
+Value GetSamplerChannels(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint64_t generation = 0;
+    std::vector<std::string> channels = g_monitor->getSamplerChannels(generation);
+    Array names = Array::New(env, channels.size());
+    for (size_t i = 0; i < channels.size(); i++) {
+        names[i] = String::New(env, channels[i]);
+    }
+    
+    Object result = Object::New(env);
+    result.Set("generation", Number::New(env, (double)generation));
+    result.Set("channels", names);
+    return result;
+}
+
+// Current per-channel read rates, index-aligned with getSamplerChannels()
+Value GetSamplerCadence(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint64_t generation = 0;
+    std::vector<double> cadence = g_monitor->getSamplerCadence(generation);
+    Float64Array rates = Float64Array::New(env, cadence.size());
+    std::copy(cadence.begin(), cadence.end(), rates.Data());
+    
+    Object result = Object::New(env);
+    result.Set("generation", Number::New(env, (double)generation));
+    result.Set("rates", rates);
+    return result;
+}
+
+// Sampler records as parallel typed arrays, for readSamples() and readSharedSamples()
+static Object SamplesToObject(Env env, const std::vector<SampleRecord>& records, uint64_t sinceSeq,
+                              uint64_t dropped, uint64_t generation) {
+    Float64Array timestamps = Float64Array::New(env, records.size());
+    Uint32Array channels = Uint32Array::New(env, records.size());
+    Float64Array values = Float64Array::New(env, records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        timestamps[i] = (double)records[i].timestamp_us / 1000.0; // Milliseconds, like Date.now()
+        channels[i] = records[i].channel;
+        values[i] = records[i].value;
+    }
+    
+    uint64_t lastSeq = records.empty() ? sinceSeq + dropped : records.back().seq;
+    Object result = Object::New(env);
+    result.Set("seq", Number::New(env, (double)lastSeq));
+    result.Set("generation", Number::New(env, (double)generation));
+    result.Set("dropped", Number::New(env, (double)dropped));
+    result.Set("timestamps", timestamps);
+    result.Set("channels", channels);
+    result.Set("values", values);
+    return result;
+}
+
+// Drain sampler records published after sinceSeq as parallel typed arrays
+Value ReadSamples(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Error::New(env, "Expected number sinceSeq").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint64_t sinceSeq = (uint64_t)info[0].As<Number>().Int64Value();
+    size_t maxRecords = 65536;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        maxRecords = (size_t)std::max<int64_t>(1, info[1].As<Number>().Int64Value());
+    }
+    
+    std::vector<SampleRecord> records;
+    records.reserve(std::min<size_t>(maxRecords, 4096));
+    uint64_t generation = 0;
+    uint64_t dropped = g_monitor->readSamples(sinceSeq, maxRecords, records, generation);
+    return SamplesToObject(env, records, sinceSeq, dropped, generation);
+}
+
+// Start mirroring the sampler into a POSIX shared-memory segment ("/name")
+Value OpenSharedSnapshot(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected shared snapshot name").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string error;
+    if (!g_monitor->openSharedSnapshot(info[0].As<String>().Utf8Value(), error)) {
+        Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Boolean::New(env, true);
+}
+
+Value CloseSharedSnapshot(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    g_monitor->closeSharedSnapshot();
+    return Boolean::New(env, true);
+}
+
+// Read-only mappings of shared snapshots, by name. Like the session log
+// readers these work before initialize(): a viewer only maps what another
+// process publishes. Bindings only run on the JS thread, so no lock.
+static std::map<std::string, std::unique_ptr<ShmSnapshotReader>> g_shm_readers;
+
+// Reopens the mapping once its writer has closed it or exited
+static ShmSnapshotReader* SharedSnapshotReader(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Error::New(env, "Expected shared snapshot name").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    
+    std::string name = info[0].As<String>().Utf8Value();
+    std::unique_ptr<ShmSnapshotReader>& reader = g_shm_readers[name];
+    if (!reader) {
+        reader.reset(new ShmSnapshotReader());
+    }
+    if (reader->isStale() && !reader->open(name)) {
+        Error::New(env, reader->error()).ThrowAsJavaScriptException();
+        g_shm_readers.erase(name);
+        return nullptr;
+    }
+    return reader.get();
+}
+
+// Same layout as snapshot(): Float64Array [schemaVersion, ...values], or null
+// before the writer's first sensor tick. Pass the previous array to reuse it.
+Value ReadSharedSnapshot(const CallbackInfo& info) {
+    Env env = info.Env();
+    ShmSnapshotReader* reader = SharedSnapshotReader(info);
+    if (reader == nullptr) {
+        return env.Null();
+    }
+    
+    std::vector<double> values;
+    uint64_t version = 0;
+    uint64_t timestampUs = 0;
+    if (!reader->readSnapshot(version, timestampUs, values)) {
+        return env.Null();
+    }
+    
+    Float64Array target;
+    if (info.Length() > 1 && info[1].IsTypedArray() &&
+        info[1].As<TypedArray>().TypedArrayType() == napi_float64_array) {
+        target = info[1].As<Float64Array>();
+    }
+    if (target.IsEmpty() || target.ElementLength() != values.size() + 1) {
+        target = Float64Array::New(env, values.size() + 1);
+    }
+    
+    double* out = target.Data();
+    out[0] = (double)version;
+    std::copy(values.begin(), values.end(), out + 1);
+    return target;
+}
+
+// Same shape as getSchema(), read from the segment
+Value GetSharedSnapshotSchema(const CallbackInfo& info) {
+    Env env = info.Env();
+    ShmSnapshotReader* reader = SharedSnapshotReader(info);
+    if (reader == nullptr) {
+        return env.Null();
+    }
+    
+    uint64_t version = 0;
+    std::vector<std::string> rows;
+    if (!reader->readSchema(version, rows)) {
+        return env.Null();
+    }
+    
+    // Rows are "group\tname\tlabel\tunit"
+    static const char* const keys[] = { "group", "name", "label", "unit" };
+    Array list = Array::New(env, rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        const std::string& row = rows[i];
+        Object field = Object::New(env);
+        size_t start = 0;
+        for (const char* key : keys) {
+            size_t end = std::min(row.find('\t', start), row.size());
+            field.Set(key, String::New(env, start < row.size() ? row.substr(start, end - start) : ""));
+            start = end + 1;
+        }
+        list[i] = field;
+    }
+    
+    Object result = Object::New(env);
+    result.Set("version", Number::New(env, (double)version));
+    result.Set("fields", list);
+    return result;
+}
+
+// Same shape as getSamplerChannels(), read from the segment
+Value GetSharedSamplerChannels(const CallbackInfo& info) {
+    Env env = info.Env();
+    ShmSnapshotReader* reader = SharedSnapshotReader(info);
+    if (reader == nullptr) {
+        return env.Null();
+    }
+    
+    uint64_t generation = 0;
+    std::vector<std::string> channels;
+    if (!reader->readChannels(generation, channels)) {
+        return env.Null();
+    }
+    
+    Array names = Array::New(env, channels.size());
+    for (size_t i = 0; i < channels.size(); i++) {
+        names[i] = String::New(env, channels[i]);
+    }
+    
+    Object result = Object::New(env);
+    result.Set("generation", Number::New(env, (double)generation));
+    result.Set("channels", names);
+    return result;
+}
+
+// Same contract as readSamples(), after the segment name: (name, sinceSeq, maxRecords)
+Value ReadSharedSamples(const CallbackInfo& info) {
+    Env env = info.Env();
+    ShmSnapshotReader* reader = SharedSnapshotReader(info);
+    if (reader == nullptr) {
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[1].IsNumber()) {
+        Error::New(env, "Expected number sinceSeq").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint64_t sinceSeq = (uint64_t)info[1].As<Number>().Int64Value();
+    size_t maxRecords = 65536;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        maxRecords = (size_t)std::max<int64_t>(1, info[2].As<Number>().Int64Value());
+    }
+    
+    std::vector<SampleRecord> records;
+    records.reserve(std::min<size_t>(maxRecords, 4096));
+    uint64_t dropped = reader->readSamples(sinceSeq, maxRecords, records);
+    // Callers re-read the names with getSharedSamplerChannels() when this changes
+    return SamplesToObject(env, records, sinceSeq, dropped, reader->channelsGeneration());
+}
+
+// Writer pid and newest sequence numbers, so viewers can tell a stalled writer
+Value GetSharedSnapshotInfo(const CallbackInfo& info) {
+    Env env = info.Env();
+    ShmSnapshotReader* reader = SharedSnapshotReader(info);
+    if (reader == nullptr) {
+        return env.Null();
+    }
+    
+    std::vector<double> values;
+    uint64_t version = 0;
+    uint64_t timestampUs = 0;
+    bool hasSnapshot = reader->readSnapshot(version, timestampUs, values);
+    
+    Object result = Object::New(env);
+    result.Set("writerPid", Number::New(env, (double)reader->writerPid()));
+    result.Set("snapshotSeq", Number::New(env, (double)reader->snapshotSeq()));
+    result.Set("sampleSeq", Number::New(env, (double)reader->sampleHead()));
+    result.Set("schemaVersion", hasSnapshot ? Number::New(env, (double)version) : env.Null());
+    result.Set("timestamp", hasSnapshot ? Number::New(env, (double)timestampUs / 1000.0) : env.Null());
+    return result;
+}
+
+// Delta-encoded snapshot streams, one encoder per subscriber (see delta_frame.h)
+static std::map<uint32_t, std::unique_ptr<DeltaFrameEncoder>> g_frame_streams;
+static uint32_t g_next_frame_stream = 1;
+
+Value OpenSnapshotStream(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t id = g_next_frame_stream++;
+    g_frame_streams[id].reset(new DeltaFrameEncoder());
+    return Number::New(env, id);
+}
+
+// { version, full, count, bitmap: Uint8Array, values: Float64Array }
+// Both arrays view one ArrayBuffer (bitmap padded to 8 bytes), so a frame is a
+// single buffer to post or transfer. values holds only the fields whose bit is set.
+static Value EncodeSnapshotFrame(Env env, DeltaFrameEncoder& encoder, uint64_t version, const std::vector<double>& values) {
+    std::vector<uint8_t> bitmap;
+    std::vector<double> changed;
+    bool full = encoder.encode(version, values, bitmap, changed);
+    
+    size_t bitmapPadded = (bitmap.size() + 7) & ~(size_t)7;
+    ArrayBuffer buffer = ArrayBuffer::New(env, bitmapPadded + changed.size() * sizeof(double));
+    uint8_t* data = static_cast<uint8_t*>(buffer.Data());
+    std::memset(data, 0, bitmapPadded);
+    std::memcpy(data, bitmap.data(), bitmap.size());
+    std::memcpy(data + bitmapPadded, changed.data(), changed.size() * sizeof(double));
+    
+    Object frame = Object::New(env);
+    frame.Set("version", Number::New(env, (double)version));
+    frame.Set("full", Boolean::New(env, full));
+    frame.Set("count", Number::New(env, (double)values.size()));
+    frame.Set("bitmap", Uint8Array::New(env, bitmap.size(), buffer, 0));
+    frame.Set("values", Float64Array::New(env, changed.size(), buffer, bitmapPadded));
+    return frame;
+}
+
+// (streamId, reset) -> frame
+Value NextSnapshotFrame(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Error::New(env, "Expected snapshot stream id").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    auto it = g_frame_streams.find(info[0].As<Number>().Uint32Value());
+    if (it == g_frame_streams.end()) {
+        Error::New(env, "Unknown snapshot stream").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() > 1 && info[1].IsBoolean() && info[1].As<Boolean>().Value()) {
+        it->second->reset();
+    }
+    
+    std::vector<double> values;
+    uint64_t version = g_monitor->snapshot(values);
+    return EncodeSnapshotFrame(env, *it->second, version, values);
+}
+
+// One snapshot, taken on the threadpool, that every open stream's next frame is encoded from
+struct SnapshotTick {
+    uint64_t version;
+    std::vector<double> values;
+};
+
+// Encoders are only touched here, back on the JS thread
+static Value SnapshotFramesToObject(Env env, const SnapshotTick& tick) {
+    Object frames = Object::New(env);
+    for (auto& stream : g_frame_streams) {
+        frames.Set(String::New(env, std::to_string(stream.first)),
+                   EncodeSnapshotFrame(env, *stream.second, tick.version, tick.values));
+    }
+    return frames;
+}
+
+// (groups?) -> Promise<{ [streamId]: frame }>, so a 10 Hz tick costs the JS
+// thread only the encoding, however many subscribers there are. Groups left
+// out of the list are not read and stream as NaN.
+Value NextSnapshotFramesAsync(const CallbackInfo& info) {
+    uint32_t groups = SENSOR_GROUPS_ALL;
+    if (!SensorGroupsArg(info, 0, groups)) {
+        return info.Env().Null();
+    }
+    return QueuePromiseWorker<SnapshotTick>(info, [groups](SystemMonitor* monitor) {
+        SnapshotTick tick;
+        tick.version = monitor->snapshot(tick.values, POWER_CONSUMER_UI, groups);
+        return tick;
+    }, SnapshotFramesToObject);
+}
+
+Value CloseSnapshotStream(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        g_frame_streams.erase(info[0].As<Number>().Uint32Value());
+    }
+    return Boolean::New(env, true);
+}
+
+// Serves /metrics from its own thread; like g_monitor it lives for the process
+static MetricsServer* g_metrics_server = nullptr;
+
+Value StartMetricsServer(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_monitor == nullptr) {
+        Error::New(env, "SystemMonitor not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t port = MetricsServer::DEFAULT_PORT;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        port = info[0].As<Number>().Uint32Value();
+    }
+    if (port > 65535) {
+        Error::New(env, "Port must be between 0 and 65535").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string address = "127.0.0.1";
+    if (info.Length() > 1 && info[1].IsString()) {
+        address = info[1].As<String>().Utf8Value();
+    }
+    
+    if (g_metrics_server == nullptr) {
+        g_metrics_server = new MetricsServer();
+    }
+    if (!g_metrics_server->start(g_monitor, address, (uint16_t)port)) {
+        Error::New(env, g_metrics_server->error()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Number::New(env, g_metrics_server->port());
+}
+
+Value StopMetricsServer(const CallbackInfo& info) {
+    Env env = info.Env();
+    if (g_metrics_server != nullptr) {
+        g_metrics_server->stop();
+    }
+    return Boolean::New(env, true);
 }
 
 // Module initialization
 Object Init(Env env, Object exports) {
     exports.Set(String::New(env, "initialize"), Function::New(env, Initialize));
+    exports.Set(String::New(env, "rescan"), Function::New(env, Rescan));
     exports.Set(String::New(env, "getCPUCores"), Function::New(env, GetCPUCores));
+    exports.Set(String::New(env, "getCPULoad"), Function::New(env, GetCPULoad));
+    exports.Set(String::New(env, "getGPUData"), Function::New(env, GetGPUData));
+    exports.Set(String::New(env, "getGPUBackend"), Function::New(env, GetGPUBackend));
+    exports.Set(String::New(env, "getDiskHealth"), Function::New(env, GetDiskHealth));
+    exports.Set(String::New(env, "getDiskHealthAsync"), Function::New(env, GetDiskHealthAsync));
+    exports.Set(String::New(env, "getTopProcesses"), Function::New(env, GetTopProcesses));
+    exports.Set(String::New(env, "getTopProcessesAsync"), Function::New(env, GetTopProcessesAsync));
+    exports.Set(String::New(env, "getEnergyByProcess"), Function::New(env, GetEnergyByProcess));
+    exports.Set(String::New(env, "getEnergyByProcessAsync"), Function::New(env, GetEnergyByProcessAsync));
+    exports.Set(String::New(env, "getEnergyByCgroup"), Function::New(env, GetEnergyByCgroup));
+    exports.Set(String::New(env, "getEnergyByCgroupAsync"), Function::New(env, GetEnergyByCgroupAsync));
     exports.Set(String::New(env, "getTemperatureSensors"), Function::New(env, GetTemperatureSensors));
     exports.Set(String::New(env, "getDDR5Temperatures"), Function::New(env, GetDDR5Temperatures));
     exports.Set(String::New(env, "getRAPLPower"), Function::New(env, GetRAPLPower));
     exports.Set(String::New(env, "getRAPLPowerCalculated"), Function::New(env, GetRAPLPowerCalculated));
     exports.Set(String::New(env, "getBatteryCalculated"), Function::New(env, GetBatteryCalculated));
+    exports.Set(String::New(env, "enableHardwareCounters"), Function::New(env, EnableHardwareCounters));
+    exports.Set(String::New(env, "getRAPLPowerTree"), Function::New(env, GetRAPLPowerTree));
+    exports.Set(String::New(env, "setPowerWindows"), Function::New(env, SetPowerWindows));
+    exports.Set(String::New(env, "getPowerWindows"), Function::New(env, GetPowerWindows));
+    exports.Set(String::New(env, "getCPUCoresAsync"), Function::New(env, GetCPUCoresAsync));
+    exports.Set(String::New(env, "getCPULoadAsync"), Function::New(env, GetCPULoadAsync));
+    exports.Set(String::New(env, "getGPUDataAsync"), Function::New(env, GetGPUDataAsync));
+    exports.Set(String::New(env, "getTemperatureSensorsAsync"), Function::New(env, GetTemperatureSensorsAsync));
+    exports.Set(String::New(env, "getDDR5TemperaturesAsync"), Function::New(env, GetDDR5TemperaturesAsync));
+    exports.Set(String::New(env, "getRAPLPowerAsync"), Function::New(env, GetRAPLPowerAsync));
+    exports.Set(String::New(env, "getRAPLPowerCalculatedAsync"), Function::New(env, GetRAPLPowerCalculatedAsync));
+    exports.Set(String::New(env, "getBatteryCalculatedAsync"), Function::New(env, GetBatteryCalculatedAsync));
+    exports.Set(String::New(env, "sampleAllAsync"), Function::New(env, SampleAllAsync));
+    exports.Set(String::New(env, "getSchema"), Function::New(env, GetSchema));
+    exports.Set(String::New(env, "snapshot"), Function::New(env, Snapshot));
+    exports.Set(String::New(env, "getIODevices"), Function::New(env, GetIODevices));
+    exports.Set(String::New(env, "readIORates"), Function::New(env, ReadIORates));
+    exports.Set(String::New(env, "openSessionLog"), Function::New(env, OpenSessionLog));
+    exports.Set(String::New(env, "appendSessionLog"), Function::New(env, AppendSessionLog));
+    exports.Set(String::New(env, "closeSessionLog"), Function::New(env, CloseSessionLog));
+    exports.Set(String::New(env, "getSessionLogInfo"), Function::New(env, GetSessionLogInfo));
+    exports.Set(String::New(env, "readSessionLog"), Function::New(env, ReadSessionLog));
+    exports.Set(String::New(env, "exportSessionLogCSV"), Function::New(env, ExportSessionLogCSV));
+    exports.Set(String::New(env, "registerMetric"), Function::New(env, RegisterMetric));
     exports.Set(String::New(env, "updateStats"), Function::New(env, UpdateStats));
+    exports.Set(String::New(env, "updateStatsBatch"), Function::New(env, UpdateStatsBatch));
     exports.Set(String::New(env, "getStats"), Function::New(env, GetStats));
+    exports.Set(String::New(env, "openHistory"), Function::New(env, OpenHistory));
+    exports.Set(String::New(env, "closeHistory"), Function::New(env, CloseHistory));
+    exports.Set(String::New(env, "takeHistoryRefused"), Function::New(env, TakeHistoryRefused));
+    exports.Set(String::New(env, "queryRange"), Function::New(env, QueryRange));
+    exports.Set(String::New(env, "getStatsColumns"), Function::New(env, GetStatsColumns));
+    exports.Set(String::New(env, "getMetricNames"), Function::New(env, GetMetricNames));
+    exports.Set(String::New(env, "getQuantiles"), Function::New(env, GetQuantiles));
+    exports.Set(String::New(env, "getQuantileSketch"), Function::New(env, GetQuantileSketch));
+    exports.Set(String::New(env, "mergeQuantileSketch"), Function::New(env, MergeQuantileSketch));
     exports.Set(String::New(env, "resetStats"), Function::New(env, ResetStats));
     exports.Set(String::New(env, "hasLastValidValue"), Function::New(env, HasLastValidValue));
     exports.Set(String::New(env, "getLastValidValue"), Function::New(env, GetLastValidValue));
+    exports.Set(String::New(env, "startSampler"), Function::New(env, StartSampler));
+    exports.Set(String::New(env, "stopSampler"), Function::New(env, StopSampler));
+    exports.Set(String::New(env, "subscribe"), Function::New(env, Subscribe));
+    exports.Set(String::New(env, "unsubscribe"), Function::New(env, Unsubscribe));
+    exports.Set(String::New(env, "getSamplingRates"), Function::New(env, GetSamplingRates));
+    exports.Set(String::New(env, "getSamplerStatus"), Function::New(env, GetSamplerStatus));
+    exports.Set(String::New(env, "getSamplerChannels"), Function::New(env, GetSamplerChannels));
+    exports.Set(String::New(env, "getSamplerCadence"), Function::New(env, GetSamplerCadence));
+    exports.Set(String::New(env, "readSamples"), Function::New(env, ReadSamples));
+    exports.Set(String::New(env, "openSharedSnapshot"), Function::New(env, OpenSharedSnapshot));
+    exports.Set(String::New(env, "closeSharedSnapshot"), Function::New(env, CloseSharedSnapshot));
+    exports.Set(String::New(env, "readSharedSnapshot"), Function::New(env, ReadSharedSnapshot));
+    exports.Set(String::New(env, "getSharedSnapshotSchema"), Function::New(env, GetSharedSnapshotSchema));
+    exports.Set(String::New(env, "getSharedSamplerChannels"), Function::New(env, GetSharedSamplerChannels));
+    exports.Set(String::New(env, "readSharedSamples"), Function::New(env, ReadSharedSamples));
+    exports.Set(String::New(env, "getSharedSnapshotInfo"), Function::New(env, GetSharedSnapshotInfo));
+    exports.Set(String::New(env, "startMetricsServer"), Function::New(env, StartMetricsServer));
+    exports.Set(String::New(env, "stopMetricsServer"), Function::New(env, StopMetricsServer));
+    exports.Set(String::New(env, "openSnapshotStream"), Function::New(env, OpenSnapshotStream));
+    exports.Set(String::New(env, "nextSnapshotFrame"), Function::New(env, NextSnapshotFrame));
+    exports.Set(String::New(env, "nextSnapshotFramesAsync"), Function::New(env, NextSnapshotFramesAsync));
+    exports.Set(String::New(env, "closeSnapshotStream"), Function::New(env, CloseSnapshotStream));
     return exports;
 }
 
@@ -0,0 +1,552 @@
+// system-monitor-daemon: the SystemMonitor core without Electron.
+//
+// Samples snapshot() at a fixed rate, optionally records every tick to a
+// session log and the history store, and answers newline-terminated
+// requests on a Unix domain socket:
+//
+//   schema    {"version":N,"fields":[{"group":..,"name":..,"label":..,"unit":..}]}
+//   snapshot  {"version":N,"timestamp":ms,"values":[...]}   (NaN is null)
+//   info      {"pid":..,"rate":..,"ticks":..,"clients":..,"log":..}
+//
+// Each reply is one JSON line. With --shm the background sampler also
+// publishes to shared memory for readers that would rather map it, and with
+// --metrics the OpenMetrics exporter serves /metrics over HTTP. Run it in
+// the foreground (under systemd or a supervisor); SIGINT / SIGTERM close the
+// log and remove the socket.
+#include "system_monitor.h"
+#include "metrics_server.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const size_t MAX_CLIENTS = 64;
+static const size_t MAX_REQUEST_BYTES = 4096;   // A client that sends more without a newline is dropped
+static const size_t MAX_PENDING_BYTES = 1 << 20; // Or that stops reading its replies
+
+struct DaemonOptions {
+    std::string socket_path;
+    double rate_hz;
+    std::string log_path;
+    uint32_t chunk_rows;
+    bool compress;
+    std::string history_path;
+    std::string shm_name;
+    std::string metrics_address;
+    int metrics_port;           // -1 = no exporter
+    bool hardware_counters;
+};
+
+struct Client {
+    int fd;
+    std::string in;
+    std::string out;
+};
+
+struct DaemonState {
+    SystemMonitor monitor;
+    DaemonOptions options;
+    
+    uint64_t schema_version;
+    bool has_schema;
+    std::vector<SnapshotField> fields;
+    std::string schema_json;
+    std::vector<double> values;
+    int64_t timestamp_ms;
+    uint64_t ticks;
+    
+    // Session log columns are fixed per file, so a schema change rolls to a new one
+    bool logging;
+    std::string log_file;
+    int log_rolls;
+    std::vector<int32_t> metric_ids;
+    
+    std::vector<Client> clients;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --socket PATH       Unix socket to serve snapshots on (default $XDG_RUNTIME_DIR/system-monitor.sock)\n"
+            "  --rate HZ           Snapshot rate (default 1, max 100)\n"
+            "  --log PATH          Record every snapshot to a columnar session log (.smlog)\n"
+            "  --chunk-rows N      Rows per session log chunk (default %u)\n"
+            "  --compress          zstd-compress session log chunks (when built with zstd)\n"
+            "  --history PATH      Keep a queryable min/max/avg history of every field\n"
+            "  --shm NAME          Also publish the sampler to shared memory (/dev/shm/NAME)\n"
+            "  --metrics [ADDR:]PORT  Serve OpenMetrics on http://ADDR:PORT/metrics (default address 127.0.0.1)\n"
+            "  --perf              Enable per-CPU hardware counters\n",
+            argv0, SessionLogWriter::DEFAULT_CHUNK_ROWS);
+}
+
+static bool parseOptions(int argc, char** argv, DaemonOptions& options) {
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    options.socket_path = std::string(runtime != nullptr && runtime[0] != '\0' ? runtime : "/tmp") +
+                          "/system-monitor.sock";
+    options.rate_hz = 1.0;
+    options.chunk_rows = SessionLogWriter::DEFAULT_CHUNK_ROWS;
+    options.compress = false;
+    options.metrics_address = "127.0.0.1";
+    options.metrics_port = -1;
+    options.hardware_counters = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--rate" && hasValue) {
+            options.rate_hz = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--log" && hasValue) {
+            options.log_path = argv[++i];
+        } else if (arg == "--chunk-rows" && hasValue) {
+            options.chunk_rows = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--compress") {
+            options.compress = true;
+        } else if (arg == "--history" && hasValue) {
+            options.history_path = argv[++i];
+        } else if (arg == "--shm" && hasValue) {
+            options.shm_name = argv[++i];
+            if (options.shm_name[0] != '/') {
+                options.shm_name = "/" + options.shm_name;
+            }
+        } else if (arg == "--metrics" && hasValue) {
+            // The port follows the last colon, so "[::1]:9184" and "::1:9184" both work
+            std::string value = argv[++i];
+            size_t colon = value.rfind(':');
+            if (colon != std::string::npos) {
+                options.metrics_address = value.substr(0, colon);
+                if (options.metrics_address.size() >= 2 && options.metrics_address.front() == '[' &&
+                    options.metrics_address.back() == ']') {
+                    options.metrics_address = options.metrics_address.substr(1, options.metrics_address.size() - 2);
+                }
+            }
+            char* end = nullptr;
+            unsigned long port = std::strtoul(value.c_str() + (colon == std::string::npos ? 0 : colon + 1), &end, 10);
+            if (end == nullptr || *end != '\0' || port > 65535) {
+                return false;
+            }
+            options.metrics_port = (int)port;
+        } else if (arg == "--perf") {
+            options.hardware_counters = true;
+        } else {
+            return false;
+        }
+    }
+    if (!(options.rate_hz > 0.0)) {
+        return false;
+    }
+    options.rate_hz = std::min(options.rate_hz, 100.0);
+    return !options.socket_path.empty();
+}
+
+static void appendJSONString(std::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        unsigned char u = (unsigned char)c;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", u);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static void appendJSONNumber(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char number[32];
+    snprintf(number, sizeof(number), "%.10g", value);
+    out += number;
+}
+
+static std::string columnName(const SnapshotField& field) {
+    return field.group + ":" + field.name + "/" + field.label;
+}
+
+static int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// "<stem>-<n><ext>" for the n-th file of a rolled session log
+static std::string rolledLogPath(const std::string& path, int roll) {
+    if (roll == 0) {
+        return path;
+    }
+    size_t slash = path.rfind('/');
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        dot = path.size();
+    }
+    return path.substr(0, dot) + "-" + std::to_string(roll) + path.substr(dot);
+}
+
+static void refreshSchema(DaemonState& state) {
+    state.fields = state.monitor.getSnapshotSchema(state.schema_version);
+    state.has_schema = true;
+    
+    std::string& json = state.schema_json;
+    json = "{\"version\":" + std::to_string(state.schema_version) + ",\"fields\":[";
+    for (size_t i = 0; i < state.fields.size(); i++) {
+        const SnapshotField& field = state.fields[i];
+        json += i == 0 ? "{\"group\":" : ",{\"group\":";
+        appendJSONString(json, field.group);
+        json += ",\"name\":";
+        appendJSONString(json, field.name);
+        json += ",\"label\":";
+        appendJSONString(json, field.label);
+        json += ",\"unit\":";
+        appendJSONString(json, field.unit);
+        json += '}';
+    }
+    json += "]}\n";
+    
+    std::vector<std::string> columns;
+    columns.reserve(state.fields.size());
+    for (const auto& field : state.fields) {
+        columns.push_back(columnName(field));
+    }
+    
+    if (!state.options.history_path.empty()) {
+        state.metric_ids.clear();
+        for (const auto& column : columns) {
+            state.metric_ids.push_back(state.monitor.registerMetric(column));
+        }
+    }
+    
+    if (!state.options.log_path.empty()) {
+        if (state.logging) {
+            state.monitor.closeSessionLog();
+            state.log_rolls++;
+        }
+        std::string error;
+        state.log_file = rolledLogPath(state.options.log_path, state.log_rolls);
+        state.logging = state.monitor.openSessionLog(state.log_file, columns, state.options.chunk_rows,
+                                                     state.options.compress, error);
+        if (!state.logging) {
+            fprintf(stderr, "system-monitor-daemon: session log disabled: %s\n", error.c_str());
+        }
+    }
+}
+
+static void tick(DaemonState& state) {
+    uint64_t version = state.monitor.snapshot(state.values);
+    state.timestamp_ms = wallClockMs();
+    state.ticks++;
+    if (!state.has_schema || version != state.schema_version) {
+        refreshSchema(state);
+        // A rescan between snapshot() and the schema read would misalign them
+        if (state.schema_version != version) {
+            state.monitor.snapshot(state.values);
+        }
+    }
+    
+    if (!state.metric_ids.empty() && state.metric_ids.size() == state.values.size()) {
+        state.monitor.updateStatsBatch(state.metric_ids.data(), state.values.data(), state.values.size());
+        if (!state.options.history_path.empty()) {
+            for (const auto& name : state.monitor.takeHistoryRefused()) {
+                fprintf(stderr, "system-monitor-daemon: history file full, not recording %s\n", name.c_str());
+            }
+        }
+    }
+    if (state.logging) {
+        std::string error;
+        if (state.monitor.appendSessionLog(state.timestamp_ms, state.values.data(), state.values.size(), error) < 0) {
+            fprintf(stderr, "system-monitor-daemon: session log stopped: %s\n", error.c_str());
+            state.monitor.closeSessionLog();
+            state.logging = false;
+        }
+    }
+}
+
+static std::string snapshotJSON(const DaemonState& state) {
+    std::string json = "{\"version\":" + std::to_string(state.schema_version) +
+                       ",\"timestamp\":" + std::to_string(state.timestamp_ms) + ",\"values\":[";
+    json.reserve(json.size() + state.values.size() * 12 + 4);
+    for (size_t i = 0; i < state.values.size(); i++) {
+        if (i > 0) {
+            json += ',';
+        }
+        appendJSONNumber(json, state.values[i]);
+    }
+    json += "]}\n";
+    return json;
+}
+
+static std::string infoJSON(const DaemonState& state) {
+    std::string json = "{\"pid\":" + std::to_string(getpid()) + ",\"rate\":";
+    appendJSONNumber(json, state.options.rate_hz);
+    json += ",\"ticks\":" + std::to_string(state.ticks);
+    json += ",\"clients\":" + std::to_string(state.clients.size());
+    json += ",\"log\":";
+    if (state.logging) {
+        appendJSONString(json, state.log_file);
+    } else {
+        json += "null";
+    }
+    json += "}\n";
+    return json;
+}
+
+static void handleRequest(DaemonState& state, Client& client, const std::string& request) {
+    if (request == "snapshot") {
+        client.out += snapshotJSON(state);
+    } else if (request == "schema") {
+        client.out += state.schema_json;
+    } else if (request == "info") {
+        client.out += infoJSON(state);
+    } else if (!request.empty()) {
+        client.out += "{\"error\":";
+        appendJSONString(client.out, "unknown request: " + request);
+        client.out += "}\n";
+    }
+}
+
+// Returns false when the client has gone away or misbehaved
+static bool readClient(DaemonState& state, Client& client) {
+    char buf[1024];
+    for (;;) {
+        ssize_t n = read(client.fd, buf, sizeof(buf));
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client.in.append(buf, (size_t)n);
+        
+        size_t start = 0;
+        size_t newline;
+        while ((newline = client.in.find('\n', start)) != std::string::npos) {
+            std::string request = client.in.substr(start, newline - start);
+            if (!request.empty() && request.back() == '\r') {
+                request.pop_back();
+            }
+            handleRequest(state, client, request);
+            start = newline + 1;
+        }
+        client.in.erase(0, start);
+        if (client.in.size() > MAX_REQUEST_BYTES || client.out.size() > MAX_PENDING_BYTES) {
+            return false;
+        }
+    }
+}
+
+static bool writeClient(Client& client) {
+    while (!client.out.empty()) {
+        ssize_t n = send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client.out.erase(0, (size_t)n);
+    }
+    return true;
+}
+
+static int listenOn(const std::string& path) {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "system-monitor-daemon: socket path too long: %s\n", path.c_str());
+        return -1;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    
+    // Replace a socket left behind by a daemon that didn't shut down cleanly,
+    // but never a regular file someone pointed --socket at by mistake
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path.c_str());
+    }
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "system-monitor-daemon: socket: %s\n", std::strerror(errno));
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        fprintf(stderr, "system-monitor-daemon: cannot listen on %s: %s\n", path.c_str(), std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void acceptClients(DaemonState& state, int listen_fd) {
+    for (;;) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (state.clients.size() >= MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        state.clients.push_back(Client{ fd, std::string(), std::string() });
+    }
+}
+
+int main(int argc, char** argv) {
+    DaemonState state;
+    if (!parseOptions(argc, argv, state.options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    state.schema_version = 0;
+    state.has_schema = false;
+    state.timestamp_ms = 0;
+    state.ticks = 0;
+    state.logging = false;
+    state.log_rolls = 0;
+    
+    // Signals arrive through the poll loop, so shutdown never races a tick
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    signal(SIGPIPE, SIG_IGN);
+    
+    state.monitor.initialize();
+    if (state.options.hardware_counters && state.monitor.enableHardwareCounters(true) == 0) {
+        fprintf(stderr, "system-monitor-daemon: hardware counters unavailable\n");
+    }
+    if (!state.options.history_path.empty()) {
+        std::string error;
+        if (!state.monitor.openHistory(state.options.history_path, 0, {}, error)) {
+            fprintf(stderr, "system-monitor-daemon: history disabled: %s\n", error.c_str());
+            state.options.history_path.clear();
+        }
+    }
+    
+    if (!state.options.shm_name.empty()) {
+        std::string error;
+        if (state.monitor.openSharedSnapshot(state.options.shm_name, error)) {
+            // Every group, battery included, so each tick's snapshot() takes the
+            // sensors from the same sampler readings the segment publishes instead
+            // of a second sysfs sweep; RAPL power is still per tick, from the counters
+            if (state.monitor.subscribe({ "rapl" }, std::max(state.options.rate_hz, 10.0), error) < 0 ||
+                state.monitor.subscribe({ "cpu", "ddr5", "cpufreq", "battery" }, state.options.rate_hz, error) < 0) {
+                fprintf(stderr, "system-monitor-daemon: shared snapshot sampler failed: %s\n", error.c_str());
+            }
+        } else {
+            fprintf(stderr, "system-monitor-daemon: shared snapshot disabled: %s\n", error.c_str());
+        }
+    }
+    
+    // Renders from its own thread; snapshot() and the stats are guarded by the monitor
+    MetricsServer metrics;
+    if (state.options.metrics_port >= 0) {
+        if (metrics.start(&state.monitor, state.options.metrics_address, (uint16_t)state.options.metrics_port)) {
+            fprintf(stderr, "system-monitor-daemon: metrics on http://%s:%u/metrics\n",
+                    state.options.metrics_address.c_str(), metrics.port());
+        } else {
+            fprintf(stderr, "system-monitor-daemon: metrics disabled: %s\n", metrics.error().c_str());
+        }
+    }
+    
+    int listen_fd = listenOn(state.options.socket_path);
+    if (listen_fd < 0 || signal_fd < 0) {
+        return 1;
+    }
+    
+    auto period = std::chrono::nanoseconds((int64_t)(1e9 / state.options.rate_hz));
+    auto deadline = std::chrono::steady_clock::now();
+    std::vector<struct pollfd> fds;
+    bool running = true;
+    
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            tick(state);
+            // Absolute deadlines, as in the sampler, but skip missed ticks rather than bursting
+            deadline += period;
+            if (deadline < now) {
+                deadline = now + period;
+            }
+        }
+        
+        fds.clear();
+        fds.push_back(pollfd{ signal_fd, POLLIN, 0 });
+        fds.push_back(pollfd{ listen_fd, POLLIN, 0 });
+        for (const auto& client : state.clients) {
+            fds.push_back(pollfd{ client.fd, (short)(POLLIN | (client.out.empty() ? 0 : POLLOUT)), 0 });
+        }
+        
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        int timeout = (int)std::max<int64_t>(0, wait.count() + 1);
+        if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) {
+            fprintf(stderr, "system-monitor-daemon: poll: %s\n", std::strerror(errno));
+            break;
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            running = false;
+        }
+        
+        // Clients are serviced in the order they were polled; new ones join next round
+        size_t polled = fds.size() - 2;
+        std::vector<Client> kept;
+        kept.reserve(state.clients.size());
+        for (size_t i = 0; i < polled; i++) {
+            Client& client = state.clients[i];
+            short revents = fds[i + 2].revents;
+            bool alive = !(revents & (POLLERR | POLLNVAL));
+            if (alive && (revents & (POLLIN | POLLHUP))) {
+                alive = readClient(state, client);
+            }
+            if (alive) {
+                alive = writeClient(client);
+            }
+            if (alive) {
+                kept.push_back(std::move(client));
+            } else {
+                close(client.fd);
+            }
+        }
+        state.clients.swap(kept);
+        
+        if (fds[1].revents & POLLIN) {
+            acceptClients(state, listen_fd);
+        }
+    }
+    
+    for (const auto& client : state.clients) {
+        close(client.fd);
+    }
+    close(listen_fd);
+    unlink(state.options.socket_path.c_str());
+    close(signal_fd);
+    metrics.stop();
+    if (state.logging) {
+        state.monitor.closeSessionLog();
+    }
+    state.monitor.closeHistory();
+    state.monitor.stopSampler();
+    state.monitor.closeSharedSnapshot();
+    return 0;
+}
@@ -0,0 +1,229 @@
+// system-monitor-tests: checks the decoders behind the GPU and SMART paths
+// against fixed inputs, without the hardware. Not shipped.
+//
+// NVML is replaced by an NVMLApi table of fake functions handed to
+// GPUMonitor::initialize(api); the SMART decoders read the pages in
+// test_fixtures/smart, or in the directory given as the first argument.
+// Exits non-zero if any check fails.
+#include "disk_health.h"
+#include "gpu_monitor.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static int g_failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL %s\n", what.c_str());
+        g_failures++;
+    }
+}
+
+static void checkValue(double actual, double expected, const std::string& what) {
+    bool ok = std::isnan(expected) ? std::isnan(actual) : actual == expected;
+    check(ok, what + ": got " + std::to_string(actual) + ", expected " + std::to_string(expected));
+}
+
+// Fake NVML: two devices whose load moves on every read, and no fan reading
+static const int FAKE_NVML_NOT_SUPPORTED = 3;
+static const int FAKE_NVML_CLOCK_MEM = 2;
+static unsigned int g_fake_tick = 0;
+static int g_fake_devices[2];
+
+static unsigned int fakeIndex(void* device) {
+    return (unsigned int)((int*)device - g_fake_devices);
+}
+
+static int fakeInit() { return 0; }
+static int fakeShutdown() { return 0; }
+
+static int fakeDeviceGetCount(unsigned int* count) {
+    *count = 2;
+    return 0;
+}
+
+static int fakeDeviceGetHandleByIndex(unsigned int index, void** device) {
+    if (index >= 2) {
+        return FAKE_NVML_NOT_SUPPORTED;
+    }
+    *device = &g_fake_devices[index];
+    return 0;
+}
+
+static int fakeDeviceGetName(void* device, char* name, unsigned int length) {
+    snprintf(name, length, "Fake GPU %u", fakeIndex(device));
+    return 0;
+}
+
+static int fakeDeviceGetUtilizationRates(void* device, NVMLUtilization* utilization) {
+    utilization->gpu = (g_fake_tick++ * 7 + fakeIndex(device) * 50) % 101;
+    utilization->memory = utilization->gpu / 2;
+    return 0;
+}
+
+static int fakeDeviceGetMemoryInfo(void* device, NVMLMemory* memory) {
+    memory->total = 8ULL << 30;
+    memory->used = (1ULL + fakeIndex(device)) << 30;
+    memory->free = memory->total - memory->used;
+    return 0;
+}
+
+static int fakeDeviceGetPowerUsage(void* device, unsigned int* milliwatts) {
+    *milliwatts = 30000 + fakeIndex(device) * 10000;
+    return 0;
+}
+
+static int fakeDeviceGetEnforcedPowerLimit(void*, unsigned int* milliwatts) {
+    *milliwatts = 200000;
+    return 0;
+}
+
+static int fakeDeviceGetClockInfo(void*, int type, unsigned int* mhz) {
+    *mhz = type == FAKE_NVML_CLOCK_MEM ? 7000 : 1500;
+    return 0;
+}
+
+static int fakeDeviceGetTemperature(void* device, int, unsigned int* celsius) {
+    *celsius = 45 + fakeIndex(device) * 5;
+    return 0;
+}
+
+static int fakeDeviceGetFanSpeed(void*, unsigned int*) {
+    return FAKE_NVML_NOT_SUPPORTED;
+}
+
+static void testNVMLDecode() {
+    NVMLApi api;
+    api.init = fakeInit;
+    api.shutdown = fakeShutdown;
+    api.deviceGetCount = fakeDeviceGetCount;
+    api.deviceGetHandleByIndex = fakeDeviceGetHandleByIndex;
+    api.deviceGetName = fakeDeviceGetName;
+    api.deviceGetUtilizationRates = fakeDeviceGetUtilizationRates;
+    api.deviceGetMemoryInfo = fakeDeviceGetMemoryInfo;
+    api.deviceGetPowerUsage = fakeDeviceGetPowerUsage;
+    api.deviceGetEnforcedPowerLimit = fakeDeviceGetEnforcedPowerLimit;
+    api.deviceGetClockInfo = fakeDeviceGetClockInfo;
+    api.deviceGetTemperature = fakeDeviceGetTemperature;
+    api.deviceGetFanSpeed = fakeDeviceGetFanSpeed;
+    
+    // A root with no sysfs, so no AMD cards join the list
+    GPUMonitor monitor("/nonexistent");
+    monitor.initialize(api);
+    check(std::strcmp(monitor.backend(), "nvml") == 0, "nvml backend");
+    
+    std::vector<GPUData> gpus = monitor.read();
+    check(gpus.size() == 2, "two fake devices");
+    for (size_t i = 0; i < gpus.size(); i++) {
+        const GPUData& gpu = gpus[i];
+        std::string name = "gpu" + std::to_string(i) + " ";
+        check(gpu.index == (int)i, name + "index");
+        check(gpu.vendor == "NVIDIA", name + "vendor");
+        check(gpu.model == "Fake GPU " + std::to_string(i), name + "model");
+        checkValue(gpu.temperature, 45 + i * 5, name + "temperature");
+        checkValue(gpu.memory_total_mb, 8192, name + "memory total");
+        checkValue(gpu.memory_used_mb, 1024 * (i + 1), name + "memory used");
+        checkValue(gpu.memory_free_mb, 8192 - 1024 * (i + 1), name + "memory free");
+        checkValue(gpu.power_draw_w, 30 + i * 10, name + "power draw");
+        checkValue(gpu.power_limit_w, 200, name + "power limit");
+        checkValue(gpu.clock_core_mhz, 1500, name + "core clock");
+        checkValue(gpu.clock_memory_mhz, 7000, name + "memory clock");
+        checkValue(gpu.fan_speed, NAN, name + "unsupported fan");
+        checkValue(gpu.utilization_memory, std::floor(gpu.utilization_gpu / 2), name + "memory utilization");
+    }
+    
+    std::vector<GPUData> next = monitor.read();
+    check(next.size() == 2 && next[0].utilization_gpu != gpus[0].utilization_gpu, "live sample on each read");
+    
+    monitor.shutdown();
+    check(std::strcmp(monitor.backend(), "none") == 0, "no backend after shutdown");
+}
+
+static bool readPage(const std::string& path, uint8_t* page) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        check(false, "open " + path);
+        return false;
+    }
+    size_t n = fread(page, 1, DiskHealth::SMART_PAGE_SIZE, file);
+    fclose(file);
+    check(n == DiskHealth::SMART_PAGE_SIZE, path + " holds a whole page");
+    return n == DiskHealth::SMART_PAGE_SIZE;
+}
+
+static DiskHealthData unreadDisk() {
+    DiskHealthData data;
+    data.error = 0;
+    data.healthy = false;
+    data.temperature = data.power_on_hours = data.power_cycles = data.wear_level = NAN;
+    data.reallocated_sectors = data.pending_sectors = data.media_errors = NAN;
+    data.unsafe_shutdowns = data.available_spare = data.critical_warning = NAN;
+    data.age_ms = 0.0;
+    return data;
+}
+
+static void testNVMeLog(const std::string& fixtures) {
+    uint8_t page[DiskHealth::SMART_PAGE_SIZE];
+    if (!readPage(fixtures + "/nvme0n1.nvme", page)) {
+        return;
+    }
+    DiskHealthData disk = unreadDisk();
+    DiskHealth::parseNVMeLog(page, disk);
+    check(disk.healthy, "nvme healthy");
+    checkValue(disk.temperature, 38, "nvme temperature");
+    checkValue(disk.wear_level, 96, "nvme wear level");
+    checkValue(disk.available_spare, 100, "nvme available spare");
+    checkValue(disk.critical_warning, 0, "nvme critical warning");
+    checkValue(disk.media_errors, 2, "nvme media errors");
+    checkValue(disk.unsafe_shutdowns, 57, "nvme unsafe shutdowns");
+    checkValue(disk.power_on_hours, 8761, "nvme power-on hours");
+    checkValue(disk.power_cycles, 1423, "nvme power cycles");
+    checkValue(disk.reallocated_sectors, NAN, "nvme has no reallocated sectors");
+    
+    // A critical warning bit alone marks the drive unhealthy
+    page[0] = 0x04;
+    disk = unreadDisk();
+    DiskHealth::parseNVMeLog(page, disk);
+    check(!disk.healthy, "nvme critical warning is unhealthy");
+    checkValue(disk.critical_warning, 4, "nvme critical warning bits");
+}
+
+static void testATASmart(const std::string& fixtures) {
+    uint8_t data[DiskHealth::SMART_PAGE_SIZE];
+    if (!readPage(fixtures + "/sda.ata", data)) {
+        return;
+    }
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < DiskHealth::SMART_PAGE_SIZE; i++) {
+        checksum += data[i];
+    }
+    check(checksum == 0, "ata fixture checksum");
+    
+    DiskHealthData disk = unreadDisk();
+    DiskHealth::parseATASmart(data, disk);
+    check(!disk.healthy, "ata with reallocated sectors is unhealthy");
+    checkValue(disk.temperature, 34, "ata temperature");
+    checkValue(disk.wear_level, 91, "ata wear level");
+    checkValue(disk.reallocated_sectors, 8, "ata reallocated sectors");
+    checkValue(disk.pending_sectors, 1, "ata pending sectors");
+    checkValue(disk.power_on_hours, 21045, "ata power-on hours");
+    checkValue(disk.power_cycles, 912, "ata power cycles");
+    checkValue(disk.media_errors, NAN, "ata has no media errors");
+}
+
+int main(int argc, char** argv) {
+    std::string fixtures = argc > 1 ? argv[1] : "test_fixtures/smart";
+    
+    testNVMLDecode();
+    testNVMeLog(fixtures);
+    testATASmart(fixtures);
+    
+    if (g_failures > 0) {
+        fprintf(stderr, "system-monitor-tests: %d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("system-monitor-tests: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "delta_frame.h"
+#include <cstring>
+
+DeltaFrameEncoder::DeltaFrameEncoder() : version_(0), primed_(false) {}
+
+size_t DeltaFrameEncoder::bitmapBytes(size_t count) {
+    return (count + 7) / 8;
+}
+
+bool DeltaFrameEncoder::encode(uint64_t version, const std::vector<double>& values,
+                               std::vector<uint8_t>& bitmap, std::vector<double>& changed) {
+    bool full = !primed_ || version != version_ || previous_.size() != values.size();
+    bitmap.assign(bitmapBytes(values.size()), full ? 0xff : 0x00);
+    changed.clear();
+    
+    if (full) {
+        changed.assign(values.begin(), values.end());
+        previous_.assign(values.begin(), values.end());
+        version_ = version;
+        primed_ = true;
+        // Keep the padding bits of the last byte clear
+        if (values.size() % 8 != 0) {
+            bitmap.back() = (uint8_t)((1u << (values.size() % 8)) - 1);
+        }
+        return true;
+    }
+    
+    for (size_t i = 0; i < values.size(); i++) {
+        // Bitwise, so NaN == NaN and -0.0 != 0.0: exactly what the viewer would see
+        if (std::memcmp(&values[i], &previous_[i], sizeof(double)) != 0) {
+            bitmap[i / 8] |= (uint8_t)(1u << (i % 8));
+            changed.push_back(values[i]);
+            previous_[i] = values[i];
+        }
+    }
+    return false;
+}
+
+void DeltaFrameEncoder::reset() {
+    primed_ = false;
+}
@@ -0,0 +1,34 @@
+#ifndef DELTA_FRAME_H
+#define DELTA_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Delta encoding of successive snapshot() vectors for streaming to a viewer.
+//
+// A frame is a change bitmap (bit i of byte i / 8 set when field i differs
+// bit-for-bit from the previous frame, so a sensor that stays NaN is
+// unchanged) followed by just the changed values, in field order. The first
+// frame, and the first after a schema version change or reset(), is full:
+// every bit set, every value present.
+class DeltaFrameEncoder {
+public:
+    DeltaFrameEncoder();
+    
+    // Returns true for a full frame. bitmap gets bitmapBytes(values.size())
+    // bytes; changed is cleared and refilled, so both can be reused per tick.
+    bool encode(uint64_t version, const std::vector<double>& values,
+                std::vector<uint8_t>& bitmap, std::vector<double>& changed);
+    // Forces the next frame to be full, e.g. when a new subscriber attaches
+    void reset();
+    
+    static size_t bitmapBytes(size_t count);
+
+private:
+    uint64_t version_;
+    bool primed_;
+    std::vector<double> previous_;
+};
+
+#endif // DELTA_FRAME_H
@@ -0,0 +1,249 @@
+#include "disk_health.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/nvme_ioctl.h>
+#include <scsi/sg.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+static const uint8_t NVME_ADMIN_GET_LOG_PAGE = 0x02;
+static const uint8_t NVME_LOG_SMART = 0x02;
+static const uint32_t NVME_NSID_ALL = 0xFFFFFFFF;
+
+static const uint8_t ATA_PASS_THROUGH_16 = 0x85;
+static const uint8_t ATA_SMART = 0xB0;
+static const uint8_t ATA_SMART_READ_DATA = 0xD0;
+static const size_t ATA_ATTRIBUTE_COUNT = 30;
+static const size_t ATA_ATTRIBUTE_SIZE = 12;
+static const unsigned int SG_TIMEOUT_MS = 3000;
+
+static double notAvailable() {
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+static uint64_t readLE(const uint8_t* bytes, size_t count) {
+    uint64_t value = 0;
+    for (size_t i = count; i > 0; i--) {
+        value = (value << 8) | bytes[i - 1];
+    }
+    return value;
+}
+
+// NVMe log counters are 128-bit; the high half is only nonzero on drives
+// that have moved more than 2^64 units, so fold it in as a double
+static double readLE128(const uint8_t* bytes) {
+    return (double)readLE(bytes, 8) + (double)readLE(bytes + 8, 8) * 18446744073709551616.0;
+}
+
+static bool isNVMeNamespace(const char* name) {
+    // nvme<ctrl>n<ns>; skips the hidden nvme<subsys>c<ctrl>n<ns> multipath paths
+    unsigned int controller, ns;
+    int consumed = 0;
+    return sscanf(name, "nvme%un%u%n", &controller, &ns, &consumed) == 2 && name[consumed] == '\0';
+}
+
+static bool isSCSIDisk(const char* name) {
+    if (std::strncmp(name, "sd", 2) != 0 || name[2] == '\0') {
+        return false;
+    }
+    for (const char* c = name + 2; *c != '\0'; c++) {
+        if (*c < 'a' || *c > 'z') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static DiskHealthData emptyReading(const std::string& device, const char* transport) {
+    DiskHealthData data;
+    data.device = device;
+    data.transport = transport;
+    data.error = 0;
+    data.healthy = true;
+    data.temperature = notAvailable();
+    data.power_on_hours = notAvailable();
+    data.power_cycles = notAvailable();
+    data.wear_level = notAvailable();
+    data.reallocated_sectors = notAvailable();
+    data.pending_sectors = notAvailable();
+    data.media_errors = notAvailable();
+    data.unsafe_shutdowns = notAvailable();
+    data.available_spare = notAvailable();
+    data.critical_warning = notAvailable();
+    data.age_ms = 0.0;
+    return data;
+}
+
+void DiskHealth::parseNVMeLog(const uint8_t* page, DiskHealthData& out) {
+    // NVMe base spec, SMART / Health Information log (page 0x02)
+    uint8_t criticalWarning = page[0];
+    uint64_t kelvin = readLE(page + 1, 2);
+    uint8_t percentUsed = page[5];
+    
+    out.critical_warning = criticalWarning;
+    out.temperature = kelvin > 0 ? (double)kelvin - 273.0 : notAvailable();
+    out.available_spare = page[3];
+    // percent_used may exceed 100 on drives past their rated endurance
+    out.wear_level = percentUsed >= 100 ? 0.0 : 100.0 - percentUsed;
+    out.power_cycles = readLE128(page + 112);
+    out.power_on_hours = readLE128(page + 128);
+    out.unsafe_shutdowns = readLE128(page + 144);
+    out.media_errors = readLE128(page + 160);
+    out.healthy = criticalWarning == 0;
+}
+
+void DiskHealth::parseATASmart(const uint8_t* data, DiskHealthData& out) {
+    double airflowTemperature = notAvailable();
+    for (size_t i = 0; i < ATA_ATTRIBUTE_COUNT; i++) {
+        // { id, flags[2], current, worst, raw[6], reserved }
+        const uint8_t* attribute = data + 2 + i * ATA_ATTRIBUTE_SIZE;
+        uint8_t id = attribute[0];
+        uint8_t current = attribute[3];
+        const uint8_t* raw = attribute + 5;
+        switch (id) {
+            case 5:
+                out.reallocated_sectors = (double)readLE(raw, 6);
+                break;
+            case 9:
+                // Vendors pack minutes or flags into the upper bytes
+                out.power_on_hours = (double)readLE(raw, 4);
+                break;
+            case 12:
+                out.power_cycles = (double)readLE(raw, 6);
+                break;
+            case 190:
+                airflowTemperature = raw[0];
+                break;
+            case 194:
+                out.temperature = raw[0];
+                break;
+            case 197:
+                out.pending_sectors = (double)readLE(raw, 6);
+                break;
+            case 231:
+            case 233:
+                // Normalized value counts down from 100 as the flash wears
+                out.wear_level = current;
+                break;
+            default:
+                break;
+        }
+    }
+    if (std::isnan(out.temperature)) {
+        out.temperature = airflowTemperature;
+    }
+    out.healthy = !(out.reallocated_sectors > 0) && !(out.pending_sectors > 0);
+}
+
+DiskHealth::DiskHealth(const std::string& root) : root_(root) {}
+
+int DiskHealth::readNVMeLog(const std::string& device, uint8_t* page) {
+    int fd = open((root_ + "/dev/" + device).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno;
+    }
+    struct nvme_admin_cmd cmd;
+    std::memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADMIN_GET_LOG_PAGE;
+    cmd.nsid = NVME_NSID_ALL;
+    cmd.addr = (uint64_t)(uintptr_t)page;
+    cmd.data_len = SMART_PAGE_SIZE;
+    // NUMDL (dwords - 1) in the upper half, log identifier in the lower
+    cmd.cdw10 = ((uint32_t)(SMART_PAGE_SIZE / 4 - 1) << 16) | NVME_LOG_SMART;
+    
+    int result = ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd);
+    int error = result < 0 ? errno : (result > 0 ? EIO : 0); // > 0 is an NVMe status code
+    close(fd);
+    return error;
+}
+
+int DiskHealth::readATASmart(const std::string& device, uint8_t* data) {
+    int fd = open((root_ + "/dev/" + device).c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return errno;
+    }
+    uint8_t cdb[16] = {};
+    cdb[0] = ATA_PASS_THROUGH_16;
+    cdb[1] = 4 << 1;        // Protocol: PIO data-in
+    cdb[2] = 0x0E;          // T_DIR in, BYT_BLOK, T_LENGTH in the sector count
+    cdb[4] = ATA_SMART_READ_DATA;
+    cdb[6] = 1;             // One sector
+    cdb[10] = 0x4F;         // LBA mid / high carry the SMART signature
+    cdb[12] = 0xC2;
+    cdb[14] = ATA_SMART;
+    
+    uint8_t sense[32] = {};
+    sg_io_hdr_t hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    hdr.interface_id = 'S';
+    hdr.dxfer_direction = SG_DXFER_FROM_DEV;
+    hdr.cmdp = cdb;
+    hdr.cmd_len = sizeof(cdb);
+    hdr.dxferp = data;
+    hdr.dxfer_len = SMART_PAGE_SIZE;
+    hdr.sbp = sense;
+    hdr.mx_sb_len = sizeof(sense);
+    hdr.timeout = SG_TIMEOUT_MS;
+    
+    int error = 0;
+    if (ioctl(fd, SG_IO, &hdr) < 0) {
+        error = errno;
+    } else if ((hdr.info & SG_INFO_OK_MASK) != SG_INFO_OK) {
+        error = EIO; // Not an ATA device, or a bridge without SAT support
+    }
+    close(fd);
+    if (error != 0) {
+        return error;
+    }
+    
+    // The last byte makes the sector sum to zero; bridges that ignore the
+    // pass-through return whatever was in the buffer
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < SMART_PAGE_SIZE; i++) {
+        checksum += data[i];
+    }
+    return checksum == 0 ? 0 : EIO;
+}
+
+std::vector<DiskHealthData> DiskHealth::read() {
+    std::vector<DiskHealthData> disks;
+    
+    std::vector<std::string> names;
+    DIR* dir = opendir((root_ + "/sys/block").c_str());
+    if (dir == nullptr) {
+        return disks;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (isNVMeNamespace(entry->d_name) || isSCSIDisk(entry->d_name)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    
+    uint8_t page[SMART_PAGE_SIZE];
+    for (const auto& name : names) {
+        bool nvme = isNVMeNamespace(name.c_str());
+        std::memset(page, 0, sizeof(page));
+        int error = nvme ? readNVMeLog(name, page) : readATASmart(name, page);
+        
+        DiskHealthData data = emptyReading(name, nvme ? "nvme" : "ata");
+        data.error = error;
+        if (error == 0) {
+            if (nvme) {
+                parseNVMeLog(page, data);
+            } else {
+                parseATASmart(page, data);
+            }
+        }
+        disks.push_back(data);
+    }
+    return disks;
+}
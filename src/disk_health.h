@@ -0,0 +1,54 @@
+#ifndef DISK_HEALTH_H
+#define DISK_HEALTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One disk's health summary; NaN for anything the log page does not carry
+struct DiskHealthData {
+    std::string device;         // Block device name, e.g. "nvme0n1" or "sda"
+    std::string transport;      // "nvme" or "ata"
+    int error;                  // errno of the failed ioctl, 0 when the fields below are valid
+    bool healthy;
+    double temperature;         // °C
+    double power_on_hours;
+    double power_cycles;
+    double wear_level;          // Percent of rated life remaining
+    double reallocated_sectors; // ATA 5
+    double pending_sectors;     // ATA 197
+    double media_errors;        // NVMe
+    double unsafe_shutdowns;    // NVMe
+    double available_spare;     // NVMe, percent
+    double critical_warning;    // NVMe bitmask, 0 when healthy
+    double age_ms;              // Time since the device was read; set by SystemMonitor
+};
+
+// SMART health without smartctl: NVMe Get Log Page 0x02 through
+// NVME_IOCTL_ADMIN_CMD, ATA SMART READ DATA through SG_IO with an
+// ATA PASS-THROUGH(16) CDB. Both need the same privileges smartctl does
+// (CAP_SYS_ADMIN / CAP_SYS_RAWIO); devices that refuse report `error`.
+class DiskHealth {
+public:
+    static const size_t SMART_PAGE_SIZE = 512;
+    
+    // root prefixes /sys/block and /dev, as for SystemMonitor
+    explicit DiskHealth(const std::string& root = "");
+    
+    // Reads every whole NVMe / SCSI-attached disk; blocks for the ioctls,
+    // so call it off the JS thread
+    std::vector<DiskHealthData> read();
+    
+    // Decoders for the raw 512-byte pages; public so they can be tested alone
+    static void parseNVMeLog(const uint8_t* page, DiskHealthData& out);
+    static void parseATASmart(const uint8_t* data, DiskHealthData& out);
+
+private:
+    int readNVMeLog(const std::string& device, uint8_t* page);
+    int readATASmart(const std::string& device, uint8_t* data);
+    
+    std::string root_;
+};
+
+#endif // DISK_HEALTH_H
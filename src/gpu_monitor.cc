@@ -0,0 +1,299 @@
+#include "gpu_monitor.h"
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+static const int NVML_SUCCESS = 0;
+static const int NVML_CLOCK_GRAPHICS = 0;
+static const int NVML_CLOCK_MEM = 2;
+static const int NVML_TEMPERATURE_GPU = 0;
+static const unsigned int NVML_NAME_LENGTH = 96;
+
+static double notAvailable() {
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+// Reads a numeric sysfs attribute from a cached fd; NaN on failure
+static double readAttribute(int fd) {
+    if (fd < 0) {
+        return notAvailable();
+    }
+    char buf[64];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return notAvailable();
+    }
+    buf[n] = '\0';
+    char* end = nullptr;
+    double value = std::strtod(buf, &end);
+    return end == buf ? notAvailable() : value;
+}
+
+static std::string readText(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return "";
+    }
+    char buf[256];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return "";
+    }
+    std::string text(buf, (size_t)n);
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+        text.pop_back();
+    }
+    return text;
+}
+
+static int openAttribute(const std::string& path) {
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+GPUMonitor::GPUMonitor(const std::string& root) : root_(root), nvml_library_(nullptr), nvml_ready_(false) {
+    std::memset(&nvml_, 0, sizeof(nvml_));
+}
+
+GPUMonitor::~GPUMonitor() {
+    shutdown();
+}
+
+void GPUMonitor::initialize() {
+    shutdown();
+    
+    const char* selection = getenv("SYSTEM_MONITOR_NVML");
+    if (selection == nullptr || std::strcmp(selection, "off") != 0) {
+        // The unversioned name only exists with the driver's development package
+        if (selection != nullptr && selection[0] != '\0') {
+            loadNVML(selection);
+        } else if (!loadNVML("libnvidia-ml.so.1")) {
+            loadNVML("libnvidia-ml.so");
+        }
+    }
+    startNVML();
+}
+
+void GPUMonitor::initialize(const NVMLApi& api) {
+    shutdown();
+    nvml_ = api;
+    startNVML();
+}
+
+void GPUMonitor::startNVML() {
+    if (nvml_.init != nullptr && nvml_.init() == NVML_SUCCESS) {
+        unsigned int count = 0;
+        if (nvml_.deviceGetCount(&count) == NVML_SUCCESS) {
+            for (unsigned int i = 0; i < count; i++) {
+                void* device = nullptr;
+                if (nvml_.deviceGetHandleByIndex(i, &device) == NVML_SUCCESS) {
+                    nvml_devices_.push_back(device);
+                }
+            }
+        }
+        nvml_ready_ = true;
+    }
+    
+    discoverAMDCards();
+}
+
+void GPUMonitor::shutdown() {
+    if (nvml_ready_ && nvml_.shutdown != nullptr) {
+        nvml_.shutdown();
+    }
+    nvml_ready_ = false;
+    nvml_devices_.clear();
+    if (nvml_library_ != nullptr) {
+        dlclose(nvml_library_);
+        nvml_library_ = nullptr;
+    }
+    std::memset(&nvml_, 0, sizeof(nvml_));
+    closeAMDCards();
+}
+
+bool GPUMonitor::loadNVML(const char* library) {
+    void* handle = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        return false;
+    }
+    
+    // The _v2 entry points replaced the originals in driver 325+
+    NVMLApi api;
+    struct { void** slot; const char* symbol; } symbols[] = {
+        { (void**)&api.init, "nvmlInit_v2" },
+        { (void**)&api.shutdown, "nvmlShutdown" },
+        { (void**)&api.deviceGetCount, "nvmlDeviceGetCount_v2" },
+        { (void**)&api.deviceGetHandleByIndex, "nvmlDeviceGetHandleByIndex_v2" },
+        { (void**)&api.deviceGetName, "nvmlDeviceGetName" },
+        { (void**)&api.deviceGetUtilizationRates, "nvmlDeviceGetUtilizationRates" },
+        { (void**)&api.deviceGetMemoryInfo, "nvmlDeviceGetMemoryInfo" },
+        { (void**)&api.deviceGetPowerUsage, "nvmlDeviceGetPowerUsage" },
+        { (void**)&api.deviceGetEnforcedPowerLimit, "nvmlDeviceGetEnforcedPowerLimit" },
+        { (void**)&api.deviceGetClockInfo, "nvmlDeviceGetClockInfo" },
+        { (void**)&api.deviceGetTemperature, "nvmlDeviceGetTemperature" },
+        { (void**)&api.deviceGetFanSpeed, "nvmlDeviceGetFanSpeed" },
+    };
+    for (const auto& symbol : symbols) {
+        *symbol.slot = dlsym(handle, symbol.symbol);
+        if (*symbol.slot == nullptr) {
+            dlclose(handle);
+            return false;
+        }
+    }
+    
+    nvml_ = api;
+    nvml_library_ = handle;
+    return true;
+}
+
+void GPUMonitor::discoverAMDCards() {
+    const std::string drmRoot = root_ + "/sys/class/drm/";
+    DIR* dir = opendir(drmRoot.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    std::vector<std::string> cards;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        // card0 is the device; card0-DP-1 and friends are its connectors
+        std::string name = entry->d_name;
+        if (name.compare(0, 4, "card") == 0 && name.find('-') == std::string::npos) {
+            cards.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(cards.begin(), cards.end());
+    
+    for (const auto& card : cards) {
+        std::string device = drmRoot + card + "/device/";
+        if (readText(device + "vendor") != "0x1002") {
+            continue;
+        }
+        
+        std::string hwmon;
+        DIR* hwmonDir = opendir((device + "hwmon").c_str());
+        if (hwmonDir != nullptr) {
+            while ((entry = readdir(hwmonDir)) != nullptr) {
+                if (std::strncmp(entry->d_name, "hwmon", 5) == 0) {
+                    hwmon = device + "hwmon/" + entry->d_name + "/";
+                    break;
+                }
+            }
+            closedir(hwmonDir);
+        }
+        
+        AMDCard amd;
+        amd.model = readText(device + "product_name");
+        if (amd.model.empty()) {
+            amd.model = "AMD GPU";
+        }
+        amd.busy_fd = openAttribute(device + "gpu_busy_percent");
+        amd.mem_busy_fd = openAttribute(device + "mem_busy_percent");
+        amd.vram_total_fd = openAttribute(device + "mem_info_vram_total");
+        amd.vram_used_fd = openAttribute(device + "mem_info_vram_used");
+        amd.temp_fd = hwmon.empty() ? -1 : openAttribute(hwmon + "temp1_input");
+        // APUs and newer dGPUs only expose the instantaneous power1_input
+        amd.power_fd = hwmon.empty() ? -1 : openAttribute(hwmon + "power1_average");
+        if (amd.power_fd < 0 && !hwmon.empty()) {
+            amd.power_fd = openAttribute(hwmon + "power1_input");
+        }
+        amd.power_cap_fd = hwmon.empty() ? -1 : openAttribute(hwmon + "power1_cap");
+        amd.sclk_fd = hwmon.empty() ? -1 : openAttribute(hwmon + "freq1_input");
+        amd.mclk_fd = hwmon.empty() ? -1 : openAttribute(hwmon + "freq2_input");
+        amd.pwm_fd = hwmon.empty() ? -1 : openAttribute(hwmon + "pwm1");
+        amd_cards_.push_back(amd);
+    }
+}
+
+void GPUMonitor::closeAMDCards() {
+    for (const auto& card : amd_cards_) {
+        int fds[] = { card.busy_fd, card.mem_busy_fd, card.vram_total_fd, card.vram_used_fd, card.temp_fd,
+                      card.power_fd, card.power_cap_fd, card.sclk_fd, card.mclk_fd, card.pwm_fd };
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+    amd_cards_.clear();
+}
+
+std::vector<GPUData> GPUMonitor::read() {
+    std::vector<GPUData> gpus;
+    readNVML(gpus);
+    readAMD(gpus);
+    return gpus;
+}
+
+const char* GPUMonitor::backend() const {
+    if (!nvml_ready_) {
+        return "none";
+    }
+    return "nvml";
+}
+
+void GPUMonitor::readNVML(std::vector<GPUData>& gpus) {
+    if (!nvml_ready_) {
+        return;
+    }
+    
+    for (size_t i = 0; i < nvml_devices_.size(); i++) {
+        void* device = nvml_devices_[i];
+        GPUData gpu;
+        gpu.index = (int)gpus.size();
+        gpu.vendor = "NVIDIA";
+        
+        char name[NVML_NAME_LENGTH];
+        gpu.model = nvml_.deviceGetName(device, name, sizeof(name)) == NVML_SUCCESS ? name : "NVIDIA GPU";
+        
+        unsigned int value = 0;
+        gpu.temperature = nvml_.deviceGetTemperature(device, NVML_TEMPERATURE_GPU, &value) == NVML_SUCCESS ? value : notAvailable();
+        
+        NVMLUtilization utilization;
+        bool hasUtilization = nvml_.deviceGetUtilizationRates(device, &utilization) == NVML_SUCCESS;
+        gpu.utilization_gpu = hasUtilization ? utilization.gpu : notAvailable();
+        gpu.utilization_memory = hasUtilization ? utilization.memory : notAvailable();
+        
+        NVMLMemory memory;
+        bool hasMemory = nvml_.deviceGetMemoryInfo(device, &memory) == NVML_SUCCESS;
+        const double MB = 1024.0 * 1024.0;
+        gpu.memory_total_mb = hasMemory ? memory.total / MB : notAvailable();
+        gpu.memory_used_mb = hasMemory ? memory.used / MB : notAvailable();
+        gpu.memory_free_mb = hasMemory ? memory.free / MB : notAvailable();
+        
+        gpu.power_draw_w = nvml_.deviceGetPowerUsage(device, &value) == NVML_SUCCESS ? value / 1000.0 : notAvailable();
+        gpu.power_limit_w = nvml_.deviceGetEnforcedPowerLimit(device, &value) == NVML_SUCCESS ? value / 1000.0 : notAvailable();
+        gpu.clock_core_mhz = nvml_.deviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &value) == NVML_SUCCESS ? value : notAvailable();
+        gpu.clock_memory_mhz = nvml_.deviceGetClockInfo(device, NVML_CLOCK_MEM, &value) == NVML_SUCCESS ? value : notAvailable();
+        gpu.fan_speed = nvml_.deviceGetFanSpeed(device, &value) == NVML_SUCCESS ? value : notAvailable();
+        gpus.push_back(gpu);
+    }
+}
+
+void GPUMonitor::readAMD(std::vector<GPUData>& gpus) {
+    const double MB = 1024.0 * 1024.0;
+    for (const auto& card : amd_cards_) {
+        GPUData gpu;
+        gpu.index = (int)gpus.size();
+        gpu.vendor = "AMD";
+        gpu.model = card.model;
+        gpu.temperature = readAttribute(card.temp_fd) / 1000.0;
+        gpu.utilization_gpu = readAttribute(card.busy_fd);
+        gpu.utilization_memory = readAttribute(card.mem_busy_fd);
+        gpu.memory_total_mb = readAttribute(card.vram_total_fd) / MB;
+        gpu.memory_used_mb = readAttribute(card.vram_used_fd) / MB;
+        gpu.memory_free_mb = gpu.memory_total_mb - gpu.memory_used_mb;
+        gpu.power_draw_w = readAttribute(card.power_fd) / 1000000.0;
+        gpu.power_limit_w = readAttribute(card.power_cap_fd) / 1000000.0;
+        gpu.clock_core_mhz = readAttribute(card.sclk_fd) / 1000000.0;
+        gpu.clock_memory_mhz = readAttribute(card.mclk_fd) / 1000000.0;
+        gpu.fan_speed = readAttribute(card.pwm_fd) * 100.0 / 255.0;
+        gpus.push_back(gpu);
+    }
+}
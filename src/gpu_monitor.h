@@ -0,0 +1,103 @@
+#ifndef GPU_MONITOR_H
+#define GPU_MONITOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One GPU reading; NaN for anything the driver does not report
+struct GPUData {
+    int index;
+    std::string vendor;
+    std::string model;
+    double temperature;         // °C
+    double utilization_gpu;     // Percent
+    double utilization_memory;  // Percent of time the memory controller was busy
+    double memory_total_mb;
+    double memory_used_mb;
+    double memory_free_mb;
+    double power_draw_w;
+    double power_limit_w;
+    double clock_core_mhz;
+    double clock_memory_mhz;
+    double fan_speed;           // Percent
+};
+
+// Layouts of the NVML structs we read (nvml.h is not needed at build time)
+struct NVMLUtilization {
+    unsigned int gpu;
+    unsigned int memory;
+};
+
+struct NVMLMemory {
+    unsigned long long total;
+    unsigned long long free;
+    unsigned long long used;
+};
+
+// The subset of NVML we call, filled from libnvidia-ml via dlsym. Every
+// function returns NVML_SUCCESS (0) or an error code.
+struct NVMLApi {
+    int (*init)();
+    int (*shutdown)();
+    int (*deviceGetCount)(unsigned int* count);
+    int (*deviceGetHandleByIndex)(unsigned int index, void** device);
+    int (*deviceGetName)(void* device, char* name, unsigned int length);
+    int (*deviceGetUtilizationRates)(void* device, NVMLUtilization* utilization);
+    int (*deviceGetMemoryInfo)(void* device, NVMLMemory* memory);
+    int (*deviceGetPowerUsage)(void* device, unsigned int* milliwatts);
+    int (*deviceGetEnforcedPowerLimit)(void* device, unsigned int* milliwatts);
+    int (*deviceGetClockInfo)(void* device, int type, unsigned int* mhz);
+    int (*deviceGetTemperature)(void* device, int sensor, unsigned int* celsius);
+    int (*deviceGetFanSpeed)(void* device, unsigned int* percent);
+};
+
+// NVIDIA GPUs through NVML, AMD GPUs through amdgpu's sysfs attributes.
+// SYSTEM_MONITOR_NVML selects the NVML library: unset loads libnvidia-ml,
+// a path loads that library instead, "off" disables NVML.
+class GPUMonitor {
+public:
+    // root prefixes the sysfs paths (not NVML), as for SystemMonitor
+    explicit GPUMonitor(const std::string& root = "");
+    ~GPUMonitor();
+    
+    // Loads NVML and discovers AMD cards; safe to call again after hotplug
+    void initialize();
+    // Same, with api in place of libnvidia-ml; the decode tests use it
+    void initialize(const NVMLApi& api);
+    void shutdown();
+    
+    std::vector<GPUData> read();
+    const char* backend() const; // "nvml" or "none"
+
+private:
+    struct AMDCard {
+        std::string model;
+        int busy_fd;            // gpu_busy_percent
+        int mem_busy_fd;        // mem_busy_percent
+        int vram_total_fd;      // mem_info_vram_total (bytes)
+        int vram_used_fd;       // mem_info_vram_used (bytes)
+        int temp_fd;            // hwmon temp1_input (m°C)
+        int power_fd;           // hwmon power1_average or power1_input (µW)
+        int power_cap_fd;       // hwmon power1_cap (µW)
+        int sclk_fd;            // hwmon freq1_input (Hz)
+        int mclk_fd;            // hwmon freq2_input (Hz)
+        int pwm_fd;             // hwmon pwm1 (0-255)
+    };
+    
+    bool loadNVML(const char* library);
+    void startNVML();
+    void discoverAMDCards();
+    void closeAMDCards();
+    void readNVML(std::vector<GPUData>& gpus);
+    void readAMD(std::vector<GPUData>& gpus);
+    
+    std::string root_;
+    NVMLApi nvml_;
+    void* nvml_library_;
+    bool nvml_ready_;
+    std::vector<void*> nvml_devices_;
+    std::vector<AMDCard> amd_cards_;
+};
+
+#endif // GPU_MONITOR_H
@@ -0,0 +1,375 @@
+#include "history_store.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+const int64_t HistoryStore::LEVEL_WIDTH_MS[HistoryStore::LEVEL_COUNT] = { 1000, 10000, 60000, 600000 };
+const uint32_t HistoryStore::LEVEL_CAPACITY[HistoryStore::LEVEL_COUNT] = { 21600, 17280, 10080, 12960 };
+
+static const char FILE_MAGIC[8] = { 'S', 'M', 'H', 'I', 'S', 'T', '0', '1' };
+static const uint32_t FORMAT_VERSION = 1;
+static const size_t FILE_HEADER_BYTES = 4096;
+static const size_t SLOT_HEADER_BYTES = 256;
+static const size_t NAME_BYTES = 128;
+static const int64_t NO_BUCKET = std::numeric_limits<int64_t>::min();
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t max_metrics;
+    uint32_t raw_capacity;
+    uint32_t level_capacity[HistoryStore::LEVEL_COUNT];
+    uint32_t slots_used;
+    uint64_t slot_bytes;
+};
+
+struct HistoryStore::SlotHeader {
+    char name[NAME_BYTES];
+    uint64_t raw_count;     // Samples ever appended; the ring holds the last RAW_CAPACITY
+    int64_t first_ms;
+    int64_t last_ms;
+    int64_t newest_bucket[LEVEL_COUNT];
+};
+
+struct HistoryStore::RawRecord {
+    int64_t t_ms;
+    double value;
+};
+
+// Floats keep a bucket at 16 bytes; charts don't need more than 7 digits
+struct HistoryStore::Bucket {
+    float min;
+    float max;
+    float mean;
+    uint32_t count;         // 0 = empty (a gap in the series)
+};
+
+static_assert(sizeof(FileHeader) <= FILE_HEADER_BYTES, "file header overflows its page");
+
+static uint64_t slotBytes() {
+    uint64_t bytes = SLOT_HEADER_BYTES + (uint64_t)HistoryStore::RAW_CAPACITY * 16;
+    for (size_t l = 0; l < HistoryStore::LEVEL_COUNT; l++) {
+        bytes += (uint64_t)HistoryStore::LEVEL_CAPACITY[l] * 16;
+    }
+    return (bytes + 4095) & ~(uint64_t)4095;
+}
+
+HistoryStore::HistoryStore()
+    : fd_(-1), base_(nullptr), mapped_bytes_(0), slot_bytes_(0), max_metrics_(0) {
+    static_assert(sizeof(SlotHeader) <= SLOT_HEADER_BYTES, "slot header overflows its reservation");
+    static_assert(sizeof(RawRecord) == 16 && sizeof(Bucket) == 16, "record sizes are part of the file format");
+}
+
+HistoryStore::~HistoryStore() {
+    close();
+}
+
+bool HistoryStore::open(const std::string& path, uint32_t max_metrics) {
+    close();
+    error_.clear();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error_ = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    slot_bytes_ = slotBytes();
+    max_metrics_ = max_metrics > 0 ? max_metrics : DEFAULT_MAX_METRICS;
+    
+    // Keep the existing history only if it was written with the same layout
+    FileHeader existing;
+    struct stat st;
+    bool reuse = fstat(fd_, &st) == 0 && (size_t)st.st_size >= FILE_HEADER_BYTES &&
+                 pread(fd_, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+                 std::memcmp(existing.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+                 existing.version == FORMAT_VERSION &&
+                 existing.raw_capacity == RAW_CAPACITY &&
+                 std::memcmp(existing.level_capacity, LEVEL_CAPACITY, sizeof(LEVEL_CAPACITY)) == 0 &&
+                 existing.slot_bytes == slot_bytes_ &&
+                 (uint64_t)st.st_size >= FILE_HEADER_BYTES + existing.slots_used * slot_bytes_;
+    if (reuse) {
+        max_metrics_ = std::max(max_metrics_, existing.max_metrics);
+    } else if (ftruncate(fd_, 0) != 0 || ftruncate(fd_, FILE_HEADER_BYTES) != 0) {
+        error_ = "cannot initialize " + path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    
+    // Map the largest size the file can grow to; growTo() extends the file
+    // underneath, so the mapping never moves
+    mapped_bytes_ = FILE_HEADER_BYTES + (size_t)max_metrics_ * slot_bytes_;
+    void* map = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        error_ = "cannot map " + path + ": " + std::strerror(errno);
+        mapped_bytes_ = 0;
+        close();
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(map);
+    
+    FileHeader* header = reinterpret_cast<FileHeader*>(base_);
+    if (!reuse) {
+        std::memcpy(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header->version = FORMAT_VERSION;
+        header->raw_capacity = RAW_CAPACITY;
+        std::memcpy(header->level_capacity, LEVEL_CAPACITY, sizeof(LEVEL_CAPACITY));
+        header->slots_used = 0;
+        header->slot_bytes = slot_bytes_;
+    }
+    header->max_metrics = max_metrics_;
+    for (uint32_t i = 0; i < header->slots_used; i++) {
+        slots_[std::string(slotHeader((int)i)->name)] = (int)i;
+    }
+    return true;
+}
+
+void HistoryStore::close() {
+    if (base_ != nullptr) {
+        msync(base_, mapped_bytes_, MS_ASYNC);
+        munmap(base_, mapped_bytes_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    mapped_bytes_ = 0;
+    slots_.clear();
+}
+
+bool HistoryStore::isOpen() const {
+    return base_ != nullptr;
+}
+
+const std::string& HistoryStore::error() const {
+    return error_;
+}
+
+HistoryStore::SlotHeader* HistoryStore::slotHeader(int slot) const {
+    return reinterpret_cast<SlotHeader*>(base_ + FILE_HEADER_BYTES + (uint64_t)slot * slot_bytes_);
+}
+
+HistoryStore::RawRecord* HistoryStore::rawRecords(int slot) const {
+    return reinterpret_cast<RawRecord*>(reinterpret_cast<uint8_t*>(slotHeader(slot)) + SLOT_HEADER_BYTES);
+}
+
+HistoryStore::Bucket* HistoryStore::buckets(int slot, size_t level) const {
+    uint8_t* at = reinterpret_cast<uint8_t*>(rawRecords(slot) + RAW_CAPACITY);
+    for (size_t l = 0; l < level; l++) {
+        at += (size_t)LEVEL_CAPACITY[l] * sizeof(Bucket);
+    }
+    return reinterpret_cast<Bucket*>(at);
+}
+
+bool HistoryStore::growTo(uint32_t slots) {
+    off_t size = (off_t)(FILE_HEADER_BYTES + (uint64_t)slots * slot_bytes_);
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && st.st_size >= size) {
+        return true;
+    }
+    // Reserve the blocks now: a sparse page that can't be allocated later
+    // would fault with SIGBUS inside append()
+    int result = posix_fallocate(fd_, 0, size);
+    if (result != 0) {
+        error_ = std::string("cannot grow history file: ") + std::strerror(result);
+        return false;
+    }
+    return true;
+}
+
+int HistoryStore::slot(const std::string& name) {
+    if (base_ == nullptr) {
+        return -1;
+    }
+    auto it = slots_.find(name);
+    if (it != slots_.end()) {
+        return it->second;
+    }
+    FileHeader* header = reinterpret_cast<FileHeader*>(base_);
+    if (header->slots_used >= max_metrics_ || !growTo(header->slots_used + 1)) {
+        return -1;
+    }
+    int slot = (int)header->slots_used;
+    SlotHeader* h = slotHeader(slot);
+    std::memset(h, 0, SLOT_HEADER_BYTES);
+    std::memcpy(h->name, name.data(), std::min(name.size(), NAME_BYTES - 1));
+    h->first_ms = 0;
+    h->last_ms = 0;
+    for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        h->newest_bucket[l] = NO_BUCKET;
+    }
+    header->slots_used++;
+    slots_[name] = slot;
+    return slot;
+}
+
+int HistoryStore::find(const std::string& name) const {
+    auto it = slots_.find(name);
+    return it != slots_.end() ? it->second : -1;
+}
+
+void HistoryStore::append(int slot, int64_t t_ms, double value) {
+    if (base_ == nullptr || slot < 0 || (uint32_t)slot >= reinterpret_cast<FileHeader*>(base_)->slots_used ||
+        !std::isfinite(value)) {
+        return;
+    }
+    SlotHeader* h = slotHeader(slot);
+    if (h->raw_count > 0 && t_ms < h->last_ms) {
+        return;
+    }
+    if (h->raw_count == 0) {
+        h->first_ms = t_ms;
+    }
+    RawRecord& record = rawRecords(slot)[h->raw_count % RAW_CAPACITY];
+    record.t_ms = t_ms;
+    record.value = value;
+    h->raw_count++;
+    h->last_ms = t_ms;
+    
+    float v = (float)value;
+    for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        Bucket* ring = buckets(slot, l);
+        int64_t capacity = LEVEL_CAPACITY[l];
+        int64_t bucket = t_ms / LEVEL_WIDTH_MS[l];
+        int64_t newest = h->newest_bucket[l];
+        if (newest == NO_BUCKET || bucket - newest >= capacity) {
+            if (newest != NO_BUCKET) {
+                std::memset(ring, 0, (size_t)capacity * sizeof(Bucket));
+            }
+            h->newest_bucket[l] = bucket;
+        } else if (bucket > newest) {
+            // Buckets skipped over are gaps; clear whatever they held a lap ago
+            for (int64_t b = newest + 1; b <= bucket; b++) {
+                ring[b % capacity] = Bucket();
+            }
+            h->newest_bucket[l] = bucket;
+        }
+        Bucket& target = ring[bucket % capacity];
+        if (target.count == 0) {
+            target.min = v;
+            target.max = v;
+            target.mean = v;
+            target.count = 1;
+        } else {
+            target.min = std::min(target.min, v);
+            target.max = std::max(target.max, v);
+            target.count++;
+            target.mean += (v - target.mean) / (float)target.count;
+        }
+    }
+}
+
+bool HistoryStore::query(int slot, int64_t t0_ms, int64_t t1_ms, size_t max_points, HistoryRange& out) const {
+    out.bucket_ms = 0;
+    out.timestamps.clear();
+    out.min.clear();
+    out.max.clear();
+    out.avg.clear();
+    if (base_ == nullptr || slot < 0 || (uint32_t)slot >= reinterpret_cast<FileHeader*>(base_)->slots_used) {
+        return false;
+    }
+    const SlotHeader* h = slotHeader(slot);
+    max_points = std::max<size_t>(max_points, 1);
+    int64_t start = std::max(t0_ms, h->first_ms);
+    int64_t end = std::min(t1_ms, h->last_ms);
+    if (h->raw_count == 0 || start > end) {
+        return true;
+    }
+    
+    // Raw samples, if the ring still reaches back to the start and they fit
+    const RawRecord* raw = rawRecords(slot);
+    uint64_t stored = std::min<uint64_t>(h->raw_count, RAW_CAPACITY);
+    uint64_t oldest = h->raw_count - stored;
+    if (raw[oldest % RAW_CAPACITY].t_ms <= start) {
+        auto lowerBound = [&](int64_t t, bool inclusive) {
+            uint64_t lo = oldest, hi = h->raw_count;
+            while (lo < hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                int64_t at = raw[mid % RAW_CAPACITY].t_ms;
+                if (inclusive ? at < t : at <= t) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        };
+        uint64_t first = lowerBound(start, true);
+        uint64_t last = lowerBound(end, false);
+        if (last - first <= max_points) {
+            for (uint64_t i = first; i < last; i++) {
+                const RawRecord& record = raw[i % RAW_CAPACITY];
+                out.timestamps.push_back((double)record.t_ms);
+                out.min.push_back(record.value);
+                out.max.push_back(record.value);
+                out.avg.push_back(record.value);
+            }
+            return true;
+        }
+    }
+    
+    // Finest level that both reaches back to the start and fits in
+    // max_points; failing that, the coarsest, merged down below
+    size_t level = LEVEL_COUNT - 1;
+    for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        int64_t width = LEVEL_WIDTH_MS[l];
+        bool covers = start / width > h->newest_bucket[l] - (int64_t)LEVEL_CAPACITY[l];
+        if (covers && (uint64_t)(end / width - start / width + 1) <= max_points) {
+            level = l;
+            break;
+        }
+    }
+    int64_t width = LEVEL_WIDTH_MS[level];
+    int64_t capacity = LEVEL_CAPACITY[level];
+    int64_t newest = h->newest_bucket[level];
+    const Bucket* ring = buckets(slot, level);
+    int64_t firstBucket = std::max(start / width, newest - capacity + 1);
+    int64_t lastBucket = std::min(end / width, newest);
+    
+    std::vector<uint32_t> counts;
+    for (int64_t b = firstBucket; b <= lastBucket; b++) {
+        const Bucket& bucket = ring[b % capacity];
+        if (bucket.count == 0) {
+            continue;
+        }
+        out.timestamps.push_back((double)(b * width));
+        out.min.push_back(bucket.min);
+        out.max.push_back(bucket.max);
+        out.avg.push_back(bucket.mean);
+        counts.push_back(bucket.count);
+    }
+    out.bucket_ms = width;
+    
+    // Merge runs of buckets when even the chosen level has too many
+    size_t n = out.timestamps.size();
+    if (n > max_points) {
+        size_t group = (n + max_points - 1) / max_points;
+        size_t w = 0;
+        for (size_t r = 0; r < n; r += group) {
+            size_t e = std::min(n, r + group);
+            double lo = out.min[r], hi = out.max[r], sum = 0.0, total = 0.0;
+            for (size_t i = r; i < e; i++) {
+                lo = std::min(lo, out.min[i]);
+                hi = std::max(hi, out.max[i]);
+                sum += out.avg[i] * counts[i];
+                total += counts[i];
+            }
+            out.timestamps[w] = out.timestamps[r];
+            out.min[w] = lo;
+            out.max[w] = hi;
+            out.avg[w] = sum / total;
+            w++;
+        }
+        out.timestamps.resize(w);
+        out.min.resize(w);
+        out.max.resize(w);
+        out.avg.resize(w);
+        out.bucket_ms = width * (int64_t)group;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Decimated series returned by HistoryStore::query(); one point per bucket
+// (or per raw sample when the range is short enough to return them as-is)
+struct HistoryRange {
+    int64_t bucket_ms;              // 0 for raw samples, otherwise the width of each point
+    std::vector<double> timestamps; // Point start, ms since the epoch
+    std::vector<double> min;
+    std::vector<double> max;
+    std::vector<double> avg;
+};
+
+// Per-metric history in one memory-mapped file, so it survives restarts and
+// lives in the page cache rather than the JS heap.
+//
+// Each metric owns a fixed-size slot: a ring of raw { t, value } records and
+// a min/max/avg pyramid (1 s, 10 s, 1 min, 10 min buckets), every level a
+// ring indexed by bucket number. append() touches one record per level, and
+// query() picks the finest source that covers the range in at most
+// max_points, so a zoom costs O(max_points) whatever the span.
+class HistoryStore {
+public:
+    static const size_t LEVEL_COUNT = 4;
+    static const int64_t LEVEL_WIDTH_MS[LEVEL_COUNT];
+    static const uint32_t LEVEL_CAPACITY[LEVEL_COUNT]; // 6 h, 48 h, 7 d, 90 d
+    static const uint32_t RAW_CAPACITY = 6000;          // 10 min at 10 Hz
+    static const uint32_t DEFAULT_MAX_METRICS = 512;
+    
+    HistoryStore();
+    ~HistoryStore();
+    
+    // Reopens an existing file with the same layout, or starts a new one
+    bool open(const std::string& path, uint32_t max_metrics);
+    void close();
+    bool isOpen() const;
+    const std::string& error() const;
+    
+    // Slot for a metric name, allocated on first use; -1 when the file is full
+    int slot(const std::string& name);
+    // Existing slot for a metric name, or -1; never allocates
+    int find(const std::string& name) const;
+    // Samples older than the metric's newest one are dropped
+    void append(int slot, int64_t t_ms, double value);
+    bool query(int slot, int64_t t0_ms, int64_t t1_ms, size_t max_points, HistoryRange& out) const;
+
+private:
+    struct SlotHeader;
+    struct RawRecord;
+    struct Bucket;
+    
+    SlotHeader* slotHeader(int slot) const;
+    RawRecord* rawRecords(int slot) const;
+    Bucket* buckets(int slot, size_t level) const;
+    bool growTo(uint32_t slots);
+    
+    int fd_;
+    uint8_t* base_;
+    size_t mapped_bytes_;
+    uint64_t slot_bytes_;
+    uint32_t max_metrics_;
+    std::unordered_map<std::string, int> slots_;
+    std::string error_;
+};
+
+#endif // HISTORY_STORE_H
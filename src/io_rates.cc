@@ -0,0 +1,377 @@
+#include "io_rates.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+static_assert((int)NET_FIELD_COUNT <= (int)DISK_FIELD_COUNT, "Device::rates holds either row type");
+
+static const double SECTOR_BYTES = 512.0; // diskstats always counts 512-byte sectors
+
+// /proc/diskstats counters after the device name
+enum DiskCounter {
+    DC_READS, DC_READS_MERGED, DC_SECTORS_READ, DC_READ_MS,
+    DC_WRITES, DC_WRITES_MERGED, DC_SECTORS_WRITTEN, DC_WRITE_MS,
+    DC_IN_FLIGHT, DC_IO_TICKS, DC_TIME_IN_QUEUE,
+    DC_COUNT
+};
+
+// /proc/net/dev counters after "iface:"
+enum NetCounter {
+    NC_RX_BYTES, NC_RX_PACKETS, NC_RX_ERRORS, NC_RX_DROP, NC_RX_FIFO, NC_RX_FRAME, NC_RX_COMPRESSED, NC_RX_MULTICAST,
+    NC_TX_BYTES, NC_TX_PACKETS, NC_TX_ERRORS,
+    NC_COUNT
+};
+
+static const char* const DISK_FIELD_NAMES[DISK_FIELD_COUNT] = {
+    "readBytesPerSec", "writeBytesPerSec", "readIOPS", "writeIOPS", "readLatencyMs", "writeLatencyMs",
+    "queueDepth", "utilization", "inFlight", "readsTotal", "writesTotal",
+};
+
+static const char* const NET_FIELD_NAMES[NET_FIELD_COUNT] = {
+    "rxBytesPerSec", "txBytesPerSec", "rxPacketsPerSec", "txPacketsPerSec", "rxErrorsPerSec", "txErrorsPerSec",
+    "rxBytes", "txBytes", "operUp",
+};
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static const char* parseCounter(const char* p, const char* end, uint64_t& value) {
+    p = skipSpaces(p, end);
+    value = 0;
+    while (p < end && isDigit(*p)) {
+        value = value * 10 + (uint64_t)(*p++ - '0');
+    }
+    return p;
+}
+
+static const char* nextLine(const char* p, const char* end) {
+    while (p < end && *p != '\n') {
+        p++;
+    }
+    return p < end ? p + 1 : end;
+}
+
+// Counters only go backwards when a device is re-created under the same name
+static double counterDelta(uint64_t current, uint64_t previous) {
+    return current >= previous ? (double)(current - previous) : 0.0;
+}
+
+// dm and md devices list the disks they are built on under slaves/
+static bool hasSlaves(const std::string& block) {
+    DIR* dir = opendir((block + "/slaves").c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    bool found = false;
+    struct dirent* entry;
+    while (!found && (entry = readdir(dir)) != nullptr) {
+        found = entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return found;
+}
+
+IORates::IORates(const std::string& root) : root_(root), previous_us_(0), version_(0) {
+    disks_.path = root + "/proc/diskstats";
+    interfaces_.path = root + "/proc/net/dev";
+    Source* sources[] = { &disks_, &interfaces_ };
+    for (Source* source : sources) {
+        source->fd = -1;
+        source->tracked_count = 0;
+    }
+}
+
+IORates::~IORates() {
+    Source* sources[] = { &disks_, &interfaces_ };
+    for (Source* source : sources) {
+        if (source->fd >= 0) {
+            close(source->fd);
+        }
+        for (const auto& device : source->devices) {
+            if (device.operstate_fd >= 0) {
+                close(device.operstate_fd);
+            }
+        }
+    }
+}
+
+bool IORates::readSource(Source& source, size_t& length) {
+    if (source.fd < 0) {
+        source.fd = open(source.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (source.fd < 0) {
+            return false;
+        }
+        source.buf.resize(8192);
+    }
+    
+    length = 0;
+    while (true) {
+        ssize_t n = pread(source.fd, source.buf.data() + length, source.buf.size() - length, (off_t)length);
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        length += (size_t)n;
+        if (length == source.buf.size()) {
+            source.buf.resize(source.buf.size() * 2);
+        }
+    }
+}
+
+// Index of the device named on `line`, registering it on first sight. The
+// common case is the same device on the same line as last time: one memcmp.
+size_t IORates::findDevice(Source& source, size_t line, const char* name, size_t nameLength, bool disk) {
+    if (line < source.line_order.size()) {
+        const Device& expected = source.devices[source.line_order[line]];
+        if (expected.name.size() == nameLength && std::memcmp(expected.name.data(), name, nameLength) == 0) {
+            return source.line_order[line];
+        }
+    }
+    
+    size_t index = 0;
+    for (; index < source.devices.size(); index++) {
+        const Device& device = source.devices[index];
+        if (device.name.size() == nameLength && std::memcmp(device.name.data(), name, nameLength) == 0) {
+            break;
+        }
+    }
+    if (index == source.devices.size()) {
+        Device device;
+        device.name.assign(name, nameLength);
+        device.present = false;
+        device.primed = false;
+        device.operstate_fd = -1;
+        device.stacked = false;
+        std::memset(device.counters, 0, sizeof(device.counters));
+        for (double& rate : device.rates) {
+            rate = std::numeric_limits<double>::quiet_NaN();
+        }
+        if (disk) {
+            // Whole disks have a /sys/block entry; skip loop and ramdisks like main.js
+            // did, and zram, whose "I/O" never leaves memory
+            std::string block = root_ + "/sys/block/" + device.name;
+            device.tracked = access(block.c_str(), F_OK) == 0 &&
+                             device.name.compare(0, 4, "loop") != 0 && device.name.compare(0, 3, "ram") != 0 &&
+                             device.name.compare(0, 4, "zram") != 0;
+            device.stacked = device.tracked && hasSlaves(block);
+        } else {
+            device.tracked = true;
+            std::string operstate = root_ + "/sys/class/net/" + device.name + "/operstate";
+            device.operstate_fd = open(operstate.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (device.tracked) {
+            source.tracked_count++;
+            version_++;
+        }
+        source.devices.push_back(device);
+    }
+    
+    if (line >= source.line_order.size()) {
+        source.line_order.resize(line + 1);
+    }
+    source.line_order[line] = index;
+    return index;
+}
+
+void IORates::updateDisks(double seconds) {
+    size_t length = 0;
+    if (!readSource(disks_, length)) {
+        return;
+    }
+    for (auto& device : disks_.devices) {
+        device.present = false;
+    }
+    
+    // "   8       0 sda 1234 ..." : major, minor, name, counters
+    const char* p = disks_.buf.data();
+    const char* end = p + length;
+    size_t line = 0;
+    for (; p < end; p = nextLine(p, end), line++) {
+        uint64_t ignored = 0;
+        p = parseCounter(p, end, ignored);
+        p = parseCounter(p, end, ignored);
+        p = skipSpaces(p, end);
+        const char* name = p;
+        while (p < end && *p != ' ' && *p != '\n') {
+            p++;
+        }
+        if (p == name) {
+            continue;
+        }
+        
+        Device& device = disks_.devices[findDevice(disks_, line, name, (size_t)(p - name), true)];
+        if (!device.tracked) {
+            continue;
+        }
+        uint64_t current[DC_COUNT];
+        for (size_t i = 0; i < DC_COUNT; i++) {
+            p = parseCounter(p, end, current[i]);
+        }
+        
+        double* rates = device.rates;
+        if (device.primed && seconds > 0.0) {
+            const uint64_t* prev = device.counters;
+            double reads = counterDelta(current[DC_READS], prev[DC_READS]);
+            double writes = counterDelta(current[DC_WRITES], prev[DC_WRITES]);
+            double elapsedMs = seconds * 1000.0;
+            rates[DISK_READ_BYTES_PER_SEC] = counterDelta(current[DC_SECTORS_READ], prev[DC_SECTORS_READ]) * SECTOR_BYTES / seconds;
+            rates[DISK_WRITE_BYTES_PER_SEC] = counterDelta(current[DC_SECTORS_WRITTEN], prev[DC_SECTORS_WRITTEN]) * SECTOR_BYTES / seconds;
+            rates[DISK_READ_IOPS] = reads / seconds;
+            rates[DISK_WRITE_IOPS] = writes / seconds;
+            rates[DISK_READ_LATENCY_MS] = reads > 0.0 ? counterDelta(current[DC_READ_MS], prev[DC_READ_MS]) / reads : 0.0;
+            rates[DISK_WRITE_LATENCY_MS] = writes > 0.0 ? counterDelta(current[DC_WRITE_MS], prev[DC_WRITE_MS]) / writes : 0.0;
+            rates[DISK_QUEUE_DEPTH] = counterDelta(current[DC_TIME_IN_QUEUE], prev[DC_TIME_IN_QUEUE]) / elapsedMs;
+            rates[DISK_UTILIZATION] = std::min(100.0, counterDelta(current[DC_IO_TICKS], prev[DC_IO_TICKS]) * 100.0 / elapsedMs);
+        }
+        rates[DISK_IN_FLIGHT] = (double)current[DC_IN_FLIGHT];
+        rates[DISK_READS_TOTAL] = (double)current[DC_READS];
+        rates[DISK_WRITES_TOTAL] = (double)current[DC_WRITES];
+        std::memcpy(device.counters, current, sizeof(current));
+        device.primed = true;
+        device.present = true;
+    }
+    if (line < disks_.line_order.size()) {
+        disks_.line_order.resize(line);
+    }
+}
+
+void IORates::updateInterfaces(double seconds) {
+    size_t length = 0;
+    if (!readSource(interfaces_, length)) {
+        return;
+    }
+    for (auto& device : interfaces_.devices) {
+        device.present = false;
+    }
+    
+    // Two header lines, then "  eth0: 1234 ..."
+    const char* p = interfaces_.buf.data();
+    const char* end = p + length;
+    p = nextLine(nextLine(p, end), end);
+    size_t line = 0;
+    for (; p < end; p = nextLine(p, end), line++) {
+        p = skipSpaces(p, end);
+        const char* name = p;
+        while (p < end && *p != ':' && *p != '\n') {
+            p++;
+        }
+        if (p == end || *p != ':' || p == name) {
+            continue;
+        }
+        
+        Device& device = interfaces_.devices[findDevice(interfaces_, line, name, (size_t)(p - name), false)];
+        p++;
+        uint64_t current[NC_COUNT];
+        for (size_t i = 0; i < NC_COUNT; i++) {
+            p = parseCounter(p, end, current[i]);
+        }
+        
+        double* rates = device.rates;
+        if (device.primed && seconds > 0.0) {
+            const uint64_t* prev = device.counters;
+            rates[NET_RX_BYTES_PER_SEC] = counterDelta(current[NC_RX_BYTES], prev[NC_RX_BYTES]) / seconds;
+            rates[NET_TX_BYTES_PER_SEC] = counterDelta(current[NC_TX_BYTES], prev[NC_TX_BYTES]) / seconds;
+            rates[NET_RX_PACKETS_PER_SEC] = counterDelta(current[NC_RX_PACKETS], prev[NC_RX_PACKETS]) / seconds;
+            rates[NET_TX_PACKETS_PER_SEC] = counterDelta(current[NC_TX_PACKETS], prev[NC_TX_PACKETS]) / seconds;
+            rates[NET_RX_ERRORS_PER_SEC] = counterDelta(current[NC_RX_ERRORS], prev[NC_RX_ERRORS]) / seconds;
+            rates[NET_TX_ERRORS_PER_SEC] = counterDelta(current[NC_TX_ERRORS], prev[NC_TX_ERRORS]) / seconds;
+        }
+        rates[NET_RX_BYTES] = (double)current[NC_RX_BYTES];
+        rates[NET_TX_BYTES] = (double)current[NC_TX_BYTES];
+        
+        rates[NET_OPER_UP] = std::numeric_limits<double>::quiet_NaN();
+        char state[16];
+        ssize_t n = device.operstate_fd >= 0 ? pread(device.operstate_fd, state, sizeof(state), 0) : -1;
+        if (n > 0) {
+            rates[NET_OPER_UP] = (n >= 2 && state[0] == 'u' && state[1] == 'p') ? 1.0 : 0.0;
+        }
+        std::memcpy(device.counters, current, sizeof(current));
+        device.primed = true;
+        device.present = true;
+    }
+    if (line < interfaces_.line_order.size()) {
+        interfaces_.line_order.resize(line);
+    }
+}
+
+void IORates::update(uint64_t now_us) {
+    double seconds = previous_us_ > 0 && now_us > previous_us_ ? (double)(now_us - previous_us_) / 1000000.0 : 0.0;
+    updateDisks(seconds);
+    updateInterfaces(seconds);
+    previous_us_ = now_us;
+}
+
+const char* IORates::diskFieldName(size_t field) {
+    return field < DISK_FIELD_COUNT ? DISK_FIELD_NAMES[field] : "";
+}
+
+const char* IORates::netFieldName(size_t field) {
+    return field < NET_FIELD_COUNT ? NET_FIELD_NAMES[field] : "";
+}
+
+uint64_t IORates::version() const {
+    return version_;
+}
+
+std::vector<std::string> IORates::diskNames() const {
+    std::vector<std::string> names;
+    for (const auto& device : disks_.devices) {
+        if (device.tracked) {
+            names.push_back(device.name);
+        }
+    }
+    return names;
+}
+
+std::vector<bool> IORates::diskStacked() const {
+    std::vector<bool> stacked;
+    for (const auto& device : disks_.devices) {
+        if (device.tracked) {
+            stacked.push_back(device.stacked);
+        }
+    }
+    return stacked;
+}
+
+std::vector<std::string> IORates::interfaceNames() const {
+    std::vector<std::string> names;
+    for (const auto& device : interfaces_.devices) {
+        names.push_back(device.name);
+    }
+    return names;
+}
+
+size_t IORates::valueCount() const {
+    return disks_.tracked_count * DISK_FIELD_COUNT + interfaces_.tracked_count * NET_FIELD_COUNT;
+}
+
+void IORates::fill(double* out) const {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    struct { const Source* source; size_t fields; } groups[] = {
+        { &disks_, DISK_FIELD_COUNT },
+        { &interfaces_, NET_FIELD_COUNT },
+    };
+    for (const auto& group : groups) {
+        for (const auto& device : group.source->devices) {
+            if (!device.tracked) {
+                continue;
+            }
+            for (size_t i = 0; i < group.fields; i++) {
+                *out++ = device.present ? device.rates[i] : nan;
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef IO_RATES_H
+#define IO_RATES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-disk fields of IORates::fill(), in order
+enum DiskRateField {
+    DISK_READ_BYTES_PER_SEC,
+    DISK_WRITE_BYTES_PER_SEC,
+    DISK_READ_IOPS,
+    DISK_WRITE_IOPS,
+    DISK_READ_LATENCY_MS,   // Mean time per completed read over the interval
+    DISK_WRITE_LATENCY_MS,
+    DISK_QUEUE_DEPTH,       // Mean requests in flight (time_in_queue / elapsed)
+    DISK_UTILIZATION,       // Percent of the interval with I/O in flight (io_ticks)
+    DISK_IN_FLIGHT,         // Instantaneous
+    DISK_READS_TOTAL,
+    DISK_WRITES_TOTAL,
+    DISK_FIELD_COUNT
+};
+
+// Per-interface fields of IORates::fill(), in order
+enum NetRateField {
+    NET_RX_BYTES_PER_SEC,
+    NET_TX_BYTES_PER_SEC,
+    NET_RX_PACKETS_PER_SEC,
+    NET_TX_PACKETS_PER_SEC,
+    NET_RX_ERRORS_PER_SEC,
+    NET_TX_ERRORS_PER_SEC,
+    NET_RX_BYTES,
+    NET_TX_BYTES,
+    NET_OPER_UP,            // 1 if operstate is "up", 0 otherwise, NaN if unknown
+    NET_FIELD_COUNT
+};
+
+// Disk and network throughput from /proc/diskstats and /proc/net/dev.
+// Both files stay open and are re-read with pread() into reused buffers;
+// lines are matched against the previous read's order first, so a tick
+// with unchanged topology parses without allocating. Every device keeps
+// the index it was first seen at, so array positions stay stable.
+class IORates {
+public:
+    // root prefixes the /proc and /sys paths, as for SystemMonitor
+    explicit IORates(const std::string& root = "");
+    ~IORates();
+    
+    // Re-reads both files and recomputes rates over the time since the previous update
+    void update(uint64_t now_us);
+    
+    // Bumped whenever a device gets a new index
+    uint64_t version() const;
+    std::vector<std::string> diskNames() const;
+    // Parallel to diskNames(): true for devices with entries under /sys/block/NAME/slaves
+    std::vector<bool> diskStacked() const;
+    std::vector<std::string> interfaceNames() const;
+    
+    // Disk rows (DISK_FIELD_COUNT each) then interface rows (NET_FIELD_COUNT each);
+    // devices that have gone away report NaN
+    void fill(double* out) const;
+    size_t valueCount() const;
+    
+    // camelCase names of DiskRateField / NetRateField values
+    static const char* diskFieldName(size_t field);
+    static const char* netFieldName(size_t field);
+
+private:
+    static const size_t MAX_COUNTERS = 16;
+    
+    struct Device {
+        std::string name;
+        bool tracked;            // Partitions and loop/ram/zram devices are indexed but skipped
+        bool stacked;            // dm/md on top of other disks, which already count its I/O
+        bool present;
+        bool primed;
+        int operstate_fd;
+        uint64_t counters[MAX_COUNTERS];
+        double rates[DISK_FIELD_COUNT]; // Interfaces use the first NET_FIELD_COUNT
+    };
+    
+    struct Source {
+        std::string path;
+        int fd;
+        std::vector<char> buf;
+        std::vector<Device> devices;
+        std::vector<size_t> line_order; // Device index of each line in the previous read
+        size_t tracked_count;
+    };
+    
+    bool readSource(Source& source, size_t& length);
+    size_t findDevice(Source& source, size_t line, const char* name, size_t nameLength, bool disk);
+    void updateDisks(double seconds);
+    void updateInterfaces(double seconds);
+    
+    std::string root_;
+    Source disks_;
+    Source interfaces_;
+    uint64_t previous_us_;
+    uint64_t version_;
+};
+
+#endif // IO_RATES_H
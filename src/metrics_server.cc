@@ -0,0 +1,577 @@
+#include "metrics_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const size_t MAX_CONNECTIONS = 64;
+static const size_t MAX_REQUEST_BYTES = 8192;
+static const int64_t IDLE_TIMEOUT_MS = 60000;
+static const int EPOLL_BATCH = 32;
+
+static const char* const CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+enum LabelKind {
+    LABELS_NONE,
+    LABELS_CPU,             // {cpu="cpu0"}
+    LABELS_CHIP_SENSOR,     // {chip="coretemp",sensor="Package id 0"}
+    LABELS_DOMAIN,          // {domain="package-0"}
+    LABELS_DOMAIN_WINDOW,   // {domain="package-0",window="10s"}
+};
+
+// Which snapshot fields feed which family. `field` matches the schema label
+// exactly, or as a prefix when `prefix` is set; null matches every label.
+struct FamilySpec {
+    const char* group;
+    const char* field;
+    bool prefix;
+    const char* name;
+    const char* type;
+    const char* unit;
+    double scale;
+    LabelKind labels;
+    const char* help;
+};
+
+static const FamilySpec FAMILY_SPECS[] = {
+    { "cpufreq", nullptr, false, "system_monitor_cpu_frequency_hertz", "gauge", "hertz", 1e6, LABELS_CPU,
+      "Current CPU frequency" },
+    { "cpu", nullptr, false, "system_monitor_cpu_temperature_celsius", "gauge", "celsius", 1.0, LABELS_CHIP_SENSOR,
+      "CPU temperature sensor" },
+    { "ddr5", nullptr, false, "system_monitor_memory_temperature_celsius", "gauge", "celsius", 1.0,
+      LABELS_CHIP_SENSOR, "DDR5 module temperature sensor" },
+    { "rapl", "power", false, "system_monitor_rapl_power_watts", "gauge", "watts", 1.0, LABELS_DOMAIN,
+      "RAPL domain power, smoothed over the last readings" },
+    { "rapl", "ewma", true, "system_monitor_rapl_power_ewma_watts", "gauge", "watts", 1.0, LABELS_DOMAIN_WINDOW,
+      "RAPL domain power, exponentially weighted over the window" },
+    { "rapl", "boxcar", true, "system_monitor_rapl_power_boxcar_watts", "gauge", "watts", 1.0,
+      LABELS_DOMAIN_WINDOW, "RAPL domain power, averaged over the window" },
+    // totalWh accumulates wrap-corrected deltas, so unlike the raw energy_uj
+    // reading it only ever grows (it restarts with the monitor, as counters may)
+    { "rapl", "totalWh", false, "system_monitor_rapl_energy_joules", "counter", "joules", 3600.0, LABELS_DOMAIN,
+      "Energy used by the RAPL domain since the monitor started" },
+    { "battery", "acConnected", false, "system_monitor_battery_ac_connected", "gauge", nullptr, 1.0, LABELS_NONE,
+      "1 when running on AC power" },
+    { "battery", "state", false, "system_monitor_battery_state", "gauge", nullptr, 1.0, LABELS_NONE,
+      "Battery state: 0 unknown, 1 charging, 2 discharging, 3 full, 4 idle" },
+    { "battery", "voltage", false, "system_monitor_battery_voltage_volts", "gauge", "volts", 1.0, LABELS_NONE,
+      "Battery voltage" },
+    { "battery", "current", false, "system_monitor_battery_current_amperes", "gauge", "amperes", 1.0, LABELS_NONE,
+      "Battery current" },
+    { "battery", "powerWatts", false, "system_monitor_battery_power_watts", "gauge", "watts", 1.0, LABELS_NONE,
+      "Battery charge or discharge power" },
+    { "battery", "energyNowWh", false, "system_monitor_battery_energy_joules", "gauge", "joules", 3600.0,
+      LABELS_NONE, "Energy stored in the battery" },
+    { "battery", "energyFullWh", false, "system_monitor_battery_energy_full_joules", "gauge", "joules", 3600.0,
+      LABELS_NONE, "Battery capacity when full" },
+    { "battery", "estimatedHours", false, "system_monitor_battery_time_remaining_seconds", "gauge", "seconds",
+      3600.0, LABELS_NONE, "Estimated time to full or empty" },
+};
+
+static int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void appendLabelValue(std::string& out, const std::string& value) {
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+}
+
+static void appendLabel(std::string& out, const char* name, const std::string& value) {
+    out += out.empty() ? '{' : ',';
+    out += name;
+    out += "=\"";
+    appendLabelValue(out, value);
+    out += '"';
+}
+
+static void appendNumber(std::string& out, double value) {
+    char number[32];
+    int length;
+    if (std::isinf(value)) {
+        length = snprintf(number, sizeof(number), "%s", value > 0 ? "+Inf" : "-Inf");
+    } else {
+        length = snprintf(number, sizeof(number), "%.10g", value);
+    }
+    out.append(number, (size_t)length);
+}
+
+static void appendFamilyHeader(std::string& out, const char* name, const char* type, const char* unit,
+                               const char* help) {
+    out += "# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+    if (unit != nullptr) {
+        out += "# UNIT ";
+        out += name;
+        out += ' ';
+        out += unit;
+        out += '\n';
+    }
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += '\n';
+}
+
+static void appendSample(std::string& out, const char* name, bool counter, const std::string& labels, double value) {
+    out += name;
+    if (counter) {
+        out += "_total";
+    }
+    out += labels;
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+static bool matchesSpec(const FamilySpec& spec, const SnapshotField& field) {
+    if (field.group != spec.group) {
+        return false;
+    }
+    if (spec.field == nullptr) {
+        return true;
+    }
+    return spec.prefix ? field.label.compare(0, std::strlen(spec.field), spec.field) == 0 : field.label == spec.field;
+}
+
+OpenMetricsRenderer::OpenMetricsRenderer(SystemMonitor* monitor)
+    : monitor_(monitor), plan_version_(0), has_plan_(false) {}
+
+void OpenMetricsRenderer::buildPlan(const std::vector<SnapshotField>& fields) {
+    families_.clear();
+    for (const FamilySpec& spec : FAMILY_SPECS) {
+        Family family{ spec.name, spec.type, spec.unit, spec.help, {} };
+        for (size_t i = 0; i < fields.size(); i++) {
+            const SnapshotField& field = fields[i];
+            if (!matchesSpec(spec, field)) {
+                continue;
+            }
+            Sample sample{ i, spec.scale, std::string() };
+            switch (spec.labels) {
+                case LABELS_CPU:
+                    appendLabel(sample.labels, "cpu", field.name);
+                    break;
+                case LABELS_CHIP_SENSOR:
+                    appendLabel(sample.labels, "chip", field.name);
+                    appendLabel(sample.labels, "sensor", field.label);
+                    break;
+                case LABELS_DOMAIN:
+                    appendLabel(sample.labels, "domain", field.name);
+                    break;
+                case LABELS_DOMAIN_WINDOW:
+                    appendLabel(sample.labels, "domain", field.name);
+                    appendLabel(sample.labels, "window", field.label.substr(std::strlen(spec.field)));
+                    break;
+                case LABELS_NONE:
+                    break;
+            }
+            if (!sample.labels.empty()) {
+                sample.labels += '}';
+            }
+            family.samples.push_back(sample);
+        }
+        if (!family.samples.empty()) {
+            families_.push_back(family);
+        }
+    }
+}
+
+void OpenMetricsRenderer::render(std::string& out) {
+    out.clear();
+    // Scrapes keep their own RAPL state, so their cadence never moves the UI's power
+    uint64_t version = monitor_->snapshot(values_, POWER_CONSUMER_METRICS);
+    if (!has_plan_ || version != plan_version_) {
+        std::vector<SnapshotField> fields = monitor_->getSnapshotSchema(plan_version_);
+        buildPlan(fields);
+        has_plan_ = true;
+        // A rescan between the two calls would misalign the plan with the values
+        if (plan_version_ != version) {
+            monitor_->snapshot(values_, POWER_CONSUMER_METRICS);
+        }
+    }
+    
+    for (const Family& family : families_) {
+        bool counter = std::strcmp(family.type, "counter") == 0;
+        appendFamilyHeader(out, family.name, family.type, family.unit, family.help);
+        for (const Sample& sample : family.samples) {
+            // Missing readings are left out rather than exported as NaN
+            if (sample.index < values_.size() && !std::isnan(values_[sample.index])) {
+                appendSample(out, family.name, counter, sample.labels, values_[sample.index] * sample.scale);
+            }
+        }
+    }
+    
+    monitor_->visitStats([this, &out](const SystemStats& stats) { renderStats(stats, out); });
+    out += "# EOF\n";
+}
+
+// Every key fed to updateStats(), labelled by its name
+void OpenMetricsRenderer::renderStats(const SystemStats& stats, std::string& out) {
+    if (stats.names.empty()) {
+        return;
+    }
+    struct StatColumn {
+        const char* name;
+        const char* type;
+        const char* help;
+        const std::vector<double>* column; // Null for the mean
+    };
+    const StatColumn columns[] = {
+        { "system_monitor_stat_value", "gauge", "Last valid value of a tracked metric", &stats.current_values },
+        { "system_monitor_stat_min", "gauge", "Smallest valid value since the last reset", &stats.min_values },
+        { "system_monitor_stat_max", "gauge", "Largest valid value since the last reset", &stats.max_values },
+        { "system_monitor_stat_avg", "gauge", "Mean of the valid values since the last reset", nullptr },
+        { "system_monitor_stat_samples", "counter", "Valid values recorded since the last reset",
+          &stats.count_values },
+    };
+    std::string labels;
+    for (const StatColumn& column : columns) {
+        bool counter = std::strcmp(column.type, "counter") == 0;
+        appendFamilyHeader(out, column.name, column.type, nullptr, column.help);
+        for (size_t i = 0; i < stats.names.size(); i++) {
+            if (!stats.has_value[i]) {
+                continue;
+            }
+            labels.clear();
+            appendLabel(labels, "metric", stats.names[i]);
+            labels += '}';
+            double value = column.column != nullptr ? (*column.column)[i]
+                                                    : stats.sum_values[i] / stats.count_values[i];
+            appendSample(out, column.name, counter, labels, value);
+        }
+    }
+}
+
+MetricsServer::MetricsServer() : listen_fd_(-1), epoll_fd_(-1), wake_fd_(-1), port_(0) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(SystemMonitor* monitor, const std::string& address, uint16_t port) {
+    stop();
+    error_.clear();
+    
+    struct sockaddr_storage addr;
+    std::memset(&addr, 0, sizeof(addr));
+    socklen_t addrLength;
+    struct sockaddr_in* v4 = reinterpret_cast<struct sockaddr_in*>(&addr);
+    struct sockaddr_in6* v6 = reinterpret_cast<struct sockaddr_in6*>(&addr);
+    if (inet_pton(AF_INET, address.c_str(), &v4->sin_addr) == 1) {
+        v4->sin_family = AF_INET;
+        v4->sin_port = htons(port);
+        addrLength = sizeof(*v4);
+    } else if (inet_pton(AF_INET6, address.c_str(), &v6->sin6_addr) == 1) {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = htons(port);
+        addrLength = sizeof(*v6);
+    } else {
+        error_ = "not a numeric IP address: " + address;
+        return false;
+    }
+    
+    listen_fd_ = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (listen_fd_ < 0 ||
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), addrLength) != 0 ||
+        listen(listen_fd_, 16) != 0) {
+        error_ = "cannot listen on " + address + ":" + std::to_string(port) + ": " + std::strerror(errno);
+        stop();
+        return false;
+    }
+    if (getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &addrLength) == 0) {
+        port_ = ntohs(addr.ss_family == AF_INET ? v4->sin_port : v6->sin6_port);
+    }
+    
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        error_ = std::string("cannot create event loop: ") + std::strerror(errno);
+        stop();
+        return false;
+    }
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    
+    renderer_.reset(new OpenMetricsRenderer(monitor));
+    thread_ = std::thread(&MetricsServer::loop, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+    }
+    for (auto& entry : connections_) {
+        close(entry.first);
+    }
+    connections_.clear();
+    int* fds[] = { &listen_fd_, &epoll_fd_, &wake_fd_ };
+    for (int* fd : fds) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    port_ = 0;
+}
+
+bool MetricsServer::isRunning() const {
+    return thread_.joinable();
+}
+
+uint16_t MetricsServer::port() const {
+    return port_;
+}
+
+const std::string& MetricsServer::error() const {
+    return error_;
+}
+
+void MetricsServer::loop() {
+    struct epoll_event events[EPOLL_BATCH];
+    for (;;) {
+        int count = epoll_wait(epoll_fd_, events, EPOLL_BATCH, 1000);
+        if (count < 0 && errno != EINTR) {
+            return;
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                return;
+            }
+            if (fd == listen_fd_) {
+                acceptConnections();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& conn = it->second;
+            bool alive = !(events[i].events & EPOLLERR);
+            if (alive && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+                alive = readConnection(fd, conn);
+            }
+            if (alive) {
+                alive = writeConnection(fd, conn);
+            }
+            if (!alive) {
+                closeConnection(fd);
+            }
+        }
+        
+        // Scrapers keep connections open between scrapes; drop the forgotten ones
+        int64_t now = steadyMs();
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if (now - it->second.last_active_ms > IDLE_TIMEOUT_MS) {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->first, nullptr);
+                close(it->first);
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void MetricsServer::acceptConnections() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (connections_.size() >= MAX_CONNECTIONS) {
+            close(fd);
+            continue;
+        }
+        Connection& conn = connections_[fd];
+        conn.in.clear();
+        conn.out.clear();
+        conn.sent = 0;
+        conn.close_after = false;
+        conn.last_active_ms = steadyMs();
+        
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+bool MetricsServer::readConnection(int fd, Connection& conn) {
+    char buf[2048];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return false;
+            }
+            break;
+        }
+        conn.in.append(buf, (size_t)n);
+        if (conn.in.size() > MAX_REQUEST_BYTES) {
+            return false;
+        }
+    }
+    conn.last_active_ms = steadyMs();
+    
+    // One response in flight at a time; pipelined requests wait in `in`
+    size_t end;
+    while (conn.out.empty() && !conn.close_after && (end = conn.in.find("\r\n\r\n")) != std::string::npos) {
+        handleRequest(conn, end);
+    }
+    return true;
+}
+
+bool MetricsServer::writeConnection(int fd, Connection& conn) {
+    while (conn.sent < conn.out.size()) {
+        ssize_t n = send(fd, conn.out.data() + conn.sent, conn.out.size() - conn.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return false;
+            }
+            break;
+        }
+        conn.sent += (size_t)n;
+    }
+    
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.data.fd = fd;
+    if (conn.sent < conn.out.size()) {
+        event.events = EPOLLIN | EPOLLOUT;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+        return true;
+    }
+    // clear() keeps the capacity, so the next scrape on this connection reuses it
+    conn.out.clear();
+    conn.sent = 0;
+    event.events = EPOLLIN;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+    if (conn.close_after) {
+        return false;
+    }
+    // Serve a request that arrived while the previous response was draining
+    size_t end = conn.in.find("\r\n\r\n");
+    if (end != std::string::npos) {
+        handleRequest(conn, end);
+        return writeConnection(fd, conn);
+    }
+    return true;
+}
+
+// Case-insensitive search for `token` in the value of `header` within [begin, end)
+static bool headerHasToken(const char* begin, const char* end, const char* header, const char* token) {
+    size_t headerLength = std::strlen(header);
+    size_t tokenLength = std::strlen(token);
+    for (const char* line = begin; line < end;) {
+        const char* lineEnd = std::search(line, end, "\r\n", "\r\n" + 2);
+        if ((size_t)(lineEnd - line) > headerLength && line[headerLength] == ':' &&
+            strncasecmp(line, header, headerLength) == 0) {
+            for (const char* at = line + headerLength + 1; at + tokenLength <= lineEnd; at++) {
+                if (strncasecmp(at, token, tokenLength) == 0) {
+                    return true;
+                }
+            }
+        }
+        line = lineEnd + 2;
+    }
+    return false;
+}
+
+// The request head is conn.in up to `end`; parsed in place so a scrape
+// doesn't allocate before the response is built
+void MetricsServer::handleRequest(Connection& conn, size_t end) {
+    const char* begin = conn.in.data();
+    const char* headEnd = begin + end;
+    const char* lineEnd = std::search(begin, headEnd, "\r\n", "\r\n" + 2);
+    const char* methodEnd = std::find(begin, lineEnd, ' ');
+    const char* target = methodEnd == lineEnd ? lineEnd : methodEnd + 1;
+    const char* targetEnd = std::find(target, lineEnd, ' ');
+    const char* protocol = targetEnd == lineEnd ? lineEnd : targetEnd + 1;
+    const char* pathEnd = std::find(target, targetEnd, '?');
+    auto equals = [](const char* from, const char* to, const char* text) {
+        size_t length = std::strlen(text);
+        return (size_t)(to - from) == length && std::memcmp(from, text, length) == 0;
+    };
+    
+    bool http10 = equals(protocol, lineEnd, "HTTP/1.0");
+    conn.close_after = http10 ? !headerHasToken(lineEnd, headEnd, "connection", "keep-alive")
+                              : headerHasToken(lineEnd, headEnd, "connection", "close");
+    
+    const char* status = "200 OK";
+    const char* type = CONTENT_TYPE;
+    bool head = equals(begin, methodEnd, "HEAD");
+    if (lineEnd - protocol < 5 || std::memcmp(protocol, "HTTP/", 5) != 0) {
+        status = "400 Bad Request";
+        conn.close_after = true;
+        body_ = "Bad request\n";
+        type = "text/plain; charset=utf-8";
+    } else if (!equals(begin, methodEnd, "GET") && !head) {
+        status = "405 Method Not Allowed";
+        body_ = "Only GET and HEAD are supported\n";
+        type = "text/plain; charset=utf-8";
+    } else if (equals(target, pathEnd, "/metrics")) {
+        renderer_->render(body_);
+    } else if (equals(target, pathEnd, "/")) {
+        body_ = "system-monitor exporter: metrics are at /metrics\n";
+        type = "text/plain; charset=utf-8";
+    } else {
+        status = "404 Not Found";
+        body_ = "Not found; metrics are at /metrics\n";
+        type = "text/plain; charset=utf-8";
+    }
+    
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+                          status, type, body_.size(), conn.close_after ? "close" : "keep-alive");
+    conn.out.assign(header, (size_t)length);
+    if (!head) {
+        conn.out += body_;
+    }
+    conn.sent = 0;
+    conn.in.erase(0, end + 4);
+}
+
+void MetricsServer::closeConnection(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+}
@@ -0,0 +1,93 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "system_monitor.h"
+
+// Renders a SystemMonitor snapshot and its statistics as OpenMetrics text.
+//
+// Snapshot fields are mapped to metric families once per schema version
+// (the mapping is rebuilt only after a rescan or hotplug). Each render
+// reuses the snapshot vector and the caller's output string, so a steady
+// scrape doesn't allocate in the exporter itself.
+class OpenMetricsRenderer {
+public:
+    explicit OpenMetricsRenderer(SystemMonitor* monitor);
+    
+    void render(std::string& out);
+
+private:
+    struct Sample {
+        size_t index;       // Into the snapshot values
+        double scale;       // To the family's base unit
+        std::string labels; // Rendered, e.g. {domain="package-0"}
+    };
+    struct Family {
+        const char* name;
+        const char* type;
+        const char* unit;
+        const char* help;
+        std::vector<Sample> samples;
+    };
+    
+    void buildPlan(const std::vector<SnapshotField>& fields);
+    void renderStats(const SystemStats& stats, std::string& out);
+    
+    SystemMonitor* monitor_;
+    uint64_t plan_version_;
+    bool has_plan_;
+    std::vector<Family> families_;
+    std::vector<double> values_;
+};
+
+// Minimal HTTP/1.1 server for /metrics: one thread, one epoll set, keep-alive
+// connections with their own reused output buffers. Binds to loopback unless
+// told otherwise; there is no authentication.
+class MetricsServer {
+public:
+    static const uint16_t DEFAULT_PORT = 9184;
+    
+    MetricsServer();
+    ~MetricsServer();
+    
+    // Port 0 picks a free one; see port()
+    bool start(SystemMonitor* monitor, const std::string& address, uint16_t port);
+    void stop();
+    bool isRunning() const;
+    uint16_t port() const;
+    const std::string& error() const;
+
+private:
+    struct Connection {
+        std::string in;
+        std::string out;
+        size_t sent;
+        bool close_after;
+        int64_t last_active_ms;
+    };
+    
+    void loop();
+    void acceptConnections();
+    // False when the connection should be closed
+    bool readConnection(int fd, Connection& conn);
+    bool writeConnection(int fd, Connection& conn);
+    void handleRequest(Connection& conn, size_t end);
+    void closeConnection(int fd);
+    
+    std::unique_ptr<OpenMetricsRenderer> renderer_;
+    int listen_fd_;
+    int epoll_fd_;
+    int wake_fd_;
+    uint16_t port_;
+    std::thread thread_;
+    std::unordered_map<int, Connection> connections_;
+    std::string body_;
+    std::string error_;
+};
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,221 @@
+#include "perf_counters.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// msr PMU event codes (arch/x86/events/msr.c)
+static const uint64_t MSR_EVENT_APERF = 0x01;
+static const uint64_t MSR_EVENT_MPERF = 0x02;
+
+// Upper bound on group members; matches the read buffer below
+static const size_t MAX_GROUP_MEMBERS = 8;
+
+static double ratio(uint64_t numerator, uint64_t denominator) {
+    if (denominator == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return (double)numerator / (double)denominator;
+}
+
+// Dynamic PMU types are assigned at boot and published in sysfs
+static int readPMUType(const std::string& root, const char* pmu) {
+    std::string path = root + "/sys/bus/event_source/devices/" + pmu + "/type";
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return -1;
+    }
+    int type = -1;
+    if (fscanf(file, "%d", &type) != 1) {
+        type = -1;
+    }
+    fclose(file);
+    return type;
+}
+
+PerfCounters::PerfCounters(const std::string& root) : root_(root), msr_pmu_type_(-1) {
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+int PerfCounters::openEvent(uint32_t type, uint64_t config, int cpu, int group_fd) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = group_fd < 0 ? 1 : 0; // Members follow the leader
+    attr.exclude_hv = 1;
+    
+    // pid = -1, cpu = N: count everything that runs on that CPU
+    return (int)syscall(__NR_perf_event_open, &attr, -1, cpu, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+bool PerfCounters::readGroup(int leader, uint64_t* values, size_t count) {
+    // { nr, time_enabled, time_running, value[nr] }
+    uint64_t buf[3 + MAX_GROUP_MEMBERS];
+    ssize_t n = ::read(leader, buf, sizeof(buf));
+    if (n < (ssize_t)(3 * sizeof(uint64_t)) || buf[0] < count || buf[0] > MAX_GROUP_MEMBERS) {
+        return false;
+    }
+    // Every member shares the group's enabled/running time, so ratios need no multiplex scaling
+    std::memcpy(values, buf + 3, count * sizeof(uint64_t));
+    return true;
+}
+
+int PerfCounters::open(const std::vector<int>& cpus) {
+    close();
+    msr_pmu_type_ = readPMUType(root_, "msr");
+    
+    struct Event { Slot slot; uint32_t type; uint64_t config; };
+    const Event coreEvents[] = {
+        { SLOT_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { SLOT_CACHE_REFERENCES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+        { SLOT_CACHE_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { SLOT_BRANCHES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+        { SLOT_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    
+    for (int cpu : cpus) {
+        CPUGroup group;
+        group.cpu = cpu;
+        group.primed = false;
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            group.position[i] = -1;
+            group.previous[i] = 0;
+        }
+        
+        group.core_leader = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, cpu, -1);
+        if (group.core_leader >= 0) {
+            fds_.push_back(group.core_leader);
+            group.position[SLOT_CYCLES] = 0;
+            int members = 1;
+            // A PMU without enough counters rejects the member; keep whatever fits
+            for (const auto& event : coreEvents) {
+                int fd = openEvent(event.type, event.config, cpu, group.core_leader);
+                if (fd >= 0) {
+                    fds_.push_back(fd);
+                    group.position[event.slot] = members++;
+                }
+            }
+        }
+        
+        group.msr_leader = -1;
+        if (msr_pmu_type_ >= 0) {
+            int aperf = openEvent((uint32_t)msr_pmu_type_, MSR_EVENT_APERF, cpu, -1);
+            if (aperf >= 0) {
+                int mperf = openEvent((uint32_t)msr_pmu_type_, MSR_EVENT_MPERF, cpu, aperf);
+                fds_.push_back(aperf);
+                if (mperf >= 0) {
+                    fds_.push_back(mperf);
+                    group.msr_leader = aperf;
+                    group.position[SLOT_APERF] = 0;
+                    group.position[SLOT_MPERF] = 1;
+                }
+            }
+        }
+        
+        if (group.core_leader < 0 && group.msr_leader < 0) {
+            continue;
+        }
+        
+        int leaders[] = { group.core_leader, group.msr_leader };
+        for (int leader : leaders) {
+            if (leader >= 0) {
+                ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+        }
+        if ((size_t)cpu >= group_index_.size()) {
+            group_index_.resize(cpu + 1, -1);
+        }
+        group_index_[cpu] = (int)groups_.size();
+        groups_.push_back(group);
+    }
+    return (int)groups_.size();
+}
+
+void PerfCounters::close() {
+    for (int fd : fds_) {
+        ::close(fd);
+    }
+    fds_.clear();
+    groups_.clear();
+    group_index_.clear();
+}
+
+bool PerfCounters::isOpen() const {
+    return !groups_.empty();
+}
+
+bool PerfCounters::read(int cpu, PerfCoreSample& out) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    out.ipc = nan;
+    out.cache_miss_rate = nan;
+    out.branch_miss_rate = nan;
+    out.active_ratio = nan;
+    if (cpu < 0 || (size_t)cpu >= group_index_.size() || group_index_[cpu] < 0) {
+        return false;
+    }
+    CPUGroup& group = groups_[group_index_[cpu]];
+    
+    uint64_t current[SLOT_COUNT];
+    bool valid[SLOT_COUNT] = {};
+    uint64_t values[MAX_GROUP_MEMBERS];
+    
+    struct { int leader; Slot first; Slot last; } reads[] = {
+        { group.core_leader, SLOT_CYCLES, SLOT_BRANCH_MISSES },
+        { group.msr_leader, SLOT_APERF, SLOT_MPERF },
+    };
+    for (const auto& r : reads) {
+        size_t members = 0;
+        for (int slot = r.first; slot <= r.last; slot++) {
+            if (group.position[slot] >= 0) {
+                members++;
+            }
+        }
+        if (r.leader < 0 || !readGroup(r.leader, values, members)) {
+            continue;
+        }
+        for (int slot = r.first; slot <= r.last; slot++) {
+            if (group.position[slot] >= 0) {
+                current[slot] = values[group.position[slot]];
+                valid[slot] = true;
+            }
+        }
+    }
+    
+    bool primed = group.primed;
+    uint64_t delta[SLOT_COUNT] = {};
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        if (valid[slot]) {
+            delta[slot] = current[slot] - group.previous[slot];
+            group.previous[slot] = current[slot];
+        }
+    }
+    group.primed = true;
+    if (!primed) {
+        return false;
+    }
+    
+    if (valid[SLOT_CYCLES] && valid[SLOT_INSTRUCTIONS]) {
+        out.ipc = ratio(delta[SLOT_INSTRUCTIONS], delta[SLOT_CYCLES]);
+    }
+    if (valid[SLOT_CACHE_REFERENCES] && valid[SLOT_CACHE_MISSES]) {
+        out.cache_miss_rate = ratio(delta[SLOT_CACHE_MISSES], delta[SLOT_CACHE_REFERENCES]);
+    }
+    if (valid[SLOT_BRANCHES] && valid[SLOT_BRANCH_MISSES]) {
+        out.branch_miss_rate = ratio(delta[SLOT_BRANCH_MISSES], delta[SLOT_BRANCHES]);
+    }
+    if (valid[SLOT_APERF] && valid[SLOT_MPERF]) {
+        out.active_ratio = ratio(delta[SLOT_APERF], delta[SLOT_MPERF]);
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Derived per-CPU rates over the interval since the previous read; NaN when
+// the underlying counter could not be opened or did not advance
+struct PerfCoreSample {
+    double ipc;              // Instructions per cycle
+    double cache_miss_rate;  // LLC misses / LLC references
+    double branch_miss_rate; // Branch misses / branch instructions
+    double active_ratio;     // APERF / MPERF: delivered vs. base frequency while not idle
+};
+
+// System-wide hardware counters, one perf_event_open() group per CPU.
+// Core PMU events share a group so a single read() returns all of them
+// (PERF_FORMAT_GROUP) from the same scheduling window; APERF/MPERF live on
+// the msr PMU and therefore get a second, two-member group.
+// Needs CAP_PERFMON or kernel.perf_event_paranoid <= 0.
+class PerfCounters {
+public:
+    // root prefixes the sysfs paths, as for SystemMonitor
+    explicit PerfCounters(const std::string& root = "");
+    ~PerfCounters();
+    
+    // Opens groups on the given CPUs; returns how many CPUs got at least one group
+    int open(const std::vector<int>& cpus);
+    void close();
+    bool isOpen() const;
+    
+    // Reads the group for `cpu` and returns rates since the previous read of that CPU.
+    // Returns false if the CPU has no group or the first read only primed it.
+    bool read(int cpu, PerfCoreSample& out);
+
+private:
+    enum Slot {
+        SLOT_CYCLES,
+        SLOT_INSTRUCTIONS,
+        SLOT_CACHE_REFERENCES,
+        SLOT_CACHE_MISSES,
+        SLOT_BRANCHES,
+        SLOT_BRANCH_MISSES,
+        SLOT_APERF,
+        SLOT_MPERF,
+        SLOT_COUNT
+    };
+    
+    struct CPUGroup {
+        int cpu;
+        int core_leader;     // Cycles; -1 if the core PMU is unavailable
+        int msr_leader;      // APERF; -1 if the msr PMU is unavailable
+        int position[SLOT_COUNT]; // Index within its group's read buffer, -1 if not opened
+        uint64_t previous[SLOT_COUNT];
+        bool primed;
+    };
+    
+    static int openEvent(uint32_t type, uint64_t config, int cpu, int group_fd);
+    static bool readGroup(int leader, uint64_t* values, size_t count);
+    
+    std::vector<CPUGroup> groups_;
+    std::vector<int> group_index_; // CPU number -> groups_ index, -1 if none
+    std::vector<int> fds_;
+    std::string root_;
+    int msr_pmu_type_;
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,644 @@
+#include "process_table.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <utility>
+
+// Fields of /proc/<pid>/stat after "pid (comm) state", 1-based as in proc(5)
+static const int STAT_PPID = 4;
+static const int STAT_UTIME = 14;
+static const int STAT_STIME = 15;
+static const int STAT_CUTIME = 16;
+static const int STAT_CSTIME = 17;
+static const int STAT_NUM_THREADS = 20;
+static const int STAT_STARTTIME = 22;
+
+static const char* const SORT_KEY_NAMES[PROCESS_SORT_COUNT] = { "cpu", "rss", "io" };
+
+// The time cap is checked once per this many reads
+static const size_t CLOCK_CHECK_READS = 64;
+
+static uint64_t monotonicMicroseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+ProcessTable::ProcessTable(const std::string& root)
+    : root_(root),
+      cursor_(0),
+      sweep_(0),
+      previous_us_(0),
+      cached_(0),
+      buf_(4096) {
+    long ticks = sysconf(_SC_CLK_TCK);
+    long page = sysconf(_SC_PAGESIZE);
+    ticks_per_sec_ = ticks > 0 ? (double)ticks : 100.0;
+    page_bytes_ = page > 0 ? (uint64_t)page : 4096;
+}
+
+ProcessTable::~ProcessTable() {
+    for (auto& entry : entries_) {
+        closeEntry(entry.second);
+    }
+}
+
+bool ProcessTable::parseSortKey(const std::string& name, ProcessSortKey& key) {
+    for (int k = 0; k < PROCESS_SORT_COUNT; k++) {
+        if (name == SORT_KEY_NAMES[k]) {
+            key = (ProcessSortKey)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProcessTable::update(uint64_t now_us, const std::vector<double>& energy_j) {
+    if (cursor_ >= pids_.size()) {
+        startSweep();
+    }
+    
+    // Enough of the listing to finish a sweep every SWEEP_TARGET_US at this call rate
+    uint64_t elapsed = previous_us_ != 0 && now_us > previous_us_ ? now_us - previous_us_ : SWEEP_TARGET_US;
+    previous_us_ = now_us;
+    size_t reads = (size_t)((double)pids_.size() * (double)elapsed / (double)SWEEP_TARGET_US) + 1;
+    reads = std::max(MIN_READS_PER_UPDATE, std::min(reads, MAX_READS_PER_UPDATE));
+    
+    size_t end = std::min(pids_.size(), cursor_ + reads);
+    uint64_t deadline = monotonicMicroseconds() + MAX_UPDATE_US;
+    for (size_t done = 0; cursor_ < end; cursor_++, done++) {
+        if (done % CLOCK_CHECK_READS == CLOCK_CHECK_READS - 1 && monotonicMicroseconds() >= deadline) {
+            break;
+        }
+        readProcess(pids_[cursor_], now_us);
+    }
+    if (cursor_ >= pids_.size()) {
+        finishSweep(energy_j);
+    }
+}
+
+void ProcessTable::startSweep() {
+    sweep_++;
+    pids_.clear();
+    cursor_ = 0;
+    
+    DIR* dir = opendir((root_ + "/proc").c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        const char* name = ent->d_name;
+        if (name[0] < '1' || name[0] > '9') {
+            continue;
+        }
+        char* end = nullptr;
+        long pid = std::strtol(name, &end, 10);
+        if (*end == '\0' && pid > 0) {
+            pids_.push_back((int)pid);
+        }
+    }
+    closedir(dir);
+}
+
+void ProcessTable::finishSweep(const std::vector<double>& energy_j) {
+    // Charged first, so processes that exited during the sweep get their share
+    chargeEnergy(energy_j);
+    
+    // Whatever this sweep didn't see has exited
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.sweep == sweep_) {
+            ++it;
+            continue;
+        }
+        auto live = start_times_.find(it->first.pid);
+        if (live != start_times_.end() && live->second == it->first.start_time) {
+            start_times_.erase(live);
+        }
+        retireEntry(it->first, it->second);
+        closeEntry(it->second);
+        it = entries_.erase(it);
+    }
+    // Credit for a parent that has itself gone can never be claimed
+    for (auto it = reaped_credit_.begin(); it != reaped_credit_.end();) {
+        if (start_times_.count(it->first) == 0) {
+            it = reaped_credit_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    // Bounded min-heaps: O(N log TOP_CAPACITY) per key
+    typedef std::pair<double, Key> Ranked;
+    auto lighter = [](const Ranked& a, const Ranked& b) { return a.first > b.first; };
+    std::vector<Ranked> heap;
+    heap.reserve(TOP_CAPACITY + 1);
+    for (int k = 0; k < PROCESS_SORT_COUNT; k++) {
+        heap.clear();
+        for (const auto& entry : entries_) {
+            double value = sortValue(entry.second.info, (ProcessSortKey)k);
+            if (heap.size() == TOP_CAPACITY && value <= heap.front().first) {
+                continue;
+            }
+            heap.push_back(Ranked(value, entry.first));
+            std::push_heap(heap.begin(), heap.end(), lighter);
+            if (heap.size() > TOP_CAPACITY) {
+                std::pop_heap(heap.begin(), heap.end(), lighter);
+                heap.pop_back();
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), lighter);
+        top_[k].clear();
+        for (const Ranked& ranked : heap) {
+            top_[k].push_back(ranked.second);
+        }
+    }
+}
+
+int ProcessTable::openProcFile(int pid, const char* file) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/%s", pid, file);
+    return open((root_ + path).c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+ssize_t ProcessTable::readProcFile(int& fd, int pid, const char* file, bool keep) {
+    if (fd < 0) {
+        fd = openProcFile(pid, file);
+        if (fd < 0) {
+            return -1;
+        }
+    }
+    ssize_t n = pread(fd, buf_.data(), buf_.size() - 1, 0);
+    if (n <= 0 || !keep) {
+        close(fd);
+        fd = -1;
+    }
+    if (n < 0) {
+        return -1;
+    }
+    buf_[n] = '\0';
+    return n;
+}
+
+void ProcessTable::closeEntry(Entry& entry) {
+    int* fds[] = { &entry.stat_fd, &entry.statm_fd, &entry.io_fd };
+    for (int* fd : fds) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    if (entry.cached) {
+        entry.cached = false;
+        cached_--;
+    }
+}
+
+// A dead process's fds read as errors, so a failed read on a cached fd means
+// the pid is gone or has been reused; both start over from a fresh open
+void ProcessTable::readProcess(int pid, uint64_t now_us) {
+    Entry* entry = nullptr;
+    auto live = start_times_.find(pid);
+    if (live != start_times_.end()) {
+        entry = &entries_[Key{ pid, live->second }];
+    }
+    
+    int fd = entry != nullptr ? entry->stat_fd : -1;
+    bool keep = entry != nullptr ? entry->cached : cached_ < MAX_CACHED_PROCESSES;
+    ssize_t n = readProcFile(fd, pid, "stat", keep);
+    if (n <= 0 && entry != nullptr && entry->stat_fd >= 0) {
+        entry->stat_fd = -1; // readProcFile closed it
+        fd = -1;
+        n = readProcFile(fd, pid, "stat", keep);
+    }
+    if (n <= 0) {
+        return;
+    }
+    
+    // comm may contain spaces and parentheses; the last ')' ends it
+    const char* text = buf_.data();
+    const char* lparen = std::strchr(text, '(');
+    const char* rparen = std::strrchr(text, ')');
+    if (lparen == nullptr || rparen == nullptr || rparen < lparen || rparen[1] == '\0') {
+        // Close the fd unless the entry already owns it; a reopen after a
+        // stale fd is not stored yet, so this catches it too
+        if (fd >= 0 && (entry == nullptr || entry->stat_fd != fd)) {
+            close(fd);
+        }
+        return;
+    }
+    std::string name(lparen + 1, rparen);
+    char state = rparen[2];
+    uint64_t ppid = 0, utime = 0, stime = 0, cutime = 0, cstime = 0, threads = 0, start = 0;
+    const char* p = rparen + 2;
+    for (int field = 3; field <= STAT_STARTTIME && *p != '\0'; field++) {
+        char* next = nullptr;
+        uint64_t value = field == 3 ? 0 : std::strtoull(p, &next, 10);
+        if (field == STAT_PPID) ppid = value;
+        else if (field == STAT_UTIME) utime = value;
+        else if (field == STAT_STIME) stime = value;
+        else if (field == STAT_CUTIME) cutime = value;
+        else if (field == STAT_CSTIME) cstime = value;
+        else if (field == STAT_NUM_THREADS) threads = value;
+        else if (field == STAT_STARTTIME) start = value;
+        p = std::strchr(p, ' ');
+        if (p == nullptr) {
+            break;
+        }
+        p++;
+    }
+    
+    Key key{ pid, start };
+    if (entry != nullptr && live->second != start) {
+        // Reused pid behind an uncached entry: the old process is gone
+        retireEntry(Key{ pid, live->second }, *entry);
+        closeEntry(*entry);
+        entries_.erase(Key{ pid, live->second });
+        entry = nullptr;
+    }
+    if (entry == nullptr) {
+        Entry fresh;
+        fresh.info.pid = pid;
+        fresh.info.start_time = start;
+        fresh.info.cpu_percent = 0.0;
+        fresh.info.rss_bytes = 0;
+        fresh.info.read_bytes_per_sec = 0.0;
+        fresh.info.write_bytes_per_sec = 0.0;
+        fresh.stat_fd = -1;
+        fresh.statm_fd = -1;
+        fresh.io_fd = -1;
+        fresh.cached = keep;
+        fresh.io_denied = false;
+        fresh.cpu_ticks = 0;
+        fresh.child_ticks = 0;
+        fresh.seen_ticks = 0;
+        fresh.read_bytes = 0;
+        fresh.write_bytes = 0;
+        fresh.read_us = 0;
+        fresh.pending_ticks = 0;
+        fresh.joules.assign(domain_names_.size(), 0.0);
+        readCgroup(pid, fresh.cgroup);
+        if (keep) {
+            cached_++;
+        }
+        entry = &(entries_[key] = fresh);
+        start_times_[pid] = start;
+    }
+    entry->stat_fd = fd;
+    entry->sweep = sweep_;
+    entry->ppid = (int)ppid;
+    
+    ProcessInfo& info = entry->info;
+    info.name = name;
+    info.state = state;
+    info.threads = (uint32_t)threads;
+    
+    // statm: size resident shared text lib data dt, in pages
+    if (readProcFile(entry->statm_fd, pid, "statm", entry->cached) > 0) {
+        unsigned long long size = 0, resident = 0;
+        if (std::sscanf(buf_.data(), "%llu %llu", &size, &resident) == 2) {
+            info.rss_bytes = (uint64_t)resident * page_bytes_;
+        }
+    }
+    
+    uint64_t readBytes = 0, writeBytes = 0;
+    bool haveIO = false;
+    if (!entry->io_denied) {
+        if (readProcFile(entry->io_fd, pid, "io", entry->cached) > 0) {
+            const char* r = std::strstr(buf_.data(), "\nread_bytes: ");
+            const char* w = std::strstr(buf_.data(), "\nwrite_bytes: ");
+            if (r != nullptr && w != nullptr) {
+                readBytes = std::strtoull(r + 13, nullptr, 10);
+                writeBytes = std::strtoull(w + 14, nullptr, 10);
+                haveIO = true;
+            }
+        } else {
+            // Other users' processes need ptrace access; don't retry every sweep
+            entry->io_denied = true;
+        }
+    }
+    
+    uint64_t ticks = utime + stime;
+    uint64_t childTicks = cutime + cstime;
+    if (entry->read_us != 0 && now_us > entry->read_us) {
+        double seconds = (double)(now_us - entry->read_us) / 1e6;
+        uint64_t usedTicks = ticks >= entry->cpu_ticks ? ticks - entry->cpu_ticks : 0;
+        info.cpu_percent = (double)usedTicks / ticks_per_sec_ / seconds * 100.0;
+        
+        // Children reaped since the last read: charged here unless the sweep
+        // already charged them while they ran
+        uint64_t reapedTicks = childTicks >= entry->child_ticks ? childTicks - entry->child_ticks : 0;
+        auto credit = reaped_credit_.find(pid);
+        if (credit != reaped_credit_.end() && reapedTicks > 0) {
+            uint64_t covered = std::min(reapedTicks, credit->second);
+            reapedTicks -= covered;
+            credit->second -= covered;
+            if (credit->second == 0) {
+                reaped_credit_.erase(credit);
+            }
+        }
+        entry->pending_ticks += usedTicks + reapedTicks;
+        entry->seen_ticks += usedTicks + reapedTicks;
+        if (haveIO) {
+            info.read_bytes_per_sec = (double)(readBytes >= entry->read_bytes ? readBytes - entry->read_bytes : 0) / seconds;
+            info.write_bytes_per_sec = (double)(writeBytes >= entry->write_bytes ? writeBytes - entry->write_bytes : 0) / seconds;
+        }
+    }
+    if (!haveIO) {
+        info.read_bytes_per_sec = std::numeric_limits<double>::quiet_NaN();
+        info.write_bytes_per_sec = std::numeric_limits<double>::quiet_NaN();
+    }
+    entry->cpu_ticks = ticks;
+    entry->child_ticks = childTicks;
+    entry->read_bytes = readBytes;
+    entry->write_bytes = writeBytes;
+    entry->read_us = now_us;
+}
+
+// v1 hierarchies name the cpu controller's group; otherwise the unified (v2) one
+void ProcessTable::readCgroup(int pid, std::string& cgroup) {
+    int fd = -1;
+    if (readProcFile(fd, pid, "cgroup", false) <= 0) {
+        return;
+    }
+    const char* line = buf_.data();
+    while (*line != '\0') {
+        const char* end = std::strchr(line, '\n');
+        if (end == nullptr) {
+            end = line + std::strlen(line);
+        }
+        const char* first = static_cast<const char*>(std::memchr(line, ':', end - line));
+        const char* second = first != nullptr ? static_cast<const char*>(std::memchr(first + 1, ':', end - first - 1)) : nullptr;
+        if (second != nullptr) {
+            std::string controllers(first + 1, second);
+            std::string path(second + 1, end);
+            if (controllers.empty()) {
+                cgroup = path;
+            } else {
+                std::string::size_type start = 0;
+                while (start <= controllers.size()) {
+                    std::string::size_type comma = controllers.find(',', start);
+                    std::string controller = controllers.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                    if (controller == "cpu" || controller == "cpuacct") {
+                        cgroup = path;
+                        return;
+                    }
+                    if (comma == std::string::npos) {
+                        break;
+                    }
+                    start = comma + 1;
+                }
+            }
+        }
+        line = *end == '\n' ? end + 1 : end;
+    }
+}
+
+void ProcessTable::setEnergyDomains(const std::vector<std::string>& names, const std::vector<bool>& in_total) {
+    domain_in_total_ = in_total;
+    domain_in_total_.resize(names.size(), false);
+    // The caller's cumulative counters restart with a new domain list
+    charged_energy_j_.clear();
+    if (names == domain_names_) {
+        return;
+    }
+    
+    domain_names_ = names;
+    unattributed_j_.assign(names.size(), 0.0);
+    for (auto& entry : entries_) {
+        entry.second.joules.assign(names.size(), 0.0);
+        entry.second.pending_ticks = 0;
+    }
+    exited_.clear();
+    exited_cgroup_joules_.clear();
+}
+
+const std::vector<std::string>& ProcessTable::energyDomains() const {
+    return domain_names_;
+}
+
+const std::vector<double>& ProcessTable::unattributedJoules() const {
+    return unattributed_j_;
+}
+
+double ProcessTable::totalJoules(const std::vector<double>& joules) const {
+    double total = 0.0;
+    for (size_t d = 0; d < joules.size() && d < domain_in_total_.size(); d++) {
+        if (domain_in_total_[d]) {
+            total += joules[d];
+        }
+    }
+    return total;
+}
+
+void ProcessTable::chargeEnergy(const std::vector<double>& energy_j) {
+    size_t domains = domain_names_.size();
+    if (domains == 0 || energy_j.size() != domains) {
+        return;
+    }
+    if (charged_energy_j_.size() != domains) {
+        // First sweep on these counters only sets the baseline
+        charged_energy_j_ = energy_j;
+        for (auto& entry : entries_) {
+            entry.second.pending_ticks = 0;
+        }
+        return;
+    }
+    
+    uint64_t totalTicks = 0;
+    for (const auto& entry : entries_) {
+        totalTicks += entry.second.pending_ticks;
+    }
+    for (size_t d = 0; d < domains; d++) {
+        double delta = std::max(0.0, energy_j[d] - charged_energy_j_[d]);
+        if (totalTicks == 0) {
+            unattributed_j_[d] += delta;
+            continue;
+        }
+        double perTick = delta / (double)totalTicks;
+        for (auto& entry : entries_) {
+            if (entry.second.pending_ticks > 0) {
+                entry.second.joules[d] += perTick * (double)entry.second.pending_ticks;
+            }
+        }
+    }
+    for (auto& entry : entries_) {
+        entry.second.pending_ticks = 0;
+    }
+    charged_energy_j_ = energy_j;
+}
+
+// Keeps an exited process's energy: in its cgroup's total, and in the
+// exited list if it is among the heaviest
+void ProcessTable::retireEntry(const Key& key, Entry& entry) {
+    // The parent's cutime/cstime will grow by everything this process used,
+    // including what was charged to it directly
+    if (entry.seen_ticks > 0 && entry.ppid > 0) {
+        reaped_credit_[entry.ppid] += entry.seen_ticks;
+    }
+    
+    double total = totalJoules(entry.joules);
+    if (total <= 0.0) {
+        return;
+    }
+    
+    std::vector<double>& cgroup = exited_cgroup_joules_[entry.cgroup];
+    cgroup.resize(domain_names_.size(), 0.0);
+    for (size_t d = 0; d < cgroup.size() && d < entry.joules.size(); d++) {
+        cgroup[d] += entry.joules[d];
+    }
+    if (exited_cgroup_joules_.size() > CGROUP_CAPACITY) {
+        auto lightest = exited_cgroup_joules_.end();
+        double lightestTotal = 0.0;
+        for (auto it = exited_cgroup_joules_.begin(); it != exited_cgroup_joules_.end(); ++it) {
+            double joules = totalJoules(it->second);
+            if (lightest == exited_cgroup_joules_.end() || joules < lightestTotal) {
+                lightest = it;
+                lightestTotal = joules;
+            }
+        }
+        exited_cgroup_joules_.erase(lightest);
+    }
+    
+    ProcessEnergy retired;
+    retired.pid = key.pid;
+    retired.start_time = key.start_time;
+    retired.name = entry.info.name;
+    retired.cgroup = entry.cgroup;
+    retired.exited = true;
+    retired.joules = total;
+    retired.domain_joules = entry.joules;
+    if (exited_.size() < EXITED_CAPACITY) {
+        exited_.push_back(retired);
+        return;
+    }
+    auto lightest = std::min_element(exited_.begin(), exited_.end(), [](const ProcessEnergy& a, const ProcessEnergy& b) {
+        return a.joules < b.joules;
+    });
+    if (lightest->joules < total) {
+        *lightest = retired;
+    }
+}
+
+void ProcessTable::energyByProcess(size_t n, std::vector<ProcessEnergy>& out) const {
+    out.clear();
+    // Rank first, copy only the winners; indexes past the live ones are exited_
+    std::vector<const std::pair<const Key, Entry>*> live;
+    std::vector<std::pair<double, size_t>> ranked;
+    for (const auto& entry : entries_) {
+        double total = totalJoules(entry.second.joules);
+        if (total > 0.0) {
+            ranked.push_back(std::make_pair(total, live.size()));
+            live.push_back(&entry);
+        }
+    }
+    for (size_t i = 0; i < exited_.size(); i++) {
+        ranked.push_back(std::make_pair(exited_[i].joules, live.size() + i));
+    }
+    
+    size_t count = std::min(n, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) {
+                          return a.first > b.first || (a.first == b.first && a.second < b.second);
+                      });
+    
+    for (size_t i = 0; i < count; i++) {
+        size_t index = ranked[i].second;
+        if (index >= live.size()) {
+            out.push_back(exited_[index - live.size()]);
+            continue;
+        }
+        const auto& entry = *live[index];
+        ProcessEnergy energy;
+        energy.pid = entry.first.pid;
+        energy.start_time = entry.first.start_time;
+        energy.name = entry.second.info.name;
+        energy.cgroup = entry.second.cgroup;
+        energy.exited = false;
+        energy.joules = ranked[i].first;
+        energy.domain_joules = entry.second.joules;
+        out.push_back(energy);
+    }
+}
+
+void ProcessTable::energyByCgroup(size_t n, std::vector<ProcessEnergy>& out) const {
+    out.clear();
+    std::unordered_map<std::string, std::vector<double>> totals = exited_cgroup_joules_;
+    for (const auto& entry : entries_) {
+        std::vector<double>& cgroup = totals[entry.second.cgroup];
+        cgroup.resize(domain_names_.size(), 0.0);
+        for (size_t d = 0; d < cgroup.size() && d < entry.second.joules.size(); d++) {
+            cgroup[d] += entry.second.joules[d];
+        }
+    }
+    
+    for (const auto& cgroup : totals) {
+        double total = totalJoules(cgroup.second);
+        if (total <= 0.0) {
+            continue;
+        }
+        ProcessEnergy energy;
+        energy.pid = 0;
+        energy.start_time = 0;
+        energy.cgroup = cgroup.first;
+        energy.exited = false;
+        energy.joules = total;
+        energy.domain_joules = cgroup.second;
+        out.push_back(energy);
+    }
+    size_t count = std::min(n, out.size());
+    std::partial_sort(out.begin(), out.begin() + count, out.end(), [](const ProcessEnergy& a, const ProcessEnergy& b) {
+        return a.joules > b.joules;
+    });
+    out.resize(count);
+}
+
+double ProcessTable::sortValue(const ProcessInfo& info, ProcessSortKey key) {
+    switch (key) {
+        case PROCESS_SORT_CPU:
+            return info.cpu_percent;
+        case PROCESS_SORT_RSS:
+            return (double)info.rss_bytes;
+        case PROCESS_SORT_IO: {
+            double io = info.read_bytes_per_sec + info.write_bytes_per_sec;
+            return std::isnan(io) ? 0.0 : io;
+        }
+        default:
+            return 0.0;
+    }
+}
+
+void ProcessTable::top(ProcessSortKey key, size_t n, std::vector<ProcessInfo>& out) const {
+    out.clear();
+    if (key < 0 || key >= PROCESS_SORT_COUNT) {
+        return;
+    }
+    for (const Key& ranked : top_[key]) {
+        if (out.size() >= n) {
+            break;
+        }
+        auto it = entries_.find(ranked);
+        if (it != entries_.end()) {
+            out.push_back(it->second.info);
+        }
+    }
+    // Members may have been re-read since the ranking was built
+    std::stable_sort(out.begin(), out.end(), [key](const ProcessInfo& a, const ProcessInfo& b) {
+        return sortValue(a, key) > sortValue(b, key);
+    });
+}
+
+size_t ProcessTable::processCount() const {
+    return entries_.size();
+}
+
+uint64_t ProcessTable::sweeps() const {
+    return sweep_;
+}
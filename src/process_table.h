@@ -0,0 +1,170 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+// Orderings ProcessTable::top() keeps heaps for
+enum ProcessSortKey {
+    PROCESS_SORT_CPU,
+    PROCESS_SORT_RSS,
+    PROCESS_SORT_IO,     // Read plus write bytes per second
+    PROCESS_SORT_COUNT
+};
+
+struct ProcessInfo {
+    int pid;
+    uint64_t start_time;        // Clock ticks after boot; (pid, start_time) names one process
+    std::string name;           // comm
+    char state;
+    uint32_t threads;
+    double cpu_percent;         // Of one CPU, since this process's previous read
+    uint64_t rss_bytes;
+    double read_bytes_per_sec;  // NaN when /proc/<pid>/io isn't readable
+    double write_bytes_per_sec;
+};
+
+// Energy charged to one process, or from energyByCgroup() to one cgroup
+struct ProcessEnergy {
+    int pid;                            // 0 for cgroup totals
+    uint64_t start_time;
+    std::string name;
+    std::string cgroup;                 // v2 path, or the v1 cpu controller's
+    bool exited;
+    double joules;                      // Sum of the domains counted in the total
+    std::vector<double> domain_joules;  // Index-aligned with energyDomains()
+};
+
+// Per-process CPU, memory and I/O from /proc/<pid>/{stat,statm,io}.
+//
+// A sweep lists /proc once and then reads a bounded slice of it on each
+// update(), sized so a sweep takes about SWEEP_TARGET_US however many
+// processes there are, but never more than MAX_READS_PER_UPDATE or
+// MAX_UPDATE_US of reading per call.
+// The three files stay open per process (up to MAX_CACHED_PROCESSES) and
+// are re-read with pread(). Deltas live in a map keyed by (pid, start
+// time), so a recycled pid starts from scratch instead of inheriting its
+// predecessor's counters. When a sweep completes, processes that were not
+// seen are dropped and bounded heaps rebuild the top-TOP_CAPACITY ranking
+// for each sort key.
+//
+// Energy attribution: update() also takes each RAPL domain's cumulative
+// energy. At the end of a sweep, every domain's energy since the previous
+// sweep is split across processes in proportion to the CPU time each used
+// since its previous read (so idle power is shared by whoever ran), and
+// accumulated per process. Exited processes keep their joules in a bounded
+// list of the heaviest EXITED_CAPACITY, and in their cgroup's total.
+// Children that exit between two reads of their parent are never read
+// themselves; their CPU time reaches the parent's cutime/cstime when it
+// waits for them, and that delta is charged to the parent. Exited children
+// that were read are credited against it so their time isn't charged twice.
+class ProcessTable {
+public:
+    static const size_t MAX_READS_PER_UPDATE = 2048;
+    static const size_t MIN_READS_PER_UPDATE = 256;
+    static const uint64_t SWEEP_TARGET_US = 1000000;
+    static const uint64_t MAX_UPDATE_US = 20000;
+    static const size_t MAX_CACHED_PROCESSES = 4096;
+    static const size_t TOP_CAPACITY = 64;
+    static const size_t EXITED_CAPACITY = 256;
+    static const size_t CGROUP_CAPACITY = 1024;
+    
+    // root prefixes /proc, as for SystemMonitor
+    explicit ProcessTable(const std::string& root = "");
+    ~ProcessTable();
+    
+    // energy_j: cumulative joules per energy domain at now_us, empty without RAPL
+    void update(uint64_t now_us, const std::vector<double>& energy_j);
+    
+    // Heaviest first, at most min(n, TOP_CAPACITY), as of the last completed sweep
+    // with each process's latest reading
+    void top(ProcessSortKey key, size_t n, std::vector<ProcessInfo>& out) const;
+    size_t processCount() const;
+    uint64_t sweeps() const;
+    
+    // Domains update() reports energy for; in_total marks those summed into
+    // ProcessEnergy::joules (nested domains and psys overlap the packages).
+    // Accumulated energy is kept only if the names are unchanged.
+    void setEnergyDomains(const std::vector<std::string>& names, const std::vector<bool>& in_total);
+    const std::vector<std::string>& energyDomains() const;
+    // Heaviest first: live processes plus retained exited ones
+    void energyByProcess(size_t n, std::vector<ProcessEnergy>& out) const;
+    void energyByCgroup(size_t n, std::vector<ProcessEnergy>& out) const;
+    // Per domain: energy from sweeps in which no tracked process used CPU
+    const std::vector<double>& unattributedJoules() const;
+    
+    // "cpu", "rss" or "io"; false for anything else
+    static bool parseSortKey(const std::string& name, ProcessSortKey& key);
+
+private:
+    struct Key {
+        int pid;
+        uint64_t start_time;
+        bool operator==(const Key& other) const {
+            return pid == other.pid && start_time == other.start_time;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return (size_t)key.pid * 0x9E3779B97F4A7C15ULL ^ (size_t)key.start_time;
+        }
+    };
+    struct Entry {
+        ProcessInfo info;
+        int stat_fd;
+        int statm_fd;
+        int io_fd;
+        bool cached;        // Holds its fds between sweeps
+        bool io_denied;     // /proc/<pid>/io belongs to another user
+        int ppid;
+        uint64_t cpu_ticks; // utime + stime
+        uint64_t child_ticks;       // cutime + cstime: waited-for children's CPU time
+        uint64_t seen_ticks;        // CPU time charged to this entry, its own and reaped children's
+        uint64_t read_bytes;
+        uint64_t write_bytes;
+        uint64_t read_us;   // When the counters above were taken, 0 before the first read
+        uint64_t sweep;     // Last sweep that saw this process
+        uint64_t pending_ticks;     // CPU time not yet charged with energy
+        std::string cgroup;
+        std::vector<double> joules; // Per energy domain
+    };
+    
+    void startSweep();
+    void finishSweep(const std::vector<double>& energy_j);
+    void chargeEnergy(const std::vector<double>& energy_j);
+    void retireEntry(const Key& key, Entry& entry);
+    void readCgroup(int pid, std::string& cgroup);
+    double totalJoules(const std::vector<double>& joules) const;
+    void readProcess(int pid, uint64_t now_us);
+    int openProcFile(int pid, const char* file);
+    ssize_t readProcFile(int& fd, int pid, const char* file, bool keep);
+    void closeEntry(Entry& entry);
+    static double sortValue(const ProcessInfo& info, ProcessSortKey key);
+    
+    std::string root_;
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+    std::unordered_map<int, uint64_t> start_times_; // pid -> start time of its live entry
+    std::vector<int> pids_;                           // This sweep's listing
+    size_t cursor_;
+    uint64_t sweep_;
+    uint64_t previous_us_;
+    size_t cached_;
+    double ticks_per_sec_;
+    uint64_t page_bytes_;
+    std::vector<char> buf_;
+    std::vector<Key> top_[PROCESS_SORT_COUNT];
+    
+    std::vector<std::string> domain_names_;
+    std::vector<bool> domain_in_total_;
+    std::vector<double> charged_energy_j_; // Cumulative energy at the last charge
+    std::vector<double> unattributed_j_;
+    std::vector<ProcessEnergy> exited_;
+    std::unordered_map<std::string, std::vector<double>> exited_cgroup_joules_;
+    std::unordered_map<int, uint64_t> reaped_credit_; // ppid -> exited children's ticks already charged
+};
+
+#endif // PROCESS_TABLE_H
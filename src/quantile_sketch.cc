@@ -0,0 +1,169 @@
+#include "quantile_sketch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const double PI = 3.14159265358979323846;
+
+// k1 scale function: centroids may span one unit of k, which keeps them
+// small near q=0 and q=1 and large around the median
+static double kOfQ(double q, double compression) {
+    return compression / (2.0 * PI) * std::asin(2.0 * q - 1.0);
+}
+
+static double qOfK(double k, double compression) {
+    return (std::sin(k * 2.0 * PI / compression) + 1.0) / 2.0;
+}
+
+QuantileSketch::QuantileSketch(double compression)
+    : compression_(compression),
+      buffer_limit_((size_t)std::ceil(compression * 5.0)),
+      total_weight_(0.0),
+      min_(std::numeric_limits<double>::infinity()),
+      max_(-std::numeric_limits<double>::infinity()) {
+}
+
+void QuantileSketch::add(double value, double weight) {
+    if (!std::isfinite(value) || !(weight > 0.0)) {
+        return;
+    }
+    
+    buffer_.push_back(Centroid{ value, weight });
+    total_weight_ += weight;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    if (buffer_.size() >= buffer_limit_) {
+        compress();
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    for (const auto& c : other.centroids_) {
+        buffer_.push_back(c);
+    }
+    for (const auto& c : other.buffer_) {
+        buffer_.push_back(c);
+    }
+    total_weight_ += other.total_weight_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    compress();
+}
+
+void QuantileSketch::reset() {
+    centroids_.clear();
+    buffer_.clear();
+    total_weight_ = 0.0;
+    min_ = std::numeric_limits<double>::infinity();
+    max_ = -std::numeric_limits<double>::infinity();
+}
+
+void QuantileSketch::compress() {
+    if (buffer_.empty()) {
+        return;
+    }
+    
+    buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+    std::sort(buffer_.begin(), buffer_.end(),
+              [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+    centroids_.clear();
+    
+    Centroid current = buffer_[0];
+    double weightSoFar = 0.0;
+    double weightLimit = total_weight_ * qOfK(kOfQ(0.0, compression_) + 1.0, compression_);
+    
+    for (size_t i = 1; i < buffer_.size(); i++) {
+        const Centroid& next = buffer_[i];
+        if (weightSoFar + current.weight + next.weight <= weightLimit) {
+            current.mean += (next.mean - current.mean) * next.weight / (current.weight + next.weight);
+            current.weight += next.weight;
+        } else {
+            weightSoFar += current.weight;
+            centroids_.push_back(current);
+            double q = std::min(1.0, weightSoFar / total_weight_);
+            weightLimit = total_weight_ * qOfK(kOfQ(q, compression_) + 1.0, compression_);
+            current = next;
+        }
+    }
+    centroids_.push_back(current);
+    buffer_.clear();
+}
+
+double QuantileSketch::quantile(double q) {
+    compress();
+    if (centroids_.empty() || !(q >= 0.0 && q <= 1.0)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (centroids_.size() == 1 || q == 0.0) {
+        return q == 0.0 ? min_ : centroids_[0].mean;
+    }
+    if (q == 1.0) {
+        return max_;
+    }
+    
+    // Interpolate between centroid midpoints, anchored at min/max at the ends
+    double index = q * total_weight_;
+    double prevMid = 0.0;
+    double prevMean = min_;
+    double cumulative = 0.0;
+    for (const auto& c : centroids_) {
+        double mid = cumulative + c.weight / 2.0;
+        if (index < mid) {
+            double span = mid - prevMid;
+            return span > 0.0 ? prevMean + (c.mean - prevMean) * (index - prevMid) / span : c.mean;
+        }
+        cumulative += c.weight;
+        prevMid = mid;
+        prevMean = c.mean;
+    }
+    
+    double span = total_weight_ - prevMid;
+    return span > 0.0 ? prevMean + (max_ - prevMean) * (index - prevMid) / span : max_;
+}
+
+double QuantileSketch::count() const {
+    return total_weight_;
+}
+
+double QuantileSketch::min() const {
+    return min_;
+}
+
+double QuantileSketch::max() const {
+    return max_;
+}
+
+void QuantileSketch::serialize(std::vector<double>& out) {
+    compress();
+    out.clear();
+    if (centroids_.empty()) {
+        return;
+    }
+    out.reserve(2 + centroids_.size() * 2);
+    out.push_back(min_);
+    out.push_back(max_);
+    for (const auto& c : centroids_) {
+        out.push_back(c.mean);
+        out.push_back(c.weight);
+    }
+}
+
+bool QuantileSketch::deserializeMerge(const double* data, size_t length) {
+    if (length < 4 || length % 2 != 0) {
+        return false;
+    }
+    
+    for (size_t i = 2; i < length; i += 2) {
+        if (!std::isfinite(data[i]) || !(data[i + 1] > 0.0)) {
+            return false;
+        }
+    }
+    for (size_t i = 2; i < length; i += 2) {
+        buffer_.push_back(Centroid{ data[i], data[i + 1] });
+        total_weight_ += data[i + 1];
+    }
+    min_ = std::min(min_, data[0]);
+    max_ = std::max(max_, data[1]);
+    compress();
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <cstddef>
+#include <vector>
+
+// Bounded-memory streaming quantile estimator (merging t-digest).
+// Accuracy is best at the tails, which is where p99/p99.9 live; memory is
+// O(compression) centroids regardless of how many values are added.
+class QuantileSketch {
+public:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+    
+    explicit QuantileSketch(double compression = 100.0);
+    
+    void add(double value, double weight = 1.0);
+    void merge(const QuantileSketch& other);
+    void reset();
+    
+    double quantile(double q);
+    double count() const;
+    double min() const;
+    double max() const;
+    
+    // Flat export/import as [min, max, mean0, weight0, mean1, weight1, ...]
+    void serialize(std::vector<double>& out);
+    bool deserializeMerge(const double* data, size_t length);
+    
+private:
+    void compress();
+    
+    double compression_;
+    size_t buffer_limit_;
+    std::vector<Centroid> centroids_;
+    std::vector<Centroid> buffer_;
+    double total_weight_;
+    double min_;
+    double max_;
+};
+
+#endif // QUANTILE_SKETCH_H
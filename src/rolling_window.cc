@@ -0,0 +1,92 @@
+#include "rolling_window.h"
+#include <cmath>
+
+RollingWindow::RollingWindow(size_t capacity)
+    : values_(capacity < 1 ? 1 : capacity, 0.0), next_(0), count_(0), sum_(0.0) {
+}
+
+void RollingWindow::push(double value) {
+    if (count_ == values_.size()) {
+        sum_ -= values_[next_];
+    } else {
+        count_++;
+    }
+    values_[next_] = value;
+    sum_ += value;
+    next_ = (next_ + 1) % values_.size();
+    
+    // Re-sum once per lap so floating-point drift in the running sum cannot accumulate
+    if (next_ == 0) {
+        sum_ = 0.0;
+        for (size_t i = 0; i < count_; i++) {
+            sum_ += values_[i];
+        }
+    }
+}
+
+double RollingWindow::mean() const {
+    return count_ > 0 ? sum_ / (double)count_ : 0.0;
+}
+
+size_t RollingWindow::size() const {
+    return count_;
+}
+
+TimeWindow::TimeWindow(uint64_t horizon_us, size_t capacity)
+    : entries_(capacity < 1 ? 1 : capacity),
+      horizon_us_(horizon_us),
+      oldest_(0),
+      count_(0),
+      weighted_sum_(0.0),
+      total_weight_(0.0) {
+}
+
+void TimeWindow::evictOldest() {
+    const Entry& entry = entries_[oldest_];
+    weighted_sum_ -= entry.value * entry.weight;
+    total_weight_ -= entry.weight;
+    oldest_ = (oldest_ + 1) % entries_.size();
+    count_--;
+    
+    if (count_ == 0) {
+        weighted_sum_ = 0.0;
+        total_weight_ = 0.0;
+    }
+}
+
+void TimeWindow::push(uint64_t timestamp_us, double value, double weight) {
+    while (count_ > 0 && entries_[oldest_].timestamp_us + horizon_us_ < timestamp_us) {
+        evictOldest();
+    }
+    if (count_ == entries_.size()) {
+        evictOldest();
+    }
+    
+    size_t slot = (oldest_ + count_) % entries_.size();
+    entries_[slot] = Entry{ timestamp_us, value, weight };
+    count_++;
+    weighted_sum_ += value * weight;
+    total_weight_ += weight;
+}
+
+double TimeWindow::mean() const {
+    return total_weight_ > 0.0 ? weighted_sum_ / total_weight_ : 0.0;
+}
+
+TimeEWMA::TimeEWMA(double tau_seconds)
+    : tau_(tau_seconds > 0.0 ? tau_seconds : 1.0), value_(0.0), primed_(false) {
+}
+
+void TimeEWMA::push(double value, double dt_seconds) {
+    if (!primed_) {
+        value_ = value;
+        primed_ = true;
+        return;
+    }
+    double alpha = 1.0 - std::exp(-dt_seconds / tau_);
+    value_ += alpha * (value - value_);
+}
+
+double TimeEWMA::value() const {
+    return value_;
+}
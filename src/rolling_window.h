@@ -0,0 +1,65 @@
+#ifndef ROLLING_WINDOW_H
+#define ROLLING_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity ring of the last N values with a running sum: O(1) push and mean
+class RollingWindow {
+public:
+    explicit RollingWindow(size_t capacity);
+    
+    void push(double value);
+    double mean() const;
+    size_t size() const;
+    
+private:
+    std::vector<double> values_;
+    size_t next_;
+    size_t count_;
+    double sum_;
+};
+
+// Time-bounded boxcar: duration-weighted mean of the samples from the last
+// `horizon_us`. Eviction is amortized O(1); capacity bounds memory if the
+// caller samples faster than expected (the window then covers less time).
+class TimeWindow {
+public:
+    TimeWindow(uint64_t horizon_us, size_t capacity);
+    
+    void push(uint64_t timestamp_us, double value, double weight);
+    double mean() const;
+    
+private:
+    struct Entry {
+        uint64_t timestamp_us;
+        double value;
+        double weight;
+    };
+    
+    void evictOldest();
+    
+    std::vector<Entry> entries_;
+    uint64_t horizon_us_;
+    size_t oldest_;
+    size_t count_;
+    double weighted_sum_;
+    double total_weight_;
+};
+
+// Exponentially weighted moving average with a time constant, robust to uneven sample spacing
+class TimeEWMA {
+public:
+    explicit TimeEWMA(double tau_seconds);
+    
+    void push(double value, double dt_seconds);
+    double value() const;
+    
+private:
+    double tau_;
+    double value_;
+    bool primed_;
+};
+
+#endif // ROLLING_WINDOW_H
@@ -0,0 +1,79 @@
+#include "sample_ring.h"
+
+static size_t roundUpPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+SampleRing::SampleRing(size_t capacity)
+    : capacity_(roundUpPowerOfTwo(capacity < 2 ? 2 : capacity)),
+      mask_(0),
+      head_(0) {
+    mask_ = capacity_ - 1;
+    slots_.reset(new Slot[capacity_]);
+    for (size_t i = 0; i < capacity_; i++) {
+        slots_[i].seq.store(0, std::memory_order_relaxed);
+        slots_[i].timestamp_us.store(0, std::memory_order_relaxed);
+        slots_[i].channel.store(0, std::memory_order_relaxed);
+        slots_[i].value.store(0.0, std::memory_order_relaxed);
+    }
+}
+
+void SampleRing::push(uint64_t timestamp_us, uint32_t channel, double value) {
+    uint64_t seq = head_.load(std::memory_order_relaxed) + 1;
+    Slot& slot = slots_[seq & mask_];
+    
+    // Invalidate the slot before overwriting so concurrent readers discard it
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    slot.timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+    slot.channel.store(channel, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.seq.store(seq, std::memory_order_release);
+    head_.store(seq, std::memory_order_release);
+}
+
+uint64_t SampleRing::head() const {
+    return head_.load(std::memory_order_acquire);
+}
+
+size_t SampleRing::capacity() const {
+    return capacity_;
+}
+
+uint64_t SampleRing::read(uint64_t sinceSeq, size_t maxRecords, std::vector<SampleRecord>& out) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t first = sinceSeq + 1;
+    uint64_t dropped = 0;
+    
+    // Records older than one ring length have already been overwritten
+    if (head >= capacity_ && first + capacity_ <= head) {
+        dropped = head - capacity_ + 1 - first;
+        first = head - capacity_ + 1;
+    }
+    
+    for (uint64_t seq = first; seq <= head && out.size() < maxRecords; seq++) {
+        const Slot& slot = slots_[seq & mask_];
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        
+        SampleRecord record;
+        record.seq = seq;
+        record.timestamp_us = slot.timestamp_us.load(std::memory_order_relaxed);
+        record.channel = slot.channel.load(std::memory_order_relaxed);
+        record.value = slot.value.load(std::memory_order_relaxed);
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.seq.load(std::memory_order_relaxed);
+        if (before != seq || after != seq) {
+            dropped++;
+            continue;
+        }
+        out.push_back(record);
+    }
+    
+    return dropped;
+}
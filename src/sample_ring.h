@@ -0,0 +1,47 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One timestamped reading published by the background sampler
+struct SampleRecord {
+    uint64_t seq;
+    uint64_t timestamp_us;
+    uint32_t channel;
+    double value;
+};
+
+// Lock-free single-producer/multi-consumer ring of sample records.
+// Sequence numbers start at 1 and every slot carries the sequence it holds,
+// so a reader that gets lapped by the producer while copying can tell.
+class SampleRing {
+public:
+    explicit SampleRing(size_t capacity);
+    
+    // Producer side (sampler thread only)
+    void push(uint64_t timestamp_us, uint32_t channel, double value);
+    
+    // Consumer side (any thread)
+    uint64_t head() const;
+    size_t capacity() const;
+    uint64_t read(uint64_t sinceSeq, size_t maxRecords, std::vector<SampleRecord>& out) const;
+    
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> timestamp_us;
+        std::atomic<uint32_t> channel;
+        std::atomic<double> value;
+    };
+    
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+    size_t mask_;
+    std::atomic<uint64_t> head_;
+};
+
+#endif // SAMPLE_RING_H
@@ -0,0 +1,217 @@
+#include "sensor_scheduler.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+SensorScheduler::SensorScheduler()
+    : slots_(WHEEL_SLOTS), next_tick_(0), fd_(-1) {
+}
+
+SensorScheduler::~SensorScheduler() {
+    close();
+}
+
+bool SensorScheduler::open() {
+    close();
+    fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = std::string("cannot create timerfd: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void SensorScheduler::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+int SensorScheduler::fd() const {
+    return fd_;
+}
+
+const std::string& SensorScheduler::error() const {
+    return error_;
+}
+
+uint64_t SensorScheduler::monotonicMicroseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+void SensorScheduler::resize(size_t channels) {
+    Channel disabled;
+    std::memset(&disabled, 0, sizeof(disabled));
+    channels_.assign(channels, disabled);
+    for (auto& slot : slots_) {
+        slot.clear();
+    }
+}
+
+void SensorScheduler::setPolicy(uint32_t channel, const CadencePolicy& policy, uint64_t now_us) {
+    if (channel >= channels_.size()) {
+        return;
+    }
+    Channel& ch = channels_[channel];
+    const CadencePolicy& old = ch.policy;
+    bool same = old.min_period_s == policy.min_period_s && old.max_period_s == policy.max_period_s &&
+                old.steady_delta == policy.steady_delta && old.rapid_delta == policy.rapid_delta &&
+                old.near_limit == policy.near_limit &&
+                (old.limit == policy.limit || (std::isnan(old.limit) && std::isnan(policy.limit)));
+    if (same) {
+        return;
+    }
+    
+    ch.policy = policy;
+    ch.policy.max_period_s = std::max(policy.max_period_s, policy.min_period_s);
+    ch.period_us = (uint64_t)(policy.min_period_s * 1e6);
+    ch.steady = 0;
+    ch.primed = false;
+    ch.queued = false; // Any wheel entry left behind is stale now
+    if (policy.min_period_s > 0.0) {
+        schedule(channel, now_us);
+    }
+}
+
+void SensorScheduler::schedule(uint32_t channel, uint64_t due_us) {
+    Channel& ch = channels_[channel];
+    uint64_t tick = std::max(due_us / TICK_US, next_tick_);
+    ch.due_tick = tick;
+    ch.queued = true;
+    slots_[tick & (WHEEL_SLOTS - 1)].push_back(Entry{ channel, tick });
+}
+
+void SensorScheduler::collectDue(uint64_t now_us, std::vector<uint32_t>& due) {
+    due.clear();
+    if (fd_ >= 0) {
+        uint64_t expirations = 0;
+        ssize_t ignored = read(fd_, &expirations, sizeof(expirations));
+        (void)ignored;
+    }
+    
+    uint64_t now_tick = now_us / TICK_US;
+    if (now_tick < next_tick_) {
+        return;
+    }
+    // After a long sleep every slot is visited once rather than once per missed tick
+    uint64_t first = now_tick - next_tick_ >= WHEEL_SLOTS ? now_tick - WHEEL_SLOTS + 1 : next_tick_;
+    for (uint64_t tick = first; tick <= now_tick; tick++) {
+        std::vector<Entry>& slot = slots_[tick & (WHEEL_SLOTS - 1)];
+        for (size_t i = 0; i < slot.size();) {
+            const Entry entry = slot[i];
+            if (entry.tick > now_tick) {
+                i++; // A later lap of the wheel
+                continue;
+            }
+            slot[i] = slot.back();
+            slot.pop_back();
+            Channel& ch = channels_[entry.channel];
+            if (ch.queued && ch.due_tick == entry.tick) {
+                ch.queued = false;
+                due.push_back(entry.channel);
+            }
+        }
+    }
+    next_tick_ = now_tick + 1;
+}
+
+void SensorScheduler::report(uint32_t channel, double value, uint64_t now_us) {
+    if (channel >= channels_.size()) {
+        return;
+    }
+    Channel& ch = channels_[channel];
+    const CadencePolicy& policy = ch.policy;
+    if (policy.min_period_s <= 0.0) {
+        return;
+    }
+    
+    uint64_t min_us = (uint64_t)(policy.min_period_s * 1e6);
+    uint64_t max_us = (uint64_t)(policy.max_period_s * 1e6);
+    if (!ch.primed) {
+        ch.primed = true;
+        ch.anchor = value;
+        ch.period_us = min_us;
+    } else {
+        double change = std::fabs(value - ch.anchor);
+        bool nearLimit = !std::isnan(policy.limit) && value >= policy.limit - policy.near_limit;
+        if (change >= policy.rapid_delta || nearLimit) {
+            ch.period_us = min_us;
+            ch.steady = 0;
+            ch.anchor = value;
+        } else if (change < policy.steady_delta) {
+            // Measured against the last change, so a slow drift still registers
+            if (++ch.steady >= STEADY_READS) {
+                ch.period_us = std::min(ch.period_us * 2, max_us);
+                ch.steady = 0;
+            }
+        } else {
+            ch.period_us = std::max(ch.period_us / 2, min_us);
+            ch.steady = 0;
+            ch.anchor = value;
+        }
+    }
+    schedule(channel, now_us + ch.period_us);
+}
+
+void SensorScheduler::reportMissing(uint32_t channel, uint64_t now_us) {
+    if (channel < channels_.size() && channels_[channel].policy.min_period_s > 0.0) {
+        schedule(channel, now_us + channels_[channel].period_us);
+    }
+}
+
+void SensorScheduler::arm(uint64_t not_after_us) {
+    if (fd_ < 0) {
+        return;
+    }
+    
+    // The wheel is ordered within one lap; past that, fall back to the earliest entry
+    uint64_t wake = std::numeric_limits<uint64_t>::max();
+    for (uint64_t tick = next_tick_; tick < next_tick_ + WHEEL_SLOTS && wake == std::numeric_limits<uint64_t>::max(); tick++) {
+        for (const Entry& entry : slots_[tick & (WHEEL_SLOTS - 1)]) {
+            if (entry.tick == tick && channels_[entry.channel].queued && channels_[entry.channel].due_tick == tick) {
+                wake = tick;
+                break;
+            }
+        }
+    }
+    if (wake == std::numeric_limits<uint64_t>::max()) {
+        for (const auto& slot : slots_) {
+            for (const Entry& entry : slot) {
+                if (channels_[entry.channel].queued && channels_[entry.channel].due_tick == entry.tick) {
+                    wake = std::min(wake, entry.tick);
+                }
+            }
+        }
+    }
+    
+    if (not_after_us != std::numeric_limits<uint64_t>::max()) {
+        wake = std::min(wake, not_after_us / TICK_US);
+    }
+    
+    struct itimerspec spec;
+    std::memset(&spec, 0, sizeof(spec));
+    if (wake != std::numeric_limits<uint64_t>::max()) {
+        uint64_t wake_us = wake * TICK_US;
+        spec.it_value.tv_sec = (time_t)(wake_us / 1000000ULL);
+        spec.it_value.tv_nsec = (long)(wake_us % 1000000ULL) * 1000L;
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1; // All zeros would disarm
+        }
+    }
+    timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+double SensorScheduler::rateHz(uint32_t channel) const {
+    if (channel >= channels_.size() || channels_[channel].policy.min_period_s <= 0.0 || channels_[channel].period_us == 0) {
+        return 0.0;
+    }
+    return 1e6 / (double)channels_[channel].period_us;
+}
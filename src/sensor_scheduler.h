@@ -0,0 +1,84 @@
+#ifndef SENSOR_SCHEDULER_H
+#define SENSOR_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How one channel's read period follows its readings
+struct CadencePolicy {
+    double min_period_s;  // Fastest cadence; 0 disables the channel
+    double max_period_s;  // Back-off ceiling; equal to min_period_s keeps the period fixed
+    double steady_delta;  // Readings closer than this to the last change count as unchanged
+    double rapid_delta;   // A step this large between reads snaps back to min_period_s
+    double limit;         // Readings within near_limit of this also snap back; NaN if none
+    double near_limit;
+};
+
+// Per-channel read scheduling for the background sampler.
+//
+// Each channel sits in a hashed timer wheel (1 ms ticks) at its next read
+// time. A channel whose readings stay put doubles its period after
+// STEADY_READS unchanged reads, up to max_period_s; a large step or a
+// reading near its limit drops it straight back to min_period_s. One
+// timerfd is armed for the earliest pending read, so the thread sleeps
+// until something is actually due.
+class SensorScheduler {
+public:
+    static const uint32_t WHEEL_SLOTS = 1024; // Power of two
+    static const uint64_t TICK_US = 1000;
+    static const uint32_t STEADY_READS = 4;
+    
+    SensorScheduler();
+    ~SensorScheduler();
+    
+    bool open();
+    void close();
+    int fd() const;
+    const std::string& error() const;
+    
+    // Drops every channel; all start disabled
+    void resize(size_t channels);
+    // A channel whose policy changes restarts at min_period_s and is due at now_us
+    void setPolicy(uint32_t channel, const CadencePolicy& policy, uint64_t now_us);
+    // Drains the timerfd and pops every channel due at now_us
+    void collectDue(uint64_t now_us, std::vector<uint32_t>& due);
+    // Adapts the period to the reading and queues the next read
+    void report(uint32_t channel, double value, uint64_t now_us);
+    // Failed reads retry at the current period
+    void reportMissing(uint32_t channel, uint64_t now_us);
+    // Arms the timerfd for the earliest queued read (or not_after_us if
+    // sooner), or disarms it when there is neither
+    void arm(uint64_t not_after_us);
+    // 0 for disabled channels
+    double rateHz(uint32_t channel) const;
+    
+    // The clock every now_us above is on
+    static uint64_t monotonicMicroseconds();
+
+private:
+    struct Channel {
+        CadencePolicy policy;
+        uint64_t period_us;
+        uint64_t due_tick;
+        double anchor;     // Reading at the last change
+        uint32_t steady;   // Unchanged reads since then
+        bool primed;
+        bool queued;
+    };
+    struct Entry {
+        uint32_t channel;
+        uint64_t tick;
+    };
+    
+    void schedule(uint32_t channel, uint64_t due_us);
+    
+    std::vector<Channel> channels_;
+    std::vector<std::vector<Entry>> slots_;
+    uint64_t next_tick_; // First tick not yet expired
+    int fd_;
+    std::string error_;
+};
+
+#endif // SENSOR_SCHEDULER_H
@@ -0,0 +1,705 @@
+#include "session_log.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// All integers are stored little-endian (every platform we build for is)
+static const char FILE_MAGIC[8] = { 'S', 'M', 'L', 'O', 'G', '0', '1', '\n' };
+static const char TRAILER_MAGIC[8] = { 'S', 'M', 'L', 'O', 'G', 'E', 'N', 'D' };
+static const char CHUNK_MAGIC[4] = { 'C', 'H', 'N', 'K' };
+static const char INDEX_MAGIC[4] = { 'I', 'N', 'D', 'X' };
+static const uint32_t FORMAT_VERSION = 1;
+static const uint32_t CHUNK_FLAG_ZSTD = 1;
+static const int ZSTD_LEVEL = 3;
+
+// { magic[4], flags, rows, columns, raw_bytes, stored_bytes, first_ms, last_ms }
+static const size_t CHUNK_HEADER_SIZE = 40;
+// { offset, first_ms, last_ms, rows, reserved }
+static const size_t INDEX_ENTRY_SIZE = 32;
+// { index_offset, magic[8] }
+static const size_t TRAILER_SIZE = 16;
+
+template <typename T>
+static void put(uint8_t* out, size_t offset, T value) {
+    std::memcpy(out + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static T get(const uint8_t* in, size_t offset) {
+    T value;
+    std::memcpy(&value, in + offset, sizeof(T));
+    return value;
+}
+
+static bool preadAll(int fd, void* data, size_t length, uint64_t offset) {
+    uint8_t* out = static_cast<uint8_t*>(data);
+    while (length > 0) {
+        ssize_t n = pread(fd, out, length, (off_t)offset);
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+// MSB-first bit stream for the Gorilla value encoding
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out), current_(0), used_(0) {}
+    
+    void write(uint64_t value, int bits) {
+        while (bits > 0) {
+            int take = std::min(bits, 8 - used_);
+            uint8_t chunk = (uint8_t)((value >> (bits - take)) & ((1u << take) - 1));
+            current_ = (uint8_t)((current_ << take) | chunk);
+            used_ += take;
+            bits -= take;
+            if (used_ == 8) {
+                out_.push_back(current_);
+                current_ = 0;
+                used_ = 0;
+            }
+        }
+    }
+    
+    // Pads the last byte so every column stream starts byte-aligned
+    void finish() {
+        if (used_ > 0) {
+            out_.push_back((uint8_t)(current_ << (8 - used_)));
+            current_ = 0;
+            used_ = 0;
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint8_t current_;
+    int used_;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t length) : data_(data), length_(length), bit_(0) {}
+    
+    bool read(int bits, uint64_t& value) {
+        if (bit_ + (size_t)bits > length_ * 8) {
+            return false;
+        }
+        value = 0;
+        while (bits > 0) {
+            size_t byte = bit_ / 8;
+            int offset = (int)(bit_ % 8);
+            int take = std::min(bits, 8 - offset);
+            uint8_t chunk = (uint8_t)((data_[byte] >> (8 - offset - take)) & ((1u << take) - 1));
+            value = (value << take) | chunk;
+            bit_ += (size_t)take;
+            bits -= take;
+        }
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t length_;
+    size_t bit_;
+};
+
+static void putVarint(std::vector<uint8_t>& out, int64_t signedValue) {
+    uint64_t value = ((uint64_t)signedValue << 1) ^ (uint64_t)(signedValue >> 63); // Zigzag
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static bool getVarint(const uint8_t* data, size_t length, size_t& position, int64_t& signedValue) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= length) {
+            return false;
+        }
+        uint8_t byte = data[position++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            signedValue = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Timestamps: first value, first delta, then delta-of-delta. A steady
+// sampling interval encodes as one zero byte per row.
+static void encodeTimestamps(std::vector<uint8_t>& out, const int64_t* timestamps, uint32_t rows) {
+    int64_t previous = 0;
+    int64_t previousDelta = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        int64_t delta = timestamps[i] - previous;
+        putVarint(out, i == 0 ? timestamps[i] : delta - previousDelta);
+        previousDelta = i == 0 ? 0 : delta;
+        previous = timestamps[i];
+    }
+}
+
+static bool decodeTimestamps(const uint8_t* data, size_t length, uint32_t rows, std::vector<int64_t>& out) {
+    size_t position = 0;
+    int64_t previous = 0;
+    int64_t previousDelta = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        int64_t value;
+        if (!getVarint(data, length, position, value)) {
+            return false;
+        }
+        if (i == 0) {
+            previous = value;
+        } else {
+            previousDelta += value;
+            previous += previousDelta;
+        }
+        out.push_back(previous);
+    }
+    return true;
+}
+
+// Gorilla (Pelkonen et al., VLDB 2015): XOR with the previous value; a zero
+// XOR costs one bit, and a XOR whose significant bits fit the previous
+// window costs two bits plus the window
+static void encodeValues(std::vector<uint8_t>& out, const double* values, uint32_t rows) {
+    BitWriter writer(out);
+    uint64_t previous = 0;
+    int previousLeading = -1;
+    int previousTrailing = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        uint64_t bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        if (i == 0) {
+            writer.write(bits, 64);
+            previous = bits;
+            continue;
+        }
+        uint64_t x = bits ^ previous;
+        previous = bits;
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        writer.write(1, 1);
+        int leading = std::min(__builtin_clzll(x), 31);
+        int trailing = __builtin_ctzll(x);
+        if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing) {
+            writer.write(0, 1);
+            writer.write(x >> previousTrailing, 64 - previousLeading - previousTrailing);
+        } else {
+            int significant = 64 - leading - trailing;
+            writer.write(1, 1);
+            writer.write((uint64_t)leading, 5);
+            writer.write((uint64_t)(significant - 1), 6);
+            writer.write(x >> trailing, significant);
+            previousLeading = leading;
+            previousTrailing = trailing;
+        }
+    }
+    writer.finish();
+}
+
+static bool decodeValues(const uint8_t* data, size_t length, uint32_t rows, std::vector<double>& out) {
+    BitReader reader(data, length);
+    uint64_t previous = 0;
+    int leading = 0;
+    int trailing = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        if (i == 0) {
+            if (!reader.read(64, previous)) {
+                return false;
+            }
+        } else {
+            uint64_t flag;
+            if (!reader.read(1, flag)) {
+                return false;
+            }
+            if (flag == 1) {
+                uint64_t control;
+                if (!reader.read(1, control)) {
+                    return false;
+                }
+                if (control == 1) {
+                    uint64_t l, s;
+                    if (!reader.read(5, l) || !reader.read(6, s)) {
+                        return false;
+                    }
+                    leading = (int)l;
+                    trailing = 64 - leading - ((int)s + 1);
+                    if (trailing < 0) {
+                        return false;
+                    }
+                }
+                uint64_t significant;
+                if (!reader.read(64 - leading - trailing, significant)) {
+                    return false;
+                }
+                previous ^= significant << trailing;
+            }
+        }
+        double value;
+        std::memcpy(&value, &previous, sizeof(value));
+        out.push_back(value);
+    }
+    return true;
+}
+
+SessionLogWriter::SessionLogWriter()
+    : fd_(-1), offset_(0), chunk_rows_(DEFAULT_CHUNK_ROWS), compress_(false), column_count_(0), rows_(0) {
+}
+
+SessionLogWriter::~SessionLogWriter() {
+    close();
+}
+
+bool SessionLogWriter::writeAll(const void* data, size_t length) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    while (length > 0) {
+        ssize_t n = ::write(fd_, in, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error_ = std::string("write failed: ") + std::strerror(errno);
+            return false;
+        }
+        in += n;
+        length -= (size_t)n;
+        offset_ += (uint64_t)n;
+    }
+    return true;
+}
+
+bool SessionLogWriter::open(const std::string& path, const std::vector<std::string>& columns,
+                            uint32_t chunk_rows, bool compress) {
+    close();
+    error_.clear();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error_ = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    offset_ = 0;
+    chunk_rows_ = chunk_rows > 0 ? chunk_rows : DEFAULT_CHUNK_ROWS;
+    compress_ = compress;
+    column_count_ = columns.size();
+    rows_ = 0;
+    timestamps_.assign(chunk_rows_, 0);
+    values_.assign(chunk_rows_ * column_count_, 0.0);
+    index_.clear();
+    
+    std::vector<uint8_t> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+    header.resize(header.size() + 8);
+    put<uint32_t>(header.data(), 8, FORMAT_VERSION);
+    put<uint32_t>(header.data(), 12, (uint32_t)column_count_);
+    for (const auto& column : columns) {
+        uint16_t length = (uint16_t)std::min<size_t>(column.size(), 0xFFFF);
+        size_t at = header.size();
+        header.resize(at + 2 + length);
+        put<uint16_t>(header.data(), at, length);
+        std::memcpy(header.data() + at + 2, column.data(), length);
+    }
+    if (!writeAll(header.data(), header.size())) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+bool SessionLogWriter::append(int64_t timestamp_ms, const double* values, size_t count) {
+    if (fd_ < 0) {
+        return false;
+    }
+    timestamps_[rows_] = timestamp_ms;
+    for (size_t c = 0; c < column_count_; c++) {
+        values_[c * chunk_rows_ + rows_] = c < count ? values[c] : std::numeric_limits<double>::quiet_NaN();
+    }
+    rows_++;
+    return rows_ == chunk_rows_ && writeChunk();
+}
+
+bool SessionLogWriter::writeChunk() {
+    if (rows_ == 0) {
+        return true;
+    }
+    uint32_t rows = rows_;
+    rows_ = 0;
+    
+    // { stream offsets[columns + 1], timestamp stream, one stream per column }
+    size_t table = (column_count_ + 1) * sizeof(uint32_t);
+    encoded_.assign(table, 0);
+    put<uint32_t>(encoded_.data(), 0, (uint32_t)encoded_.size());
+    encodeTimestamps(encoded_, timestamps_.data(), rows);
+    for (size_t c = 0; c < column_count_; c++) {
+        put<uint32_t>(encoded_.data(), (c + 1) * sizeof(uint32_t), (uint32_t)encoded_.size());
+        encodeValues(encoded_, &values_[c * chunk_rows_], rows);
+    }
+    
+    uint32_t flags = 0;
+    const std::vector<uint8_t>* stored = &encoded_;
+#ifdef HAVE_ZSTD
+    if (compress_) {
+        compressed_.resize(ZSTD_compressBound(encoded_.size()));
+        size_t size = ZSTD_compress(compressed_.data(), compressed_.size(), encoded_.data(), encoded_.size(), ZSTD_LEVEL);
+        if (!ZSTD_isError(size) && size < encoded_.size()) {
+            compressed_.resize(size);
+            stored = &compressed_;
+            flags |= CHUNK_FLAG_ZSTD;
+        }
+    }
+#endif
+    
+    uint8_t header[CHUNK_HEADER_SIZE];
+    std::memcpy(header, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    put<uint32_t>(header, 4, flags);
+    put<uint32_t>(header, 8, rows);
+    put<uint32_t>(header, 12, (uint32_t)column_count_);
+    put<uint32_t>(header, 16, (uint32_t)encoded_.size());
+    put<uint32_t>(header, 20, (uint32_t)stored->size());
+    put<int64_t>(header, 24, timestamps_[0]);
+    put<int64_t>(header, 32, timestamps_[rows - 1]);
+    
+    SessionLogChunk chunk = { offset_, timestamps_[0], timestamps_[rows - 1], rows };
+    if (!writeAll(header, sizeof(header)) || !writeAll(stored->data(), stored->size())) {
+        return false;
+    }
+    index_.push_back(chunk);
+    return true;
+}
+
+bool SessionLogWriter::flush() {
+    return fd_ >= 0 && writeChunk();
+}
+
+void SessionLogWriter::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    if (writeChunk()) {
+        uint64_t indexOffset = offset_;
+        std::vector<uint8_t> index(8 + index_.size() * INDEX_ENTRY_SIZE + TRAILER_SIZE, 0);
+        std::memcpy(index.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        put<uint32_t>(index.data(), 4, (uint32_t)index_.size());
+        for (size_t i = 0; i < index_.size(); i++) {
+            size_t at = 8 + i * INDEX_ENTRY_SIZE;
+            put<uint64_t>(index.data(), at, index_[i].offset);
+            put<int64_t>(index.data(), at + 8, index_[i].first_ms);
+            put<int64_t>(index.data(), at + 16, index_[i].last_ms);
+            put<uint32_t>(index.data(), at + 24, index_[i].rows);
+        }
+        size_t trailer = index.size() - TRAILER_SIZE;
+        put<uint64_t>(index.data(), trailer, indexOffset);
+        std::memcpy(index.data() + trailer + 8, TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+        writeAll(index.data(), index.size());
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+bool SessionLogWriter::isOpen() const {
+    return fd_ >= 0;
+}
+
+size_t SessionLogWriter::columnCount() const {
+    return column_count_;
+}
+
+const std::string& SessionLogWriter::error() const {
+    return error_;
+}
+
+SessionLogReader::SessionLogReader() : fd_(-1), data_offset_(0) {
+}
+
+SessionLogReader::~SessionLogReader() {
+    close();
+}
+
+void SessionLogReader::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    columns_.clear();
+    chunks_.clear();
+}
+
+bool SessionLogReader::open(const std::string& path) {
+    close();
+    error_.clear();
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    uint8_t header[16];
+    if (fstat(fd_, &st) != 0 || !preadAll(fd_, header, sizeof(header), 0) ||
+        std::memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        error_ = path + " is not a session log";
+        close();
+        return false;
+    }
+    if (get<uint32_t>(header, 8) != FORMAT_VERSION) {
+        error_ = path + " uses an unsupported session log version";
+        close();
+        return false;
+    }
+    uint64_t fileSize = (uint64_t)st.st_size;
+    uint32_t columnCount = get<uint32_t>(header, 12);
+    uint64_t offset = sizeof(header);
+    for (uint32_t c = 0; c < columnCount; c++) {
+        uint8_t lengthBytes[2];
+        if (!preadAll(fd_, lengthBytes, 2, offset)) {
+            error_ = path + ": truncated column list";
+            close();
+            return false;
+        }
+        uint16_t length = get<uint16_t>(lengthBytes, 0);
+        std::string name(length, '\0');
+        if (length > 0 && !preadAll(fd_, &name[0], length, offset + 2)) {
+            error_ = path + ": truncated column list";
+            close();
+            return false;
+        }
+        columns_.push_back(name);
+        offset += 2 + length;
+    }
+    data_offset_ = offset;
+    
+    // Prefer the index written on close; fall back to walking the chunks
+    uint8_t trailer[TRAILER_SIZE];
+    if (fileSize >= data_offset_ + TRAILER_SIZE &&
+        preadAll(fd_, trailer, TRAILER_SIZE, fileSize - TRAILER_SIZE) &&
+        std::memcmp(trailer + 8, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) == 0) {
+        uint64_t indexOffset = get<uint64_t>(trailer, 0);
+        uint8_t indexHeader[8];
+        if (indexOffset >= data_offset_ && indexOffset + 8 <= fileSize - TRAILER_SIZE &&
+            preadAll(fd_, indexHeader, 8, indexOffset) &&
+            std::memcmp(indexHeader, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0) {
+            uint32_t count = get<uint32_t>(indexHeader, 4);
+            std::vector<uint8_t> entries((size_t)count * INDEX_ENTRY_SIZE);
+            if (indexOffset + 8 + entries.size() + TRAILER_SIZE == fileSize &&
+                preadAll(fd_, entries.data(), entries.size(), indexOffset + 8)) {
+                for (uint32_t i = 0; i < count; i++) {
+                    const uint8_t* entry = entries.data() + (size_t)i * INDEX_ENTRY_SIZE;
+                    chunks_.push_back({ get<uint64_t>(entry, 0), get<int64_t>(entry, 8),
+                                        get<int64_t>(entry, 16), get<uint32_t>(entry, 24) });
+                }
+                return true;
+            }
+        }
+    }
+    return scanChunks(fileSize);
+}
+
+bool SessionLogReader::scanChunks(uint64_t file_size) {
+    uint64_t offset = data_offset_;
+    uint8_t header[CHUNK_HEADER_SIZE];
+    while (offset + CHUNK_HEADER_SIZE <= file_size && preadAll(fd_, header, sizeof(header), offset)) {
+        if (std::memcmp(header, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) {
+            break;
+        }
+        uint64_t end = offset + CHUNK_HEADER_SIZE + get<uint32_t>(header, 20);
+        if (end > file_size) {
+            break; // Torn write at the tail
+        }
+        chunks_.push_back({ offset, get<int64_t>(header, 24), get<int64_t>(header, 32), get<uint32_t>(header, 8) });
+        offset = end;
+    }
+    return true;
+}
+
+const std::vector<std::string>& SessionLogReader::columns() const {
+    return columns_;
+}
+
+const std::vector<SessionLogChunk>& SessionLogReader::chunks() const {
+    return chunks_;
+}
+
+const std::string& SessionLogReader::error() const {
+    return error_;
+}
+
+bool SessionLogReader::readChunk(size_t index, std::vector<int64_t>& timestamps,
+                                 std::vector<std::vector<double>>& values) {
+    if (fd_ < 0 || index >= chunks_.size()) {
+        error_ = "chunk index out of range";
+        return false;
+    }
+    uint8_t header[CHUNK_HEADER_SIZE];
+    if (!preadAll(fd_, header, sizeof(header), chunks_[index].offset) ||
+        std::memcmp(header, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) {
+        error_ = "corrupt chunk header";
+        return false;
+    }
+    uint32_t flags = get<uint32_t>(header, 4);
+    uint32_t rows = get<uint32_t>(header, 8);
+    uint32_t columnCount = get<uint32_t>(header, 12);
+    uint32_t rawBytes = get<uint32_t>(header, 16);
+    uint32_t storedBytes = get<uint32_t>(header, 20);
+    if (columnCount != columns_.size()) {
+        error_ = "chunk column count does not match the header";
+        return false;
+    }
+    
+    stored_.resize(storedBytes);
+    if (!preadAll(fd_, stored_.data(), storedBytes, chunks_[index].offset + CHUNK_HEADER_SIZE)) {
+        error_ = "truncated chunk";
+        return false;
+    }
+    const std::vector<uint8_t>* raw = &stored_;
+    if (flags & CHUNK_FLAG_ZSTD) {
+#ifdef HAVE_ZSTD
+        decoded_.resize(rawBytes);
+        size_t size = ZSTD_decompress(decoded_.data(), decoded_.size(), stored_.data(), stored_.size());
+        if (ZSTD_isError(size) || size != rawBytes) {
+            error_ = "corrupt compressed chunk";
+            return false;
+        }
+        raw = &decoded_;
+#else
+        error_ = "log is zstd-compressed; rebuild with with_zstd=1 to read it";
+        return false;
+#endif
+    }
+    
+    size_t table = ((size_t)columnCount + 1) * sizeof(uint32_t);
+    if (raw->size() != rawBytes || rawBytes < table) {
+        error_ = "corrupt chunk";
+        return false;
+    }
+    const uint8_t* data = raw->data();
+    auto streamEnd = [&](size_t stream) -> uint32_t {
+        return stream < columnCount ? get<uint32_t>(data, (stream + 1) * sizeof(uint32_t)) : rawBytes;
+    };
+    uint32_t start = get<uint32_t>(data, 0);
+    uint32_t end = streamEnd(0);
+    if (start > end || end > rawBytes || !decodeTimestamps(data + start, end - start, rows, timestamps)) {
+        error_ = "corrupt timestamp stream";
+        return false;
+    }
+    values.resize(columnCount);
+    for (uint32_t c = 0; c < columnCount; c++) {
+        start = end;
+        end = streamEnd(c + 1);
+        if (start > end || end > rawBytes || !decodeValues(data + start, end - start, rows, values[c])) {
+            error_ = "corrupt value stream for " + columns_[c];
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SessionLogReader::readRange(int64_t t0_ms, int64_t t1_ms, std::vector<int64_t>& timestamps,
+                                 std::vector<std::vector<double>>& values) {
+    values.resize(columns_.size());
+    std::vector<int64_t> chunkTimestamps;
+    std::vector<std::vector<double>> chunkValues;
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        if (chunks_[i].last_ms < t0_ms || chunks_[i].first_ms > t1_ms) {
+            continue;
+        }
+        chunkTimestamps.clear();
+        for (auto& column : chunkValues) {
+            column.clear();
+        }
+        if (!readChunk(i, chunkTimestamps, chunkValues)) {
+            return false;
+        }
+        for (size_t row = 0; row < chunkTimestamps.size(); row++) {
+            if (chunkTimestamps[row] < t0_ms || chunkTimestamps[row] > t1_ms) {
+                continue;
+            }
+            timestamps.push_back(chunkTimestamps[row]);
+            for (size_t c = 0; c < values.size(); c++) {
+                values[c].push_back(chunkValues[c][row]);
+            }
+        }
+    }
+    return true;
+}
+
+// Whole numbers print bare, everything else with two decimals like logger.js
+static void writeCSVValue(FILE* out, double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        fprintf(out, "%.0f", value);
+    } else {
+        fprintf(out, "%.2f", value);
+    }
+}
+
+bool SessionLogReader::exportCSV(const std::string& log_path, const std::string& csv_path, std::string& error) {
+    SessionLogReader reader;
+    if (!reader.open(log_path)) {
+        error = reader.error();
+        return false;
+    }
+    FILE* out = fopen(csv_path.c_str(), "w");
+    if (out == nullptr) {
+        error = "cannot create " + csv_path + ": " + std::strerror(errno);
+        return false;
+    }
+    
+    fputs("timestamp", out);
+    for (const auto& column : reader.columns()) {
+        fputc(',', out);
+        fputs(column.c_str(), out);
+    }
+    fputc('\n', out);
+    
+    std::vector<int64_t> timestamps;
+    std::vector<std::vector<double>> values;
+    bool ok = true;
+    for (size_t i = 0; i < reader.chunks().size() && ok; i++) {
+        timestamps.clear();
+        for (auto& column : values) {
+            column.clear();
+        }
+        if (!reader.readChunk(i, timestamps, values)) {
+            error = reader.error();
+            ok = false;
+            break;
+        }
+        for (size_t row = 0; row < timestamps.size(); row++) {
+            time_t seconds = (time_t)(timestamps[row] / 1000);
+            struct tm utc;
+            gmtime_r(&seconds, &utc);
+            char stamp[32];
+            strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &utc);
+            fprintf(out, "%s.%03dZ", stamp, (int)(timestamps[row] % 1000));
+            for (const auto& column : values) {
+                fputc(',', out);
+                writeCSVValue(out, column[row]);
+            }
+            fputc('\n', out);
+        }
+    }
+    if (fclose(out) != 0 && ok) {
+        error = "write failed: " + csv_path;
+        ok = false;
+    }
+    return ok;
+}
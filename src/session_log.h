@@ -0,0 +1,100 @@
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One entry of a session log's chunk index
+struct SessionLogChunk {
+    uint64_t offset;    // File offset of the chunk header
+    int64_t first_ms;
+    int64_t last_ms;
+    uint32_t rows;
+};
+
+// Append-only columnar session log (.smlog).
+//
+// Layout: a header with the column names, then self-describing chunks of up
+// to chunk_rows rows, then (on a clean close) an index of every chunk and a
+// fixed trailer pointing at it. Inside a chunk, timestamps are
+// delta-of-delta varints and each column is Gorilla XOR-encoded against its
+// previous value, so slowly changing sensors cost a few bits per sample.
+// Chunks may be zstd-compressed when built with HAVE_ZSTD. A log cut short
+// by a crash has no index; the reader rebuilds it by walking the chunk
+// headers and drops a torn final chunk.
+class SessionLogWriter {
+public:
+    static const uint32_t DEFAULT_CHUNK_ROWS = 600; // One minute at 10 Hz
+    
+    SessionLogWriter();
+    ~SessionLogWriter();
+    
+    bool open(const std::string& path, const std::vector<std::string>& columns,
+              uint32_t chunk_rows, bool compress);
+    // Missing trailing values are NaN, extra ones are dropped.
+    // Returns true when this row completed a chunk and it was written out.
+    bool append(int64_t timestamp_ms, const double* values, size_t count);
+    // Writes the partial chunk, if any
+    bool flush();
+    // Flushes, then writes the index and trailer
+    void close();
+    
+    bool isOpen() const;
+    size_t columnCount() const;
+    const std::string& error() const;
+
+private:
+    bool writeChunk();
+    bool writeAll(const void* data, size_t length);
+    
+    int fd_;
+    uint64_t offset_;
+    uint32_t chunk_rows_;
+    bool compress_;
+    size_t column_count_;
+    uint32_t rows_;
+    std::vector<int64_t> timestamps_;
+    std::vector<double> values_;        // Column-major: column c starts at c * chunk_rows_
+    std::vector<uint8_t> encoded_;
+    std::vector<uint8_t> compressed_;
+    std::vector<SessionLogChunk> index_;
+    std::string error_;
+};
+
+class SessionLogReader {
+public:
+    SessionLogReader();
+    ~SessionLogReader();
+    
+    bool open(const std::string& path);
+    void close();
+    
+    const std::vector<std::string>& columns() const;
+    const std::vector<SessionLogChunk>& chunks() const;
+    const std::string& error() const;
+    
+    // Appends the chunk's rows; values are column-major, one block of
+    // rows per column, matching the order of timestamps
+    bool readChunk(size_t index, std::vector<int64_t>& timestamps, std::vector<std::vector<double>>& values);
+    // Every row with t0_ms <= timestamp <= t1_ms, touching only overlapping chunks
+    bool readRange(int64_t t0_ms, int64_t t1_ms, std::vector<int64_t>& timestamps,
+                   std::vector<std::vector<double>>& values);
+    
+    // Writes "timestamp,<columns>" rows with ISO-8601 UTC timestamps
+    static bool exportCSV(const std::string& log_path, const std::string& csv_path, std::string& error);
+
+private:
+    bool scanChunks(uint64_t file_size);
+    
+    int fd_;
+    uint64_t data_offset_;
+    std::vector<std::string> columns_;
+    std::vector<SessionLogChunk> chunks_;
+    std::vector<uint8_t> stored_;
+    std::vector<uint8_t> decoded_;
+    std::string error_;
+};
+
+#endif // SESSION_LOG_H
@@ -0,0 +1,497 @@
+#include "shm_snapshot.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+static const char SHM_MAGIC[8] = { 'S', 'M', 'S', 'H', 'M', '0', '0', '1' };
+static const uint32_t SHM_VERSION = 1;
+static const size_t SHM_HEADER_BYTES = 4096;
+static const uint32_t TEXT_BYTES_PER_FIELD = 128;
+static const int READ_ATTEMPTS = 4;
+
+enum SegmentState : uint32_t {
+    SEGMENT_INITIALIZING = 0,
+    SEGMENT_LIVE = 1,
+    SEGMENT_CLOSED = 2,
+};
+
+struct ShmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t max_fields;
+    uint32_t ring_capacity;
+    uint32_t text_capacity;
+    uint64_t total_bytes;
+    int64_t writer_pid;
+    std::atomic<uint32_t> state;
+    std::atomic<uint64_t> latest;       // Sequence of the newest complete snapshot, 0 before the first
+    std::atomic<uint64_t> ring_head;
+};
+
+// Followed by max_fields values
+struct SnapshotBuffer {
+    std::atomic<uint64_t> seq;          // Snapshot sequence held, 0 while being rewritten
+    std::atomic<uint64_t> version;
+    std::atomic<uint64_t> timestamp_us;
+    std::atomic<uint64_t> count;
+};
+
+// Followed by text_capacity bytes of '\n'-separated rows
+struct TextBlock {
+    std::atomic<uint64_t> seq;          // Update counter, 0 while being rewritten
+    std::atomic<uint64_t> version;
+    std::atomic<uint64_t> length;
+    uint64_t reserved;
+};
+
+struct RingSlot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> timestamp_us;
+    std::atomic<uint64_t> channel;      // 64-bit to keep slots at 32 bytes
+    std::atomic<double> value;
+};
+
+static_assert(sizeof(ShmHeader) <= SHM_HEADER_BYTES, "shm header overflows its page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+              "shared atomics must be lock-free to work across processes");
+
+struct ShmLayout {
+    size_t buffer_bytes;
+    size_t schema;
+    size_t channels;
+    size_t ring;
+    size_t total;
+};
+
+static size_t alignTo64(size_t n) {
+    return (n + 63) & ~(size_t)63;
+}
+
+static ShmLayout computeLayout(uint32_t max_fields, uint32_t ring_capacity, uint32_t text_capacity) {
+    ShmLayout layout;
+    layout.buffer_bytes = alignTo64(sizeof(SnapshotBuffer) + (size_t)max_fields * sizeof(std::atomic<double>));
+    layout.schema = SHM_HEADER_BYTES + 2 * layout.buffer_bytes;
+    layout.channels = layout.schema + alignTo64(sizeof(TextBlock) + text_capacity);
+    layout.ring = layout.channels + alignTo64(sizeof(TextBlock) + text_capacity);
+    layout.total = layout.ring + (size_t)ring_capacity * sizeof(RingSlot);
+    return layout;
+}
+
+static uint32_t roundUpPowerOfTwo(uint32_t n) {
+    uint32_t p = 2;
+    while (p < n && p < (1u << 30)) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static SnapshotBuffer* snapshotBuffer(const uint8_t* base, const ShmLayout& layout, uint64_t seq) {
+    return reinterpret_cast<SnapshotBuffer*>(const_cast<uint8_t*>(base) + SHM_HEADER_BYTES +
+                                             (seq & 1) * layout.buffer_bytes);
+}
+
+static std::atomic<double>* snapshotValues(SnapshotBuffer* buffer) {
+    return reinterpret_cast<std::atomic<double>*>(buffer + 1);
+}
+
+static TextBlock* textBlock(const uint8_t* base, size_t offset) {
+    return reinterpret_cast<TextBlock*>(const_cast<uint8_t*>(base) + offset);
+}
+
+static RingSlot* ringSlots(const uint8_t* base, const ShmLayout& layout) {
+    return reinterpret_cast<RingSlot*>(const_cast<uint8_t*>(base) + layout.ring);
+}
+
+static ShmLayout layoutOf(const uint8_t* base) {
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base);
+    return computeLayout(header->max_fields, header->ring_capacity, header->text_capacity);
+}
+
+static void writeText(TextBlock* block, uint32_t capacity, uint64_t update, uint64_t version,
+                      const std::vector<std::string>& rows) {
+    block->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    // Rows that don't fit are dropped whole, never cut mid-row
+    char* data = reinterpret_cast<char*>(block + 1);
+    size_t length = 0;
+    for (const auto& row : rows) {
+        if (length + row.size() + 1 > capacity) {
+            break;
+        }
+        std::memcpy(data + length, row.data(), row.size());
+        length += row.size();
+        data[length++] = '\n';
+    }
+    block->version.store(version, std::memory_order_relaxed);
+    block->length.store(length, std::memory_order_relaxed);
+    block->seq.store(update, std::memory_order_release);
+}
+
+static bool readText(const TextBlock* block, uint32_t capacity, uint64_t& version, std::vector<std::string>& rows) {
+    const char* data = reinterpret_cast<const char*>(block + 1);
+    std::string text;
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        uint64_t before = block->seq.load(std::memory_order_acquire);
+        if (before == 0) {
+            continue;
+        }
+        size_t length = std::min<uint64_t>(block->length.load(std::memory_order_relaxed), capacity);
+        version = block->version.load(std::memory_order_relaxed);
+        text.assign(data, length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block->seq.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        
+        rows.clear();
+        size_t start = 0;
+        size_t newline;
+        while ((newline = text.find('\n', start)) != std::string::npos) {
+            rows.push_back(text.substr(start, newline - start));
+            start = newline + 1;
+        }
+        return true;
+    }
+    return false;
+}
+
+static uint64_t readTextVersion(const TextBlock* block) {
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        uint64_t before = block->seq.load(std::memory_order_acquire);
+        if (before == 0) {
+            continue;
+        }
+        uint64_t version = block->version.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block->seq.load(std::memory_order_relaxed) == before) {
+            return version;
+        }
+    }
+    return 0;
+}
+
+ShmSnapshotWriter::ShmSnapshotWriter() : fd_(-1), base_(nullptr), size_(0), text_updates_(0) {}
+
+ShmSnapshotWriter::~ShmSnapshotWriter() {
+    close();
+}
+
+bool ShmSnapshotWriter::open(const std::string& name, uint32_t max_fields, uint32_t ring_capacity) {
+    close();
+    error_.clear();
+    if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != std::string::npos) {
+        error_ = "shared snapshot name must look like /name: " + name;
+        return false;
+    }
+    max_fields = max_fields > 0 ? max_fields : DEFAULT_MAX_FIELDS;
+    ring_capacity = roundUpPowerOfTwo(ring_capacity > 0 ? ring_capacity : DEFAULT_RING_CAPACITY);
+    uint32_t text_capacity = max_fields * TEXT_BYTES_PER_FIELD;
+    ShmLayout layout = computeLayout(max_fields, ring_capacity, text_capacity);
+    
+    // Readers still mapping a previous segment keep it until they see it closed
+    shm_unlink(name.c_str());
+    fd_ = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error_ = "cannot create " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    // Reserve the pages up front, as HistoryStore does: a full /dev/shm
+    // should fail here, not SIGBUS the sampler later
+    int result = posix_fallocate(fd_, 0, (off_t)layout.total);
+    if (result != 0) {
+        error_ = "cannot size " + name + ": " + std::strerror(result);
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* map = mmap(nullptr, layout.total, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        error_ = "cannot map " + name + ": " + std::strerror(errno);
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(name.c_str());
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(map);
+    size_ = layout.total;
+    name_ = name;
+    text_updates_ = 0;
+    
+    // Fresh pages are zeroed, which is already the empty state of every structure
+    ShmHeader* header = reinterpret_cast<ShmHeader*>(base_);
+    std::memcpy(header->magic, SHM_MAGIC, sizeof(SHM_MAGIC));
+    header->version = SHM_VERSION;
+    header->max_fields = max_fields;
+    header->ring_capacity = ring_capacity;
+    header->text_capacity = text_capacity;
+    header->total_bytes = layout.total;
+    header->writer_pid = getpid();
+    header->state.store(SEGMENT_LIVE, std::memory_order_release);
+    return true;
+}
+
+void ShmSnapshotWriter::close() {
+    if (base_ != nullptr) {
+        reinterpret_cast<ShmHeader*>(base_)->state.store(SEGMENT_CLOSED, std::memory_order_release);
+        munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(name_.c_str());
+    }
+    name_.clear();
+}
+
+bool ShmSnapshotWriter::isOpen() const {
+    return base_ != nullptr;
+}
+
+const std::string& ShmSnapshotWriter::error() const {
+    return error_;
+}
+
+void ShmSnapshotWriter::publishSchema(uint64_t version, const std::vector<std::string>& rows) {
+    if (base_ == nullptr) {
+        return;
+    }
+    ShmLayout layout = layoutOf(base_);
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    writeText(textBlock(base_, layout.schema), header->text_capacity, ++text_updates_, version, rows);
+}
+
+void ShmSnapshotWriter::publishChannels(uint64_t generation, const std::vector<std::string>& channels) {
+    if (base_ == nullptr) {
+        return;
+    }
+    ShmLayout layout = layoutOf(base_);
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    writeText(textBlock(base_, layout.channels), header->text_capacity, ++text_updates_, generation, channels);
+}
+
+void ShmSnapshotWriter::publishSnapshot(uint64_t version, uint64_t timestamp_us, const double* values, size_t count) {
+    if (base_ == nullptr) {
+        return;
+    }
+    ShmHeader* header = reinterpret_cast<ShmHeader*>(base_);
+    ShmLayout layout = layoutOf(base_);
+    count = std::min<size_t>(count, header->max_fields);
+    
+    // Write into the buffer readers aren't pointed at; they only collide with
+    // us if a copy takes longer than a whole snapshot period
+    uint64_t seq = header->latest.load(std::memory_order_relaxed) + 1;
+    SnapshotBuffer* buffer = snapshotBuffer(base_, layout, seq);
+    buffer->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    buffer->version.store(version, std::memory_order_relaxed);
+    buffer->timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+    buffer->count.store(count, std::memory_order_relaxed);
+    std::atomic<double>* out = snapshotValues(buffer);
+    for (size_t i = 0; i < count; i++) {
+        out[i].store(values[i], std::memory_order_relaxed);
+    }
+    buffer->seq.store(seq, std::memory_order_release);
+    header->latest.store(seq, std::memory_order_release);
+}
+
+void ShmSnapshotWriter::pushSample(uint64_t timestamp_us, uint32_t channel, double value) {
+    if (base_ == nullptr) {
+        return;
+    }
+    ShmHeader* header = reinterpret_cast<ShmHeader*>(base_);
+    ShmLayout layout = layoutOf(base_);
+    uint64_t seq = header->ring_head.load(std::memory_order_relaxed) + 1;
+    RingSlot& slot = ringSlots(base_, layout)[seq & (header->ring_capacity - 1)];
+    
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    slot.timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+    slot.channel.store(channel, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.seq.store(seq, std::memory_order_release);
+    header->ring_head.store(seq, std::memory_order_release);
+}
+
+ShmSnapshotReader::ShmSnapshotReader() : base_(nullptr), size_(0) {}
+
+ShmSnapshotReader::~ShmSnapshotReader() {
+    close();
+}
+
+bool ShmSnapshotReader::open(const std::string& name) {
+    close();
+    error_.clear();
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        error_ = "cannot open " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < SHM_HEADER_BYTES) {
+        error_ = name + " is not a shared snapshot";
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        error_ = "cannot map " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    base_ = static_cast<const uint8_t*>(map);
+    size_ = (size_t)st.st_size;
+    
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    bool valid = header->state.load(std::memory_order_acquire) != SEGMENT_INITIALIZING &&
+                 std::memcmp(header->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) == 0 &&
+                 header->version == SHM_VERSION &&
+                 header->ring_capacity >= 2 && (header->ring_capacity & (header->ring_capacity - 1)) == 0 &&
+                 layoutOf(base_).total <= size_;
+    if (!valid) {
+        error_ = name + " is not a compatible shared snapshot";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ShmSnapshotReader::close() {
+    if (base_ != nullptr) {
+        munmap(const_cast<uint8_t*>(base_), size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+}
+
+bool ShmSnapshotReader::isOpen() const {
+    return base_ != nullptr;
+}
+
+const std::string& ShmSnapshotReader::error() const {
+    return error_;
+}
+
+bool ShmSnapshotReader::isStale() const {
+    if (base_ == nullptr) {
+        return true;
+    }
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    if (header->state.load(std::memory_order_acquire) == SEGMENT_CLOSED) {
+        return true;
+    }
+    // A writer that crashed never marked the segment closed
+    return kill((pid_t)header->writer_pid, 0) != 0 && errno == ESRCH;
+}
+
+pid_t ShmSnapshotReader::writerPid() const {
+    return base_ != nullptr ? (pid_t)reinterpret_cast<const ShmHeader*>(base_)->writer_pid : 0;
+}
+
+uint64_t ShmSnapshotReader::snapshotSeq() const {
+    return base_ != nullptr ? reinterpret_cast<const ShmHeader*>(base_)->latest.load(std::memory_order_acquire) : 0;
+}
+
+uint64_t ShmSnapshotReader::sampleHead() const {
+    return base_ != nullptr ? reinterpret_cast<const ShmHeader*>(base_)->ring_head.load(std::memory_order_acquire) : 0;
+}
+
+bool ShmSnapshotReader::readSnapshot(uint64_t& version, uint64_t& timestamp_us, std::vector<double>& values) const {
+    if (base_ == nullptr) {
+        return false;
+    }
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    ShmLayout layout = layoutOf(base_);
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        uint64_t seq = header->latest.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return false;
+        }
+        SnapshotBuffer* buffer = snapshotBuffer(base_, layout, seq);
+        if (buffer->seq.load(std::memory_order_acquire) != seq) {
+            continue;
+        }
+        version = buffer->version.load(std::memory_order_relaxed);
+        timestamp_us = buffer->timestamp_us.load(std::memory_order_relaxed);
+        size_t count = std::min<uint64_t>(buffer->count.load(std::memory_order_relaxed), header->max_fields);
+        values.resize(count);
+        const std::atomic<double>* in = snapshotValues(buffer);
+        for (size_t i = 0; i < count; i++) {
+            values[i] = in[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer->seq.load(std::memory_order_relaxed) == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShmSnapshotReader::readSchema(uint64_t& version, std::vector<std::string>& rows) const {
+    if (base_ == nullptr) {
+        return false;
+    }
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    return readText(textBlock(base_, layoutOf(base_).schema), header->text_capacity, version, rows);
+}
+
+bool ShmSnapshotReader::readChannels(uint64_t& generation, std::vector<std::string>& channels) const {
+    if (base_ == nullptr) {
+        return false;
+    }
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    return readText(textBlock(base_, layoutOf(base_).channels), header->text_capacity, generation, channels);
+}
+
+uint64_t ShmSnapshotReader::channelsGeneration() const {
+    return base_ != nullptr ? readTextVersion(textBlock(base_, layoutOf(base_).channels)) : 0;
+}
+
+uint64_t ShmSnapshotReader::readSamples(uint64_t sinceSeq, size_t maxRecords, std::vector<SampleRecord>& out) const {
+    if (base_ == nullptr) {
+        return 0;
+    }
+    const ShmHeader* header = reinterpret_cast<const ShmHeader*>(base_);
+    const RingSlot* slots = ringSlots(base_, layoutOf(base_));
+    uint64_t capacity = header->ring_capacity;
+    uint64_t mask = capacity - 1;
+    uint64_t head = header->ring_head.load(std::memory_order_acquire);
+    uint64_t first = sinceSeq + 1;
+    uint64_t dropped = 0;
+    
+    if (head >= capacity && first + capacity <= head) {
+        dropped = head - capacity + 1 - first;
+        first = head - capacity + 1;
+    }
+    
+    for (uint64_t seq = first; seq <= head && out.size() < maxRecords; seq++) {
+        const RingSlot& slot = slots[seq & mask];
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        
+        SampleRecord record;
+        record.seq = seq;
+        record.timestamp_us = slot.timestamp_us.load(std::memory_order_relaxed);
+        record.channel = (uint32_t)slot.channel.load(std::memory_order_relaxed);
+        record.value = slot.value.load(std::memory_order_relaxed);
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.seq.load(std::memory_order_relaxed);
+        if (before != seq || after != seq) {
+            dropped++;
+            continue;
+        }
+        out.push_back(record);
+    }
+    return dropped;
+}
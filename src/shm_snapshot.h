@@ -0,0 +1,85 @@
+#ifndef SHM_SNAPSHOT_H
+#define SHM_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "sample_ring.h"
+
+// Shared-memory publication of the sampler's output, so any number of local
+// processes can read one collector without sampling sysfs themselves.
+//
+// The POSIX segment (/dev/shm/<name>) holds:
+//  - two snapshot buffers: the writer fills the one readers aren't pointed at,
+//    then flips `latest`; each buffer carries the sequence it holds, so a
+//    reader that was lapped mid-copy retries (a seqlock per buffer)
+//  - the snapshot schema and the sampler channel names as text blocks, under
+//    the same scheme, rewritten only when the sensor topology changes
+//  - a ring of recent sampler records with the SampleRing slot protocol
+// Readers map the segment read-only and never write to it.
+class ShmSnapshotWriter {
+public:
+    static const uint32_t DEFAULT_MAX_FIELDS = 4096;
+    static const uint32_t DEFAULT_RING_CAPACITY = 1 << 16; // Power of two
+    
+    ShmSnapshotWriter();
+    ~ShmSnapshotWriter();
+    
+    // Replaces any segment of the same name; name is "/something"
+    bool open(const std::string& name, uint32_t max_fields, uint32_t ring_capacity);
+    // Marks the segment closed for attached readers, then unlinks it
+    void close();
+    bool isOpen() const;
+    const std::string& error() const;
+    
+    // Schema rows are "group\tname\tlabel\tunit", in snapshot order
+    void publishSchema(uint64_t version, const std::vector<std::string>& rows);
+    void publishChannels(uint64_t generation, const std::vector<std::string>& channels);
+    // Values past max_fields are dropped
+    void publishSnapshot(uint64_t version, uint64_t timestamp_us, const double* values, size_t count);
+    void pushSample(uint64_t timestamp_us, uint32_t channel, double value);
+
+private:
+    std::string name_;
+    int fd_;
+    uint8_t* base_;
+    size_t size_;
+    uint64_t text_updates_;
+    std::string error_;
+};
+
+// Read-only view of a segment published by ShmSnapshotWriter
+class ShmSnapshotReader {
+public:
+    ShmSnapshotReader();
+    ~ShmSnapshotReader();
+    
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const;
+    const std::string& error() const;
+    // True once the writer has closed the segment or exited; reopen to follow a new one
+    bool isStale() const;
+    pid_t writerPid() const;
+    
+    // False until the first snapshot, or if the writer kept lapping the copy
+    bool readSnapshot(uint64_t& version, uint64_t& timestamp_us, std::vector<double>& values) const;
+    bool readSchema(uint64_t& version, std::vector<std::string>& rows) const;
+    bool readChannels(uint64_t& generation, std::vector<std::string>& channels) const;
+    // Just the generation readChannels() would report, without copying the names;
+    // 0 before the first publish
+    uint64_t channelsGeneration() const;
+    // Same contract as SampleRing::read(): records after sinceSeq, returns the number dropped
+    uint64_t readSamples(uint64_t sinceSeq, size_t maxRecords, std::vector<SampleRecord>& out) const;
+    uint64_t snapshotSeq() const;
+    uint64_t sampleHead() const;
+
+private:
+    const uint8_t* base_;
+    size_t size_;
+    std::string error_;
+};
+
+#endif // SHM_SNAPSHOT_H
@@ -2,32 +2,195 @@
 #include <fstream>
 #include <sstream>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <linux/netlink.h>
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <cstdio>
 
-SystemMonitor::SystemMonitor() {
+// Scratch size for a single sysfs attribute read (values, names and labels all fit)
+static const size_t SENSOR_BUF_SIZE = 128;
+
+// Sampler ring holds ~16 s of a 4-domain RAPL capture at 1 kHz
+static const size_t SAMPLE_RING_CAPACITY = 1 << 16;
+
+// history_slots_ entry for a metric not yet looked up in the history file
+static const int HISTORY_SLOT_UNRESOLVED = -2;
+
+SystemMonitor::SystemMonitor(const std::string& root)
+    : root_(root),
+      table_generation_(0),
+      uevent_fd_(-1),
+      sample_ring_(SAMPLE_RING_CAPACITY),
+      sampler_wake_fd_(-1),
+      sampler_stop_(false),
+      sampler_running_(false),
+      sampler_rates_changed_(false),
+      next_subscription_id_(1),
+      sampler_generation_(0),
+      sampler_battery_valid_(false),
+      sampler_active_groups_(0),
+      sampler_publish_period_us_(0),
+      sampler_next_publish_us_(0),
+      shm_schema_version_(0),
+      shm_channels_generation_(0),
+      perf_counters_(root),
+      perf_enabled_(false),
+      proc_stat_fd_(-1),
+      cpu_load_time_(0),
+      io_rates_(root),
+      io_rates_time_(0),
+      gpu_monitor_(root),
+      gpu_initialized_(false),
+      disk_health_(root),
+      disk_health_time_(0),
+      process_table_(root),
+      process_table_time_(0),
+      attribution_running_(false),
+      attribution_stop_(false),
+      attribution_last_query_us_(0) {
+    power_windows_ = { 1.0, 10.0, 60.0 };
+    std::fill(sampler_group_hz_, sampler_group_hz_ + SENSOR_GROUP_COUNT, 0.0);
+    std::fill(manual_rates_, manual_rates_ + SENSOR_GROUP_COUNT, 0.0);
+    std::fill(sampler_group_first_, sampler_group_first_ + SENSOR_GROUP_COUNT, (size_t)0);
     // Initialize statistics
     stats_ = SystemStats();
 }
 
 SystemMonitor::~SystemMonitor() {
-    // Cleanup if needed
+    joinSamplerThread();
+    joinAttributionThread();
+    closeSensorHandles();
+    if (uevent_fd_ >= 0) {
+        close(uevent_fd_);
+    }
+    if (proc_stat_fd_ >= 0) {
+        close(proc_stat_fd_);
+    }
+}
+
+int SystemMonitor::openSensorHandle(const std::string& path) {
+    auto it = sensor_fds_.find(path);
+    if (it != sensor_fds_.end()) {
+        return it->second;
+    }
+    
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    sensor_fds_[path] = fd;
+    return fd;
+}
+
+void SystemMonitor::closeSensorHandles() {
+    for (const auto& pair : sensor_fds_) {
+        close(pair.second);
+    }
+    sensor_fds_.clear();
+}
+
+ssize_t SystemMonitor::readSensor(const std::string& path, char* buf, size_t size) {
+    if (size == 0) {
+        return -1;
+    }
+    
+    // Try the cached handle first, then reopen once if the device went away
+    // underneath us (hwmon hot-remove/rebind leaves the old fd returning ENODEV)
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int fd = openSensorHandle(path);
+        if (fd < 0) {
+            return -1;
+        }
+        
+        ssize_t n = pread(fd, buf, size - 1, 0);
+        if (n >= 0) {
+            buf[n] = '\0';
+            return n;
+        }
+        
+        int err = errno;
+        close(fd);
+        sensor_fds_.erase(path);
+        if (err != ENODEV && err != ENXIO && err != ESTALE && err != EBADF) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+bool SystemMonitor::readSensorValue(const std::string& path, double& value) {
+    char buf[SENSOR_BUF_SIZE];
+    if (readSensor(path, buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    
+    char* end = nullptr;
+    double parsed = std::strtod(buf, &end);
+    if (end == buf) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// The msr driver maps the register number to the file offset
+bool SystemMonitor::readMSR(const std::string& path, uint32_t reg, uint64_t& value) {
+    int fd = openSensorHandle(path);
+    if (fd < 0) {
+        return false;
+    }
+    uint64_t raw = 0;
+    if (pread(fd, &raw, sizeof(raw), (off_t)reg) != (ssize_t)sizeof(raw)) {
+        return false;
+    }
+    value = raw;
+    return true;
+}
+
+bool SystemMonitor::readSensorCounter(const std::string& path, uint64_t& value) {
+    char buf[SENSOR_BUF_SIZE];
+    if (readSensor(path, buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(buf, &end, 10);
+    if (end == buf) {
+        return false;
+    }
+    value = parsed;
+    return true;
 }
 
 std::string SystemMonitor::readFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
+    char buf[SENSOR_BUF_SIZE];
+    ssize_t n = readSensor(path, buf, sizeof(buf));
+    if (n <= 0) {
         return "";
     }
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    // Attributes larger than the scratch buffer fall back to a full stream read
+    if ((size_t)n == sizeof(buf) - 1) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return "";
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+    return std::string(buf, n);
 }
 
 std::vector<std::string> SystemMonitor::readDirectory(const std::string& path) {
@@ -52,311 +215,983 @@ bool SystemMonitor::fileExists(const std::string& path) {
     return (stat(path.c_str(), &buffer) == 0);
 }
 
-std::vector<CoreData> SystemMonitor::getCPUCores() {
-    std::vector<CoreData> cores;
+static std::string trimNewline(std::string s) {
+    while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) {
+        s.pop_back();
+    }
+    return s;
+}
+
+// Parse "<prefix><N><suffix>" directory entries such as cpu12 or temp3_input; returns -1 otherwise
+static int parseIndexedEntry(const std::string& entry, const char* prefix, const char* suffix) {
+    size_t prefixLen = std::char_traits<char>::length(prefix);
+    size_t suffixLen = std::char_traits<char>::length(suffix);
+    if (entry.size() <= prefixLen + suffixLen || entry.compare(0, prefixLen, prefix) != 0 ||
+        entry.compare(entry.size() - suffixLen, suffixLen, suffix) != 0) {
+        return -1;
+    }
+    
+    int index = 0;
+    for (size_t i = prefixLen; i < entry.size() - suffixLen; i++) {
+        if (entry[i] < '0' || entry[i] > '9') {
+            return -1;
+        }
+        index = index * 10 + (entry[i] - '0');
+    }
+    return index;
+}
+
+void SystemMonitor::initialize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (uevent_fd_ < 0) {
+        openUeventSocket();
+    }
+    rescanLocked();
+}
+
+void SystemMonitor::rescan() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rescanLocked();
+    }
+    std::lock_guard<std::mutex> lock(gpu_mutex_);
+    if (gpu_initialized_) {
+        gpu_monitor_.initialize();
+    }
+}
+
+void SystemMonitor::rescanLocked() {
+    // Handles for sensors that disappeared are dropped with the old table;
+    // discovery below reopens everything still present
+    closeSensorHandles();
+    
+    auto table = std::make_shared<SensorTable>();
+    discoverCPUFrequencies(*table);
+    discoverHwmonSensors(*table);
+    discoverRAPLDomains(*table);
+    sensor_table_ = table;
+    table_generation_++;
     
-    // Read CPU frequencies from /sys/devices/system/cpu/
-    std::vector<std::string> cpuDirs = readDirectory("/sys/devices/system/cpu/");
+    // Hotplugged CPUs need their own counter groups
+    if (perf_enabled_) {
+        perf_counters_.open(table->cpu_ids);
+    }
+}
+
+std::shared_ptr<const SensorTable> SystemMonitor::ensureSensorTable() {
+    if (!sensor_table_ || consumeHotplugEvents()) {
+        rescanLocked();
+    }
+    return sensor_table_;
+}
+
+void SystemMonitor::openUeventSocket() {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        return;
+    }
     
-    for (const auto& dir : cpuDirs) {
-        if (dir.find("cpu") == 0 && dir != "cpufreq" && dir != "cpuidle") {
-            std::string cpuPath = "/sys/devices/system/cpu/" + dir;
-            std::string freqPath = cpuPath + "/cpufreq/scaling_cur_freq";
+    struct sockaddr_nl addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid = 0;
+    addr.nl_groups = 1; // Kernel uevent multicast group
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return;
+    }
+    uevent_fd_ = fd;
+}
+
+bool SystemMonitor::consumeHotplugEvents() {
+    if (uevent_fd_ < 0) {
+        return false;
+    }
+    
+    // Drain everything queued since the last poll; one non-blocking recv()
+    // returning EAGAIN is the steady-state cost
+    bool changed = false;
+    char buf[4096];
+    while (true) {
+        ssize_t n = recv(uevent_fd_, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+        if (n <= 0) {
+            break;
+        }
+        buf[n] = '\0';
+        
+        // Payload is "action@devpath\0KEY=VALUE\0KEY=VALUE\0..."
+        bool addOrRemove = std::strncmp(buf, "add@", 4) == 0 || std::strncmp(buf, "remove@", 7) == 0;
+        if (!addOrRemove) {
+            continue;
+        }
+        for (ssize_t off = 0; off < n; off += std::strlen(buf + off) + 1) {
+            const char* field = buf + off;
+            if (std::strcmp(field, "SUBSYSTEM=hwmon") == 0 ||
+                std::strcmp(field, "SUBSYSTEM=powercap") == 0 ||
+                std::strcmp(field, "SUBSYSTEM=cpu") == 0) {
+                changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+void SystemMonitor::discoverCPUFrequencies(SensorTable& table) {
+    const std::string cpuRoot = root_ + "/sys/devices/system/cpu/";
+    std::vector<std::pair<int, std::string>> cpus;
+    for (const auto& dir : readDirectory(cpuRoot)) {
+        int index = parseIndexedEntry(dir, "cpu", "");
+        if (index < 0) {
+            continue;
+        }
+        std::string freqPath = cpuRoot + dir + "/cpufreq/scaling_cur_freq";
+        if (openSensorHandle(freqPath) >= 0) {
+            cpus.push_back(std::make_pair(index, freqPath));
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    
+    for (const auto& cpu : cpus) {
+        SensorDescriptor desc;
+        desc.name = "cpu" + std::to_string(cpu.first);
+        desc.label = desc.name;
+        desc.path = cpu.second;
+        desc.scale = 1.0 / 1000.0; // kHz to MHz
+        desc.type = "cpufreq";
+        table.cpu_freq.push_back(desc);
+        table.cpu_ids.push_back(cpu.first);
+        
+        // intel_pstate/amd-pstate publish base_frequency; acpi-cpufreq's max is the nominal P0
+        std::string cpufreqDir = cpuRoot + desc.name + "/cpufreq/";
+        std::string base = trimNewline(readFile(cpufreqDir + "base_frequency"));
+        if (base.empty()) {
+            base = trimNewline(readFile(cpufreqDir + "cpuinfo_max_freq"));
+        }
+        table.cpu_base_mhz.push_back(base.empty() ? 0.0 : std::atof(base.c_str()) / 1000.0);
+    }
+}
+
+void SystemMonitor::discoverHwmonSensors(SensorTable& table) {
+    const std::string hwmonRoot = root_ + "/sys/class/hwmon/";
+    for (const auto& hwmon : readDirectory(hwmonRoot)) {
+        if (hwmon.find("hwmon") != 0) {
+            continue;
+        }
+        std::string basePath = hwmonRoot + hwmon;
+        std::string name = trimNewline(readFile(basePath + "/name"));
+        
+        bool isCPU = name.find("coretemp") != std::string::npos ||
+                     name.find("k10temp") != std::string::npos ||
+                     name.find("zenpower") != std::string::npos ||
+                     name.find("x86_pkg_temp") != std::string::npos;
+        bool isDDR5 = name.find("spd5118") != std::string::npos;
+        if (!isCPU && !isDDR5) {
+            continue;
+        }
+        
+        // One directory listing per chip replaces probing temp1..tempN for existence
+        std::vector<int> indices;
+        for (const auto& entry : readDirectory(basePath)) {
+            int index = parseIndexedEntry(entry, "temp", "_input");
+            if (index > 0) {
+                indices.push_back(index);
+            }
+        }
+        std::sort(indices.begin(), indices.end());
+        
+        for (int i : indices) {
+            std::string prefix = basePath + "/temp" + std::to_string(i);
+            if (openSensorHandle(prefix + "_input") < 0) {
+                continue;
+            }
             
-            if (fileExists(freqPath)) {
-                CoreData core;
-                std::string freqStr = readFile(freqPath);
-                if (!freqStr.empty()) {
-                    core.frequency = std::stod(freqStr) / 1000.0; // Convert kHz to MHz
-                } else {
-                    core.frequency = 0.0;
-                }
-                core.load = 0.0; // Will be filled by JavaScript
-                core.temperature = 0.0; // Will be filled by temperature sensors
-                cores.push_back(core);
+            SensorDescriptor desc;
+            desc.name = name;
+            desc.label = trimNewline(readFile(prefix + "_label"));
+            if (desc.label.empty()) {
+                desc.label = (isCPU ? "temp" : "DDR5_Module_") + std::to_string(i);
             }
+            desc.path = prefix + "_input";
+            desc.scale = 1.0 / 1000.0; // Millidegrees to degrees
+            desc.type = isCPU ? "cpu" : "ddr5";
+            (isCPU ? table.cpu_temps : table.ddr5_temps).push_back(desc);
+        }
+    }
+}
+
+// Walks every powercap zone, including subzones (intel-rapl:0:0 core/uncore/dram)
+// and the MMIO interface. AMD RAPL registers under the same intel-rapl control type.
+void SystemMonitor::discoverRAPLDomains(SensorTable& table) {
+    const std::string powercapRoot = root_ + "/sys/class/powercap/";
+    std::vector<std::string> zones;
+    for (const auto& entry : readDirectory(powercapRoot)) {
+        // Control-type directories ("intel-rapl") have no ':'; zones are flat symlinks
+        if (entry.find("intel-rapl:") == 0 || entry.find("intel-rapl-mmio:") == 0) {
+            zones.push_back(entry);
         }
     }
+    // Lexical order puts every parent ("intel-rapl:0") before its children ("intel-rapl:0:1");
+    // MMIO zones go last so the primary package domains keep their usual positions
+    std::sort(zones.begin(), zones.end());
+    std::stable_partition(zones.begin(), zones.end(), [](const std::string& zone) {
+        return zone.find("intel-rapl-mmio:") != 0;
+    });
     
-    return cores;
+    std::map<std::string, std::string> zoneNames;
+    for (const auto& zone : zones) {
+        std::string basePath = powercapRoot + zone;
+        std::string name = trimNewline(readFile(basePath + "/name"));
+        std::string energyPath = basePath + "/energy_uj";
+        if (name.empty() || openSensorHandle(energyPath) < 0) {
+            continue;
+        }
+        
+        // Subzone names ("core", "dram") repeat per socket, so qualify them with the parent
+        std::string parent;
+        size_t firstColon = zone.find(':');
+        size_t lastColon = zone.rfind(':');
+        if (lastColon != firstColon) {
+            auto it = zoneNames.find(zone.substr(0, lastColon));
+            if (it != zoneNames.end()) {
+                parent = it->second;
+                name = parent + "/" + name;
+            }
+        } else if (zone.find("intel-rapl-mmio:") == 0) {
+            name += "-mmio"; // Same package as the MSR-backed zone, different interface
+        }
+        zoneNames[zone] = name;
+        
+        RAPLZone info;
+        info.id = zone;
+        info.parent = parent;
+        info.max_energy_uj = 0;
+        info.msr = 0;
+        info.msr_unit_uj = 0.0;
+        uint64_t range = 0;
+        if (readSensorCounter(basePath + "/max_energy_range_uj", range) && range > 0) {
+            info.max_energy_uj = range;
+        } else {
+            info.max_energy_uj = 1ULL << 32;
+        }
+        
+        SensorDescriptor desc;
+        desc.name = name;
+        desc.label = name;
+        desc.path = energyPath;
+        desc.scale = 1.0 / 1000000.0; // Microjoules to joules
+        desc.type = "rapl";
+        table.rapl.push_back(desc);
+        table.rapl_zones.push_back(info);
+    }
+    
+    // Since 5.10 energy_uj is root-only; fall back to the MSRs if they are readable
+    bool readable = false;
+    for (size_t i = 0; i < table.rapl.size() && !readable; i++) {
+        uint64_t energy = 0;
+        readable = readRAPLEnergy(table, i, energy);
+    }
+    if (!readable) {
+        table.rapl.clear();
+        table.rapl_zones.clear();
+        discoverRAPLMSR(table);
+    }
 }
 
-std::vector<SensorData> SystemMonitor::getTemperatureSensors() {
-    std::vector<SensorData> sensors;
+// RAPL energy status registers (Intel SDM vol. 4, AMD PPR for family 17h+)
+static const uint32_t MSR_RAPL_POWER_UNIT = 0x606;
+static const uint32_t MSR_PKG_ENERGY_STATUS = 0x611;
+static const uint32_t MSR_DRAM_ENERGY_STATUS = 0x619;
+static const uint32_t MSR_PP0_ENERGY_STATUS = 0x639;
+static const uint32_t MSR_PP1_ENERGY_STATUS = 0x641;
+static const uint32_t MSR_PLATFORM_ENERGY_STATUS = 0x64D;
+static const uint32_t MSR_AMD_RAPL_POWER_UNIT = 0xC0010299;
+static const uint32_t MSR_AMD_PKG_ENERGY_STATUS = 0xC001029B;
+
+// Reads the package-scope energy registers through /dev/cpu/<n>/msr on the
+// first CPU of each package. Needs the msr module and CAP_SYS_RAWIO (or a
+// readable device node); silently finds nothing otherwise.
+void SystemMonitor::discoverRAPLMSR(SensorTable& table) {
+    const std::string cpuRoot = root_ + "/sys/devices/system/cpu/";
+    std::map<int, int> packageCPU;
+    for (const auto& dir : readDirectory(cpuRoot)) {
+        int cpu = parseIndexedEntry(dir, "cpu", "");
+        if (cpu < 0) {
+            continue;
+        }
+        std::string package = trimNewline(readFile(cpuRoot + dir + "/topology/physical_package_id"));
+        int id = package.empty() ? 0 : std::atoi(package.c_str());
+        auto it = packageCPU.find(id);
+        if (it == packageCPU.end() || cpu < it->second) {
+            packageCPU[id] = cpu;
+        }
+    }
     
-    // Read from /sys/class/hwmon
-    std::vector<std::string> hwmonDirs = readDirectory("/sys/class/hwmon/");
+    for (const auto& pkg : packageCPU) {
+        std::string path = root_ + "/dev/cpu/" + std::to_string(pkg.second) + "/msr";
+        std::string packageName = "package-" + std::to_string(pkg.first);
+        
+        // Energy status unit is bits 12:8 of the power unit register: 1/2^ESU joules
+        uint64_t units = 0;
+        bool amd = false;
+        if (!readMSR(path, MSR_RAPL_POWER_UNIT, units)) {
+            if (!readMSR(path, MSR_AMD_RAPL_POWER_UNIT, units)) {
+                continue;
+            }
+            amd = true;
+        }
+        double unitUJ = 1000000.0 / (double)(1ULL << ((units >> 8) & 0x1f));
+        
+        struct { uint32_t reg; std::string name; std::string parent; } domains[] = {
+            { amd ? MSR_AMD_PKG_ENERGY_STATUS : MSR_PKG_ENERGY_STATUS, packageName, "" },
+            { amd ? 0 : MSR_PP0_ENERGY_STATUS, packageName + "/core", packageName },
+            { amd ? 0 : MSR_PP1_ENERGY_STATUS, packageName + "/uncore", packageName },
+            { amd ? 0 : MSR_DRAM_ENERGY_STATUS, packageName + "/dram", packageName },
+            { (amd || pkg.first != 0) ? 0 : MSR_PLATFORM_ENERGY_STATUS, "psys", "" },
+        };
+        for (const auto& domain : domains) {
+            // Unsupported registers either fault (EIO) or read back as a stuck zero
+            uint64_t raw = 0;
+            if (domain.reg == 0 || !readMSR(path, domain.reg, raw) || (raw & 0xffffffffULL) == 0) {
+                continue;
+            }
+            
+            char id[48];
+            snprintf(id, sizeof(id), "msr:%d:0x%x", pkg.second, domain.reg);
+            RAPLZone info;
+            info.id = id;
+            info.parent = domain.parent;
+            info.max_energy_uj = (uint64_t)((double)(1ULL << 32) * unitUJ);
+            info.msr = domain.reg;
+            info.msr_unit_uj = unitUJ;
+            
+            SensorDescriptor desc;
+            desc.name = domain.name;
+            desc.label = domain.name;
+            desc.path = path;
+            desc.scale = 1.0 / 1000000.0; // Microjoules to joules
+            desc.type = "rapl";
+            table.rapl.push_back(desc);
+            table.rapl_zones.push_back(info);
+        }
+    }
+}
+
+bool SystemMonitor::readRAPLEnergy(const SensorTable& table, size_t index, uint64_t& energy_uj) {
+    const RAPLZone& zone = table.rapl_zones[index];
+    if (zone.msr == 0) {
+        return readSensorCounter(table.rapl[index].path, energy_uj);
+    }
+    
+    uint64_t raw = 0;
+    if (!readMSR(table.rapl[index].path, zone.msr, raw)) {
+        return false;
+    }
+    energy_uj = (uint64_t)((double)(raw & 0xffffffffULL) * zone.msr_unit_uj);
+    return true;
+}
+
+// Energy consumed between two counter readings, allowing for one wrap at the zone's range
+static uint64_t wrappedEnergyDelta(uint64_t previous, uint64_t current, uint64_t range) {
+    if (current >= previous) {
+        return current - previous;
+    }
+    return (range > previous ? range - previous : 0) + current;
+}
+
+std::vector<CoreData> SystemMonitor::getCPUCores() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<CoreData> cores;
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    cores.reserve(table->cpu_freq.size());
+    refreshCPULoadLocked();
     
-    for (const auto& hwmon : hwmonDirs) {
-        if (hwmon.find("hwmon") == 0) {
-            std::string basePath = "/sys/class/hwmon/" + hwmon;
-            std::string namePath = basePath + "/name";
-            std::string name = readFile(namePath);
+    for (size_t i = 0; i < table->cpu_freq.size(); i++) {
+        const SensorDescriptor& desc = table->cpu_freq[i];
+        double freqKHz = 0.0;
+        if (readSensorValue(desc.path, freqKHz)) {
+            CoreData core;
+            core.cpu = table->cpu_ids[i];
+            core.frequency = freqKHz * desc.scale;
+            size_t slot = (size_t)core.cpu + 1;
+            core.load = (slot < cpu_load_.size() && cpu_present_[slot]) ? cpu_load_[slot].load : 0.0;
+            core.temperature = 0.0; // Will be filled by temperature sensors
             
-            // Remove newline
-            if (!name.empty() && name.back() == '\n') {
-                name.pop_back();
+            PerfCoreSample counters;
+            perf_counters_.read(core.cpu, counters); // All NaN when disabled or not primed yet
+            core.ipc = counters.ipc;
+            core.cache_miss_rate = counters.cache_miss_rate;
+            core.branch_miss_rate = counters.branch_miss_rate;
+            core.effective_frequency = table->cpu_base_mhz[i] > 0.0
+                ? counters.active_ratio * table->cpu_base_mhz[i]
+                : std::numeric_limits<double>::quiet_NaN();
+            cores.push_back(core);
+        }
+    }
+    
+    return cores;
+}
+
+// user nice system idle iowait irq softirq steal; guest time is already part of user
+static const size_t CPU_TIME_FIELDS = 8;
+// CPU load, disk/network rates and the process table reuse their last result
+// below this interval; the jiffy-granular counters are mostly quantization noise there
+static const uint64_t MIN_RATE_INTERVAL_US = 20000;
+
+std::vector<CPULoad> SystemMonitor::getCPULoad() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refreshCPULoadLocked();
+    std::vector<CPULoad> loads;
+    loads.reserve(cpu_load_.size());
+    for (size_t slot = 0; slot < cpu_load_.size(); slot++) {
+        if (cpu_present_[slot]) {
+            loads.push_back(cpu_load_[slot]);
+        }
+    }
+    return loads;
+}
+
+// Parses the cpu lines of /proc/stat into cpu_times_ and turns the deltas
+// against the previous read into percentages. Reuses the fd and every buffer,
+// so steady state is one pread() and no allocation.
+void SystemMonitor::refreshCPULoadLocked() {
+    uint64_t now = getCurrentTimeMicroseconds();
+    if (!cpu_load_.empty() && now - cpu_load_time_ < MIN_RATE_INTERVAL_US) {
+        return;
+    }
+    
+    if (proc_stat_fd_ < 0) {
+        proc_stat_fd_ = open((root_ + "/proc/stat").c_str(), O_RDONLY | O_CLOEXEC);
+        if (proc_stat_fd_ < 0) {
+            return;
+        }
+        proc_stat_buf_.resize(16384);
+    }
+    
+    size_t length = 0;
+    while (true) {
+        ssize_t n = pread(proc_stat_fd_, proc_stat_buf_.data() + length, proc_stat_buf_.size() - length, (off_t)length);
+        if (n < 0) {
+            return;
+        }
+        if (n == 0) {
+            break;
+        }
+        length += (size_t)n;
+        if (length == proc_stat_buf_.size()) {
+            proc_stat_buf_.resize(proc_stat_buf_.size() * 2); // Grows once for large hosts, then stays
+        }
+    }
+    
+    std::fill(cpu_present_.begin(), cpu_present_.end(), 0);
+    const char* p = proc_stat_buf_.data();
+    const char* end = p + length;
+    while (end - p > 3 && p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+        p += 3;
+        size_t slot = 0;
+        if (*p >= '0' && *p <= '9') {
+            size_t cpu = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                cpu = cpu * 10 + (size_t)(*p++ - '0');
             }
-            
-            // Check for CPU-related sensors
-            if (name.find("coretemp") != std::string::npos ||
-                name.find("k10temp") != std::string::npos ||
-                name.find("zenpower") != std::string::npos ||
-                name.find("x86_pkg_temp") != std::string::npos) {
-                
-                // Read temperature sensors
-                for (int i = 1; i <= 30; i++) {
-                    std::string tempPath = basePath + "/temp" + std::to_string(i) + "_input";
-                    std::string labelPath = basePath + "/temp" + std::to_string(i) + "_label";
-                    
-                    if (fileExists(tempPath)) {
-                        std::string tempStr = readFile(tempPath);
-                        std::string label = readFile(labelPath);
-                        
-                        if (!tempStr.empty()) {
-                            SensorData sensor;
-                            sensor.name = name;
-                            sensor.label = label.empty() ? "temp" + std::to_string(i) : label;
-                            if (!sensor.label.empty() && sensor.label.back() == '\n') {
-                                sensor.label.pop_back();
-                            }
-                            sensor.value = std::stod(tempStr) / 1000.0; // Convert millidegrees to degrees
-                            sensor.type = "cpu";
-                            sensors.push_back(sensor);
-                        }
-                    }
-                }
+            slot = cpu + 1;
+        }
+        if (slot >= cpu_present_.size()) {
+            cpu_present_.resize(slot + 1, 0);
+            cpu_times_.resize((slot + 1) * CPU_TIME_FIELDS, 0);
+            prev_cpu_times_.resize((slot + 1) * CPU_TIME_FIELDS, 0);
+            cpu_load_.resize(slot + 1);
+        }
+        
+        uint64_t* times = &cpu_times_[slot * CPU_TIME_FIELDS];
+        for (size_t field = 0; field < CPU_TIME_FIELDS; field++) {
+            while (p < end && *p == ' ') {
+                p++;
+            }
+            uint64_t value = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                value = value * 10 + (uint64_t)(*p++ - '0');
             }
+            times[field] = value;
         }
+        cpu_present_[slot] = 1;
+        
+        while (p < end && *p != '\n') {
+            p++;
+        }
+        p++;
     }
     
-    return sensors;
+    for (size_t slot = 0; slot < cpu_present_.size(); slot++) {
+        if (!cpu_present_[slot]) {
+            continue;
+        }
+        uint64_t* cur = &cpu_times_[slot * CPU_TIME_FIELDS];
+        uint64_t* prev = &prev_cpu_times_[slot * CPU_TIME_FIELDS];
+        double delta[CPU_TIME_FIELDS];
+        double total = 0.0;
+        for (size_t field = 0; field < CPU_TIME_FIELDS; field++) {
+            // Counters can step backwards across CPU offline/online
+            delta[field] = cur[field] >= prev[field] ? (double)(cur[field] - prev[field]) : 0.0;
+            total += delta[field];
+            prev[field] = cur[field];
+        }
+        
+        CPULoad& load = cpu_load_[slot];
+        load.cpu = (int)slot - 1;
+        if (total <= 0.0) {
+            continue; // No tick elapsed; keep the previous figures
+        }
+        double scale = 100.0 / total;
+        load.user = (delta[0] + delta[1]) * scale;
+        load.system = delta[2] * scale;
+        load.idle = delta[3] * scale;
+        load.iowait = delta[4] * scale;
+        load.irq = (delta[5] + delta[6]) * scale;
+        load.steal = delta[7] * scale;
+        load.load = 100.0 - load.idle - load.iowait;
+    }
+    cpu_load_time_ = now;
 }
 
-std::vector<SensorData> SystemMonitor::getDDR5Temperatures() {
-    std::vector<SensorData> sensors;
+uint64_t SystemMonitor::readIORates(std::vector<double>& values) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t now = getCurrentTimeMicroseconds();
+    if (io_rates_time_ == 0 || now - io_rates_time_ >= MIN_RATE_INTERVAL_US) {
+        io_rates_.update(now);
+        io_rates_time_ = now;
+    }
+    values.resize(io_rates_.valueCount());
+    io_rates_.fill(values.data());
+    return io_rates_.version();
+}
+
+uint64_t SystemMonitor::getIODevices(std::vector<std::string>& disks, std::vector<bool>& stacked,
+                                     std::vector<std::string>& interfaces) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (io_rates_time_ == 0) {
+        io_rates_time_ = getCurrentTimeMicroseconds();
+        io_rates_.update(io_rates_time_);
+    }
+    disks = io_rates_.diskNames();
+    stacked = io_rates_.diskStacked();
+    interfaces = io_rates_.interfaceNames();
+    return io_rates_.version();
+}
+
+// Non-zero stamps stay non-zero so getIODevices() and the process sweep don't
+// mistake an expired cache for a first read
+void SystemMonitor::expireRateCaches() {
+    std::lock_guard<std::mutex> process_lock(process_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpu_load_time_ = 0;
+    if (io_rates_time_ != 0) {
+        io_rates_time_ = 1;
+    }
+    if (process_table_time_ != 0) {
+        process_table_time_ = 1;
+    }
+}
+
+std::vector<GPUData> SystemMonitor::getGPUs() {
+    std::lock_guard<std::mutex> lock(gpu_mutex_);
+    if (!gpu_initialized_) {
+        gpu_monitor_.initialize();
+        gpu_initialized_ = true;
+    }
+    return gpu_monitor_.read();
+}
+
+std::string SystemMonitor::getGPUBackend() {
+    std::lock_guard<std::mutex> lock(gpu_mutex_);
+    if (!gpu_initialized_) {
+        gpu_monitor_.initialize();
+        gpu_initialized_ = true;
+    }
+    return gpu_monitor_.backend();
+}
+
+std::vector<DiskHealthData> SystemMonitor::getDiskHealth(uint64_t max_age_ms) {
+    std::lock_guard<std::mutex> lock(disk_health_mutex_);
+    uint64_t now = getCurrentTimeMicroseconds();
+    if (disk_health_time_ == 0 || now - disk_health_time_ >= max_age_ms * 1000) {
+        disk_health_cache_ = disk_health_.read();
+        disk_health_time_ = now;
+    }
     
-    // Read from /sys/class/hwmon for spd5118 sensors
-    std::vector<std::string> hwmonDirs = readDirectory("/sys/class/hwmon/");
+    std::vector<DiskHealthData> disks = disk_health_cache_;
+    for (auto& disk : disks) {
+        disk.age_ms = (now - disk_health_time_) / 1000.0;
+    }
+    return disks;
+}
+
+// Caller holds process_mutex_; mutex_ is taken inside it, never the other way round
+void SystemMonitor::advanceProcessTableLocked() {
+    uint64_t now = getCurrentTimeMicroseconds();
+    if (process_table_time_ != 0 && now - process_table_time_ < MIN_RATE_INTERVAL_US) {
+        return;
+    }
     
-    for (const auto& hwmon : hwmonDirs) {
-        if (hwmon.find("hwmon") == 0) {
-            std::string basePath = "/sys/class/hwmon/" + hwmon;
-            std::string namePath = basePath + "/name";
-            std::string name = readFile(namePath);
-            
-            // Remove newline
-            if (!name.empty() && name.back() == '\n') {
-                name.pop_back();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<const SensorTable> table = ensureSensorTable();
+        if (table != attribution_table_) {
+            std::vector<std::string> names;
+            std::vector<bool> inTotal;
+            for (size_t i = 0; i < table->rapl.size(); i++) {
+                names.push_back(table->rapl[i].name);
+                // Subzones sit inside their package, and psys covers the whole platform
+                inTotal.push_back(table->rapl_zones[i].parent.empty() && table->rapl[i].name.compare(0, 4, "psys") != 0);
             }
-            
-            // Check for spd5118 sensors (DDR5 memory)
-            if (name.find("spd5118") != std::string::npos) {
-                for (int i = 1; i <= 10; i++) {
-                    std::string tempPath = basePath + "/temp" + std::to_string(i) + "_input";
-                    std::string labelPath = basePath + "/temp" + std::to_string(i) + "_label";
-                    
-                    if (fileExists(tempPath)) {
-                        std::string tempStr = readFile(tempPath);
-                        std::string label = readFile(labelPath);
-                        
-                        if (!tempStr.empty()) {
-                            SensorData sensor;
-                            sensor.name = name;
-                            sensor.label = label.empty() ? "DDR5_Module_" + std::to_string(i) : label;
-                            if (!sensor.label.empty() && sensor.label.back() == '\n') {
-                                sensor.label.pop_back();
-                            }
-                            sensor.value = std::stod(tempStr) / 1000.0; // Convert millidegrees to degrees
-                            sensor.type = "ddr5";
-                            sensors.push_back(sensor);
-                        }
-                    }
-                }
+            process_table_.setEnergyDomains(names, inTotal);
+            attribution_table_ = table;
+            attribution_prev_uj_.assign(names.size(), 0);
+            attribution_primed_.assign(names.size(), false);
+            attribution_energy_j_.assign(names.size(), 0.0);
+        }
+        
+        for (size_t i = 0; i < table->rapl.size(); i++) {
+            uint64_t energy = 0;
+            if (!readRAPLEnergy(*table, i, energy)) {
+                continue;
             }
+            if (attribution_primed_[i]) {
+                uint64_t delta = wrappedEnergyDelta(attribution_prev_uj_[i], energy, table->rapl_zones[i].max_energy_uj);
+                attribution_energy_j_[i] += (double)delta / 1e6;
+            }
+            attribution_prev_uj_[i] = energy;
+            attribution_primed_[i] = true;
         }
     }
     
-    return sensors;
+    process_table_.update(now, attribution_energy_j_);
+    process_table_time_ = now;
 }
 
-std::vector<SensorData> SystemMonitor::getRAPLPower() {
+std::vector<ProcessInfo> SystemMonitor::getTopProcesses(ProcessSortKey key, size_t count) {
+    std::lock_guard<std::mutex> lock(process_mutex_);
+    advanceProcessTableLocked();
+    
+    std::vector<ProcessInfo> top;
+    process_table_.top(key, count, top);
+    return top;
+}
+
+// How often the attribution thread advances the sweep, and how long it keeps
+// going after the last energy query
+static const uint64_t ATTRIBUTION_PERIOD_US = 100000;
+static const uint64_t ATTRIBUTION_IDLE_US = 60000000;
+
+void SystemMonitor::keepAttributionRunning() {
+    std::lock_guard<std::mutex> lock(attribution_mutex_);
+    attribution_last_query_us_ = getCurrentTimeMicroseconds();
+    if (attribution_running_ || attribution_stop_) {
+        return;
+    }
+    // An idle thread has already returned; reap it before starting another
+    if (attribution_thread_.joinable()) {
+        attribution_thread_.join();
+    }
+    attribution_running_ = true;
+    attribution_thread_ = std::thread(&SystemMonitor::attributionLoop, this);
+}
+
+void SystemMonitor::attributionLoop() {
+    std::unique_lock<std::mutex> lock(attribution_mutex_);
+    while (!attribution_stop_ &&
+           getCurrentTimeMicroseconds() - attribution_last_query_us_ < ATTRIBUTION_IDLE_US) {
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> process_lock(process_mutex_);
+            advanceProcessTableLocked();
+        }
+        lock.lock();
+        attribution_wake_.wait_for(lock, std::chrono::microseconds(ATTRIBUTION_PERIOD_US),
+                                   [this] { return attribution_stop_; });
+    }
+    attribution_running_ = false;
+}
+
+void SystemMonitor::joinAttributionThread() {
+    {
+        std::lock_guard<std::mutex> lock(attribution_mutex_);
+        attribution_stop_ = true;
+    }
+    attribution_wake_.notify_all();
+    if (attribution_thread_.joinable()) {
+        attribution_thread_.join();
+    }
+}
+
+std::vector<ProcessEnergy> SystemMonitor::getEnergyByProcess(size_t count, std::vector<std::string>& domains) {
+    keepAttributionRunning();
+    std::lock_guard<std::mutex> lock(process_mutex_);
+    advanceProcessTableLocked();
+    
+    std::vector<ProcessEnergy> energy;
+    process_table_.energyByProcess(count, energy);
+    domains = process_table_.energyDomains();
+    return energy;
+}
+
+std::vector<ProcessEnergy> SystemMonitor::getEnergyByCgroup(size_t count, std::vector<std::string>& domains) {
+    keepAttributionRunning();
+    std::lock_guard<std::mutex> lock(process_mutex_);
+    advanceProcessTableLocked();
+    
+    std::vector<ProcessEnergy> energy;
+    process_table_.energyByCgroup(count, energy);
+    domains = process_table_.energyDomains();
+    return energy;
+}
+
+bool SystemMonitor::openSessionLog(const std::string& path, const std::vector<std::string>& columns,
+                                   uint32_t chunk_rows, bool compress, std::string& error) {
+    std::lock_guard<std::mutex> lock(session_log_mutex_);
+    if (!session_log_.open(path, columns, chunk_rows, compress)) {
+        error = session_log_.error();
+        return false;
+    }
+    return true;
+}
+
+int SystemMonitor::appendSessionLog(int64_t timestamp_ms, const double* values, size_t count, std::string& error) {
+    std::lock_guard<std::mutex> lock(session_log_mutex_);
+    if (!session_log_.isOpen()) {
+        error = "Session log not open";
+        return -1;
+    }
+    if (session_log_.append(timestamp_ms, values, count)) {
+        return 1;
+    }
+    if (!session_log_.error().empty()) {
+        error = session_log_.error();
+        return -1;
+    }
+    return 0;
+}
+
+void SystemMonitor::closeSessionLog() {
+    std::lock_guard<std::mutex> lock(session_log_mutex_);
+    session_log_.close();
+}
+
+int SystemMonitor::enableHardwareCounters(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enable) {
+        perf_enabled_ = false;
+        perf_counters_.close();
+        return 0;
+    }
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    perf_enabled_ = true;
+    return perf_counters_.open(table->cpu_ids);
+}
+
+std::vector<SensorData> SystemMonitor::readSensorGroup(const std::vector<SensorDescriptor>& group) {
     std::vector<SensorData> sensors;
+    sensors.reserve(group.size());
     
-    // Read from /sys/class/powercap/intel-rapl
-    if (!fileExists("/sys/class/powercap/intel-rapl")) {
-        return sensors;
+    for (const auto& desc : group) {
+        double raw = 0.0;
+        if (readSensorValue(desc.path, raw)) {
+            SensorData sensor;
+            sensor.name = desc.name;
+            sensor.label = desc.label;
+            sensor.value = raw * desc.scale;
+            sensor.type = desc.type;
+            sensors.push_back(sensor);
+        }
     }
     
-    std::vector<std::string> raplDirs = readDirectory("/sys/class/powercap/intel-rapl/");
+    return sensors;
+}
+
+std::vector<SensorData> SystemMonitor::getTemperatureSensors() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    return readSensorGroup(table->cpu_temps);
+}
+
+std::vector<SensorData> SystemMonitor::getDDR5Temperatures() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    return readSensorGroup(table->ddr5_temps);
+}
+
+std::vector<SensorData> SystemMonitor::getRAPLPower() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    std::vector<SensorData> sensors;
+    sensors.reserve(table->rapl.size());
+    for (size_t i = 0; i < table->rapl.size(); i++) {
+        uint64_t energy = 0;
+        if (readRAPLEnergy(*table, i, energy)) {
+            const SensorDescriptor& desc = table->rapl[i];
+            sensors.push_back(SensorData{ desc.name, desc.label, (double)energy * desc.scale, desc.type });
+        }
+    }
+    return sensors;
+}
+
+std::vector<PowerData> SystemMonitor::getRAPLPowerCalculated() {
+    std::vector<PowerData> power;
+    getRAPLPowerCalculated(power);
+    return power;
+}
+
+void SystemMonitor::getRAPLPowerCalculated(std::vector<PowerData>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    readRAPLPowerLocked(*table, POWER_CONSUMER_UI, out);
+}
+
+void SystemMonitor::setPowerWindows(const std::vector<double>& seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    power_windows_.clear();
+    for (double s : seconds) {
+        if (s > 0.0 && std::isfinite(s)) {
+            power_windows_.push_back(s);
+        }
+    }
+    for (auto& states : rapl_state_) {
+        for (auto& pair : states) {
+            resetPowerWindows(pair.second);
+        }
+    }
+    table_generation_++; // Snapshot layout includes one field pair per window
+}
+
+std::vector<double> SystemMonitor::getPowerWindows() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return power_windows_;
+}
+
+void SystemMonitor::resetPowerWindows(RAPLDomainState& state) {
+    state.ewma.clear();
+    state.boxcar.clear();
+    for (double seconds : power_windows_) {
+        state.ewma.push_back(TimeEWMA(seconds));
+        // State advances at most every RAPL_MIN_INTERVAL_US, so 10 per second is the most a window holds
+        state.boxcar.push_back(TimeWindow((uint64_t)(seconds * 1000000.0), (size_t)std::ceil(seconds * 10.0) + 1));
+    }
+}
+
+// Shortest interval a consumer's power state advances over; readers in between
+// get the values as of the last advance
+static const uint64_t RAPL_MIN_INTERVAL_US = 100000;
+// Longest interval still averaged into displayed power; energy is kept either way
+static const uint64_t RAPL_MAX_INTERVAL_US = 10000000;
+
+// Overwrites powerData element by element, so on a steady topology the
+// names and window vectors keep their storage and nothing is allocated
+void SystemMonitor::readRAPLPowerLocked(const SensorTable& table, PowerConsumer consumer, std::vector<PowerData>& powerData) {
+    size_t count = 0;
+    uint64_t currentTime = getCurrentTimeMicroseconds();
     
-    for (const auto& dir : raplDirs) {
-        if (dir.find("intel-rapl:") == 0) {
-            std::string basePath = "/sys/class/powercap/intel-rapl/" + dir;
-            std::string namePath = basePath + "/name";
-            std::string energyPath = basePath + "/energy_uj";
-            
-            if (fileExists(namePath) && fileExists(energyPath)) {
-                std::string name = readFile(namePath);
-                std::string energyStr = readFile(energyPath);
-                
-                if (!name.empty() && !energyStr.empty()) {
-                    if (name.back() == '\n') name.pop_back();
-                    
-                    SensorData sensor;
-                    sensor.name = name;
-                    sensor.label = name;
-                    sensor.value = std::stod(energyStr) / 1000000.0; // Convert microjoules to joules
-                    sensor.type = "rapl";
-                    sensors.push_back(sensor);
-                }
-            }
+    for (size_t i = 0; i < table.rapl.size(); i++) {
+        uint64_t energy = 0;
+        if (!readRAPLEnergy(table, i, energy)) {
+            continue;
+        }
+        if (count == powerData.size()) {
+            powerData.emplace_back();
         }
+        updateRAPLPowerLocked(table, consumer, i, energy, currentTime, powerData[count++]);
     }
-    
-    return sensors;
+    powerData.resize(count);
 }
 
-std::vector<PowerData> SystemMonitor::getRAPLPowerCalculated() {
-    std::vector<PowerData> powerData;
+// Feeds one counter reading of domain index into consumer's state and fills power from it
+void SystemMonitor::updateRAPLPowerLocked(const SensorTable& table, PowerConsumer consumer, size_t index,
+                                          uint64_t energy, uint64_t currentTime, PowerData& power) {
+    const SensorDescriptor& domain = table.rapl[index];
+    const RAPLZone& zone = table.rapl_zones[index];
+    std::map<std::string, RAPLDomainState>& states = rapl_state_[consumer];
+    power.name = domain.name;
+    power.zone = zone.id;
+    power.parent = zone.parent;
+    power.energy = (double)energy / 1000000.0; // Convert to joules
     
-    // Read from /sys/class/powercap/intel-rapl
-    if (!fileExists("/sys/class/powercap/intel-rapl")) {
-        return powerData;
+    // Initialize if first time
+    auto it = states.find(domain.name);
+    if (it == states.end()) {
+        RAPLDomainState& state = states[domain.name];
+        resetPowerWindows(state);
+        state.previous_energy = energy;
+        state.previous_time = currentTime;
+        
+        // Return initial state with zero cumulative energy
+        power.power = 0.0;
+        power.min_power = 0.0;
+        power.max_power = 0.0;
+        power.avg_power = 0.0;
+        power.total_wh = 0.0;
+        power.total_kwh = 0.0;
+        power.ewma_power.assign(power_windows_.size(), 0.0);
+        power.boxcar_power.assign(power_windows_.size(), 0.0);
+        return;
     }
+    RAPLDomainState& state = it->second;
     
-    std::vector<std::string> raplDirs = readDirectory("/sys/class/powercap/intel-rapl/");
-    uint64_t currentTime = getCurrentTimeMicroseconds();
-    
-    for (const auto& dir : raplDirs) {
-        if (dir.find("intel-rapl:") == 0) {
-            std::string basePath = "/sys/class/powercap/intel-rapl/" + dir;
-            std::string namePath = basePath + "/name";
-            std::string energyPath = basePath + "/energy_uj";
+    // Another reader of this consumer advanced it moments ago: report its values
+    // rather than computing power over a sliver of an interval
+    uint64_t timeDelta = currentTime - state.previous_time;
+    if (timeDelta >= RAPL_MIN_INTERVAL_US) {
+        // Counters wrap at the zone's max_energy_range_uj (2^32 counts for MSRs)
+        uint64_t energyDelta = wrappedEnergyDelta(state.previous_energy, energy, zone.max_energy_uj);
+        // Power (W) = Energy (μJ) / Time (μs)
+        double powerWatts = (double)energyDelta / (double)timeDelta;
+        
+        // Every wrap-corrected delta counts, so totalWh is a true monotonic
+        // counter. A delta past half the counter range is a reset (the
+        // counter went backwards), not energy.
+        bool reset = energyDelta > zone.max_energy_uj / 2;
+        if (!reset) {
+            // Accumulate session energy in Wh: μJ -> Wh = μJ / 3.6e9
+            state.cumulative_energy_wh += (double)energyDelta / 3600000000.0;
+        }
+        
+        // Filter reasonable power values for display
+        if (!reset && timeDelta < RAPL_MAX_INTERVAL_US && powerWatts < 1000.0) {
+            // Rolling average (last 10 readings) and the longer smoothing horizons, all O(1)
+            state.recent.push(powerWatts);
+            double seconds = (double)timeDelta / 1000000.0;
+            for (size_t w = 0; w < state.ewma.size(); w++) {
+                state.ewma[w].push(powerWatts, seconds);
+                state.boxcar[w].push(currentTime, powerWatts, seconds);
+            }
+            double avgPower = state.recent.mean();
             
-            if (fileExists(namePath) && fileExists(energyPath)) {
-                std::string name = readFile(namePath);
-                std::string energyStr = readFile(energyPath);
-                
-                if (!name.empty() && !energyStr.empty()) {
-                    if (name.back() == '\n') name.pop_back();
-                    
-                    uint64_t energy = std::stoull(energyStr);
-                    
-                    // Initialize if first time
-                    if (previous_energy_.find(name) == previous_energy_.end()) {
-                        previous_energy_[name] = energy;
-                        previous_time_[name] = currentTime;
-                        power_readings_[name] = std::vector<double>();
-                        min_power_[name] = 0.0;
-                        max_power_[name] = 0.0;
-                        sum_power_[name] = 0.0;
-                        count_power_[name] = 0;
-                        cumulative_energy_wh_[name] = 0.0; // Initialize cumulative energy
-                        // Return initial state with zero cumulative energy
-                        PowerData power;
-                        power.name = name;
-                        power.power = 0.0;
-                        power.energy = (double)energy / 1000000.0; // Convert to joules
-                        power.min_power = 0.0;
-                        power.max_power = 0.0;
-                        power.avg_power = 0.0;
-                        power.total_wh = 0.0;
-                        power.total_kwh = 0.0;
-                        powerData.push_back(power);
-                        continue;
-                    }
-                    
-                    // Calculate power
-                    uint64_t timeDelta = currentTime - previous_time_[name];
-                    uint64_t energyDelta = energy - previous_energy_[name];
-                    
-                    // Handle energy counter overflow (32-bit counter wraps around at ~2^32)
-                    const uint64_t MAX_ENERGY = 1ULL << 32;
-                    if (energyDelta > MAX_ENERGY / 2) {
-                        energyDelta = energy + (MAX_ENERGY - previous_energy_[name]);
-                    }
-                    
-                    double powerWatts = 0.0;
-                    double avgPower = 0.0;
-                    
-                    if (timeDelta > 0) {
-                        // Convert microjoules and microseconds to watts:
-                        // Power (W) = Energy (J) / Time (s)
-                        // Power (W) = (Energy (μJ) / 1,000,000) / (Time (μs) / 1,000,000)
-                        // Power (W) = Energy (μJ) / Time (μs) * (1,000,000 / 1,000,000)
-                        // Power (W) = Energy (μJ) / Time (μs)
-                        powerWatts = (double)energyDelta / (double)timeDelta;
-                    }
-                    
-                    // Always accumulate energy if timeDelta is reasonable (regardless of power filter)
-                    // Energy counter is accurate even if power calculation looks suspicious
-                    // Note: energyDelta is unsigned, so >= 0 is always true, but checking anyway for clarity
-                    if (timeDelta > 100000 && timeDelta < 10000000) {
-                        // Accumulate session energy in Wh: μJ -> Wh = μJ / 3.6e9
-                        double whDelta = (double)energyDelta / 3600000000.0;
-                        cumulative_energy_wh_[name] += whDelta;
-                    }
-                    
-                    // Filter reasonable power values for display
-                    if (timeDelta > 100000 && timeDelta < 10000000 && // 0.1-10 seconds
-                        powerWatts >= 0.0 && powerWatts < 1000.0) {
-                        
-                        // Store reading
-                        power_readings_[name].push_back(powerWatts);
-                        if (power_readings_[name].size() > 100) {
-                            power_readings_[name].erase(power_readings_[name].begin());
-                        }
-                        
-                        // Calculate rolling average (last 10 readings)
-                        int count = std::min(10, (int)power_readings_[name].size());
-                        for (int i = std::max(0, (int)power_readings_[name].size() - count); 
-                             i < (int)power_readings_[name].size(); i++) {
-                            avgPower += power_readings_[name][i];
-                        }
-                        avgPower /= count;
-                        
-                        // Update statistics
-                        if (min_power_[name] == 0.0 || avgPower < min_power_[name]) {
-                            min_power_[name] = avgPower;
-                        }
-                        if (avgPower > max_power_[name]) {
-                            max_power_[name] = avgPower;
-                        }
-                        sum_power_[name] += avgPower;
-                        count_power_[name]++;
-                    } else {
-                        // Use last valid power reading if available
-                        if (!power_readings_[name].empty()) {
-                            int count = std::min(10, (int)power_readings_[name].size());
-                            for (int i = std::max(0, (int)power_readings_[name].size() - count); 
-                                 i < (int)power_readings_[name].size(); i++) {
-                                avgPower += power_readings_[name][i];
-                            }
-                            avgPower /= count;
-                        }
-                    }
-
-                    PowerData power;
-                    power.name = name;
-                    power.power = avgPower;
-                    power.energy = (double)energy / 1000000.0; // Convert to joules
-                    power.min_power = min_power_[name];
-                    power.max_power = max_power_[name];
-                    power.avg_power = (count_power_[name] > 0) ? sum_power_[name] / count_power_[name] : 0.0;
-                    power.total_wh = cumulative_energy_wh_[name];
-                    power.total_kwh = cumulative_energy_wh_[name] / 1000.0;
-                    powerData.push_back(power);
-                    
-                    // Update previous values
-                    previous_energy_[name] = energy;
-                    previous_time_[name] = currentTime;
-                }
+            // Update statistics
+            if (state.min_power == 0.0 || avgPower < state.min_power) {
+                state.min_power = avgPower;
+            }
+            if (avgPower > state.max_power) {
+                state.max_power = avgPower;
             }
+            state.sum_power += avgPower;
+            state.count_power++;
         }
+        
+        state.previous_energy = energy;
+        state.previous_time = currentTime;
     }
     
-    return powerData;
+    // Falls back to the last valid rolling average when this reading was filtered
+    power.power = state.recent.mean();
+    power.min_power = state.min_power;
+    power.max_power = state.max_power;
+    power.avg_power = (state.count_power > 0) ? state.sum_power / state.count_power : 0.0;
+    power.total_wh = state.cumulative_energy_wh;
+    power.total_kwh = state.cumulative_energy_wh / 1000.0;
+    power.ewma_power.resize(state.ewma.size());
+    power.boxcar_power.resize(state.boxcar.size());
+    for (size_t w = 0; w < state.ewma.size(); w++) {
+        power.ewma_power[w] = state.ewma[w].value();
+        power.boxcar_power[w] = state.boxcar[w].mean();
+    }
 }
 
 uint64_t SystemMonitor::getCurrentTimeMicroseconds() {
@@ -376,7 +1211,23 @@ bool SystemMonitor::getBatteryCalculated(
     double& estimated_hours,
     std::string& derived_state
 ) {
-    const std::string baseDir = "/sys/class/power_supply";
+    std::lock_guard<std::mutex> lock(mutex_);
+    return readBatteryLocked(status, ac_connected, voltage_v, current_a, power_w,
+                             energy_now_wh, energy_full_wh, estimated_hours, derived_state);
+}
+
+bool SystemMonitor::readBatteryLocked(
+    std::string& status,
+    bool& ac_connected,
+    double& voltage_v,
+    double& current_a,
+    double& power_w,
+    double& energy_now_wh,
+    double& energy_full_wh,
+    double& estimated_hours,
+    std::string& derived_state
+) {
+    const std::string baseDir = root_ + "/sys/class/power_supply";
     if (!fileExists(baseDir)) return false;
     auto entries = readDirectory(baseDir);
     std::string batName;
@@ -463,55 +1314,909 @@ bool SystemMonitor::getBatteryCalculated(
     return true;
 }
 
+// Battery fields appended after the per-sensor groups in every snapshot
+static const char* const BATTERY_SNAPSHOT_FIELDS[][2] = {
+    { "acConnected", "bool" },
+    { "state", "enum" },        // 0 unknown, 1 charging, 2 discharging, 3 full, 4 idle
+    { "voltage", "V" },
+    { "current", "A" },
+    { "powerWatts", "W" },
+    { "energyNowWh", "Wh" },
+    { "energyFullWh", "Wh" },
+    { "estimatedHours", "h" },
+};
+static const size_t BATTERY_SNAPSHOT_FIELD_COUNT = sizeof(BATTERY_SNAPSHOT_FIELDS) / sizeof(BATTERY_SNAPSHOT_FIELDS[0]);
+static const size_t BATTERY_POWER_FIELD = 4;
+
+// Per-domain RAPL fields, in snapshot order
+static const char* const RAPL_SNAPSHOT_FIELDS[][2] = {
+    { "power", "W" },
+    { "energy", "J" },
+    { "min", "W" },
+    { "max", "W" },
+    { "avg", "W" },
+    { "totalWh", "Wh" },
+};
+
+// Snapshot field label for a power window, e.g. "ewma10s"
+static std::string powerWindowLabel(const char* kind, double seconds) {
+    char label[32];
+    snprintf(label, sizeof(label), "%s%gs", kind, seconds);
+    return label;
+}
+
+static double batteryStateCode(const std::string& state) {
+    if (state == "charging") return 1.0;
+    if (state == "discharging") return 2.0;
+    if (state == "full") return 3.0;
+    if (state == "idle") return 4.0;
+    return 0.0;
+}
+
+std::vector<SnapshotField> SystemMonitor::getSnapshotSchema(uint64_t& version) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    version = table_generation_;
+    return snapshotSchemaLocked(*table);
+}
+
+std::vector<SnapshotField> SystemMonitor::snapshotSchemaLocked(const SensorTable& table) {
+    std::vector<SnapshotField> fields;
+    auto addGroup = [&fields](const char* group, const std::vector<SensorDescriptor>& descs, const char* unit) {
+        for (const auto& desc : descs) {
+            fields.push_back(SnapshotField{ group, desc.name, desc.label, unit });
+        }
+    };
+    addGroup("cpufreq", table.cpu_freq, "MHz");
+    addGroup("cpu", table.cpu_temps, "C");
+    addGroup("ddr5", table.ddr5_temps, "C");
+    for (const auto& desc : table.rapl) {
+        for (const auto& field : RAPL_SNAPSHOT_FIELDS) {
+            fields.push_back(SnapshotField{ "rapl", desc.name, field[0], field[1] });
+        }
+        for (double seconds : power_windows_) {
+            fields.push_back(SnapshotField{ "rapl", desc.name, powerWindowLabel("ewma", seconds), "W" });
+        }
+        for (double seconds : power_windows_) {
+            fields.push_back(SnapshotField{ "rapl", desc.name, powerWindowLabel("boxcar", seconds), "W" });
+        }
+    }
+    for (const auto& field : BATTERY_SNAPSHOT_FIELDS) {
+        fields.push_back(SnapshotField{ "battery", "battery", field[0], field[1] });
+    }
+    return fields;
+}
+
+uint64_t SystemMonitor::snapshot(std::vector<double>& values, PowerConsumer consumer, uint32_t groups) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const SensorTable> table = ensureSensorTable();
+    snapshotLocked(*table, consumer, groups, values);
+    return table_generation_;
+}
+
+// Groups the running sampler reads come from its latest readings, taken at
+// the cadence it adapted to, rather than from another sysfs sweep
+void SystemMonitor::snapshotLocked(const SensorTable& table, PowerConsumer consumer, uint32_t groups,
+                                   std::vector<double>& values) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    values.clear();
+    uint32_t sampled = sampler_table_.get() == &table ? sampler_active_groups_ : 0;
+    
+    const SensorGroup scalarGroups[] = { SENSOR_GROUP_CPUFREQ, SENSOR_GROUP_CPU_TEMPS, SENSOR_GROUP_DDR5 };
+    const std::vector<SensorDescriptor>* descs[] = { &table.cpu_freq, &table.cpu_temps, &table.ddr5_temps };
+    for (size_t g = 0; g < 3; g++) {
+        if (!(groups & (1u << scalarGroups[g]))) {
+            values.insert(values.end(), descs[g]->size(), nan);
+            continue;
+        }
+        bool cached = (sampled & (1u << scalarGroups[g])) != 0;
+        size_t first = sampler_group_first_[scalarGroups[g]];
+        for (size_t i = 0; i < descs[g]->size(); i++) {
+            const SensorDescriptor& desc = (*descs[g])[i];
+            // Not read yet (or failing): fall back to reading it here
+            double value = cached ? sampler_values_[first + i] : nan;
+            double raw = 0.0;
+            if (std::isnan(value) && readSensorValue(desc.path, raw)) {
+                value = raw * desc.scale;
+            }
+            values.push_back(value);
+        }
+    }
+    
+    const size_t fixedFields = sizeof(RAPL_SNAPSHOT_FIELDS) / sizeof(RAPL_SNAPSHOT_FIELDS[0]);
+    const size_t windowFields = 2 * power_windows_.size();
+    auto appendPower = [&values, nan, this](const PowerData& p) {
+        double fields[] = { p.power, p.energy, p.min_power, p.max_power, p.avg_power, p.total_wh };
+        values.insert(values.end(), fields, fields + sizeof(fields) / sizeof(fields[0]));
+        // Sized to the windows as of the last update; setPowerWindows() may have changed them since
+        for (size_t w = 0; w < power_windows_.size(); w++) {
+            values.push_back(w < p.ewma_power.size() ? p.ewma_power[w] : nan);
+        }
+        for (size_t w = 0; w < power_windows_.size(); w++) {
+            values.push_back(w < p.boxcar_power.size() ? p.boxcar_power[w] : nan);
+        }
+    };
+    if (!(groups & (1u << SENSOR_GROUP_RAPL))) {
+        values.insert(values.end(), table.rapl.size() * (fixedFields + windowFields), nan);
+    } else if (consumer == POWER_CONSUMER_SAMPLER && (sampled & (1u << SENSOR_GROUP_RAPL))) {
+        // Only the sampler's own consumer shares its power; everyone else
+        // keeps separate RAPL state and gets power over its own interval
+        for (size_t i = 0; i < table.rapl.size(); i++) {
+            if (sampler_power_valid_[i]) {
+                appendPower(sampler_power_[i]);
+            } else {
+                values.insert(values.end(), fixedFields + windowFields, nan);
+            }
+        }
+    } else {
+        // readRAPLPowerLocked() keeps table order but skips unreadable domains
+        std::vector<PowerData>& power = snapshot_power_;
+        readRAPLPowerLocked(table, consumer, power);
+        size_t next = 0;
+        for (const auto& desc : table.rapl) {
+            if (next < power.size() && power[next].name == desc.name) {
+                appendPower(power[next++]);
+            } else {
+                values.insert(values.end(), fixedFields + windowFields, nan);
+            }
+        }
+    }
+    
+    double battery[BATTERY_SNAPSHOT_FIELD_COUNT];
+    if (!(groups & (1u << SENSOR_GROUP_BATTERY))) {
+        std::fill(battery, battery + BATTERY_SNAPSHOT_FIELD_COUNT, nan);
+    } else if ((sampled & (1u << SENSOR_GROUP_BATTERY)) && sampler_battery_valid_) {
+        std::copy(sampler_battery_.begin(), sampler_battery_.end(), battery);
+    } else {
+        readBatterySnapshotLocked(battery);
+    }
+    values.insert(values.end(), battery, battery + BATTERY_SNAPSHOT_FIELD_COUNT);
+}
+
+// Fills the BATTERY_SNAPSHOT_FIELDS values, all NaN without a battery
+bool SystemMonitor::readBatterySnapshotLocked(double* fields) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::string status, state;
+    bool ac = false;
+    double voltage = nan, current = nan, powerW = nan, energyNow = nan, energyFull = nan, hours = nan;
+    bool hasBattery = readBatteryLocked(status, ac, voltage, current, powerW, energyNow, energyFull, hours, state);
+    double battery[] = { hasBattery ? (ac ? 1.0 : 0.0) : nan, hasBattery ? batteryStateCode(state) : nan,
+                         voltage, current, powerW, energyNow, energyFull, hours };
+    std::copy(battery, battery + BATTERY_SNAPSHOT_FIELD_COUNT, fields);
+    return hasBattery;
+}
+
+int SystemMonitor::registerMetric(const std::string& key) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return registerMetricLocked(key);
+}
+
+int SystemMonitor::registerMetricLocked(const std::string& key) {
+    auto it = metric_ids_.find(key);
+    if (it != metric_ids_.end()) {
+        return it->second;
+    }
+    
+    int id = (int)stats_.names.size();
+    metric_ids_[key] = id;
+    stats_.names.push_back(key);
+    stats_.min_values.push_back(0.0);
+    stats_.max_values.push_back(0.0);
+    stats_.sum_values.push_back(0.0);
+    stats_.count_values.push_back(0.0);
+    stats_.current_values.push_back(0.0);
+    stats_.has_value.push_back(0);
+    stats_.is_power.push_back(key.find("power") != std::string::npos ? 1 : 0);
+    stats_.sketches.push_back(QuantileSketch());
+    return id;
+}
+
 void SystemMonitor::updateStats(const std::string& key, double value) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    updateStatsLocked(registerMetricLocked(key), value, (int64_t)(getCurrentTimeMicroseconds() / 1000));
+}
+
+void SystemMonitor::updateStats(int id, double value) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    updateStatsLocked(id, value, (int64_t)(getCurrentTimeMicroseconds() / 1000));
+}
+
+void SystemMonitor::updateStatsBatch(const int32_t* ids, const double* values, size_t count) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    int64_t now = (int64_t)(getCurrentTimeMicroseconds() / 1000);
+    for (size_t i = 0; i < count; i++) {
+        updateStatsLocked(ids[i], values[i], now);
+    }
+}
+
+void SystemMonitor::updateStatsLocked(int id, double value, int64_t now_ms) {
+    if (id < 0 || (size_t)id >= stats_.names.size()) {
+        return;
+    }
+    
     // Validate value - skip invalid values
-    if (value != value || value == std::numeric_limits<double>::infinity() || value == -std::numeric_limits<double>::infinity()) {
+    if (!std::isfinite(value)) {
         return;
     }
     
     // Additional validation for power values
-    if (key.find("power") != std::string::npos && (value < 0.0 || value > 1000.0)) {
+    if (stats_.is_power[id] && (value < 0.0 || value > 1000.0)) {
         return;
     }
     
     // Update statistics only for valid values
-    if (stats_.min_values.find(key) == stats_.min_values.end() || value < stats_.min_values[key]) {
-        stats_.min_values[key] = value;
+    if (!stats_.has_value[id] || value < stats_.min_values[id]) {
+        stats_.min_values[id] = value;
     }
     
-    if (stats_.max_values.find(key) == stats_.max_values.end() || value > stats_.max_values[key]) {
-        stats_.max_values[key] = value;
+    if (!stats_.has_value[id] || value > stats_.max_values[id]) {
+        stats_.max_values[id] = value;
     }
     
-    stats_.sum_values[key] += value;
-    stats_.count_values[key]++;
-    stats_.valid_count_values[key]++;  // Track valid readings separately
-    stats_.current_values[key] = value;
-    stats_.last_valid_values[key] = value;  // Store as last valid value
+    stats_.sum_values[id] += value;
+    stats_.count_values[id] += 1.0;
+    stats_.current_values[id] = value;
+    stats_.has_value[id] = 1;
+    stats_.sketches[id].add(value);
+    
+    if (history_.isOpen()) {
+        history_.append(historySlotLocked(id), now_ms, value);
+    }
+}
+
+int SystemMonitor::historySlotLocked(int id) {
+    if ((size_t)id >= history_slots_.size()) {
+        history_slots_.resize(stats_.names.size(), HISTORY_SLOT_UNRESOLVED);
+    }
+    if (history_slots_[id] == HISTORY_SLOT_UNRESOLVED) {
+        const std::string& name = stats_.names[id];
+        if (!history_metrics_.empty() && history_metrics_.count(name) == 0) {
+            history_slots_[id] = -1;
+        } else {
+            history_slots_[id] = history_.slot(name);
+            if (history_slots_[id] < 0) {
+                history_refused_.push_back(name); // The file is full
+            }
+        }
+    }
+    return history_slots_[id];
+}
+
+// For queries: a metric that never got a slot stays without one
+int SystemMonitor::findHistorySlotLocked(int id) const {
+    if ((size_t)id < history_slots_.size() && history_slots_[id] != HISTORY_SLOT_UNRESOLVED) {
+        return history_slots_[id];
+    }
+    return history_.find(stats_.names[id]);
+}
+
+bool SystemMonitor::openHistory(const std::string& path, uint32_t max_metrics, const std::vector<std::string>& metrics,
+                                std::string& error) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    history_slots_.assign(stats_.names.size(), HISTORY_SLOT_UNRESOLVED);
+    history_metrics_.clear();
+    history_metrics_.insert(metrics.begin(), metrics.end());
+    history_refused_.clear();
+    if (max_metrics == 0) {
+        max_metrics = (uint32_t)history_metrics_.size();
+    }
+    if (!history_.open(path, max_metrics)) {
+        error = history_.error();
+        return false;
+    }
+    return true;
+}
+
+void SystemMonitor::closeHistory() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    history_.close();
+    history_slots_.clear();
+    history_metrics_.clear();
+}
+
+std::vector<std::string> SystemMonitor::takeHistoryRefused() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    std::vector<std::string> refused;
+    refused.swap(history_refused_);
+    return refused;
+}
+
+bool SystemMonitor::queryHistory(const std::vector<int>& ids, int64_t t0_ms, int64_t t1_ms, size_t max_points,
+                                 std::vector<HistoryRange>& out) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    out.assign(ids.size(), HistoryRange());
+    if (!history_.isOpen()) {
+        return false;
+    }
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (ids[i] >= 0 && (size_t)ids[i] < stats_.names.size()) {
+            history_.query(findHistorySlotLocked(ids[i]), t0_ms, t1_ms, max_points, out[i]);
+        }
+    }
+    return true;
 }
 
-SystemStats SystemMonitor::getStats() {
-    return stats_;
+void SystemMonitor::visitStats(const std::function<void(const SystemStats&)>& visitor) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    visitor(stats_);
 }
 
 void SystemMonitor::resetStats() {
-    stats_.min_values.clear();
-    stats_.max_values.clear();
-    stats_.sum_values.clear();
-    stats_.count_values.clear();
-    stats_.valid_count_values.clear();
-    stats_.current_values.clear();
-    stats_.last_valid_values.clear();
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    // Metric ids stay registered so callers holding them keep working
+    std::fill(stats_.min_values.begin(), stats_.min_values.end(), 0.0);
+    std::fill(stats_.max_values.begin(), stats_.max_values.end(), 0.0);
+    std::fill(stats_.sum_values.begin(), stats_.sum_values.end(), 0.0);
+    std::fill(stats_.count_values.begin(), stats_.count_values.end(), 0.0);
+    std::fill(stats_.current_values.begin(), stats_.current_values.end(), 0.0);
+    std::fill(stats_.has_value.begin(), stats_.has_value.end(), 0);
+    for (auto& sketch : stats_.sketches) {
+        sketch.reset();
+    }
+}
+
+std::vector<double> SystemMonitor::getQuantiles(const std::string& key, const std::vector<double>& quantiles) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    std::vector<double> result(quantiles.size(), std::numeric_limits<double>::quiet_NaN());
+    auto it = metric_ids_.find(key);
+    if (it == metric_ids_.end()) {
+        return result;
+    }
+    
+    QuantileSketch& sketch = stats_.sketches[it->second];
+    for (size_t i = 0; i < quantiles.size(); i++) {
+        result[i] = sketch.quantile(quantiles[i]);
+    }
+    return result;
+}
+
+bool SystemMonitor::exportQuantileSketch(const std::string& key, std::vector<double>& out) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    auto it = metric_ids_.find(key);
+    if (it == metric_ids_.end()) {
+        return false;
+    }
+    stats_.sketches[it->second].serialize(out);
+    return true;
+}
+
+bool SystemMonitor::mergeQuantileSketch(const std::string& key, const double* data, size_t length) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    int id = registerMetricLocked(key);
+    return stats_.sketches[id].deserializeMerge(data, length);
 }
 
 bool SystemMonitor::hasLastValidValue(const std::string& key) {
-    return stats_.last_valid_values.find(key) != stats_.last_valid_values.end();
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    auto it = metric_ids_.find(key);
+    return it != metric_ids_.end() && stats_.has_value[it->second];
 }
 
 double SystemMonitor::getLastValidValue(const std::string& key) {
-    auto it = stats_.last_valid_values.find(key);
-    if (it != stats_.last_valid_values.end()) {
-        return it->second;
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    auto it = metric_ids_.find(key);
+    if (it != metric_ids_.end() && stats_.has_value[it->second]) {
+        return stats_.current_values[it->second];
     }
     return 0.0;
 }
+
+static const char* const SENSOR_GROUP_NAMES[SENSOR_GROUP_COUNT] = { "rapl", "cpu", "ddr5", "cpufreq", "battery" };
+
+// RAPL counters update roughly every millisecond, so 1 kHz is the useful ceiling
+static double clampSamplingRate(double hz) {
+    return std::max(0.1, std::min(hz, 1000.0));
+}
+
+bool SystemMonitor::startSampler(double raplHz, double sensorHz) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    // A sampler that stopped on an error may be started again
+    if (manual_rates_[SENSOR_GROUP_RAPL] > 0.0 && sampler_running_.load()) {
+        return false;
+    }
+    
+    double rapl = clampSamplingRate(std::max(raplHz, 1.0));
+    double sensors = std::min(clampSamplingRate(sensorHz), rapl);
+    manual_rates_[SENSOR_GROUP_RAPL] = rapl;
+    manual_rates_[SENSOR_GROUP_CPU_TEMPS] = sensors;
+    manual_rates_[SENSOR_GROUP_DDR5] = sensors;
+    manual_rates_[SENSOR_GROUP_CPUFREQ] = sensors;
+    std::string error;
+    if (!applySamplingRatesLocked(error)) {
+        std::fill(manual_rates_, manual_rates_ + SENSOR_GROUP_COUNT, 0.0);
+        return false;
+    }
+    return true;
+}
+
+// Only withdraws startSampler()'s rates; subscriptions keep the thread running
+void SystemMonitor::stopSampler() {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    std::fill(manual_rates_, manual_rates_ + SENSOR_GROUP_COUNT, 0.0);
+    std::string error;
+    applySamplingRatesLocked(error);
+}
+
+bool SystemMonitor::parseSensorGroups(const std::vector<std::string>& groups, uint32_t& mask, std::string& error) {
+    mask = 0;
+    for (const auto& name : groups) {
+        const char* const* end = SENSOR_GROUP_NAMES + SENSOR_GROUP_COUNT;
+        const char* const* it = std::find_if(SENSOR_GROUP_NAMES, end, [&name](const char* group) {
+            return name == group;
+        });
+        if (it == end) {
+            error = "Unknown sensor group '" + name + "' (expected rapl, cpu, ddr5, cpufreq or battery)";
+            return false;
+        }
+        mask |= 1u << (it - SENSOR_GROUP_NAMES);
+    }
+    return true;
+}
+
+int SystemMonitor::subscribe(const std::vector<std::string>& groups, double rateHz, std::string& error) {
+    uint32_t mask = 0;
+    if (!parseSensorGroups(groups, mask, error)) {
+        return -1;
+    }
+    if (mask == 0) {
+        error = "No sensor groups to subscribe to";
+        return -1;
+    }
+    if (!(rateHz > 0.0)) {
+        error = "Subscription rate must be positive";
+        return -1;
+    }
+    
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    int id = next_subscription_id_++;
+    subscriptions_[id] = Subscription{ mask, clampSamplingRate(rateHz) };
+    if (!applySamplingRatesLocked(error)) {
+        subscriptions_.erase(id);
+        return -1;
+    }
+    return id;
+}
+
+bool SystemMonitor::unsubscribe(int id) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    if (subscriptions_.erase(id) == 0) {
+        return false;
+    }
+    std::string error;
+    applySamplingRatesLocked(error);
+    return true;
+}
+
+std::map<std::string, double> SystemMonitor::getSamplingRates() {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    double rates[SENSOR_GROUP_COUNT];
+    computeSamplingRatesLocked(rates);
+    std::map<std::string, double> out;
+    for (int g = 0; g < SENSOR_GROUP_COUNT; g++) {
+        out[SENSOR_GROUP_NAMES[g]] = rates[g];
+    }
+    return out;
+}
+
+void SystemMonitor::computeSamplingRatesLocked(double rates[SENSOR_GROUP_COUNT]) {
+    std::copy(manual_rates_, manual_rates_ + SENSOR_GROUP_COUNT, rates);
+    for (const auto& entry : subscriptions_) {
+        for (int g = 0; g < SENSOR_GROUP_COUNT; g++) {
+            if (entry.second.groups & (1u << g)) {
+                rates[g] = std::max(rates[g], entry.second.rate_hz);
+            }
+        }
+    }
+}
+
+// Hands the new rates to the sampler thread, starting it for the first
+// sampled group (or restarting it after an error) and joining it once no
+// group is sampled. False, with error, if the thread could not be started.
+bool SystemMonitor::applySamplingRatesLocked(std::string& error) {
+    double rates[SENSOR_GROUP_COUNT];
+    computeSamplingRatesLocked(rates);
+    if (std::all_of(rates, rates + SENSOR_GROUP_COUNT, [](double hz) { return hz <= 0.0; })) {
+        joinSamplerThread();
+        return true;
+    }
+    if (sampler_thread_.joinable() && !sampler_running_.load()) {
+        joinSamplerThread();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        std::copy(rates, rates + SENSOR_GROUP_COUNT, sampler_group_hz_);
+        sampler_rates_changed_ = true;
+        if (!sampler_thread_.joinable()) {
+            sampler_stop_ = false;
+        }
+    }
+    if (sampler_thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t ignored = write(sampler_wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        return true;
+    }
+    
+    // Opened here rather than on the thread so a failure reaches the caller
+    if (!sampler_scheduler_.open()) {
+        error = sampler_scheduler_.error();
+    } else {
+        sampler_wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (sampler_wake_fd_ < 0) {
+            error = std::string("cannot create eventfd: ") + std::strerror(errno);
+            sampler_scheduler_.close();
+        }
+    }
+    std::lock_guard<std::mutex> lock(sampler_mutex_);
+    if (sampler_wake_fd_ < 0) {
+        sampler_error_ = error;
+        return false;
+    }
+    sampler_error_.clear();
+    sampler_running_.store(true);
+    sampler_thread_ = std::thread(&SystemMonitor::samplerLoop, this);
+    return true;
+}
+
+void SystemMonitor::joinSamplerThread() {
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        sampler_stop_ = true;
+    }
+    if (sampler_thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t ignored = write(sampler_wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        sampler_thread_.join();
+    }
+    if (sampler_wake_fd_ >= 0) {
+        close(sampler_wake_fd_);
+        sampler_wake_fd_ = -1;
+    }
+    sampler_scheduler_.close();
+    sampler_running_.store(false);
+}
+
+bool SystemMonitor::isSamplerRunning() {
+    return sampler_running_.load();
+}
+
+std::string SystemMonitor::getSamplerError() {
+    std::lock_guard<std::mutex> lock(sampler_mutex_);
+    return sampler_error_;
+}
+
+std::vector<std::string> SystemMonitor::getSamplerChannels(uint64_t& generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation = sampler_generation_.load();
+    return sampler_channels_;
+}
+
+std::vector<double> SystemMonitor::getSamplerCadence(uint64_t& generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation = sampler_generation_.load();
+    if (!sampler_running_.load()) {
+        return std::vector<double>(sampler_cadence_hz_.size(), 0.0);
+    }
+    return sampler_cadence_hz_;
+}
+
+uint64_t SystemMonitor::readSamples(uint64_t sinceSeq, size_t maxRecords, std::vector<SampleRecord>& out, uint64_t& generation) {
+    // Lock-free: readers never contend with the sampler or with each other
+    generation = sampler_generation_.load(std::memory_order_acquire);
+    return sample_ring_.read(sinceSeq, maxRecords, out);
+}
+
+bool SystemMonitor::openSharedSnapshot(const std::string& name, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!shm_.open(name, ShmSnapshotWriter::DEFAULT_MAX_FIELDS, ShmSnapshotWriter::DEFAULT_RING_CAPACITY)) {
+            error = shm_.error();
+            return false;
+        }
+        shm_schema_version_ = 0;
+        shm_channels_generation_ = 0;
+    }
+    
+    // A running sampler may be asleep with no publish deadline armed
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    if (sampler_wake_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(sampler_wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+    return true;
+}
+
+void SystemMonitor::closeSharedSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shm_.close();
+}
+
+// The scheduler's timerfd says when channels are due; the eventfd wakes the
+// loop for rate changes and shutdown. Nothing else runs on this thread.
+// On a poll error the thread records it and exits; the next start or
+// subscription change restarts it.
+void SystemMonitor::samplerLoop() {
+    SensorScheduler& scheduler = sampler_scheduler_;
+    double rates[SENSOR_GROUP_COUNT] = {};
+    std::vector<uint32_t> due;
+    std::shared_ptr<const SensorTable> layout;
+    while (true) {
+        bool ratesChanged = false;
+        {
+            std::lock_guard<std::mutex> lock(sampler_mutex_);
+            if (sampler_stop_) {
+                break;
+            }
+            if (sampler_rates_changed_) {
+                sampler_rates_changed_ = false;
+                std::copy(sampler_group_hz_, sampler_group_hz_ + SENSOR_GROUP_COUNT, rates);
+                ratesChanged = true;
+            }
+        }
+        
+        uint64_t now = SensorScheduler::monotonicMicroseconds();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::shared_ptr<const SensorTable> table = ensureSensorTable();
+            if (table != sampler_table_) {
+                sampler_table_ = table;
+                rebuildSamplerChannelsLocked(*table);
+            }
+            if (sampler_table_ != layout) {
+                layout = sampler_table_;
+                scheduler.resize(sampler_channels_.size());
+                ratesChanged = true;
+            }
+            if (ratesChanged) {
+                applyCadenceLocked(scheduler, rates, now);
+            }
+        }
+        
+        scheduler.collectDue(now, due);
+        if (!due.empty()) {
+            sampleChannels(scheduler, due, now);
+        }
+        
+        // The shared snapshot keeps the fastest sensor group's rate however
+        // far individual channels have backed off
+        uint64_t publishAt = std::numeric_limits<uint64_t>::max();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (shm_.isOpen() && sampler_publish_period_us_ > 0) {
+                if (now >= sampler_next_publish_us_) {
+                    publishSharedSnapshotLocked(*sampler_table_, getCurrentTimeMicroseconds());
+                    sampler_next_publish_us_ = now + sampler_publish_period_us_;
+                }
+                publishAt = sampler_next_publish_us_;
+            }
+        }
+        scheduler.arm(publishAt);
+        
+        struct pollfd fds[2];
+        fds[0].fd = scheduler.fd();
+        fds[0].events = POLLIN;
+        fds[1].fd = sampler_wake_fd_;
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+            std::lock_guard<std::mutex> lock(sampler_mutex_);
+            sampler_error_ = std::string("sampler poll failed: ") + std::strerror(errno);
+            break;
+        }
+        if ((fds[0].revents | fds[1].revents) & (POLLERR | POLLNVAL)) {
+            std::lock_guard<std::mutex> lock(sampler_mutex_);
+            sampler_error_ = "sampler wakeup descriptor failed";
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t count = 0;
+            ssize_t ignored = read(sampler_wake_fd_, &count, sizeof(count));
+            (void)ignored;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sampler_active_groups_ = 0;
+    }
+    sampler_running_.store(false);
+}
+
+// Channel layout: RAPL domains (W), CPU temps, DDR5 temps (°C), CPU frequencies (MHz), battery power (W)
+void SystemMonitor::rebuildSamplerChannelsLocked(const SensorTable& table) {
+    sampler_channels_.clear();
+    sampler_channel_group_.clear();
+    sampler_channel_index_.clear();
+    sampler_channel_limit_.clear();
+    
+    auto add = [this](const std::string& name, SensorGroup group, size_t index, double limit) {
+        sampler_channels_.push_back(name);
+        sampler_channel_group_.push_back((uint8_t)group);
+        sampler_channel_index_.push_back((uint32_t)index);
+        sampler_channel_limit_.push_back(limit);
+    };
+    // hwmon publishes the trip point next to the reading; crit wins over max
+    auto temperatureLimit = [this](const SensorDescriptor& desc) {
+        const std::string suffix = "_input";
+        if (desc.path.size() > suffix.size() &&
+            desc.path.compare(desc.path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            std::string base = desc.path.substr(0, desc.path.size() - suffix.size());
+            double raw = 0.0;
+            if ((readSensorValue(base + "_crit", raw) || readSensorValue(base + "_max", raw)) && raw > 0.0) {
+                return raw * desc.scale;
+            }
+        }
+        return std::numeric_limits<double>::quiet_NaN();
+    };
+    
+    const double none = std::numeric_limits<double>::quiet_NaN();
+    sampler_group_first_[SENSOR_GROUP_RAPL] = sampler_channels_.size();
+    for (size_t i = 0; i < table.rapl.size(); i++) {
+        add("rapl:" + table.rapl[i].name, SENSOR_GROUP_RAPL, i, none);
+    }
+    sampler_group_first_[SENSOR_GROUP_CPU_TEMPS] = sampler_channels_.size();
+    for (size_t i = 0; i < table.cpu_temps.size(); i++) {
+        const SensorDescriptor& desc = table.cpu_temps[i];
+        add("cpu:" + desc.name + "/" + desc.label, SENSOR_GROUP_CPU_TEMPS, i, temperatureLimit(desc));
+    }
+    sampler_group_first_[SENSOR_GROUP_DDR5] = sampler_channels_.size();
+    for (size_t i = 0; i < table.ddr5_temps.size(); i++) {
+        const SensorDescriptor& desc = table.ddr5_temps[i];
+        add("ddr5:" + desc.name + "/" + desc.label, SENSOR_GROUP_DDR5, i, temperatureLimit(desc));
+    }
+    sampler_group_first_[SENSOR_GROUP_CPUFREQ] = sampler_channels_.size();
+    for (size_t i = 0; i < table.cpu_freq.size(); i++) {
+        add("cpufreq:" + table.cpu_freq[i].name, SENSOR_GROUP_CPUFREQ, i, none);
+    }
+    sampler_group_first_[SENSOR_GROUP_BATTERY] = sampler_channels_.size();
+    add("battery:powerWatts", SENSOR_GROUP_BATTERY, 0, none);
+    
+    sampler_cadence_hz_.assign(sampler_channels_.size(), 0.0);
+    sampler_values_.assign(sampler_channels_.size(), none);
+    sampler_power_.resize(table.rapl.size());
+    sampler_power_valid_.assign(table.rapl.size(), 0);
+    sampler_battery_.assign(BATTERY_SNAPSHOT_FIELD_COUNT, none);
+    sampler_battery_valid_ = false;
+    sampler_prev_energy_.assign(table.rapl.size(), 0);
+    sampler_prev_time_.assign(table.rapl.size(), 0);
+    sampler_generation_.fetch_add(1, std::memory_order_release);
+}
+
+// Slowest adaptive period, as a multiple of the subscribed one and absolute
+static const double CADENCE_MAX_BACKOFF = 16.0;
+static const double CADENCE_MAX_PERIOD_S = 5.0;
+
+void SystemMonitor::applyCadenceLocked(SensorScheduler& scheduler, const double rates[SENSOR_GROUP_COUNT], uint64_t now_us) {
+    for (uint32_t channel = 0; channel < sampler_channels_.size(); channel++) {
+        SensorGroup group = (SensorGroup)sampler_channel_group_[channel];
+        double hz = rates[group];
+        
+        CadencePolicy policy;
+        policy.min_period_s = hz > 0.0 ? 1.0 / hz : 0.0;
+        policy.max_period_s = std::max(policy.min_period_s,
+                                       std::min(policy.min_period_s * CADENCE_MAX_BACKOFF, CADENCE_MAX_PERIOD_S));
+        policy.limit = sampler_channel_limit_[channel];
+        policy.near_limit = 0.0;
+        switch (group) {
+            case SENSOR_GROUP_CPU_TEMPS:
+            case SENSOR_GROUP_DDR5:
+                policy.steady_delta = 0.5; // °C; hwmon mostly reports whole degrees
+                policy.rapid_delta = 3.0;
+                policy.near_limit = 5.0;
+                break;
+            case SENSOR_GROUP_CPUFREQ:
+                policy.steady_delta = 100.0; // MHz
+                policy.rapid_delta = 500.0;
+                break;
+            case SENSOR_GROUP_BATTERY:
+                policy.steady_delta = 0.1; // W
+                policy.rapid_delta = 2.0;
+                break;
+            default:
+                // RAPL power is a rate over the read interval; it keeps a fixed cadence
+                policy.max_period_s = policy.min_period_s;
+                policy.steady_delta = 0.0;
+                policy.rapid_delta = 0.0;
+                break;
+        }
+        scheduler.setPolicy(channel, policy, now_us);
+        sampler_cadence_hz_[channel] = scheduler.rateHz(channel);
+    }
+    
+    sampler_active_groups_ = 0;
+    for (int g = 0; g < SENSOR_GROUP_COUNT; g++) {
+        if (rates[g] > 0.0) {
+            sampler_active_groups_ |= 1u << g;
+        }
+    }
+    double fastestSensorHz = *std::max_element(rates + SENSOR_GROUP_RAPL + 1, rates + SENSOR_GROUP_COUNT);
+    sampler_publish_period_us_ = fastestSensorHz > 0.0 ? (uint64_t)(1e6 / fastestSensorHz) : 0;
+    sampler_next_publish_us_ = 0;
+}
+
+void SystemMonitor::sampleChannels(SensorScheduler& scheduler, const std::vector<uint32_t>& due, uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SensorTable& table = *sampler_table_;
+    uint64_t timestamp = getCurrentTimeMicroseconds();
+    
+    for (uint32_t channel : due) {
+        SensorGroup group = (SensorGroup)sampler_channel_group_[channel];
+        uint32_t index = sampler_channel_index_[channel];
+        double value = 0.0;
+        bool ok = false;
+        switch (group) {
+            case SENSOR_GROUP_RAPL: {
+                uint64_t energy = 0;
+                if (!readRAPLEnergy(table, index, energy)) {
+                    break;
+                }
+                updateRAPLPowerLocked(table, POWER_CONSUMER_SAMPLER, index, energy, timestamp, sampler_power_[index]);
+                sampler_power_valid_[index] = 1;
+                if (sampler_prev_time_[index] != 0 && timestamp > sampler_prev_time_[index]) {
+                    uint64_t delta = wrappedEnergyDelta(sampler_prev_energy_[index], energy, table.rapl_zones[index].max_energy_uj);
+                    // μJ / μs = W, averaged since this domain was last sampled
+                    double watts = (double)delta / (double)(timestamp - sampler_prev_time_[index]);
+                    sample_ring_.push(timestamp, channel, watts);
+                    shm_.pushSample(timestamp, channel, watts);
+                }
+                sampler_prev_energy_[index] = energy;
+                sampler_prev_time_[index] = timestamp;
+                scheduler.report(channel, 0.0, now_us);
+                continue;
+            }
+            case SENSOR_GROUP_CPU_TEMPS:
+            case SENSOR_GROUP_DDR5:
+            case SENSOR_GROUP_CPUFREQ: {
+                const std::vector<SensorDescriptor>& descs = group == SENSOR_GROUP_CPUFREQ ? table.cpu_freq :
+                                                             group == SENSOR_GROUP_DDR5 ? table.ddr5_temps : table.cpu_temps;
+                const SensorDescriptor& desc = descs[index];
+                double raw = 0.0;
+                if (readSensorValue(desc.path, raw)) {
+                    value = raw * desc.scale;
+                    ok = true;
+                }
+                break;
+            }
+            case SENSOR_GROUP_BATTERY: {
+                sampler_battery_valid_ = readBatterySnapshotLocked(sampler_battery_.data());
+                value = sampler_battery_[BATTERY_POWER_FIELD];
+                ok = sampler_battery_valid_ && !std::isnan(value);
+                break;
+            }
+            default:
+                break;
+        }
+        
+        sampler_values_[channel] = ok ? value : std::numeric_limits<double>::quiet_NaN();
+        if (ok) {
+            sample_ring_.push(timestamp, channel, value);
+            shm_.pushSample(timestamp, channel, value);
+            scheduler.report(channel, value, now_us);
+        } else {
+            scheduler.reportMissing(channel, now_us);
+        }
+        sampler_cadence_hz_[channel] = scheduler.rateHz(channel);
+    }
+}
+
+void SystemMonitor::publishSharedSnapshotLocked(const SensorTable& table, uint64_t now_us) {
+    // Text blocks are only rewritten when the topology they describe changes
+    if (shm_schema_version_ != table_generation_) {
+        std::vector<std::string> rows;
+        for (const auto& field : snapshotSchemaLocked(table)) {
+            rows.push_back(field.group + "\t" + field.name + "\t" + field.label + "\t" + field.unit);
+        }
+        shm_.publishSchema(table_generation_, rows);
+        shm_schema_version_ = table_generation_;
+    }
+    uint64_t generation = sampler_generation_.load(std::memory_order_relaxed);
+    if (shm_channels_generation_ != generation) {
+        shm_.publishChannels(generation, sampler_channels_);
+        shm_channels_generation_ = generation;
+    }
+    
+    // Only what the sampler itself reads; other groups would cost a sysfs sweep per publish
+    snapshotLocked(table, POWER_CONSUMER_SAMPLER, sampler_active_groups_, shm_values_);
+    shm_.publishSnapshot(table_generation_, now_us, shm_values_.data(), shm_values_.size());
+}
@@ -5,12 +5,51 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <sys/types.h>
+#include "sample_ring.h"
+#include "quantile_sketch.h"
+#include "rolling_window.h"
+#include "perf_counters.h"
+#include "io_rates.h"
+#include "gpu_monitor.h"
+#include "disk_health.h"
+#include "session_log.h"
+#include "history_store.h"
+#include "shm_snapshot.h"
+#include "sensor_scheduler.h"
+#include "process_table.h"
 
 // Core data structures
 struct CoreData {
+    int cpu;
     double load;
     double frequency;
     double temperature;
+    // Hardware counters since the previous call; NaN unless enableHardwareCounters() succeeded
+    double ipc;
+    double cache_miss_rate;
+    double branch_miss_rate;
+    double effective_frequency; // MHz, from APERF/MPERF and the base frequency
+};
+
+// CPU time split over the interval since the previous /proc/stat read, in percent
+struct CPULoad {
+    int cpu;        // -1 for the all-CPU aggregate
+    double load;    // 100 - idle - iowait
+    double user;    // Includes nice
+    double system;
+    double idle;
+    double iowait;
+    double irq;     // Includes softirq
+    double steal;
 };
 
 struct SensorData {
@@ -20,8 +59,47 @@ struct SensorData {
     std::string type;
 };
 
+// A sensor found during discovery; hot polls only read `path` and apply `scale`
+struct SensorDescriptor {
+    std::string name;
+    std::string label;
+    std::string path;
+    double scale;
+    std::string type;
+};
+
+// RAPL zone metadata, index-aligned with SensorTable::rapl
+struct RAPLZone {
+    std::string id;          // Powercap zone ("intel-rapl:0:1") or "msr:<cpu>:<reg>"
+    std::string parent;      // Domain name of the enclosing zone, empty for top-level zones
+    uint64_t max_energy_uj;  // Counter range; readings wrap back to zero past this
+    uint32_t msr;            // Energy status register for the MSR fallback, 0 for powercap
+    double msr_unit_uj;      // Microjoules per MSR count
+};
+
+// Immutable sensor topology, rebuilt on initialize()/rescan() or hotplug events
+struct SensorTable {
+    std::vector<SensorDescriptor> cpu_freq;
+    std::vector<int> cpu_ids;          // Index-aligned with cpu_freq
+    std::vector<double> cpu_base_mhz;  // Non-turbo frequency MPERF ticks at, 0 if unknown
+    std::vector<SensorDescriptor> cpu_temps;
+    std::vector<SensorDescriptor> ddr5_temps;
+    std::vector<SensorDescriptor> rapl;
+    std::vector<RAPLZone> rapl_zones;
+};
+
+// One slot of the flat snapshot() layout; names are fetched once via getSnapshotSchema()
+struct SnapshotField {
+    std::string group;
+    std::string name;
+    std::string label;
+    std::string unit;
+};
+
 struct PowerData {
     std::string name;
+    std::string zone;
+    std::string parent; // Empty for top-level domains
     double power;
     double energy;
     double min_power;
@@ -29,30 +107,117 @@ struct PowerData {
     double avg_power;
     double total_wh;
     double total_kwh;
+    std::vector<double> ewma_power;   // One per configured power window
+    std::vector<double> boxcar_power; // One per configured power window
+};
+
+// Readers that keep their own RAPL power state. Within one, readers share a
+// reading: the state only advances once RAPL_MIN_INTERVAL_US has passed, so
+// overlapping callers never cut each other's intervals short.
+enum PowerConsumer {
+    POWER_CONSUMER_UI,      // JS getters, snapshot() and the snapshot stream
+    POWER_CONSUMER_SAMPLER, // Shared-memory snapshots published by the sampler thread
+    POWER_CONSUMER_METRICS, // OpenMetrics scrapes
+    POWER_CONSUMER_COUNT
+};
+
+// Per-RAPL-domain power calculation state
+struct RAPLDomainState {
+    uint64_t previous_energy;
+    uint64_t previous_time;
+    RollingWindow recent;             // Last 10 valid readings (displayed power)
+    std::vector<TimeEWMA> ewma;
+    std::vector<TimeWindow> boxcar;
+    double min_power;
+    double max_power;
+    double sum_power;
+    int count_power;
+    double cumulative_energy_wh;
+    
+    RAPLDomainState() : previous_energy(0), previous_time(0), recent(10), min_power(0.0), max_power(0.0),
+                        sum_power(0.0), count_power(0), cumulative_energy_wh(0.0) {}
 };
 
+// Column-oriented statistics; index i of every column belongs to metric id i
 struct SystemStats {
-    std::map<std::string, double> min_values;
-    std::map<std::string, double> max_values;
-    std::map<std::string, double> sum_values;
-    std::map<std::string, int> count_values;
-    std::map<std::string, int> valid_count_values;  // Track only valid readings
-    std::map<std::string, double> current_values;
-    std::map<std::string, double> last_valid_values;  // Store last valid values for persistence
+    std::vector<std::string> names;
+    std::vector<double> min_values;
+    std::vector<double> max_values;
+    std::vector<double> sum_values;
+    std::vector<double> count_values;   // Valid readings only
+    std::vector<double> current_values; // Also the last valid value, for persistence
+    std::vector<uint8_t> has_value;
+    std::vector<uint8_t> is_power;      // Power metrics are range-checked to 0-1000 W
+    std::vector<QuantileSketch> sketches;
+};
+
+// Groups the background sampler can read, named like their snapshot groups
+enum SensorGroup {
+    SENSOR_GROUP_RAPL,      // "rapl"
+    SENSOR_GROUP_CPU_TEMPS, // "cpu"
+    SENSOR_GROUP_DDR5,      // "ddr5"
+    SENSOR_GROUP_CPUFREQ,   // "cpufreq"
+    SENSOR_GROUP_BATTERY,   // "battery"
+    SENSOR_GROUP_COUNT
 };
+const uint32_t SENSOR_GROUPS_ALL = (1u << SENSOR_GROUP_COUNT) - 1;
 
 // Main class for system monitoring
 class SystemMonitor {
 public:
-    SystemMonitor();
+    // root prefixes every /sys, /proc and /dev path, so tests and benchmarks
+    // can point the monitor at a synthetic tree; empty reads the real system
+    explicit SystemMonitor(const std::string& root = "");
     ~SystemMonitor();
     
+    // Sensor discovery
+    void initialize();
+    void rescan();
+    
     // Core functions
     std::vector<CoreData> getCPUCores();
+    // Per-CPU perf_event counter groups for getCPUCores(); returns CPUs opened (0 = unavailable)
+    int enableHardwareCounters(bool enable);
+    // Aggregate load first, then one entry per online CPU
+    std::vector<CPULoad> getCPULoad();
+    // Disk/network rate rows (see io_rates.h) in stable device-index order; returns the layout version
+    uint64_t readIORates(std::vector<double>& values);
+    // stacked[i] is set for disks[i] built on other disks (dm, md), whose I/O those already count
+    uint64_t getIODevices(std::vector<std::string>& disks, std::vector<bool>& stacked,
+                          std::vector<std::string>& interfaces);
+    // Drops the MIN_RATE_INTERVAL_US reuse so the next CPU load, I/O rate and
+    // process sweep re-read; for the bench, which calls back to back
+    void expireRateCaches();
+    // NVIDIA (NVML) then AMD (amdgpu sysfs) GPUs; the backend is loaded on first use
+    std::vector<GPUData> getGPUs();
+    std::string getGPUBackend();
+    // SMART / NVMe health via ioctl; re-reads only when the cache is older than max_age_ms
+    std::vector<DiskHealthData> getDiskHealth(uint64_t max_age_ms);
+    // Heaviest processes by CPU, RSS or I/O rate; each call advances the
+    // incremental /proc sweep (see process_table.h)
+    std::vector<ProcessInfo> getTopProcesses(ProcessSortKey key, size_t count);
+    // RAPL energy charged to processes (or cgroups) by CPU time, heaviest first;
+    // domains receives the names ProcessEnergy::domain_joules is aligned with
+    std::vector<ProcessEnergy> getEnergyByProcess(size_t count, std::vector<std::string>& domains);
+    std::vector<ProcessEnergy> getEnergyByCgroup(size_t count, std::vector<std::string>& domains);
+    
+    // Columnar session log (see session_log.h); replaces any log already open
+    bool openSessionLog(const std::string& path, const std::vector<std::string>& columns,
+                        uint32_t chunk_rows, bool compress, std::string& error);
+    // 1 when the row completed a chunk and it was written, 0 when buffered,
+    // -1 when no log is open or the write failed (see error)
+    int appendSessionLog(int64_t timestamp_ms, const double* values, size_t count, std::string& error);
+    void closeSessionLog();
     std::vector<SensorData> getTemperatureSensors();
     std::vector<SensorData> getDDR5Temperatures();
     std::vector<SensorData> getRAPLPower();
     std::vector<PowerData> getRAPLPowerCalculated();
+    // Same, overwriting out in place: a caller that keeps out between calls
+    // reuses its elements, strings and window vectors
+    void getRAPLPowerCalculated(std::vector<PowerData>& out);
+    // Smoothing horizons (seconds) for the per-domain EWMA and boxcar power; default 1/10/60 s
+    void setPowerWindows(const std::vector<double>& seconds);
+    std::vector<double> getPowerWindows();
     // Battery
     // Returns map-like via V8 binding; here return as a simple std::map string->double not needed.
     // We'll expose via bindings directly assembling a JS object from C++ getters.
@@ -68,25 +233,243 @@ public:
         std::string& derived_state
     );
     
-    // Statistics
+    // Single-pass snapshot of every sensor group as a flat array of doubles.
+    // Returns the schema version; the layout only changes when it does.
+    // consumer picks whose RAPL power state the power fields come from.
+    // Groups outside the mask (1 << SensorGroup) are not read and hold NaN.
+    uint64_t snapshot(std::vector<double>& values, PowerConsumer consumer = POWER_CONSUMER_UI,
+                      uint32_t groups = SENSOR_GROUPS_ALL);
+    std::vector<SnapshotField> getSnapshotSchema(uint64_t& version);
+    
+    // Statistics: keys are interned to dense ids so updates are O(1) array writes
+    int registerMetric(const std::string& key);
     void updateStats(const std::string& key, double value);
-    SystemStats getStats();
+    void updateStats(int id, double value);
+    void updateStatsBatch(const int32_t* ids, const double* values, size_t count);
+    void visitStats(const std::function<void(const SystemStats&)>& visitor);
     void resetStats();
+    
+    // Streaming quantiles, fed by the same valid values as updateStats()
+    std::vector<double> getQuantiles(const std::string& key, const std::vector<double>& quantiles);
+    bool exportQuantileSketch(const std::string& key, std::vector<double>& out);
+    bool mergeQuantileSketch(const std::string& key, const double* data, size_t length);
     bool hasLastValidValue(const std::string& key);
     double getLastValidValue(const std::string& key);
     
+    // Persistent history of valid stats values (see history_store.h).
+    // metrics limits recording to those stats keys; empty records every metric.
+    // max_metrics 0 sizes the file to the list (or the default without one).
+    bool openHistory(const std::string& path, uint32_t max_metrics, const std::vector<std::string>& metrics,
+                     std::string& error);
+    // Metrics refused a slot because the file was full since the last call
+    std::vector<std::string> takeHistoryRefused();
+    void closeHistory();
+    // One decimated range per metric id; unknown ids and metrics without a slot come back empty
+    bool queryHistory(const std::vector<int>& ids, int64_t t0_ms, int64_t t1_ms, size_t max_points,
+                      std::vector<HistoryRange>& out);
+    
+    // Background sampler: RAPL power at raplHz, temperatures/frequencies at sensorHz.
+    // Same as a subscription to every group but battery; false if already
+    // running or the thread could not start (see getSamplerError()).
+    bool startSampler(double raplHz, double sensorHz);
+    void stopSampler();
+    // False once the thread stopped on an error; getSamplerError() says why
+    bool isSamplerRunning();
+    std::string getSamplerError();
+    // Demand-driven sampling: a group is only read while a subscription (or
+    // startSampler()) covers it, at the highest rate any of them asked for, and
+    // the thread exits once nothing does. Returns the id, or -1 (see error).
+    int subscribe(const std::vector<std::string>& groups, double rateHz, std::string& error);
+    // Group names ("rapl", "cpu", ...) to a 1 << SensorGroup mask
+    static bool parseSensorGroups(const std::vector<std::string>& groups, uint32_t& mask, std::string& error);
+    bool unsubscribe(int id);
+    // Effective rate per group name; 0 for groups nobody is sampling
+    std::map<std::string, double> getSamplingRates();
+    std::vector<std::string> getSamplerChannels(uint64_t& generation);
+    // Current read rate per channel (adaptive; see sensor_scheduler.h), 0 while unsampled
+    std::vector<double> getSamplerCadence(uint64_t& generation);
+    uint64_t readSamples(uint64_t sinceSeq, size_t maxRecords, std::vector<SampleRecord>& out, uint64_t& generation);
+    // Mirror the sampler into a POSIX shared-memory segment (see shm_snapshot.h):
+    // every record it pushes, plus a full snapshot() on each sensor tick
+    bool openSharedSnapshot(const std::string& name, std::string& error);
+    void closeSharedSnapshot();
+    
 private:
+    std::string root_;
     SystemStats stats_;
+    std::unordered_map<std::string, int> metric_ids_;
+    std::mutex stats_mutex_;
+    HistoryStore history_;
+    std::vector<int> history_slots_; // By metric id; HISTORY_SLOT_UNRESOLVED until first append
+    std::unordered_set<std::string> history_metrics_; // Keys to record; empty means all
+    std::vector<std::string> history_refused_;
+    
+    // Serializes sensor state between JS callers and the sampler thread
+    std::mutex mutex_;
+    
+    // Discovered sensor topology and the netlink socket that invalidates it
+    std::shared_ptr<const SensorTable> sensor_table_;
+    uint64_t table_generation_;
+    int uevent_fd_;
+    
+    // RAPL power calculation state per consumer, keyed by domain name so it survives rescans
+    std::map<std::string, RAPLDomainState> rapl_state_[POWER_CONSUMER_COUNT];
+    std::vector<double> power_windows_;
+    std::vector<PowerData> snapshot_power_; // snapshotLocked()'s scratch, reused across calls
+    
+    // Sampler thread and the ring it publishes into
+    SampleRing sample_ring_;
+    std::thread sampler_thread_;
+    std::mutex sampler_mutex_;
+    int sampler_wake_fd_; // eventfd; the thread sleeps on it and its timerfd
+    bool sampler_stop_;
+    std::atomic<bool> sampler_running_;
+    std::string sampler_error_; // Under sampler_mutex_; why the thread last failed to start or stopped
+    SensorScheduler sampler_scheduler_;
+    double sampler_group_hz_[SENSOR_GROUP_COUNT]; // Under sampler_mutex_, read by the thread
+    bool sampler_rates_changed_;
+    
+    // Who wants which groups sampled; serializes thread start/stop
+    struct Subscription {
+        uint32_t groups; // 1 << SensorGroup
+        double rate_hz;
+    };
+    std::mutex subscription_mutex_;
+    std::map<int, Subscription> subscriptions_;
+    int next_subscription_id_;
+    double manual_rates_[SENSOR_GROUP_COUNT]; // From startSampler()
+    std::shared_ptr<const SensorTable> sampler_table_;
+    std::vector<std::string> sampler_channels_;
+    std::atomic<uint64_t> sampler_generation_;
+    std::vector<uint64_t> sampler_prev_energy_;
+    std::vector<uint64_t> sampler_prev_time_;
+    // Index-aligned with sampler_channels_
+    std::vector<uint8_t> sampler_channel_group_;   // SensorGroup
+    std::vector<uint32_t> sampler_channel_index_;  // Into that group's table entries
+    std::vector<double> sampler_channel_limit_;    // hwmon crit/max, NaN if none
+    std::vector<double> sampler_cadence_hz_;
+    // Latest readings, which snapshots use for the groups the sampler reads
+    std::vector<double> sampler_values_;            // Per channel, NaN until read
+    size_t sampler_group_first_[SENSOR_GROUP_COUNT]; // Each group's first channel
+    std::vector<PowerData> sampler_power_;          // Per RAPL domain, from POWER_CONSUMER_SAMPLER; only its snapshots use it
+    std::vector<uint8_t> sampler_power_valid_;
+    std::vector<double> sampler_battery_;           // Battery snapshot fields
+    bool sampler_battery_valid_;
+    uint32_t sampler_active_groups_;                // 1 << SensorGroup with a rate, 0 while stopped
+    uint64_t sampler_publish_period_us_; // Shared snapshots follow the fastest sensor group
+    uint64_t sampler_next_publish_us_;
+    
+    // Shared-memory mirror, written by the sampler thread under mutex_
+    ShmSnapshotWriter shm_;
+    uint64_t shm_schema_version_;
+    uint64_t shm_channels_generation_;
+    std::vector<double> shm_values_;
+    
+    // Hardware counters, reopened on rescan while enabled
+    PerfCounters perf_counters_;
+    bool perf_enabled_;
+    
+    // /proc/stat counters: CPU_TIME_FIELDS per slot, slot 0 is the aggregate, slot n + 1 is cpu n
+    int proc_stat_fd_;
+    std::vector<char> proc_stat_buf_;
+    std::vector<uint64_t> cpu_times_;
+    std::vector<uint64_t> prev_cpu_times_;
+    std::vector<uint8_t> cpu_present_;
+    std::vector<CPULoad> cpu_load_;
+    uint64_t cpu_load_time_;
+    
+    // /proc/diskstats and /proc/net/dev rates, refreshed at most every MIN_RATE_INTERVAL_US
+    IORates io_rates_;
+    uint64_t io_rates_time_;
+    
+    // GPUs have their own lock: NVML calls can take milliseconds
+    GPUMonitor gpu_monitor_;
+    std::mutex gpu_mutex_;
+    bool gpu_initialized_;
+    
+    // SMART reads block on the drives, so they are cached under their own lock
+    DiskHealth disk_health_;
+    std::mutex disk_health_mutex_;
+    std::vector<DiskHealthData> disk_health_cache_;
+    uint64_t disk_health_time_;
+    
+    // A /proc slice takes milliseconds on a busy host; keep it off mutex_ too
+    ProcessTable process_table_;
+    std::mutex process_mutex_;
+    uint64_t process_table_time_;
+    // Cumulative RAPL joules the table apportions, rebased when the sensor table changes
+    std::shared_ptr<const SensorTable> attribution_table_;
+    std::vector<uint64_t> attribution_prev_uj_;
+    std::vector<bool> attribution_primed_;
+    std::vector<double> attribution_energy_j_;
+    // Keeps the sweep moving between energy queries on its own thread, so the
+    // sampler never waits on /proc; it exits ATTRIBUTION_IDLE_US after the last query
+    std::thread attribution_thread_;
+    std::mutex attribution_mutex_;
+    std::condition_variable attribution_wake_;
+    bool attribution_running_;
+    bool attribution_stop_;
+    uint64_t attribution_last_query_us_;
+    
+    SessionLogWriter session_log_;
+    std::mutex session_log_mutex_;
+    
+    // Persistent sysfs handles: each attribute is opened once and re-read with pread()
+    std::map<std::string, int> sensor_fds_;
+    
+    int openSensorHandle(const std::string& path);
+    void closeSensorHandles();
+    ssize_t readSensor(const std::string& path, char* buf, size_t size);
+    bool readSensorValue(const std::string& path, double& value);
+    bool readSensorCounter(const std::string& path, uint64_t& value);
+    bool readMSR(const std::string& path, uint32_t reg, uint64_t& value);
+    
+    void snapshotLocked(const SensorTable& table, PowerConsumer consumer, uint32_t groups, std::vector<double>& values);
+    std::vector<SnapshotField> snapshotSchemaLocked(const SensorTable& table);
+    void publishSharedSnapshotLocked(const SensorTable& table, uint64_t now_us);
+    void rescanLocked();
+    std::shared_ptr<const SensorTable> ensureSensorTable();
+    void openUeventSocket();
+    bool consumeHotplugEvents();
+    void discoverCPUFrequencies(SensorTable& table);
+    void discoverHwmonSensors(SensorTable& table);
+    void discoverRAPLDomains(SensorTable& table);
+    void discoverRAPLMSR(SensorTable& table);
+    void refreshCPULoadLocked();
+    void advanceProcessTableLocked();
+    void keepAttributionRunning();
+    void attributionLoop();
+    void joinAttributionThread();
+    std::vector<SensorData> readSensorGroup(const std::vector<SensorDescriptor>& group);
+    int registerMetricLocked(const std::string& key);
+    void updateStatsLocked(int id, double value, int64_t now_ms);
+    int historySlotLocked(int id);
+    int findHistorySlotLocked(int id) const;
+    void readRAPLPowerLocked(const SensorTable& table, PowerConsumer consumer, std::vector<PowerData>& powerData);
+    void updateRAPLPowerLocked(const SensorTable& table, PowerConsumer consumer, size_t index,
+                               uint64_t energy, uint64_t currentTime, PowerData& power);
+    bool readRAPLEnergy(const SensorTable& table, size_t index, uint64_t& energy_uj);
+    void resetPowerWindows(RAPLDomainState& state);
+    bool readBatterySnapshotLocked(double* fields);
+    bool readBatteryLocked(
+        std::string& status,
+        bool& ac_connected,
+        double& voltage_v,
+        double& current_a,
+        double& power_w,
+        double& energy_now_wh,
+        double& energy_full_wh,
+        double& estimated_hours,
+        std::string& derived_state
+    );
     
-    // RAPL power calculation state
-    std::map<std::string, uint64_t> previous_energy_;
-    std::map<std::string, uint64_t> previous_time_;
-    std::map<std::string, std::vector<double>> power_readings_;
-    std::map<std::string, double> min_power_;
-    std::map<std::string, double> max_power_;
-    std::map<std::string, double> sum_power_;
-    std::map<std::string, int> count_power_;
-    std::map<std::string, double> cumulative_energy_wh_;
+    void computeSamplingRatesLocked(double rates[SENSOR_GROUP_COUNT]);
+    bool applySamplingRatesLocked(std::string& error);
+    void joinSamplerThread();
+    void samplerLoop();
+    void rebuildSamplerChannelsLocked(const SensorTable& table);
+    void applyCadenceLocked(SensorScheduler& scheduler, const double rates[SENSOR_GROUP_COUNT], uint64_t now_us);
+    void sampleChannels(SensorScheduler& scheduler, const std::vector<uint32_t>& due, uint64_t now_us);
     
     std::string readFile(const std::string& path);
     std::vector<std::string> readDirectory(const std::string& path);
@@ -14,6 +14,13 @@ try {
     const initResult = systemMonitor.initialize();
     console.log('✓ Initialization:', initResult);
     
+    try {
+        systemMonitor.rescan();
+        console.log('✓ Sensor rescan working');
+    } catch (e) {
+        console.log('⚠ Rescan test failed:', e.message);
+    }
+    
     // Test basic functionality
     try {
         const cores = systemMonitor.getCPUCores();
@@ -22,6 +29,125 @@ try {
         console.log('⚠ CPU cores test failed:', e.message);
     }
     
+    try {
+        const io = systemMonitor.getIODevices();
+        const rates = systemMonitor.readIORates();
+        console.log('✓ I/O rates:', io.disks.length, 'disks,', io.interfaces.length, 'interfaces,', rates.length - 1, 'values');
+    } catch (e) {
+        console.log('⚠ I/O rates test failed:', e.message);
+    }
+    
+    try {
+        const gpus = systemMonitor.getGPUData();
+        console.log('✓ GPUs:', gpus.length, 'via', systemMonitor.getGPUBackend());
+    } catch (e) {
+        console.log('⚠ GPU test failed:', e.message);
+    }
+    
+    try {
+        const disks = Object.values(systemMonitor.getDiskHealth());
+        const readable = disks.filter(disk => !disk.error).length;
+        console.log('✓ Disk health:', readable, 'of', disks.length, 'disks readable');
+    } catch (e) {
+        console.log('⚠ Disk health test failed:', e.message);
+    }
+    
+    // Every row must come back exactly as appended, across chunk boundaries
+    try {
+        const assert = require('assert');
+        const logPath = require('path').join(require('os').tmpdir(), `test-native-${process.pid}.smlog`);
+        const t0 = Date.now();
+        const timestamps = [t0, t0 + 100, t0 + 200, t0 + 350, t0 + 351];
+        const a = [1.5, 1.5, NaN, -0.25, 1.5];
+        const b = [2, 3, 3, 1e300, NaN];
+        systemMonitor.openSessionLog(logPath, ['a', 'b'], { chunkRows: 2 });
+        systemMonitor.appendSessionLog(timestamps[0], new Float64Array([a[0], b[0]]));
+        for (let i = 1; i < timestamps.length; i++) {
+            systemMonitor.appendSessionLog(timestamps[i], [a[i], b[i]]);
+        }
+        systemMonitor.closeSessionLog();
+        const log = systemMonitor.readSessionLog(logPath);
+        const window = systemMonitor.readSessionLog(logPath, t0 + 100, t0 + 350);
+        require('fs').unlinkSync(logPath);
+        
+        assert.deepStrictEqual(Array.from(log.timestamps), timestamps);
+        assert.deepStrictEqual(Object.keys(log.columns), ['a', 'b']);
+        // deepStrictEqual treats NaN as equal to NaN
+        assert.deepStrictEqual(Array.from(log.columns.a), a);
+        assert.deepStrictEqual(Array.from(log.columns.b), b);
+        assert.deepStrictEqual(Array.from(window.timestamps), timestamps.slice(1, 4));
+        assert.deepStrictEqual(Array.from(window.columns.a), a.slice(1, 4));
+        assert.deepStrictEqual(Array.from(window.columns.b), b.slice(1, 4));
+        console.log('✓ Session log:', log.timestamps.length, 'rows round-tripped, b =', Array.from(log.columns.b).join(','));
+    } catch (e) {
+        console.log('✗ Session log round trip failed:', e.message);
+        process.exitCode = 1;
+    }
+    
+    // Raw points must be exactly the valid values recorded, and survive a reopen
+    try {
+        const assert = require('assert');
+        const historyPath = require('path').join(require('os').tmpdir(), `test-native-${process.pid}.smhist`);
+        // One slot for two listed keys: the second is refused, unlisted keys are ignored
+        systemMonitor.openHistory(historyPath, 1, ['test_history', 'test_history_overflow']);
+        const id = systemMonitor.registerMetric('test_history');
+        const before = Date.now() - 1;
+        for (const value of [42, NaN, 42, 43.5]) {
+            systemMonitor.updateStats(id, value);
+        }
+        const after = Date.now() + 1;
+        systemMonitor.updateStats(systemMonitor.registerMetric('test_history_overflow'), 1);
+        systemMonitor.updateStats(systemMonitor.registerMetric('test_history_unlisted'), 1);
+        const refused = systemMonitor.takeHistoryRefused();
+        const [range] = systemMonitor.queryRange([id], 0, after + 1000, 100);
+        const [merged] = systemMonitor.queryRange([id], 0, after + 1000, 1);
+        systemMonitor.closeHistory();
+        systemMonitor.openHistory(historyPath, 1, ['test_history', 'test_history_overflow']);
+        const [reopened] = systemMonitor.queryRange([id], 0, after + 1000, 100);
+        systemMonitor.closeHistory();
+        require('fs').unlinkSync(historyPath);
+        
+        assert.deepStrictEqual(refused, ['test_history_overflow']);
+        // The NaN is not a valid value, so it is never recorded
+        assert.strictEqual(range.bucketMs, 0);
+        assert.deepStrictEqual(Array.from(range.avg), [42, 42, 43.5]);
+        assert.deepStrictEqual(Array.from(range.min), [42, 42, 43.5]);
+        assert.deepStrictEqual(Array.from(range.max), [42, 42, 43.5]);
+        assert.strictEqual(range.timestamps.length, 3);
+        range.timestamps.forEach((t, i) => {
+            assert.ok(t >= before && t <= after, `timestamp ${t} outside [${before}, ${after}]`);
+            assert.ok(i === 0 || t >= range.timestamps[i - 1], 'timestamps out of order');
+        });
+        assert.ok(merged.bucketMs > 0);
+        assert.strictEqual(merged.timestamps.length, 1);
+        assert.strictEqual(merged.min[0], 42);
+        assert.strictEqual(merged.max[0], 43.5);
+        assert.strictEqual(merged.avg[0], 42.5);
+        assert.deepStrictEqual(Array.from(reopened.timestamps), Array.from(range.timestamps));
+        assert.deepStrictEqual(Array.from(reopened.avg), Array.from(range.avg));
+        console.log('✓ History:', range.timestamps.length, 'point(s), avg', merged.avg[0] + ', refused', refused.join(','));
+    } catch (e) {
+        console.log('✗ History query failed:', e.message);
+        process.exitCode = 1;
+    }
+    
+    try {
+        const load = systemMonitor.getCPULoad();
+        console.log('✓ CPU load:', load.currentLoad.toFixed(1) + '%,', load.cpus.length, 'CPUs');
+    } catch (e) {
+        console.log('⚠ CPU load test failed:', e.message);
+    }
+    
+    try {
+        const covered = systemMonitor.enableHardwareCounters(true);
+        systemMonitor.getCPUCores();
+        const core = systemMonitor.getCPUCores()[0];
+        console.log('✓ Hardware counters:', covered, 'CPUs', core ? `(cpu${core.cpu} ipc ${core.ipc})` : '');
+        systemMonitor.enableHardwareCounters(false);
+    } catch (e) {
+        console.log('⚠ Hardware counters test failed:', e.message);
+    }
+    
     try {
         const sensors = systemMonitor.getTemperatureSensors();
         console.log('✓ Temperature sensors:', sensors.length, 'detected');
@@ -29,6 +155,29 @@ try {
         console.log('⚠ Temperature sensors test failed:', e.message);
     }
     
+    try {
+        systemMonitor.setPowerWindows([1, 10, 60]);
+        const power = systemMonitor.getRAPLPowerCalculated();
+        console.log('✓ RAPL tree:', systemMonitor.getRAPLPowerTree().map(d => `${d.name}(${d.children.length})`).join(', '));
+        console.log('✓ Power windows:', systemMonitor.getPowerWindows(), power.length ? power[0].ewma : '(no RAPL)');
+    } catch (e) {
+        console.log('⚠ Power windows test failed:', e.message);
+    }
+    
+    try {
+        const schema = systemMonitor.getSchema();
+        const values = systemMonitor.snapshot();
+        const refilled = systemMonitor.snapshot(values);
+        console.log('✓ Snapshot:', schema.fields.length, 'fields, schema', values[0],
+            refilled === values ? '(buffer reused)' : '(buffer reallocated)');
+    } catch (e) {
+        console.log('⚠ Snapshot test failed:', e.message);
+    }
+    
+    systemMonitor.sampleAllAsync()
+        .then(sample => console.log('✓ sampleAllAsync:', sample.cores.length, 'cores,', sample.rapl.length, 'RAPL domains'))
+        .catch(e => console.log('⚠ sampleAllAsync test failed:', e.message));
+    
     try {
         const stats = systemMonitor.getStats();
         console.log('✓ Statistics system working');
@@ -36,6 +185,52 @@ try {
         console.log('⚠ Statistics test failed:', e.message);
     }
     
+    try {
+        const id = systemMonitor.registerMetric('test_metric');
+        systemMonitor.updateStatsBatch(new Int32Array([id, id]), new Float64Array([1, 3]));
+        const columns = systemMonitor.getStatsColumns();
+        const count = systemMonitor.getMetricNames().length;
+        console.log('✓ Batched stats: avg', columns[2 * count + id]);
+    } catch (e) {
+        console.log('⚠ Batched stats test failed:', e.message);
+    }
+    
+    // 1..1000 in shuffled order: the tails are exact and the middle within the sketch's error
+    try {
+        const assert = require('assert');
+        const id = systemMonitor.registerMetric('test_quantiles');
+        const values = new Float64Array(1001);
+        for (let i = 0; i < 1000; i++) {
+            values[i] = ((i * 7919) % 1000) + 1;
+        }
+        values[1000] = NaN;
+        systemMonitor.updateStatsBatch(new Int32Array(values.length).fill(id), values);
+        const [q0, p50, p90, p99, q1] = systemMonitor.getQuantiles('test_quantiles', [0, 0.5, 0.9, 0.99, 1]);
+        assert.strictEqual(q0, 1);
+        assert.strictEqual(q1, 1000);
+        assert.ok(Math.abs(p50 - 500.5) <= 5, `p50 ${p50}`);
+        assert.ok(Math.abs(p90 - 900.5) <= 5, `p90 ${p90}`);
+        assert.ok(Math.abs(p99 - 990.5) <= 2, `p99 ${p99}`);
+        
+        // A merged copy of the sketch answers the same
+        systemMonitor.registerMetric('test_quantiles_merged');
+        assert.strictEqual(systemMonitor.mergeQuantileSketch('test_quantiles_merged',
+            systemMonitor.getQuantileSketch('test_quantiles')), true);
+        assert.deepStrictEqual(systemMonitor.getQuantiles('test_quantiles_merged', [0, 0.5, 0.9, 0.99, 1]),
+            [q0, p50, p90, p99, q1]);
+        
+        const repeated = systemMonitor.registerMetric('test_quantiles_repeated');
+        for (let i = 0; i < 10; i++) {
+            systemMonitor.updateStats(repeated, 7.25);
+        }
+        assert.deepStrictEqual(systemMonitor.getQuantiles('test_quantiles_repeated', [0.01, 0.5, 0.99]), [7.25, 7.25, 7.25]);
+        assert.deepStrictEqual(systemMonitor.getQuantiles('test_quantiles_unknown', [0.5]), [NaN]);
+        console.log('✓ Quantiles: p50', p50, 'p90', p90, 'p99', p99);
+    } catch (e) {
+        console.log('✗ Quantiles failed:', e.message);
+        process.exitCode = 1;
+    }
+    
     // Test new methods
     try {
         const hasValue = systemMonitor.hasLastValidValue('test_key');
@@ -51,6 +246,128 @@ try {
         console.log('⚠ getLastValidValue test failed:', e.message);
     }
     
+    try {
+        systemMonitor.startSampler(100, 10);
+        const start = Date.now();
+        while (Date.now() - start < 250) { /* let the sampler run */ }
+        const batch = systemMonitor.readSamples(0);
+        systemMonitor.stopSampler();
+        console.log('✓ Background sampler:', batch.values.length, 'records, seq', batch.seq);
+    } catch (e) {
+        console.log('⚠ Sampler test failed:', e.message);
+    }
+    
+    try {
+        systemMonitor.getTopProcesses('cpu', 5);
+        const top = systemMonitor.getTopProcesses('rss', 5);
+        console.log('✓ Top processes by RSS:', top.map(p => `${p.name}(${p.pid}) ${(p.rssBytes / 1048576).toFixed(0)} MB`).join(', '));
+    } catch (e) {
+        console.log('⚠ Process table test failed:', e.message);
+    }
+    
+    try {
+        const energy = systemMonitor.getEnergyByProcess(5);
+        console.log('✓ Energy by process:', energy.map(p => `${p.name}(${p.pid}) ${p.joules.toFixed(2)} J`).join(', ') || 'nothing charged yet');
+    } catch (e) {
+        console.log('⚠ Energy attribution test failed:', e.message);
+    }
+    
+    try {
+        const id = systemMonitor.subscribe(['cpu', 'cpufreq'], 20);
+        const rates = systemMonitor.getSamplingRates();
+        const start = Date.now();
+        while (Date.now() - start < 300) { /* let the cadence adapt */ }
+        const cadence = systemMonitor.getSamplerCadence();
+        console.log('✓ Sampler cadence:', Array.from(cadence.rates).map(hz => hz.toFixed(1)).join(' '), 'Hz');
+        systemMonitor.unsubscribe(id);
+        console.log('✓ Sampler subscription: cpu', rates.cpu, 'Hz, rapl', rates.rapl, 'Hz, after unsubscribe',
+            systemMonitor.getSamplingRates().cpu, 'Hz');
+    } catch (e) {
+        console.log('⚠ Sampler subscription test failed:', e.message);
+    }
+    
+    try {
+        const name = `/system-monitor-test-${process.pid}`;
+        systemMonitor.openSharedSnapshot(name);
+        systemMonitor.startSampler(50, 10);
+        const start = Date.now();
+        while (Date.now() - start < 250) { /* let the sampler publish */ }
+        const shared = systemMonitor.readSharedSnapshot(name);
+        const schema = systemMonitor.getSharedSnapshotSchema(name);
+        const samples = systemMonitor.readSharedSamples(name, 0);
+        systemMonitor.stopSampler();
+        systemMonitor.closeSharedSnapshot();
+        console.log('✓ Shared snapshot:', shared ? shared.length - 1 : 0, 'values,', schema ? schema.fields.length : 0,
+            'fields,', samples.values.length, 'sampler records');
+    } catch (e) {
+        console.log('⚠ Shared snapshot test failed:', e.message);
+    }
+    
+    // Decoding the frames must rebuild each snapshot bit for bit
+    try {
+        const assert = require('assert');
+        const schema = systemMonitor.getSchema();
+        const bitsSet = (bitmap) => bitmap.reduce((n, byte) => {
+            for (; byte; byte &= byte - 1) n++;
+            return n;
+        }, 0);
+        const stream = systemMonitor.openSnapshotStream();
+        const first = systemMonitor.nextSnapshotFrame(stream);
+        const second = systemMonitor.nextSnapshotFrame(stream);
+        const again = systemMonitor.nextSnapshotFrame(stream, true);
+        systemMonitor.closeSnapshotStream(stream);
+        assert.throws(() => systemMonitor.nextSnapshotFrame(stream), /Unknown snapshot stream/);
+        
+        assert.strictEqual(first.full, true);
+        assert.strictEqual(first.version, schema.version);
+        assert.strictEqual(first.count, schema.fields.length);
+        assert.strictEqual(first.bitmap.length, Math.ceil(first.count / 8));
+        assert.strictEqual(bitsSet(first.bitmap), first.count);
+        assert.strictEqual(first.values.length, first.count);
+        
+        assert.strictEqual(second.full, false);
+        assert.strictEqual(second.count, first.count);
+        assert.strictEqual(second.values.length, bitsSet(second.bitmap));
+        const previous = Array.from(first.values);
+        const current = previous.slice();
+        let next = 0;
+        for (let i = 0; i < second.count; i++) {
+            if (second.bitmap[i >> 3] & (1 << (i & 7))) {
+                current[i] = second.values[next++];
+                // A field is only sent when it changed; NaN to NaN is no change
+                assert.ok(!Object.is(current[i], previous[i]), `field ${i} sent unchanged`);
+            }
+        }
+        
+        // A reset makes the next frame full again
+        assert.strictEqual(again.full, true);
+        assert.strictEqual(bitsSet(again.bitmap), again.count);
+        assert.strictEqual(again.values.length, current.length);
+        console.log('✓ Snapshot stream: full frame', first.values.length, 'values, then',
+            second.values.length, 'changed of', second.count);
+    } catch (e) {
+        console.log('✗ Snapshot stream failed:', e.message);
+        process.exitCode = 1;
+    }
+    
+    try {
+        const port = systemMonitor.startMetricsServer(0);
+        require('http').get({ host: '127.0.0.1', port, path: '/metrics' }, (res) => {
+            let body = '';
+            res.on('data', (chunk) => { body += chunk; });
+            res.on('end', () => {
+                systemMonitor.stopMetricsServer();
+                console.log('✓ Metrics server:', res.statusCode, body.split('\n').filter((l) => l && l[0] !== '#').length,
+                    'samples, ends with # EOF:', body.endsWith('# EOF\n'));
+            });
+        }).on('error', (e) => {
+            systemMonitor.stopMetricsServer();
+            console.log('⚠ Metrics server test failed:', e.message);
+        });
+    } catch (e) {
+        console.log('⚠ Metrics server test failed:', e.message);
+    }
+    
     console.log('✓ Native addon test completed successfully');
     
 } catch (error) {